@@ -2,13 +2,20 @@
 
 #include <ctype.h>
 #include <debug.h>
+#include <list.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -49,6 +56,42 @@
 #define CMD_IDENTIFY_DEVICE 0xec    /* IDENTIFY DEVICE. */
 #define CMD_READ_SECTOR_RETRY 0x20  /* READ SECTOR with retries. */
 #define CMD_WRITE_SECTOR_RETRY 0x30 /* WRITE SECTOR with retries. */
+#define CMD_READ_DMA 0xc8           /* READ DMA with retries. */
+#define CMD_WRITE_DMA 0xca          /* WRITE DMA with retries. */
+
+/** #Project 3: Busmaster DMA - PIIX류 IDE 컨트롤러의 busmaster 레지스터.
+ *  PCI BAR4가 가리키는 16바이트 블록을 두 채널이 8바이트씩 나눠 쓴다. */
+#define reg_bm_cmd(CHANNEL) ((CHANNEL)->bm_base + 0)    /* Command. */
+#define reg_bm_status(CHANNEL) ((CHANNEL)->bm_base + 2) /* Status. */
+#define reg_bm_prdt(CHANNEL) ((CHANNEL)->bm_base + 4)   /* PRDT address. */
+
+/* Busmaster Command Register bits. */
+#define BM_CMD_START 0x01 /* 1=start transfer. */
+#define BM_CMD_READ 0x08  /* 1=disk to memory, 0=memory to disk. */
+
+/* Busmaster Status Register bits (IRQ/ERR are write-1-to-clear). */
+#define BM_STA_ACTIVE 0x01 /* Transfer in progress. */
+#define BM_STA_ERR 0x02    /* Transfer error. */
+#define BM_STA_IRQ 0x04    /* Device raised an interrupt. */
+
+/* PCI configuration space access (ports 0xcf8/0xcfc), just enough
+   to find the IDE controller's busmaster register block. */
+#define PCI_CONFIG_ADDR 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+#define PCI_REG_ID 0x00      /* Device/vendor ID. */
+#define PCI_REG_COMMAND 0x04 /* Status/command. */
+#define PCI_REG_CLASS 0x08   /* Class/subclass/prog-if/revision. */
+#define PCI_REG_BAR4 0x20    /* Base address register 4. */
+
+/** #Project 3: Multi-sector 전송 - 채널당 bounce 버퍼 크기. 64KB는 PRD
+ *  엔트리 하나가 다룰 수 있는 최대 크기(byte count 0 인코딩)이자 한
+ *  명령의 최대치인 128 섹터 분량이다. */
+#define DMA_BUF_PAGES 16
+#define DMA_BUF_SECTORS (DMA_BUF_PAGES * PGSIZE / DISK_SECTOR_SIZE)
+
+/** #Project 3: I/O Stats - 요청 지연 히스토그램의 버킷 수. 버킷 i는
+ *  제출부터 완료까지 2^i 마이크로초 미만이 걸린 요청을 센다. */
+#define DISK_LAT_BUCKETS 16
 
 /* An ATA device. */
 struct disk {
@@ -61,6 +104,20 @@ struct disk {
 
     long long read_cnt;  /* Number of sectors read. */
     long long write_cnt; /* Number of sectors written. */
+
+    /** #Project 3: I/O Stats - 병합 횟수와 로그 스케일 지연 분포. */
+    long long merge_cnt;                  /* Requests merged away. */
+    long long lat_hist[DISK_LAT_BUCKETS]; /* Latency histogram. */
+};
+
+/** #Project 3: 채널 상태 기계 - 완료 인터럽트가 왔을 때 핸들러가 해야 할
+ *  일. 명령을 날린 쪽은 상태만 걸어 두고 락을 놓은 채 잠들고, 인터럽트
+ *  핸들러가 상태에 맞는 완료 처리를 직접 진행한다. */
+enum channel_state {
+    CHAN_IDLE,      /* 큐 밖의 명령 (부팅 IDENTIFY 등): ack + wake만. */
+    CHAN_PIO_READ,  /* 데이터 레지스터를 io_buf로 비운 뒤 wake. */
+    CHAN_PIO_WRITE, /* 데이터는 이미 밀어 넣었음: ack + wake. */
+    CHAN_DMA,       /* 버스마스터가 데이터 소유: ack + wake. */
 };
 
 /* An ATA channel (aka controller).
@@ -75,9 +132,49 @@ struct channel {
                                          any interrupt would be spurious. */
     struct semaphore completion_wait; /* Up'd by interrupt handler. */
 
+    /** #Project 3: 채널 상태 기계 - 날아가 있는 명령의 완료 방식. 채널
+     *  락은 레지스터를 만지는 짧은 구간에만 잡고, 장치가 일하는 동안은
+     *  이 상태와 세마포어만으로 완료를 주고받는다. */
+    enum channel_state state; /* 진행 중인 명령의 종류. */
+    void *io_buf;             /* CHAN_PIO_READ: 섹터를 받을 버퍼. */
+    bool io_error;            /* 인터럽트 시점에 BSY/DRQ가 틀어져 있었음. */
+
+    /** #Project 3: Busmaster DMA - 0이면 PIO로 동작한다. dma_buf는 DMA
+     *  zone(palloc_get_dma)에서 받은 64KB 정렬 bounce 버퍼라 PRD의 64KB
+     *  경계 제약을 만족한다. */
+    uint16_t bm_base;   /* Busmaster register base, 0 if none. */
+    uint32_t *prdt;     /* PRD 테이블 (엔트리 하나). */
+    void *dma_buf;      /* DMA bounce 버퍼 (DMA_BUF_PAGES 페이지). */
+
+    /** #Project 3: Request Queue - 채널별 요청 큐. 디스패처 스레드가
+     *  head_pos부터 섹터 오름차순(C-LOOK)으로 꺼내 처리한다. */
+    struct list req_queue;     /* Pending requests, sorted by sector. */
+    struct semaphore req_sema; /* Counts pending queue entries. */
+    disk_sector_t head_pos;    /* One past the last serviced sector. */
+    size_t queue_depth;        /* Entries currently queued. */
+    size_t queue_max;          /* Deepest the queue has been. */
+
     struct disk devices[2]; /* The devices on this channel. */
 };
 
+/** #Project 3: Request Queue - 큐에 들어가는 전송 요청 하나. done이 NULL이면
+ *  동기 요청이라 완료 시 wait를 올려 주고, 아니면 디스패처 스레드가
+ *  done(aux)를 부른 뒤 요청을 해제한다. 인접 요청이 병합되면 뒤쪽 요청은
+ *  앞쪽 요청의 merged 리스트에 매달려 같은 명령으로 함께 완료된다. */
+struct disk_request {
+    struct disk *d;        /* Target device. */
+    disk_sector_t sector;  /* First sector to transfer. */
+    size_t cnt;            /* Number of sectors. */
+    void *buffer;          /* Data buffer. */
+    bool write;            /* Write or read? */
+    int64_t submit_ns;     /* ktime_ns() at submission, for latency. */
+    disk_done_func *done;  /* Completion callback, null for sync requests. */
+    void *aux;             /* Argument for DONE. */
+    struct semaphore wait; /* Up'd on completion when DONE is null. */
+    struct list merged;    /* Requests folded into this one. */
+    struct list_elem elem; /* Queue / merge list element. */
+};
+
 /* We support the two "legacy" ATA channels found in a standard PC. */
 #define CHANNEL_CNT 2
 static struct channel channels[CHANNEL_CNT];
@@ -86,11 +183,22 @@ static void reset_channel(struct channel *);
 static bool check_device_type(struct disk *);
 static void identify_ata_device(struct disk *);
 
-static void select_sector(struct disk *, disk_sector_t);
+static void select_sector(struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command(struct channel *, uint8_t command);
 static void input_sector(struct channel *, void *);
 static void output_sector(struct channel *, const void *);
 
+/** #Project 3: Busmaster DMA 보조 함수 */
+static void bm_init(void);
+static void dma_setup(struct channel *, bool to_memory, size_t bytes);
+static bool dma_finish(struct channel *);
+
+/** #Project 3: Request Queue 보조 함수 */
+static void submit_request(struct disk_request *);
+static void complete_request(struct disk_request *);
+static void do_transfer(struct disk_request *);
+static void disk_dispatch(void *);
+
 static void wait_until_idle(const struct disk *);
 static bool wait_while_busy(const struct disk *);
 static void select_device(const struct disk *);
@@ -98,6 +206,31 @@ static void select_device_wait(const struct disk *);
 
 static void interrupt_handler(struct intr_frame *);
 
+/** #Project 3: Boot 가속 - 채널 하나를 리셋하고 장치를 식별한다.
+ *  리셋 대기가 수백 ms라 두 채널을 직렬로 돌리면 그 비용이 두 배로
+ *  쌓인다. disk_init()이 채널마다 이 함수를 스레드로 띄워 동시에
+ *  진행시키고, probe_done 세마포어로 완료를 기다린다. */
+static struct semaphore probe_done;
+
+static void channel_probe(void *c_) {
+    struct channel *c = c_;
+    int dev_no;
+
+    /* Reset hardware. */
+    reset_channel(c);
+
+    /* Distinguish ATA hard disks from other devices. */
+    if (check_device_type(&c->devices[0]))
+        check_device_type(&c->devices[1]);
+
+    /* Read hard disk identity information. */
+    for (dev_no = 0; dev_no < 2; dev_no++)
+        if (c->devices[dev_no].is_ata)
+            identify_ata_device(&c->devices[dev_no]);
+
+    sema_up(&probe_done);
+}
+
 /* Initialize the disk subsystem and detect disks. */
 void disk_init(void) {
     size_t chan_no;
@@ -122,7 +255,14 @@ void disk_init(void) {
         }
         lock_init(&c->lock);
         c->expecting_interrupt = false;
+        c->state = CHAN_IDLE;
+        c->io_buf = NULL;
+        c->io_error = false;
         sema_init(&c->completion_wait, 0);
+        list_init(&c->req_queue);
+        sema_init(&c->req_sema, 0);
+        c->head_pos = 0;
+        c->queue_depth = c->queue_max = 0;
 
         /* Initialize devices. */
         for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -135,39 +275,167 @@ void disk_init(void) {
             d->capacity = 0;
 
             d->read_cnt = d->write_cnt = 0;
+            d->merge_cnt = 0;
         }
 
         /* Register interrupt handler. */
         intr_register_ext(c->irq, interrupt_handler, c->name);
+    }
 
-        /* Reset hardware. */
-        reset_channel(c);
+    /** #Project 3: Boot 가속 - 두 채널을 동시에 리셋/식별한다.
+     *  스레드 생성에 실패하면 이 자리에서 직접 돌린다 (channel_probe가
+     *  세마포어를 올리므로 조인 횟수는 같다). */
+    sema_init(&probe_done, 0);
+    for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+        struct channel *c = &channels[chan_no];
+        char name[16];
+
+        snprintf(name, sizeof name, "%s-probe", c->name);
+        if (thread_create(name, PRI_DEFAULT, channel_probe, c) == TID_ERROR)
+            channel_probe(c);
+    }
+    for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++)
+        sema_down(&probe_done);
 
-        /* Distinguish ATA hard disks from other devices. */
-        if (check_device_type(&c->devices[0]))
-            check_device_type(&c->devices[1]);
+    /** #Project 3: Busmaster DMA - PCI에서 busmaster 블록을 찾아 켠다.
+     *  없으면 bm_base가 0으로 남아 기존 PIO 경로 그대로 동작한다. */
+    bm_init();
 
-        /* Read hard disk identity information. */
-        for (dev_no = 0; dev_no < 2; dev_no++)
-            if (c->devices[dev_no].is_ata)
-                identify_ata_device(&c->devices[dev_no]);
+    /** #Project 3: Request Queue - 채널마다 디스패처 스레드를 띄운다.
+     *  이후 모든 전송은 큐를 거쳐 이 스레드가 처리한다. 대부분 잠들어
+     *  있고 깨어나면 바로 장치에 명령을 넣어야 하므로 우선순위를 최대로
+     *  준다 (ksoftirqd와 같은 이유). */
+    for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+        struct channel *c = &channels[chan_no];
+        char name[16];
+
+        snprintf(name, sizeof name, "%s-io", c->name);
+        thread_create(name, PRI_MAX, disk_dispatch, c);
     }
 
     /* DO NOT MODIFY BELOW LINES. */
     register_disk_inspect_intr();
 }
 
-/* Prints disk statistics. */
+/** #Project 3: Busmaster DMA - PCI config dword 읽기/쓰기 */
+static uint32_t pci_read(int dev, int func, int reg) {
+    outl(PCI_CONFIG_ADDR, 0x80000000u | (dev << 11) | (func << 8) | (reg & 0xfc));
+    return inl(PCI_CONFIG_DATA);
+}
+
+static void pci_write(int dev, int func, int reg, uint32_t value) {
+    outl(PCI_CONFIG_ADDR, 0x80000000u | (dev << 11) | (func << 8) | (reg & 0xfc));
+    outl(PCI_CONFIG_DATA, value);
+}
+
+/** #Project 3: Busmaster DMA - 버스 0에서 IDE 컨트롤러(클래스 01:01)를 찾아
+ *  BAR4의 busmaster 블록을 두 채널에 나눠 주고, PCI command 레지스터의
+ *  I/O·busmaster enable 비트를 켠다. PRD 테이블과 bounce 버퍼도 여기서
+ *  할당한다 (kernel pool 페이지는 물리 주소가 낮아 32비트 PRD에 안전). */
+static void bm_init(void) {
+    for (int dev = 0; dev < 32; dev++)
+        for (int func = 0; func < 8; func++) {
+            if ((pci_read(dev, func, PCI_REG_ID) & 0xffff) == 0xffff)
+                continue;
+            if ((pci_read(dev, func, PCI_REG_CLASS) >> 16) != 0x0101)
+                continue;
+
+            uint16_t bar4 = pci_read(dev, func, PCI_REG_BAR4) & 0xfffc;
+            if (bar4 == 0)
+                return;
+
+            pci_write(dev, func, PCI_REG_COMMAND, pci_read(dev, func, PCI_REG_COMMAND) | 0x5);
+
+            for (int chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+                struct channel *c = &channels[chan_no];
+
+                /** #Project 3: DMA Zone - bounce 버퍼는 PRD 하나로 걸 수
+                 *  있도록 64KB 정렬을 요구한다 (크기가 딱 64KB이므로 정렬
+                 *  없이는 반드시 경계를 걸친다). 구역을 못 잘라낸 작은
+                 *  메모리 구성에서만 예전 경로로 물러난다. PRD 테이블은
+                 *  페이지 정렬된 한 페이지라 경계를 걸칠 수 없다. */
+                c->prdt = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+                c->dma_buf = palloc_get_dma(DMA_BUF_PAGES, DMA_BUF_PAGES * PGSIZE);
+                if (c->dma_buf == NULL)
+                    c->dma_buf = palloc_get_multiple(PAL_ASSERT, DMA_BUF_PAGES);
+                c->bm_base = bar4 + chan_no * 8;
+                printf("%s: bus-master DMA at 0x%x\n", c->name, c->bm_base);
+            }
+            return;
+        }
+}
+
+/** #Project 3: Busmaster DMA - bounce 버퍼 BYTES만큼의 PRD를 걸고 방향을
+ *  설정한다. 채널 lock을 쥔 채 command 발행 직전에 호출한다. */
+static void dma_setup(struct channel *c, bool to_memory, size_t bytes) {
+    ASSERT(bytes > 0 && bytes <= DMA_BUF_PAGES * PGSIZE);
+
+    c->prdt[0] = vtop(c->dma_buf);
+    c->prdt[1] = (bytes & 0xffff) | 0x80000000u; /* byte count | EOT (0 = 64KB). */
+
+    outl(reg_bm_prdt(c), vtop(c->prdt));
+    outb(reg_bm_status(c), inb(reg_bm_status(c)) | BM_STA_IRQ | BM_STA_ERR);
+    outb(reg_bm_cmd(c), to_memory ? BM_CMD_READ : 0);
+}
+
+/** #Project 3: Busmaster DMA - 전송 정지 후 상태 비트를 정리하고 에러
+ *  여부를 돌려준다. 완료 인터럽트를 받은 뒤 호출한다. */
+static bool dma_finish(struct channel *c) {
+    uint8_t status = inb(reg_bm_status(c));
+
+    outb(reg_bm_cmd(c), inb(reg_bm_cmd(c)) & ~BM_CMD_START);
+    outb(reg_bm_status(c), status | BM_STA_IRQ | BM_STA_ERR);
+
+    return !(status & BM_STA_ERR);
+}
+
+/** #Project 3: I/O Stats - 디스크별 전송량·병합·지연 분포와 채널별 큐
+ *  깊이를 출력한다. 지연 버킷은 0이 아닌 것만 찍는다. */
 void disk_print_stats(void) {
     int chan_no;
 
     for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+        struct channel *c = &channels[chan_no];
         int dev_no;
 
         for (dev_no = 0; dev_no < 2; dev_no++) {
             struct disk *d = disk_get(chan_no, dev_no);
-            if (d != NULL && d->is_ata)
-                printf("%s: %lld reads, %lld writes\n", d->name, d->read_cnt, d->write_cnt);
+            int b;
+
+            if (d == NULL || !d->is_ata)
+                continue;
+
+            printf("%s: %lld reads, %lld writes (%lld kB), %lld merges\n", d->name, d->read_cnt, d->write_cnt,
+                   (d->read_cnt + d->write_cnt) * DISK_SECTOR_SIZE / 1024, d->merge_cnt);
+
+            for (b = 0; b < DISK_LAT_BUCKETS; b++)
+                if (d->lat_hist[b] != 0)
+                    printf("%s: latency <%dus: %lld\n", d->name, 1 << b, d->lat_hist[b]);
+        }
+
+        if (c->queue_max > 0)
+            printf("%s: max queue depth %zu\n", c->name, c->queue_max);
+    }
+}
+
+/** #Project 3: Kernel Stats - 모든 ATA 디스크의 전송·병합 카운터를 합산한다.
+ *  커널 통계 시스템 콜에서 사용한다. */
+void disk_get_totals(long long *read_sectors, long long *write_sectors, long long *merges) {
+    int chan_no;
+
+    *read_sectors = *write_sectors = *merges = 0;
+    for (chan_no = 0; chan_no < (int)CHANNEL_CNT; chan_no++) {
+        int dev_no;
+
+        for (dev_no = 0; dev_no < 2; dev_no++) {
+            struct disk *d = disk_get(chan_no, dev_no);
+
+            if (d == NULL || !d->is_ata)
+                continue;
+
+            *read_sectors += d->read_cnt;
+            *write_sectors += d->write_cnt;
+            *merges += d->merge_cnt;
         }
     }
 }
@@ -200,26 +468,42 @@ disk_sector_t disk_size(struct disk *d) {
     return d->capacity;
 }
 
+/** #Project 3: Request Queue - D가 속한 채널에 지금 적재된 요청 수.
+ *  readahead가 창 크기를 큐의 남은 자리에 맞추는 데 쓴다. 락 없이
+ *  읽는 스냅샷이라 근사값이면 충분하다. */
+size_t disk_queue_depth(struct disk *d) {
+    ASSERT(d != NULL);
+
+    return d->channel->queue_depth;
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for DISK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer) {
-    struct channel *c;
+    disk_read_multi(d, sec_no, 1, buffer);
+}
+
+/** #Project 3: Multi-sector 전송 - 연속된 CNT개 섹터를 읽는다. 요청을 채널
+ *  큐에 넣고 디스패처 스레드가 처리를 마칠 때까지 잔다. */
+void disk_read_multi(struct disk *d, disk_sector_t sec_no, size_t cnt, void *buffer) {
+    struct disk_request r;
 
     ASSERT(d != NULL);
     ASSERT(buffer != NULL);
-
-    c = d->channel;
-    lock_acquire(&c->lock);
-    select_sector(d, sec_no);
-    issue_pio_command(c, CMD_READ_SECTOR_RETRY);
-    sema_down(&c->completion_wait);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
-    input_sector(c, buffer);
-    d->read_cnt++;
-    lock_release(&c->lock);
+    ASSERT(cnt > 0);
+
+    r.d = d;
+    r.sector = sec_no;
+    r.cnt = cnt;
+    r.buffer = buffer;
+    r.write = false;
+    r.done = NULL;
+    sema_init(&r.wait, 0);
+
+    submit_request(&r);
+    sema_down(&r.wait);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -228,21 +512,275 @@ void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer) {
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer) {
-    struct channel *c;
+    disk_write_multi(d, sec_no, 1, buffer);
+}
+
+/** #Project 3: Multi-sector 전송 - 연속된 CNT개 섹터를 쓴다. 요청을 채널
+ *  큐에 넣고 디스패처 스레드가 처리를 마칠 때까지 잔다. */
+void disk_write_multi(struct disk *d, disk_sector_t sec_no, size_t cnt, const void *buffer) {
+    struct disk_request r;
+
+    ASSERT(d != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(cnt > 0);
+
+    r.d = d;
+    r.sector = sec_no;
+    r.cnt = cnt;
+    r.buffer = (void *)buffer;
+    r.write = true;
+    r.done = NULL;
+    sema_init(&r.wait, 0);
+
+    submit_request(&r);
+    sema_down(&r.wait);
+}
+
+/** #Project 3: Request Queue - 비동기 읽기. 요청만 큐에 넣고 바로 돌아오며,
+ *  전송이 끝나면 디스패처 스레드가 DONE(AUX)을 부른다. */
+void disk_submit_read(struct disk *d, disk_sector_t sec_no, size_t cnt, void *buffer, disk_done_func *done, void *aux) {
+    struct disk_request *r;
 
     ASSERT(d != NULL);
     ASSERT(buffer != NULL);
+    ASSERT(cnt > 0);
+    ASSERT(done != NULL);
+
+    r = malloc(sizeof *r);
+    if (r == NULL) {
+        /* 메모리가 없으면 동기로라도 처리해 준다. */
+        disk_read_multi(d, sec_no, cnt, buffer);
+        done(aux);
+        return;
+    }
 
-    c = d->channel;
-    lock_acquire(&c->lock);
-    select_sector(d, sec_no);
-    issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
-    if (!wait_while_busy(d))
-        PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
-    output_sector(c, buffer);
-    sema_down(&c->completion_wait);
-    d->write_cnt++;
-    lock_release(&c->lock);
+    r->d = d;
+    r->sector = sec_no;
+    r->cnt = cnt;
+    r->buffer = buffer;
+    r->write = false;
+    r->done = done;
+    r->aux = aux;
+
+    submit_request(r);
+}
+
+/** #Project 3: Request Queue - 비동기 쓰기. disk_submit_read() 참고. */
+void disk_submit_write(struct disk *d, disk_sector_t sec_no, size_t cnt, const void *buffer, disk_done_func *done, void *aux) {
+    struct disk_request *r;
+
+    ASSERT(d != NULL);
+    ASSERT(buffer != NULL);
+    ASSERT(cnt > 0);
+    ASSERT(done != NULL);
+
+    r = malloc(sizeof *r);
+    if (r == NULL) {
+        disk_write_multi(d, sec_no, cnt, buffer);
+        done(aux);
+        return;
+    }
+
+    r->d = d;
+    r->sector = sec_no;
+    r->cnt = cnt;
+    r->buffer = (void *)buffer;
+    r->write = true;
+    r->done = done;
+    r->aux = aux;
+
+    submit_request(r);
+}
+
+/* Orders queued requests by starting sector. */
+static bool request_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED) {
+    const struct disk_request *a = list_entry(a_, struct disk_request, elem);
+    const struct disk_request *b = list_entry(b_, struct disk_request, elem);
+
+    return a->sector < b->sector;
+}
+
+/** #Project 3: Request Queue - 요청을 채널 큐에 넣는다. 방향이 같고 섹터와
+ *  버퍼가 모두 이어지는 대기 요청이 있으면 그 요청을 늘리는 것으로 병합해
+ *  명령 횟수를 줄인다. 짧은 임계 구역이므로 인터럽트만 끈다. */
+static void submit_request(struct disk_request *r) {
+    struct channel *c = r->d->channel;
+    struct list_elem *e;
+    bool merged = false;
+    enum intr_level old_level;
+
+    TRACE(r->write ? TRACE_DISK_WRITE : TRACE_DISK_READ, r->sector, (c - channels) * 2 + r->d->dev_no);
+
+    r->submit_ns = ktime_ns();
+
+    old_level = intr_disable();
+    for (e = list_begin(&c->req_queue); e != list_end(&c->req_queue); e = list_next(e)) {
+        struct disk_request *q = list_entry(e, struct disk_request, elem);
+
+        if (q->d == r->d && q->write == r->write && q->sector + q->cnt == r->sector && (uint8_t *)q->buffer + q->cnt * DISK_SECTOR_SIZE == r->buffer && q->cnt + r->cnt <= 256) {
+            q->cnt += r->cnt;
+            list_push_back(&q->merged, &r->elem);
+            r->d->merge_cnt++;
+            merged = true;
+            break;
+        }
+    }
+    if (!merged) {
+        list_init(&r->merged);
+        list_insert_ordered(&c->req_queue, &r->elem, request_less, NULL);
+        if (++c->queue_depth > c->queue_max)
+            c->queue_max = c->queue_depth;
+        sema_up(&c->req_sema);
+    }
+    intr_set_level(old_level);
+}
+
+/** #Project 3: I/O Stats - NOW 시점에 완료된 요청의 지연을 로그 스케일
+ *  버킷에 기록한다 (버킷 i = 2^i 마이크로초 미만). */
+static void record_latency(struct disk_request *r, int64_t now) {
+    int64_t us = (now - r->submit_ns) / 1000;
+    int bucket = 0;
+
+    while (us > 1 && bucket < DISK_LAT_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    r->d->lat_hist[bucket]++;
+}
+
+/** #Project 3: Request Queue - 전송이 끝난 요청(과 병합된 요청들)을 완료
+ *  처리한다. 동기 요청은 잠든 쪽을 깨우고, 비동기 요청은 콜백을 부른 뒤
+ *  해제한다. */
+static void complete_request(struct disk_request *r) {
+    int64_t now = ktime_ns();
+
+    while (!list_empty(&r->merged)) {
+        struct disk_request *q = list_entry(list_pop_front(&r->merged), struct disk_request, elem);
+
+        record_latency(q, now);
+        if (q->done != NULL) {
+            q->done(q->aux);
+            free(q);
+        } else
+            sema_up(&q->wait);
+    }
+
+    record_latency(r, now);
+    if (r->done != NULL) {
+        r->done(r->aux);
+        free(r);
+    } else
+        sema_up(&r->wait);
+}
+
+/** #Project 3: Multi-sector 전송 - 요청 하나를 실제로 장치에 밀어 넣는다.
+ *  bounce 버퍼 크기만큼씩, 최대 128 섹터를 한 번의 명령 사이클로 처리해
+ *  섹터마다 select/command/interrupt 왕복을 반복하던 비용을 명령 단위로
+ *  묶는다. PIO로 동작하는 컨트롤러에서는 예전처럼 섹터별로 처리한다. */
+static void do_transfer(struct disk_request *r) {
+    struct disk *d = r->d;
+    struct channel *c = d->channel;
+    disk_sector_t sec_no = r->sector;
+    uint8_t *buffer = r->buffer;
+    size_t cnt = r->cnt;
+
+    /** #Project 3: 채널 상태 기계 - 락은 레지스터를 만지는 구간에서만
+     *  잡는다. 장치가 전송을 수행하는 수백 µs~수 ms 동안은 락을 놓고
+     *  세마포어에서 잠들므로, 같은 채널의 다른 레지스터 사용자(부팅
+     *  프로브, 통계)가 명령 지속 시간만큼 갇히지 않는다. */
+    while (cnt > 0) {
+        size_t chunk = 1;
+
+        if (c->bm_base != 0) {
+            /** #Project 3: Busmaster DMA - 컨트롤러가 bounce 버퍼를 오가는
+             *  동안 CPU는 잠들고, 완료 인터럽트 후 memcpy 한 번만 한다. */
+            chunk = cnt < DMA_BUF_SECTORS ? cnt : DMA_BUF_SECTORS;
+            if (r->write)
+                memcpy(c->dma_buf, buffer, chunk * DISK_SECTOR_SIZE);
+            lock_acquire(&c->lock);
+            select_sector(d, sec_no, chunk);
+            dma_setup(c, !r->write, chunk * DISK_SECTOR_SIZE);
+            c->state = CHAN_DMA;
+            issue_pio_command(c, r->write ? CMD_WRITE_DMA : CMD_READ_DMA);
+            outb(reg_bm_cmd(c), (r->write ? 0 : BM_CMD_READ) | BM_CMD_START);
+            lock_release(&c->lock);
+            sema_down(&c->completion_wait);
+            lock_acquire(&c->lock);
+            bool ok = dma_finish(c) && wait_while_busy(d);
+            lock_release(&c->lock);
+            if (!ok)
+                PANIC("%s: disk %s failed, sector=%" PRDSNu, d->name, r->write ? "write" : "read", sec_no);
+            if (!r->write)
+                memcpy(buffer, c->dma_buf, chunk * DISK_SECTOR_SIZE);
+        } else if (r->write) {
+            lock_acquire(&c->lock);
+            select_sector(d, sec_no, 1);
+            c->state = CHAN_PIO_WRITE;
+            issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
+            if (!wait_while_busy(d))
+                PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
+            output_sector(c, buffer);
+            lock_release(&c->lock);
+            sema_down(&c->completion_wait);
+        } else {
+            /* 읽기 완료는 인터럽트 핸들러가 데이터 레지스터까지 비워
+             * 주므로, 여기서는 잠들었다 깨어나면 버퍼가 차 있다. */
+            lock_acquire(&c->lock);
+            select_sector(d, sec_no, 1);
+            c->io_buf = buffer;
+            c->state = CHAN_PIO_READ;
+            issue_pio_command(c, CMD_READ_SECTOR_RETRY);
+            lock_release(&c->lock);
+            sema_down(&c->completion_wait);
+            if (c->io_error) {
+                c->io_error = false;
+                PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, sec_no);
+            }
+        }
+
+        sec_no += chunk;
+        buffer += chunk * DISK_SECTOR_SIZE;
+        cnt -= chunk;
+        if (r->write)
+            d->write_cnt += chunk;
+        else
+            d->read_cnt += chunk;
+    }
+}
+
+/** #Project 3: Request Queue - 채널 디스패처 스레드의 본체. 큐가 비면 잠들고,
+ *  깨어나면 C-LOOK 순서 - 마지막으로 처리한 위치(head_pos) 이후에서 섹터
+ *  번호가 가장 가까운 요청, 없으면 가장 낮은 섹터로 되감기 - 로 요청을
+ *  골라 처리한다. 정렬된 큐를 머리부터 훑으므로 선택은 O(n)이다. */
+static void disk_dispatch(void *c_) {
+    struct channel *c = c_;
+
+    for (;;) {
+        struct disk_request *r = NULL;
+        struct list_elem *e;
+        enum intr_level old_level;
+
+        sema_down(&c->req_sema);
+
+        old_level = intr_disable();
+        for (e = list_begin(&c->req_queue); e != list_end(&c->req_queue); e = list_next(e)) {
+            struct disk_request *q = list_entry(e, struct disk_request, elem);
+
+            if (q->sector >= c->head_pos) {
+                r = q;
+                break;
+            }
+        }
+        if (r == NULL)
+            r = list_entry(list_begin(&c->req_queue), struct disk_request, elem);
+        list_remove(&r->elem);
+        c->queue_depth--;
+        c->head_pos = r->sector + r->cnt;
+        intr_set_level(old_level);
+
+        do_transfer(r);
+        complete_request(r);
+    }
 }
 
 /* Disk detection and identification. */
@@ -276,13 +814,29 @@ static void reset_channel(struct channel *c) {
 
     /* Issue soft reset sequence, which selects device 0 as a side effect.
        Also enable interrupts. */
+    /** #Project 3: Sub-tick Delay - ATA가 요구하는 건 5µs/2ms 오더의
+     *  짧은 유지 시간뿐이다. udelay()/ndelay()는 TSC로 정확히 그만큼만
+     *  돌고, 잠들지 않으므로 리셋 시퀀스의 타이밍을 흐트러뜨리지 않는다. */
     outb(reg_ctl(c), 0);
-    timer_usleep(10);
+    udelay(10);
     outb(reg_ctl(c), CTL_SRST);
-    timer_usleep(10);
+    udelay(10);
     outb(reg_ctl(c), 0);
 
-    timer_msleep(150);
+    /** #Project 3: Boot 가속 - 고정 150ms 대신 상태 레지스터를 1ms
+     *  간격으로 폴링해 장치가 준비되는 즉시 빠져나간다. SRST 해제 후
+     *  2ms까지는 상태를 믿을 수 없으므로 그만큼만 무조건 기다린다.
+     *  장치가 하나도 없으면 기다릴 이유 자체가 없다. */
+    if (present[0] || present[1]) {
+        int i;
+
+        timer_msleep(2);
+        for (i = 0; i < 150; i++) {
+            if (!(inb(reg_alt_status(c)) & STA_BSY))
+                break;
+            timer_msleep(1);
+        }
+    }
 
     /* Wait for device 0 to clear BSY. */
     if (present[0]) {
@@ -295,10 +849,12 @@ static void reset_channel(struct channel *c) {
         int i;
 
         select_device(&c->devices[1]);
-        for (i = 0; i < 3000; i++) {
+        for (i = 0; i < 30000; i++) {
             if (inb(reg_nsect(c)) == 1 && inb(reg_lbal(c)) == 1)
                 break;
-            timer_msleep(10);
+            /* 1ms granularity: 총 한도는 30초 그대로지만 응답하는
+               장치는 첫 폴에서 바로 통과한다. */
+            timer_msleep(1);
         }
         wait_while_busy(&c->devices[1]);
     }
@@ -391,14 +947,15 @@ static void print_ata_string(char *string, size_t size) {
 /* Selects device D, waiting for it to become ready, and then
    writes SEC_NO to the disk's sector selection registers.  (We
    use LBA mode.) */
-static void select_sector(struct disk *d, disk_sector_t sec_no) {
+static void select_sector(struct disk *d, disk_sector_t sec_no, size_t cnt) {
     struct channel *c = d->channel;
 
-    ASSERT(sec_no < d->capacity);
+    ASSERT(cnt > 0 && cnt <= 256);
+    ASSERT(sec_no + cnt <= d->capacity);
     ASSERT(sec_no < (1UL << 28));
 
     select_device_wait(d);
-    outb(reg_nsect(c), 1);
+    outb(reg_nsect(c), cnt & 0xff); /* 0은 256 섹터를 뜻한다. */
     outb(reg_lbal(c), sec_no);
     outb(reg_lbam(c), sec_no >> 8);
     outb(reg_lbah(c), (sec_no >> 16));
@@ -438,10 +995,19 @@ static void output_sector(struct channel *c, const void *sector) {
 static void wait_until_idle(const struct disk *d) {
     int i;
 
+    /** #Project 3: Spin 최소화 - 명령 사이의 채널은 대개 이미 idle이라
+     *  첫 읽기에서 끝난다. 기대 구간(~10µs)까지만 스핀하고, 그 이상은
+     *  장치가 실제로 일하는 중이니 양보하며 폴링한다. */
+    for (i = 0; i < 10; i++) {
+        if ((inb(reg_status(d->channel)) & (STA_BSY | STA_DRQ)) == 0)
+            return;
+        udelay(1);
+    }
+
     for (i = 0; i < 1000; i++) {
         if ((inb(reg_status(d->channel)) & (STA_BSY | STA_DRQ)) == 0)
             return;
-        timer_usleep(10);
+        timer_usleep(200); /* SPIN_MAX_NS 초과: 기한까지 yield 반복 */
     }
 
     printf("%s: idle timeout\n", d->name);
@@ -455,6 +1021,24 @@ static bool wait_while_busy(const struct disk *d) {
     struct channel *c = d->channel;
     int i;
 
+    /** #Project 3: Spin 최소화 - 완료 자체는 인터럽트가 알려 주므로 여기
+     *  올 때 BSY는 보통 수 µs 안에 내려가 있거나 곧 내려간다 (PIO 쓰기의
+     *  첫 DRQ처럼 ATA가 인터럽트를 주지 않는 구간 포함). 그 기대
+     *  구간(100µs)까지만 스핀하고, 이후로는 양보하며 폴링해 장치가
+     *  꾸물거리는 동안 CPU를 계산에 돌려준다. */
+    for (i = 0; i < 100; i++) {
+        if (!(inb(reg_alt_status(c)) & STA_BSY))
+            return (inb(reg_alt_status(c)) & STA_DRQ) != 0;
+        udelay(1);
+    }
+
+    for (i = 0; i < 1000; i++) {
+        if (!(inb(reg_alt_status(c)) & STA_BSY))
+            return (inb(reg_alt_status(c)) & STA_DRQ) != 0;
+        timer_usleep(200); /* SPIN_MAX_NS 초과: 기한까지 yield 반복 */
+    }
+
+    /* 리셋 직후의 장치는 표준상 30초까지 걸릴 수 있다: 틱 단위 수면. */
     for (i = 0; i < 3000; i++) {
         if (i == 700)
             printf("%s: busy, waiting...", d->name);
@@ -478,7 +1062,7 @@ static void select_device(const struct disk *d) {
         dev |= DEV_DEV;
     outb(reg_device(c), dev);
     inb(reg_alt_status(c));
-    timer_nsleep(400);
+    ndelay(400);
 }
 
 /* Select disk D in its channel, as select_device(), but wait for
@@ -496,7 +1080,19 @@ static void interrupt_handler(struct intr_frame *f) {
     for (c = channels; c < channels + CHANNEL_CNT; c++)
         if (f->vec_no == c->irq) {
             if (c->expecting_interrupt) {
-                inb(reg_status(c));           /* Acknowledge interrupt. */
+                uint8_t status = inb(reg_status(c)); /* Acknowledge interrupt. */
+
+                /** #Project 3: 채널 상태 기계 - PIO 읽기의 데이터 레지스터는
+                 *  여기서 바로 비운다. 디스패처는 섹터마다 깨어나 상태를
+                 *  확인하고 다시 레지스터를 읽는 왕복 없이, 깨어나는 즉시
+                 *  다음 명령으로 넘어간다. */
+                if (c->state == CHAN_PIO_READ) {
+                    if ((status & STA_BSY) == 0 && (status & STA_DRQ) != 0)
+                        input_sector(c, c->io_buf);
+                    else
+                        c->io_error = true;
+                }
+                c->state = CHAN_IDLE;
                 sema_up(&c->completion_wait); /* Wake up waiter. */
             } else
                 printf("%s: unexpected interrupt\n", c->name);
@@ -4,6 +4,7 @@
 
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/interrupt.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
@@ -14,7 +15,10 @@ void input_init(void) {
 }
 
 /* Adds a key to the input buffer.
-   Interrupts must be off and the buffer must not be full. */
+   Interrupts must be off and the buffer must not be full.
+   A reader sleeping on an empty buffer is not woken here but by
+   input_notify(), which the interrupt handlers call once per
+   burst of keys. */
 void input_putc(uint8_t key) {
     ASSERT(intr_get_level() == INTR_OFF);
     ASSERT(!intq_full(&buffer));
@@ -23,6 +27,13 @@ void input_putc(uint8_t key) {
     serial_notify();
 }
 
+/* Wakes up a thread sleeping in input_getc(), if any.  Called by
+   the keyboard and serial interrupt handlers after they have
+   queued a whole burst of input. */
+void input_notify(void) {
+    intq_notify(&buffer);
+}
+
 /* Retrieves a key from the input buffer.
    If the buffer is empty, waits for a key to be pressed. */
 uint8_t input_getc(void) {
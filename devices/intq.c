@@ -2,29 +2,25 @@
 
 #include <debug.h>
 
+#include "threads/interrupt.h"
 #include "threads/thread.h"
 
-static int next(int pos);
-static void wait(struct intq *q, struct thread **waiter);
-static void signal(struct intq *q, struct thread **waiter);
+static void wake(struct thread **waiter);
 
 /* Initializes interrupt queue Q. */
 void intq_init(struct intq *q) {
-    lock_init(&q->lock);
     q->not_full = q->not_empty = NULL;
     q->head = q->tail = 0;
 }
 
 /* Returns true if Q is empty, false otherwise. */
 bool intq_empty(const struct intq *q) {
-    ASSERT(intr_get_level() == INTR_OFF);
-    return q->head == q->tail;
+    return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE);
 }
 
 /* Returns true if Q is full, false otherwise. */
 bool intq_full(const struct intq *q) {
-    ASSERT(intr_get_level() == INTR_OFF);
-    return next(q->head) == q->tail;
+    return __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&q->tail, __ATOMIC_ACQUIRE) == INTQ_BUFSIZE;
 }
 
 /* Removes a byte from Q and returns it.
@@ -34,64 +30,70 @@ bool intq_full(const struct intq *q) {
 uint8_t intq_getc(struct intq *q) {
     uint8_t byte;
 
-    ASSERT(intr_get_level() == INTR_OFF);
     while (intq_empty(q)) {
+        enum intr_level old_level;
+
         ASSERT(!intr_context());
-        lock_acquire(&q->lock);
-        wait(q, &q->not_empty);
-        lock_release(&q->lock);
+
+        /* Recheck with interrupts off so a byte (and its notify)
+           arriving between the check and the block cannot be
+           missed. */
+        old_level = intr_disable();
+        if (intq_empty(q)) {
+            q->not_empty = thread_current();
+            thread_block();
+        }
+        intr_set_level(old_level);
     }
 
-    byte = q->buf[q->tail];
-    q->tail = next(q->tail);
-    signal(q, &q->not_full);
+    byte = q->buf[q->tail & (INTQ_BUFSIZE - 1)];
+    __atomic_store_n(&q->tail, q->tail + 1, __ATOMIC_RELEASE);
+    if (q->not_full != NULL)
+        wake(&q->not_full);
     return byte;
 }
 
-/* Adds BYTE to the end of Q.
+/* Adds BYTE to the end of Q, without waking up a consumer
+   sleeping on an empty queue: the producer calls intq_notify()
+   once after enqueueing a whole burst.
    Q must not be full if called from an interrupt handler.
    Otherwise, if Q is full, first sleeps until a byte is
    removed. */
 void intq_putc(struct intq *q, uint8_t byte) {
-    ASSERT(intr_get_level() == INTR_OFF);
     while (intq_full(q)) {
+        enum intr_level old_level;
+
         ASSERT(!intr_context());
-        lock_acquire(&q->lock);
-        wait(q, &q->not_full);
-        lock_release(&q->lock);
-    }
 
-    q->buf[q->head] = byte;
-    q->head = next(q->head);
-    signal(q, &q->not_empty);
-}
+        old_level = intr_disable();
+        if (intq_full(q)) {
+            q->not_full = thread_current();
+            thread_block();
+        }
+        intr_set_level(old_level);
+    }
 
-/* Returns the position after POS within an intq. */
-static int next(int pos) {
-    return (pos + 1) % INTQ_BUFSIZE;
+    q->buf[q->head & (INTQ_BUFSIZE - 1)] = byte;
+    __atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELEASE);
 }
 
-/* WAITER must be the address of Q's not_empty or not_full
-   member.  Waits until the given condition is true. */
-static void wait(struct intq *q UNUSED, struct thread **waiter) {
-    ASSERT(!intr_context());
-    ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT((waiter == &q->not_empty && intq_empty(q)) || (waiter == &q->not_full && intq_full(q)));
-
-    *waiter = thread_current();
-    thread_block();
+/* Wakes up a consumer sleeping on an empty Q, if there is one.
+   Called by the producer after a burst of intq_putc() calls, so a
+   burst costs one wakeup, not one per byte. */
+void intq_notify(struct intq *q) {
+    if (q->not_empty != NULL && !intq_empty(q))
+        wake(&q->not_empty);
 }
 
 /* WAITER must be the address of Q's not_empty or not_full
-   member, and the associated condition must be true.  If a
-   thread is waiting for the condition, wakes it up and resets
-   the waiting thread. */
-static void signal(struct intq *q UNUSED, struct thread **waiter) {
-    ASSERT(intr_get_level() == INTR_OFF);
-    ASSERT((waiter == &q->not_empty && !intq_empty(q)) || (waiter == &q->not_full && !intq_full(q)));
+   member.  If a thread is waiting there, wakes it up and resets
+   the pointer. */
+static void wake(struct thread **waiter) {
+    enum intr_level old_level = intr_disable();
 
     if (*waiter != NULL) {
         thread_unblock(*waiter);
         *waiter = NULL;
     }
+    intr_set_level(old_level);
 }
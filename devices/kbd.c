@@ -8,10 +8,18 @@
 #include "devices/input.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/softirq.h"
 
 /* Keyboard data register port. */
 #define DATA_REG 0x60
 
+/** #Project 3: Softirq - 하드 핸들러가 읽어 둔 생 스캔코드 링 버퍼.
+ *  하드 핸들러만 head를, bottom half만 tail을 움직이는 SPSC 구조라
+ *  별도 잠금이 필요 없다. 크기는 2의 거듭제곱 (마스크 인덱싱). */
+#define KBD_RAW_BUFSIZE 64
+static unsigned raw_buf[KBD_RAW_BUFSIZE];
+static size_t raw_head, raw_tail;
+
 /* Current state of shift keys.
    True if depressed, false otherwise. */
 static bool left_shift, right_shift; /* Left and right Shift keys. */
@@ -26,10 +34,12 @@ static bool caps_lock;
 static int64_t key_cnt;
 
 static intr_handler_func keyboard_interrupt;
+static void kbd_softirq(void);
 
 /* Initializes the keyboard. */
 void kbd_init(void) {
     intr_register_ext(0x21, keyboard_interrupt, "8042 Keyboard");
+    softirq_register(SOFTIRQ_KBD, kbd_softirq);
 }
 
 /* Prints keyboard statistics. */
@@ -66,26 +76,35 @@ static const struct keymap shifted_keymap[] = {
 
 static bool map_key(const struct keymap[], unsigned scancode, uint8_t *);
 
+/** #Project 3: Softirq - 하드 핸들러. 장치에서 스캔코드만 뽑아 링 버퍼에
+ *  넣고 bottom half를 raise한다. 인터럽트 비활성 구간이 포트 읽기 두 번
+ *  이하로 줄어든다. */
 static void keyboard_interrupt(struct intr_frame *args UNUSED) {
+    /* Read scancode, including second byte if prefix code. */
+    unsigned code = inb(DATA_REG);
+    if (code == 0xe0)
+        code = (code << 8) | inb(DATA_REG);
+
+    if (raw_head - raw_tail < KBD_RAW_BUFSIZE) {
+        raw_buf[raw_head++ & (KBD_RAW_BUFSIZE - 1)] = code;
+        softirq_raise(SOFTIRQ_KBD);
+    }
+}
+
+/** #Project 3: Softirq - bottom half. 버퍼에 쌓인 스캔코드를 인터럽트가
+ *  켜진 채로 해석하여 입력 큐에 넣는다. (기존 하드 핸들러 본문 이동) */
+static void kbd_decode(unsigned code) {
     /* Status of shift keys. */
     bool shift = left_shift || right_shift;
     bool alt = left_alt || right_alt;
     bool ctrl = left_ctrl || right_ctrl;
 
-    /* Keyboard scancode. */
-    unsigned code;
-
     /* False if key pressed, true if key released. */
     bool release;
 
     /* Character that corresponds to `code'. */
     uint8_t c;
 
-    /* Read scancode, including second byte if prefix code. */
-    code = inb(DATA_REG);
-    if (code == 0xe0)
-        code = (code << 8) | inb(DATA_REG);
-
     /* Bit 0x80 distinguishes key press from key release
        (even if there's a prefix). */
     release = (code & 0x80) != 0;
@@ -113,11 +132,15 @@ static void keyboard_interrupt(struct intr_frame *args UNUSED) {
             if (alt)
                 c += 0x80;
 
-            /* Append to keyboard buffer. */
+            /** #Project 3: Softirq - 입력 큐에 넣는다. 시리얼 수신
+             *  인터럽트도 같은 큐에 넣으므로 넣는 동안만 인터럽트를
+             *  끈다. */
+            enum intr_level old_level = intr_disable();
             if (!input_full()) {
                 key_cnt++;
                 input_putc(c);
             }
+            intr_set_level(old_level);
         }
     } else {
         /* Maps a keycode into a shift state variable. */
@@ -142,6 +165,14 @@ static void keyboard_interrupt(struct intr_frame *args UNUSED) {
     }
 }
 
+/** #Project 3: Softirq - 하드 핸들러가 쌓아 둔 스캔코드를 전부 소모한 뒤
+ *  한 번만 소비자를 깨운다 (burst당 wakeup 한 번). */
+static void kbd_softirq(void) {
+    while (raw_tail != raw_head)
+        kbd_decode(raw_buf[raw_tail++ & (KBD_RAW_BUFSIZE - 1)]);
+    input_notify();
+}
+
 /* Scans the array of keymaps K for SCANCODE.
    If found, sets *C to the corresponding character and returns
    true.
@@ -1,9 +1,9 @@
 #include "devices/serial.h"
 
 #include <debug.h>
+#include <string.h>
 
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
@@ -53,8 +53,19 @@
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/** #Project 3: Buffered TX - 송신 출력 링. 쓰는 쪽은 memcpy만 하고 바로
+ *  돌아가며, 실제 전송은 TX 인터럽트가 FIFO 깊이만큼씩 몰아서 한다.
+ *  head/tail은 자유 증가 인덱스로, 버퍼 접근 시에만 마스크한다. */
+#define TXBUF_SIZE 4096 /* Must be a power of 2. */
+#define UART_FIFO_DEPTH 16
+static uint8_t txbuf[TXBUF_SIZE];
+static size_t tx_head; /* New data is written here. */
+static size_t tx_tail; /* Data is transmitted from here. */
+
+/* Returns true if the transmit ring is empty. */
+static bool txbuf_empty(void) {
+    return tx_head == tx_tail;
+}
 
 static void set_serial(int bps);
 static void putc_poll(uint8_t);
@@ -68,10 +79,10 @@ static intr_handler_func serial_interrupt;
 static void init_poll(void) {
     ASSERT(mode == UNINIT);
     outb(IER_REG, 0);        /* Turn off all interrupts. */
-    outb(FCR_REG, 0);        /* Disable FIFO. */
+    outb(FCR_REG, 0x07);     /* Enable and clear FIFOs, so a THRE
+                                interrupt accepts a 16-byte burst. */
     set_serial(115200);      /* 115.2 kbps, N-8-1. */
     outb(MCR_REG, MCR_OUT2); /* Required to enable interrupts. */
-    intq_init(&txq);
     mode = POLL;
 }
 
@@ -105,28 +116,63 @@ void serial_putc(uint8_t byte) {
     } else {
         /* Otherwise, queue a byte and update the interrupt enable
            register. */
-        if (old_level == INTR_OFF && intq_full(&txq)) {
-            /* Interrupts are off and the transmit queue is full.
-               If we wanted to wait for the queue to empty,
-               we'd have to reenable interrupts.
-               That's impolite, so we'll send a character via
-               polling instead. */
-            putc_poll(intq_getc(&txq));
+        if (tx_head - tx_tail == TXBUF_SIZE) {
+            /* The ring is full.  Transmit one byte by polling to
+               make room; waiting politely would mean reenabling
+               interrupts, which the caller may not tolerate. */
+            putc_poll(txbuf[tx_tail++ & (TXBUF_SIZE - 1)]);
         }
 
-        intq_putc(&txq, byte);
+        txbuf[tx_head++ & (TXBUF_SIZE - 1)] = byte;
         write_ier();
     }
 
     intr_set_level(old_level);
 }
 
+/** #Project 3: Buffered TX - N바이트를 출력 링에 한꺼번에 넣는다. 링이
+ *  가득 차지 않는 한 비용은 memcpy 한두 번과 IER 갱신뿐이고, 전송은 TX
+ *  인터럽트가 뒤에서 처리한다. putbuf()류의 콘솔 출력 핫패스용. */
+void serial_write(const char *buffer, size_t n) {
+    enum intr_level old_level;
+
+    if (mode != QUEUE) {
+        while (n-- > 0)
+            serial_putc(*buffer++);
+        return;
+    }
+
+    old_level = intr_disable();
+    while (n > 0) {
+        size_t space = TXBUF_SIZE - (tx_head - tx_tail);
+        size_t ofs = tx_head & (TXBUF_SIZE - 1);
+        size_t chunk = n;
+
+        if (space == 0) {
+            /* Full: drain one byte by polling, as in serial_putc(). */
+            putc_poll(txbuf[tx_tail++ & (TXBUF_SIZE - 1)]);
+            continue;
+        }
+        if (chunk > space)
+            chunk = space;
+        if (chunk > TXBUF_SIZE - ofs)
+            chunk = TXBUF_SIZE - ofs; /* Don't wrap within one copy. */
+
+        memcpy(txbuf + ofs, buffer, chunk);
+        tx_head += chunk;
+        buffer += chunk;
+        n -= chunk;
+    }
+    write_ier();
+    intr_set_level(old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
-   mode. */
+   mode.  Also the panic path: it makes no use of interrupts. */
 void serial_flush(void) {
     enum intr_level old_level = intr_disable();
-    while (!intq_empty(&txq))
-        putc_poll(intq_getc(&txq));
+    while (!txbuf_empty())
+        putc_poll(txbuf[tx_tail++ & (TXBUF_SIZE - 1)]);
     intr_set_level(old_level);
 }
 
@@ -166,7 +212,7 @@ static void write_ier(void) {
 
     /* Enable transmit interrupt if we have any characters to
        transmit. */
-    if (!intq_empty(&txq))
+    if (!txbuf_empty())
         ier |= IER_XMIT;
 
     /* Enable receive interrupt if we have room to store any
@@ -194,14 +240,20 @@ static void serial_interrupt(struct intr_frame *f UNUSED) {
     inb(IIR_REG);
 
     /* As long as we have room to receive a byte, and the hardware
-       has a byte for us, receive a byte.  */
+       has a byte for us, receive a byte.  The reader is woken once
+       for the whole burst below, not per byte. */
     while (!input_full() && (inb(LSR_REG) & LSR_DR) != 0)
         input_putc(inb(RBR_REG));
+    input_notify();
+
+    /* As long as we have bytes to transmit and the transmit FIFO
+       is empty, stuff a whole FIFO's worth at a time. */
+    while (!txbuf_empty() && (inb(LSR_REG) & LSR_THRE) != 0) {
+        int i;
 
-    /* As long as we have a byte to transmit, and the hardware is
-       ready to accept a byte for transmission, transmit a byte. */
-    while (!intq_empty(&txq) && (inb(LSR_REG) & LSR_THRE) != 0)
-        outb(THR_REG, intq_getc(&txq));
+        for (i = 0; i < UART_FIFO_DEPTH && !txbuf_empty(); i++)
+            outb(THR_REG, txbuf[tx_tail++ & (TXBUF_SIZE - 1)]);
+    }
 
     /* Update interrupt enable register based on queue status. */
     write_ier();
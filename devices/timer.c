@@ -4,9 +4,13 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include <syscall-nr.h>
 
+#include "intrinsic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/palloc.h"
+#include "threads/softirq.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
 
@@ -22,48 +26,157 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
-/* Number of loops per timer tick.
-   Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+/** #Project 3: Tickless Idle - 한 틱에 해당하는 8254 카운트와 one-shot으로
+ *  건너뛸 수 있는 최대 틱 수 (16-bit 카운터 한계 ≈ 55ms). */
+#define PIT_COUNT_PER_TICK ((1193180 + TIMER_FREQ / 2) / TIMER_FREQ)
+#define TICKLESS_MAX_SKIP 5
+
+/* 0이면 주기 모드, 양수면 그만큼의 틱을 건너뛰는 one-shot이 걸려 있음 */
+static int64_t tickless_skip;
+
+/** #Project 3: TSC 시계 - 틱당 TSC 사이클 수와 부팅 기준 TSC.
+ *  timer_calibrate()가 PIT 틱에 대고 한 번 재고, 이후 ktime_ns()는
+ *  rdtsc만 읽는다. */
+#define KTIME_CAL_TICKS 5                          // 보정에 쓰는 틱 수
+#define NS_PER_TICK (1000000000 / TIMER_FREQ)
+
+/** #Project 3: Sub-tick Delay - 틱 미만 대기 중 이 길이(100µs)까지만
+ *  spin하고, 그보다 길면 기한까지 yield한다. */
+#define SPIN_MAX_NS 100000
+static uint64_t tsc_per_tick;
+static uint64_t boot_tsc;
+
+/** #Project 3: vDSO 시간 페이지 - 유저 공간에 읽기 전용으로 매핑될 커널
+ *  페이지. 보정값은 timer_calibrate()가 한 번 채우고, ticks만 타이머
+ *  인터럽트가 다시 publish한다. 갱신이 8바이트 정렬 store 하나뿐이라
+ *  유저 쪽 독자는 락 없이 읽어도 찢긴 값을 볼 수 없다. */
+static struct vdso_time *vdso_time;
+
+/** #Project 3: Kernel Timer - 커널 콜백용 타이머 휠. 잠든 스레드의 휠
+ *  (thread.c)과 같은 구조로, 만료 틱의 하위 비트로 버킷을 고른다. 만료된
+ *  타이머는 ready 리스트로 옮겨지고 콜백은 타이머 softirq에서 돈다. 주기
+ *  유지보수 작업 하나가 스레드 한 장 대신 리스트 연산 몇 번이 된다. */
+#define KTIMER_WHEEL_SIZE 64
+
+static struct list ktimer_wheel[KTIMER_WHEEL_SIZE];
+static struct list ktimer_ready;
+static size_t ktimer_cnt;  // 휠에 걸린 타이머 수 (ready 제외)
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops(unsigned loops);
-static void busy_wait(int64_t loops);
 static void real_time_sleep(int64_t num, int32_t denom);
+static void ktimer_softirq(void);
+
+/** #Project 3: Tickless Idle - counter 0을 MODE로 COUNT 카운트만큼 설정.
+ *  CW: counter 0(00), LSB then MSB(11), mode(MMM), binary(0). */
+static void pit_program(uint8_t mode, uint16_t count) {
+    outb(0x43, 0x30 | (mode << 1));
+    outb(0x40, count & 0xff);  // 하위 8 Bit ** 8bit bus로 연결되어 있음
+    outb(0x40, count >> 8);    // 상위 8 Bit
+}
 
 /* 초당 100 회 인터럽트하도록 8254 Programmable Interval Timer (PIT) 설정 및 인터럽트 등록 */
 void timer_init(void) {
     /* 8254 입력 주파수를 TIMER_FREQ로 나눠서 가장 가까운 값으로 반올림
        PC가 1초에 1193180 Hz의 클럭 신호를 발생시키기 때문에 1초에 100번 인터럽트를 발생시키게 하기 위한 값 */
-    uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;  //
-    outb(0x43, 0x34);                                          /* CW: counter 0(00), LSB then MSB(11), mode 2(010), binary(0). */
-    outb(0x40, count & 0xff);                                  // 하위 8 Bit 체크 ** 8bit bus로 연결되어 있음
-    outb(0x40, count >> 8);                                    // 상위 8 Bit 체크
+    pit_program(2, PIT_COUNT_PER_TICK); /* mode 2: rate generator */
 
     intr_register_ext(0x20, timer_interrupt, "8254 Timer");  // 외부 인터럽트 핸들러를 호출하기 위한 VEC Number 등록
+
+    /** #Project 3: Kernel Timer - 휠 초기화 및 softirq 등록 */
+    for (int i = 0; i < KTIMER_WHEEL_SIZE; i++)
+        list_init(&ktimer_wheel[i]);
+    list_init(&ktimer_ready);
+    softirq_register(SOFTIRQ_TIMER, ktimer_softirq);
 }
 
-/* Pintos 구동 사양에 맞게 loops_per_tick 보정 */
-void timer_calibrate(void) {
-    unsigned high_bit, test_bit;
+/** #Project 3: Tickless Idle - idle 진입 직전(HLT 전, 인터럽트 비활성)에
+ *  호출. 타이머 휠에서 다음 깨울 시각을 구해 그 직전까지 one-shot으로
+ *  건너뛰어, 전부 잠든 동안 주기 틱으로 깨어나지 않게 한다. mlfqs는
+ *  틱마다 decay 계산이 있어 제외한다. */
+void timer_enter_idle(void) {
+    if (thread_mlfqs || tickless_skip > 0)
+        return;
+
+    /** #Project 3: Kernel Timer - 걸려 있는 커널 타이머가 있으면 틱을
+     *  건너뛰지 않는다. 만료 틱 계산까지 하기엔 idle 진입이 너무 잦다. */
+    if (ktimer_cnt != 0)
+        return;
+
+    int64_t wake = thread_earliest_wakeup();
+    int64_t skip = wake == INT64_MAX ? TICKLESS_MAX_SKIP : wake - ticks;
+    if (skip > TICKLESS_MAX_SKIP)
+        skip = TICKLESS_MAX_SKIP;
+    if (skip <= 1)
+        return;
+
+    tickless_skip = skip;
+    pit_program(0, skip * PIT_COUNT_PER_TICK); /* mode 0: one-shot */
+}
 
+/** #Project 3: TSC 시계 - PIT 틱 KTIME_CAL_TICKS개에 걸친 TSC 증가량으로
+ *  틱당 사이클 수를 한 번만 잰다. 예전의 loops_per_tick 이진 탐색(수십 틱
+ *  소모)을 대체하며, 틱 미만 대기도 이제 이 시계로 돈다. */
+void timer_calibrate(void) {
     ASSERT(intr_get_level() == INTR_ON);
     printf("Calibrating timer...  ");
 
-    /* 1024부터 근사한 2의 거듭제곱으로 loops_per_tick 상승 */
-    loops_per_tick = 1u << 10;
-    while (!too_many_loops(loops_per_tick << 1)) {
-        loops_per_tick <<= 1;
-        ASSERT(loops_per_tick != 0);
+    /* 틱 경계에 맞춘 뒤 KTIME_CAL_TICKS 틱 동안의 TSC 증가량 측정 */
+    int64_t start = ticks;
+    while (ticks == start)
+        barrier();
+
+    uint64_t tsc_start = rdtsc();
+    start = ticks;
+    while (ticks - start < KTIME_CAL_TICKS)
+        barrier();
+
+    tsc_per_tick = (rdtsc() - tsc_start) / KTIME_CAL_TICKS;
+    boot_tsc = rdtsc() - (uint64_t)ticks * tsc_per_tick;
+
+    /** #Project 3: vDSO 시간 페이지 - 보정이 끝났으니 페이지를 만든다.
+     *  magic은 나머지 필드가 모두 보인 뒤에 써야 하므로 맨 마지막이다.
+     *  할당 실패 시 페이지 없이 부팅하고 process.c는 매핑을 건너뛴다. */
+    struct vdso_time *vp = palloc_get_page(PAL_ZERO);
+    if (vp != NULL) {
+        vp->ticks = ticks;
+        vp->boot_tsc = boot_tsc;
+        vp->tsc_per_tick = tsc_per_tick;
+        vp->ns_per_tick = NS_PER_TICK;
+        barrier();
+        vp->magic = VDSO_TIME_MAGIC;
+        vdso_time = vp;
     }
 
-    /* loops_per_tick의 다음 8 bit 다듬기 */
-    high_bit = loops_per_tick;
-    for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-        if (!too_many_loops(high_bit | test_bit))
-            loops_per_tick |= test_bit;
+    printf("%'" PRIu64 " cycles/s.\n", tsc_per_tick * TIMER_FREQ);
+}
+
+/** #Project 3: Boot Timing - TSC 사이클 수를 마이크로초로 변환.
+ *  보정 전에 찍은 구간도 보정만 끝나면 변환할 수 있도록 원시 사이클을
+ *  받는다. 보정 전 호출이면 0을 반환한다. */
+int64_t timer_cycles_to_us(uint64_t cycles) {
+    if (tsc_per_tick == 0)
+        return 0;
+
+    uint64_t us_per_tick = 1000000 / TIMER_FREQ;
+    return (cycles / tsc_per_tick) * us_per_tick + (cycles % tsc_per_tick) * us_per_tick / tsc_per_tick;
+}
+
+/** #Project 3: TSC 시계 - 부팅 이후 경과 시간을 나노초로 반환. rdtsc 한 번
+ *  뿐이라 락 hold time, syscall 지연 측정 같은 계측 경로에서 마음껏 불러도
+ *  된다. 보정 전(timer_calibrate() 이전)에는 0을 반환한다. */
+int64_t ktime_ns(void) {
+    if (tsc_per_tick == 0)
+        return 0;
+
+    /* (delta * NS_PER_TICK)의 오버플로를 피하려고 몫/나머지로 나눠 계산 */
+    uint64_t delta = rdtsc() - boot_tsc;
+    return (delta / tsc_per_tick) * NS_PER_TICK + (delta % tsc_per_tick) * NS_PER_TICK / tsc_per_tick;
+}
 
-    printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+/** #Project 3: vDSO 시간 페이지 - 유저 매핑용 커널 페이지를 반환한다.
+ *  보정 전이거나 할당에 실패했으면 NULL. */
+void *timer_vdso_page(void) {
+    return vdso_time;
 }
 
 /* OS 부팅 이후 타이머 틱 수 반환 */
@@ -109,60 +222,168 @@ void timer_nsleep(int64_t ns) {
     real_time_sleep(ns, 1000 * 1000 * 1000);
 }
 
+/** #Project 3: Sub-tick Delay - 기한까지 TSC만 보고 도는 busy-wait.
+ *  잠들지도 양보하지도 않으므로 인터럽트가 꺼진 구간에서도 쓸 수 있고,
+ *  폴링 루프의 한 바퀴 간격처럼 짧고 정확해야 하는 대기에 맞다.
+ *  보정 전(timer_calibrate() 이전)에는 시계가 없으므로 그냥 돌아온다. */
+void ndelay(int64_t ns) {
+    if (tsc_per_tick == 0)
+        return;
+
+    int64_t deadline = ktime_ns() + ns;
+    while (ktime_ns() < deadline)
+        __asm __volatile("pause" : : : "memory");
+}
+
+/** #Project 3: Sub-tick Delay - ndelay()의 마이크로초 단위 표기 */
+void udelay(int64_t us) {
+    ndelay(us * 1000);
+}
+
 /* 타이머 상태 출력 */
 void timer_print_stats(void) {
     printf("Timer: %" PRId64 " ticks\n", timer_ticks());
 }
 
 /* 타이머 인터럽트 핸들러 */
-static void timer_interrupt(struct intr_frame *args UNUSED) {
+static void timer_interrupt(struct intr_frame *args) {
+    /** #Project 3: Sampling Profiler - 중단된 rip을 스레드별 링에 기록 */
+    if (rip_prof_active)
+        thread_sample_rip(args->rip);
+
+    /** #Project 3: Tickless Idle - one-shot 만료. 건너뛴 틱들을 버킷별로
+     *  따라잡고 주기 모드로 복귀한다. */
+    if (tickless_skip > 0) {
+        while (--tickless_skip > 0) {
+            ticks++;
+            thread_awake(ticks);
+        }
+        pit_program(2, PIT_COUNT_PER_TICK);
+    }
+
     ticks++;
     thread_tick();
 
+    /** #Project 3: vDSO 시간 페이지 - 건너뛴 틱까지 합산된 최종 값만
+     *  publish하면 된다. */
+    if (vdso_time != NULL)
+        vdso_time->ticks = ticks;
+
     /** #Advanced Scheduler mlfqs 스케줄러의 경우 */
     if (thread_mlfqs) {
         mlfqs_increment();
 
-        if (!(ticks % 4)) {
-            mlfqs_recalc_priority();
+        /** #Project 3: Incremental MLFQS - 전체 스레드 순회 대신 현재
+         *  스레드만 갱신한다. 나머지는 다시 주목받을 때 decay를 접는다
+         *  (thread.c의 mlfqs_fold). */
+        if (!(ticks % 4))
+            mlfqs_priority(thread_current());
 
-            if (!(ticks % TIMER_FREQ)) {
-                mlfqs_load_avg();
-                mlfqs_recalc_recent_cpu();
+        if (!(ticks % TIMER_FREQ))
+            mlfqs_load_avg();
+    }
+
+    /** #Alarm Clock 타이머 휠에서 지금 틱에 만료되는 버킷만 확인하여 활성화 */
+    thread_awake(ticks);
+
+    /** #Project 3: Kernel Timer - 지금 틱 버킷의 만료 타이머를 ready로
+     *  옮기고 softirq를 올린다. 콜백 실행은 ksoftirqd로 미룬다. */
+    if (ktimer_cnt != 0) {
+        struct list *bucket = &ktimer_wheel[ticks & (KTIMER_WHEEL_SIZE - 1)];
+        struct list_elem *e = list_begin(bucket);
+        bool raised = false;
+
+        while (e != list_end(bucket)) {
+            struct ktimer *t = list_entry(e, struct ktimer, elem);
+
+            e = list_next(e);
+            if (ticks >= t->expires) {  // 휠 한 바퀴 이상 남은 건 제자리에
+                list_remove(&t->elem);
+                ktimer_cnt--;
+                t->ready = true;
+                list_push_back(&ktimer_ready, &t->elem);
+                raised = true;
             }
         }
+        if (raised)
+            softirq_raise(SOFTIRQ_TIMER);
     }
+}
+
+/** #Project 3: Kernel Timer - 타이머 softirq. ready 리스트의 콜백을
+ *  인터럽트가 켜진 채로 실행한다. 주기 타이머는 콜백 실행 전에 재장전해,
+ *  콜백이 오래 걸려도 다음 주기를 놓치지 않는다. */
+static void ktimer_softirq(void) {
+    for (;;) {
+        enum intr_level old_level = intr_disable();
 
-    /** #Alarm Clock 현재 활성화되어야 하는 thread가 있는지 탐색하여 활성화 */
-    if (get_next_tick_to_awake() <= ticks)
-        thread_awake(ticks);
+        if (list_empty(&ktimer_ready)) {
+            intr_set_level(old_level);
+            break;
+        }
+
+        struct ktimer *t = list_entry(list_pop_front(&ktimer_ready), struct ktimer, elem);
+        t->ready = false;
+        if (t->period > 0) {
+            t->expires = ticks + t->period;
+            list_push_back(&ktimer_wheel[t->expires & (KTIMER_WHEEL_SIZE - 1)], &t->elem);
+            ktimer_cnt++;
+        } else
+            t->active = false;
+        intr_set_level(old_level);
+
+        t->func(t->aux);
+    }
 }
 
-/* loop가 1개 초과시 true 반환 */
-static bool too_many_loops(unsigned loops) {
-    /* Wait for a timer tick. */
-    int64_t start = ticks;
-    while (ticks == start)
-        barrier();
+/** #Project 3: Kernel Timer - 타이머 객체 초기화. 시작은 ktimer_start(). */
+void ktimer_init(struct ktimer *t, ktimer_func *func, void *aux) {
+    t->func = func;
+    t->aux = aux;
+    t->expires = 0;
+    t->period = 0;
+    t->active = false;
+    t->ready = false;
+}
 
-    /* Run LOOPS loops. */
-    start = ticks;
-    busy_wait(loops);
+/** #Project 3: Kernel Timer - DELAY 틱 뒤에 만료하도록 건다. PERIOD가
+ *  양수면 만료 때마다 PERIOD 틱 간격으로 재장전되는 주기 타이머가 된다.
+ *  이미 걸려 있으면 새 시각으로 다시 건다. */
+void ktimer_start(struct ktimer *t, int64_t delay, int64_t period) {
+    enum intr_level old_level = intr_disable();
 
-    /* If the tick count changed, we iterated too long. */
-    barrier();
-    return start != ticks;
+    if (t->active) {
+        list_remove(&t->elem);
+        if (!t->ready)
+            ktimer_cnt--;
+    }
+    t->expires = ticks + (delay > 0 ? delay : 1);
+    t->period = period;
+    t->active = true;
+    t->ready = false;
+    list_push_back(&ktimer_wheel[t->expires & (KTIMER_WHEEL_SIZE - 1)], &t->elem);
+    ktimer_cnt++;
+
+    intr_set_level(old_level);
 }
 
-/* 짧은 지연을 구현하기 위해 간단한 루프 LOOPS 회 반복
+/** #Project 3: Kernel Timer - 타이머를 내린다(O(1)). 아직 걸려 있었으면
+ *  true. 이미 실행 중인 콜백까지 막지는 못하므로, 콜백과 공유하는 상태는
+ *  호출자가 따로 정리해야 한다. */
+bool ktimer_cancel(struct ktimer *t) {
+    enum intr_level old_level = intr_disable();
+    bool was_active = t->active;
+
+    if (t->active) {
+        list_remove(&t->elem);
+        if (!t->ready)
+            ktimer_cnt--;
+        t->active = false;
+        t->ready = false;
+    }
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE busy_wait(int64_t loops) {
-    while (loops-- > 0)
-        barrier();
+    intr_set_level(old_level);
+    return was_active;
 }
 
 /* 대략 NUM/DENOM seconds 동안 sleep */
@@ -181,11 +402,19 @@ static void real_time_sleep(int64_t num, int32_t denom) {
            timer_sleep() because it will yield the CPU to other
            processes. */
         timer_sleep(ticks);
-    } else {
-        /* Otherwise, use a busy-wait loop for more accurate
-           sub-tick timing.  We scale the numerator and denominator
-           down by 1000 to avoid the possibility of overflow. */
-        ASSERT(denom % 1000 == 0);
-        busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+    } else if (tsc_per_tick != 0) {
+        /** #Project 3: Sub-tick Delay - 틱 미만 대기는 길이에 따라 나눈다.
+         *  SPIN_MAX_NS 이하는 ndelay()로 spin하고, 그보다 긴 대기(예:
+         *  TIMER_FREQ=100에서의 timer_msleep(1))는 기한까지 yield를
+         *  반복한다. 예전에는 후자도 pause spin이라 밀리초급 CPU를
+         *  통째로 태웠다. (보정 전에는 예전과 마찬가지로 그냥 돌아온다.) */
+        int64_t ns = num * (1000000000 / denom);
+        if (ns <= SPIN_MAX_NS) {
+            ndelay(ns);
+        } else {
+            int64_t deadline = ktime_ns() + ns;
+            while (ktime_ns() < deadline)
+                thread_yield();
+        }
     }
 }
@@ -1,10 +1,15 @@
 #include "filesys/directory.h"
 #include <stdio.h>
 #include <string.h>
+#include <hash.h>
 #include <list.h>
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/page_cache.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/synch.h"
 
 /* A directory. */
 struct dir {
@@ -19,6 +24,215 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* The entries of a directory form an open-addressed hash table
+ * keyed on the file name: an entry lives in the slot its name
+ * hashes to, or is linearly probed a few slots past it.  A slot
+ * whose inode_sector is zero has never held an entry and ends a
+ * probe chain; a removed entry keeps its old sector number, so
+ * the chain stays intact and the slot can be reused.  Lookup and
+ * insertion touch a handful of cached sectors regardless of how
+ * many entries the directory holds.  When an insertion cannot
+ * find a free slot within DIR_MAX_PROBE steps the table doubles
+ * and rehashes, which also clears accumulated tombstones. */
+#define DIR_MAX_PROBE 8
+
+/* Returns the number of entry slots in DIR. */
+static size_t
+dir_capacity (const struct dir *dir) {
+	return inode_length (dir->inode) / sizeof (struct dir_entry);
+}
+
+/* Reads slot IDX of DIR into E.  Returns true on success. */
+static bool
+read_slot (const struct dir *dir, size_t idx, struct dir_entry *e) {
+	return inode_read_at (dir->inode, e, sizeof *e, idx * sizeof *e)
+		== sizeof *e;
+}
+
+/* Doubles DIR's slot count and reinserts every entry at its new
+ * home, dropping the tombstones left behind by removals.
+ * Returns true on success. */
+static bool
+dir_rehash (struct dir *dir) {
+	size_t cap = dir_capacity (dir);
+	size_t new_cap = cap * 2;
+	struct dir_entry *old_tbl, *new_tbl;
+	bool success = false;
+	size_t i;
+
+	old_tbl = malloc (cap * sizeof *old_tbl);
+	new_tbl = calloc (new_cap, sizeof *new_tbl);
+	if (old_tbl == NULL || new_tbl == NULL)
+		goto done;
+	if (inode_read_at (dir->inode, old_tbl, cap * sizeof *old_tbl, 0)
+			!= (off_t) (cap * sizeof *old_tbl))
+		goto done;
+
+	for (i = 0; i < cap; i++) {
+		struct dir_entry *e = &old_tbl[i];
+		size_t j;
+
+		if (!e->in_use)
+			continue;
+		for (j = 0; j < new_cap; j++) {
+			struct dir_entry *slot
+				= &new_tbl[(hash_string (e->name) + j) % new_cap];
+
+			if (!slot->in_use) {
+				*slot = *e;
+				break;
+			}
+		}
+	}
+
+	success = inode_write_at (dir->inode, new_tbl,
+			new_cap * sizeof *new_tbl, 0)
+		== (off_t) (new_cap * sizeof *new_tbl);
+done:
+	free (old_tbl);
+	free (new_tbl);
+	return success;
+}
+
+/* Dentry cache: maps (directory, name) to the sector of the inode
+ * the name resolves to, so resolving a warm path reads no
+ * directory sectors at all.  dir_add and dir_remove keep it
+ * coherent; rehashing does not, and need not, touch it, since it
+ * only moves entries between slots.  The cache is bounded and
+ * evicts in insertion order. */
+#define DENTRY_CACHE_SIZE 64
+
+struct dentry {
+	disk_sector_t dir_sector;           /* Directory's inode sector. */
+	char name[NAME_MAX + 1];            /* Name within the directory. */
+	disk_sector_t inode_sector;         /* What the name resolves to. */
+	struct hash_elem helem;             /* Element in dentry_cache. */
+	struct list_elem lelem;             /* In dentry_fifo, oldest first. */
+};
+
+static struct hash dentry_cache;
+static struct list dentry_fifo;
+static size_t dentry_cnt;
+static struct lock dentry_lock;
+
+/* Returns a hash for the dentry's (directory, name) key. */
+static uint64_t
+dentry_hash (const struct hash_elem *e_, void *aux UNUSED) {
+	const struct dentry *e = hash_entry (e_, struct dentry, helem);
+	return hash_word (e->dir_sector) ^ hash_string (e->name);
+}
+
+/* Orders dentries by directory, then name. */
+static bool
+dentry_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct dentry *a = hash_entry (a_, struct dentry, helem);
+	const struct dentry *b = hash_entry (b_, struct dentry, helem);
+
+	if (a->dir_sector != b->dir_sector)
+		return a->dir_sector < b->dir_sector;
+	return strcmp (a->name, b->name) < 0;
+}
+
+/* Memory-pressure shrinker: evicts the oldest dentries until about
+ * GOAL pages' worth of them have been freed.  Dentries are cheap to
+ * rebuild -- a cold lookup just rereads directory sectors -- so the
+ * cache gives its memory up readily when the pools run dry. */
+static size_t
+dentry_shrink (size_t goal, void *aux UNUSED) {
+	size_t target = goal * (PGSIZE / sizeof (struct dentry));
+	size_t n = 0;
+
+	lock_acquire (&dentry_lock);
+	while (n < target && !list_empty (&dentry_fifo)) {
+		struct dentry *d = list_entry (list_pop_front (&dentry_fifo),
+				struct dentry, lelem);
+
+		hash_delete (&dentry_cache, &d->helem);
+		free (d);
+		dentry_cnt--;
+		n++;
+	}
+	lock_release (&dentry_lock);
+	return n * sizeof (struct dentry) / PGSIZE;
+}
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	hash_init (&dentry_cache, dentry_hash, dentry_less, NULL);
+	list_init (&dentry_fifo);
+	lock_init (&dentry_lock);
+	palloc_register_shrinker (dentry_shrink, NULL, "dentry");
+}
+
+/* Returns the cached dentry for NAME in the directory at
+ * DIR_SECTOR, or a null pointer.  Caller must hold dentry_lock. */
+static struct dentry *
+dentry_find (disk_sector_t dir_sector, const char *name) {
+	struct dentry key;
+	struct hash_elem *h;
+
+	key.dir_sector = dir_sector;
+	strlcpy (key.name, name, sizeof key.name);
+	h = hash_find (&dentry_cache, &key.helem);
+	return h != NULL ? hash_entry (h, struct dentry, helem) : NULL;
+}
+
+/* Caches NAME in the directory at DIR_SECTOR as resolving to
+ * INODE_SECTOR, evicting the oldest dentry if the cache is full.
+ * A failed allocation just skips the caching. */
+static void
+dentry_insert (disk_sector_t dir_sector, const char *name,
+		disk_sector_t inode_sector) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dentry_lock);
+	d = dentry_find (dir_sector, name);
+	if (d == NULL) {
+		if (dentry_cnt >= DENTRY_CACHE_SIZE) {
+			d = list_entry (list_pop_front (&dentry_fifo),
+					struct dentry, lelem);
+			hash_delete (&dentry_cache, &d->helem);
+			dentry_cnt--;
+		} else
+			d = malloc (sizeof *d);
+		if (d != NULL) {
+			d->dir_sector = dir_sector;
+			strlcpy (d->name, name, sizeof d->name);
+			hash_insert (&dentry_cache, &d->helem);
+			list_push_back (&dentry_fifo, &d->lelem);
+			dentry_cnt++;
+		}
+	}
+	if (d != NULL)
+		d->inode_sector = inode_sector;
+	lock_release (&dentry_lock);
+}
+
+/* Drops any cached dentry for NAME in the directory at
+ * DIR_SECTOR. */
+static void
+dentry_drop (disk_sector_t dir_sector, const char *name) {
+	struct dentry *d;
+
+	if (strlen (name) > NAME_MAX)
+		return;
+
+	lock_acquire (&dentry_lock);
+	d = dentry_find (dir_sector, name);
+	if (d != NULL) {
+		hash_delete (&dentry_cache, &d->helem);
+		list_remove (&d->lelem);
+		dentry_cnt--;
+		free (d);
+	}
+	lock_release (&dentry_lock);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -79,24 +293,68 @@ dir_get_inode (struct dir *dir) {
 static bool
 lookup (const struct dir *dir, const char *name,
 		struct dir_entry *ep, off_t *ofsp) {
-	struct dir_entry e;
-	size_t ofs;
+	size_t cap = dir_capacity (dir);
+	size_t hash, i;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
 
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
+	if (cap == 0)
+		return false;
+
+	hash = hash_string (name);
+	for (i = 0; i < cap; i++) {
+		size_t idx = (hash + i) % cap;
+		struct dir_entry e;
+
+		if (!read_slot (dir, idx, &e))
+			return false;
 		if (e.in_use && !strcmp (name, e.name)) {
 			if (ep != NULL)
 				*ep = e;
 			if (ofsp != NULL)
-				*ofsp = ofs;
+				*ofsp = idx * sizeof e;
 			return true;
 		}
+		if (!e.in_use && e.inode_sector == 0)
+			break;              /* End of the probe chain. */
+	}
 	return false;
 }
 
+/* Searches DIR for a file with the given NAME and returns true
+ * if one exists, storing its inode sector into *SECTORP.  Unlike
+ * dir_lookup(), the inode itself is not opened; this is the
+ * cheap path behind stat-style metadata queries. */
+bool
+dir_lookup_sector (const struct dir *dir, const char *name,
+		disk_sector_t *sectorp) {
+	disk_sector_t dir_sector;
+	disk_sector_t sector = 0;
+	struct dir_entry e;
+	struct dentry *d;
+
+	ASSERT (dir != NULL);
+	ASSERT (name != NULL);
+
+	/* Try the dentry cache first; a hit resolves the name without
+	 * reading any directory data. */
+	dir_sector = inode_get_inumber (dir->inode);
+	lock_acquire (&dentry_lock);
+	d = dentry_find (dir_sector, name);
+	if (d != NULL)
+		sector = d->inode_sector;
+	lock_release (&dentry_lock);
+
+	if (sector == 0 && lookup (dir, name, &e, NULL)) {
+		sector = e.inode_sector;
+		dentry_insert (dir_sector, name, sector);
+	}
+
+	*sectorp = sector;
+	return sector != 0;
+}
+
 /* Searches DIR for a file with the given NAME
  * and returns true if one exists, false otherwise.
  * On success, sets *INODE to an inode for the file, otherwise to
@@ -104,16 +362,10 @@ lookup (const struct dir *dir, const char *name,
 bool
 dir_lookup (const struct dir *dir, const char *name,
 		struct inode **inode) {
-	struct dir_entry e;
-
-	ASSERT (dir != NULL);
-	ASSERT (name != NULL);
-
-	if (lookup (dir, name, &e, NULL))
-		*inode = inode_open (e.inode_sector);
-	else
-		*inode = NULL;
+	disk_sector_t sector;
 
+	*inode = dir_lookup_sector (dir, name, &sector)
+		? inode_open (sector) : NULL;
 	return *inode != NULL;
 }
 
@@ -126,8 +378,8 @@ dir_lookup (const struct dir *dir, const char *name,
 bool
 dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	struct dir_entry e;
-	off_t ofs;
-	bool success = false;
+	size_t hash, free_idx = 0, free_dist = 0;
+	bool found_free;
 
 	ASSERT (dir != NULL);
 	ASSERT (name != NULL);
@@ -136,30 +388,52 @@ dir_add (struct dir *dir, const char *name, disk_sector_t inode_sector) {
 	if (*name == '\0' || strlen (name) > NAME_MAX)
 		return false;
 
-	/* Check that NAME is not in use. */
-	if (lookup (dir, name, NULL, NULL))
-		goto done;
-
-	/* Set OFS to offset of free slot.
-	 * If there are no free slots, then it will be set to the
-	 * current end-of-file.
-
-	 * inode_read_at() will only return a short read at end of file.
-	 * Otherwise, we'd need to verify that we didn't get a short
-	 * read due to something intermittent such as low memory. */
-	for (ofs = 0; inode_read_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
-			ofs += sizeof e)
-		if (!e.in_use)
+	/* Probe NAME's chain once, checking for a duplicate and noting
+	 * the first reusable slot.  A free slot too far from the home
+	 * slot would stretch every later lookup, so in that case (or
+	 * when the table is full) grow the table and probe again. */
+	hash = hash_string (name);
+	for (;;) {
+		size_t cap = dir_capacity (dir);
+		size_t i;
+
+		if (cap == 0)
+			return false;
+		found_free = false;
+		for (i = 0; i < cap; i++) {
+			size_t idx = (hash + i) % cap;
+
+			if (!read_slot (dir, idx, &e))
+				return false;
+			if (e.in_use) {
+				if (!strcmp (name, e.name))
+					return false;   /* NAME is already present. */
+			} else {
+				if (!found_free) {
+					found_free = true;
+					free_idx = idx;
+					free_dist = i;
+				}
+				if (e.inode_sector == 0)
+					break;          /* End of the probe chain. */
+			}
+		}
+		if (found_free && free_dist <= DIR_MAX_PROBE)
 			break;
+		if (!dir_rehash (dir))
+			return false;
+	}
 
 	/* Write slot. */
 	e.in_use = true;
 	strlcpy (e.name, name, sizeof e.name);
 	e.inode_sector = inode_sector;
-	success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
+	if (inode_write_at (dir->inode, &e, sizeof e,
+				free_idx * sizeof e) != sizeof e)
+		return false;
 
-done:
-	return success;
+	dentry_insert (inode_get_inumber (dir->inode), name, inode_sector);
+	return true;
 }
 
 /* Removes any entry for NAME in DIR.
@@ -191,6 +465,7 @@ dir_remove (struct dir *dir, const char *name) {
 
 	/* Remove inode. */
 	inode_remove (inode);
+	dentry_drop (inode_get_inumber (dir->inode), name);
 	success = true;
 
 done:
@@ -198,6 +473,29 @@ done:
 	return success;
 }
 
+/* Entries scanned ahead of dir_readdir for inode prefetch. */
+#define READDIR_PREFETCH 16
+
+/* Schedules asynchronous reads of the inode sectors of up to
+ * READDIR_PREFETCH in-use entries at and after POS, so an
+ * enumerate-then-stat loop finds the metadata already cached by
+ * the time it asks.  The sectors are usually near each other on
+ * disk and merge into larger commands in the disk request
+ * queue. */
+static void
+readdir_prefetch (const struct dir *dir, off_t pos) {
+	int i;
+
+	for (i = 0; i < READDIR_PREFETCH; i++, pos += sizeof (struct dir_entry)) {
+		struct dir_entry e;
+
+		if (inode_read_at (dir->inode, &e, sizeof e, pos) != sizeof e)
+			break;
+		if (e.in_use)
+			pagecache_readahead (filesys_disk, e.inode_sector);
+	}
+}
+
 /* Reads the next directory entry in DIR and stores the name in
  * NAME.  Returns true if successful, false if the directory
  * contains no more entries. */
@@ -206,6 +504,10 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1]) {
 	struct dir_entry e;
 
 	while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e) {
+		/* On each prefetch-batch boundary, queue the inode sectors
+		 * of the next batch of entries. */
+		if ((dir->pos / sizeof e) % READDIR_PREFETCH == 0)
+			readdir_prefetch (dir, dir->pos);
 		dir->pos += sizeof e;
 		if (e.in_use) {
 			strlcpy (name, e.name, NAME_MAX + 1);
@@ -1,8 +1,11 @@
 #include "filesys/fat.h"
 #include "devices/disk.h"
 #include "filesys/filesys.h"
+#include "filesys/page_cache.h"
 #include "threads/malloc.h"
 #include "threads/synch.h"
+#include "threads/workqueue.h"
+#include <bitmap.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -28,9 +31,54 @@ struct fat_fs {
 
 static struct fat_fs *fat_fs;
 
+/* FAT entries packed into one disk sector. */
+#define CLUSTERS_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
+/* The FAT is fully memory-resident while the file system runs:
+ * fat_put() edits the in-memory table and marks the covering FAT
+ * sector in a dirty bitmap, and a work item on the kernel work
+ * queue pushes just the dirty sectors into the buffer cache,
+ * where the cache flusher coalesces adjacent ones into
+ * multi-sector writes.  No chain edit waits for the disk. */
+static struct bitmap *fat_dirty;    /* Dirty FAT sectors, pending flush. */
+static struct workqueue fat_wq;
+static struct work fat_work;
+static bool fat_queued;             /* Is fat_work pending or running? */
+
+static void fat_flush (void *aux);
+
 void fat_boot_create (void);
 void fat_fs_init (void);
 
+/* Marks the FAT sector holding CLST dirty and kicks the
+ * write-behind flusher.  Caller must hold write_lock. */
+static void
+fat_mark_dirty (cluster_t clst) {
+	bitmap_mark (fat_dirty, clst / CLUSTERS_PER_SECTOR);
+	if (!fat_queued) {
+		fat_queued = true;
+		workqueue_enqueue (&fat_wq, &fat_work, fat_flush, NULL);
+	}
+}
+
+/* Write-behind work: pushes every dirty FAT sector into the
+ * buffer cache.  The disk I/O itself is batched further by the
+ * cache flusher. */
+static void
+fat_flush (void *aux UNUSED) {
+	size_t i;
+
+	lock_acquire (&fat_fs->write_lock);
+	fat_queued = false;
+	for (i = 0; i < fat_fs->bs.fat_sectors; i++)
+		if (bitmap_test (fat_dirty, i)) {
+			bitmap_reset (fat_dirty, i);
+			pagecache_write (filesys_disk, fat_fs->bs.fat_start + i,
+					(uint8_t *) fat_fs->fat + i * DISK_SECTOR_SIZE);
+		}
+	lock_release (&fat_fs->write_lock);
+}
+
 void
 fat_init (void) {
 	fat_fs = calloc (1, sizeof (struct fat_fs));
@@ -90,27 +138,10 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
-	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
-	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
-	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
-		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
-		} else {
-			bounce = calloc (1, DISK_SECTOR_SIZE);
-			if (bounce == NULL)
-				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
-			free (bounce);
-		}
-	}
+	/* Only the FAT sectors dirtied since the load need writing;
+	 * clean sectors still match the disk.  They go through the
+	 * buffer cache and reach the disk in pagecache_flush(). */
+	fat_flush (NULL);
 }
 
 void
@@ -124,6 +155,10 @@ fat_create (void) {
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
 
+	/* A fresh FAT matches nothing on disk: every sector must go
+	 * out at close. */
+	bitmap_set_all (fat_dirty, true);
+
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
 
@@ -152,7 +187,19 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	fat_fs->fat_length = fat_fs->bs.fat_sectors * CLUSTERS_PER_SECTOR;
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	fat_fs->last_clst = ROOT_DIR_CLUSTER + 1;
+	lock_init (&fat_fs->write_lock);
+
+	/* fat_create() re-runs this after fat_init(); the dirty
+	 * bitmap and work queue are created only once. */
+	if (fat_dirty == NULL) {
+		fat_dirty = bitmap_create (fat_fs->bs.fat_sectors);
+		if (fat_dirty == NULL)
+			PANIC ("FAT init failed");
+		workqueue_create (&fat_wq, "fat", 1);
+	}
 }
 
 /*----------------------------------------------------------------------------*/
@@ -161,33 +208,86 @@ fat_fs_init (void) {
 
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
- * Returns 0 if fails to allocate a new cluster. */
+ * Returns 0 if fails to allocate a new cluster.
+ * The search for a free cluster starts at the rotating last_clst
+ * cursor, where the previous allocation ended, so appends do not
+ * rescan the low clusters on every chain extension. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	cluster_t i, found = 0;
+
+	lock_acquire (&fat_fs->write_lock);
+
+	/* Scan from the cursor to the end, then wrap. */
+	for (i = fat_fs->last_clst; i < fat_fs->fat_length; i++)
+		if (fat_fs->fat[i] == 0) {
+			found = i;
+			break;
+		}
+	if (found == 0)
+		for (i = ROOT_DIR_CLUSTER + 1; i < fat_fs->last_clst
+				&& i < fat_fs->fat_length; i++)
+			if (fat_fs->fat[i] == 0) {
+				found = i;
+				break;
+			}
+
+	if (found != 0) {
+		fat_fs->last_clst = found + 1;
+		fat_fs->fat[found] = EOChain;
+		fat_mark_dirty (found);
+		if (clst != 0) {
+			fat_fs->fat[clst] = found;
+			fat_mark_dirty (clst);
+		}
+	}
+	lock_release (&fat_fs->write_lock);
+
+	return found;
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0) {
+		fat_fs->fat[pclst] = EOChain;
+		fat_mark_dirty (pclst);
+	}
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_fs->fat[clst];
+
+		fat_fs->fat[clst] = 0;
+		fat_mark_dirty (clst);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst < fat_fs->fat_length);
+
+	lock_acquire (&fat_fs->write_lock);
+	fat_fs->fat[clst] = val;
+	fat_mark_dirty (clst);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst < fat_fs->fat_length);
+
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst != 0 && clst < fat_fs->fat_length);
+
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
 }
@@ -2,8 +2,45 @@
 
 #include <debug.h>
 
+#include "devices/disk.h"
+#include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "userprog/pipe.h"
+
+/** #Project 3: Readahead - 순차 읽기 창의 초기값/상한 (섹터 수). */
+#define RA_WINDOW_MIN 4
+#define RA_WINDOW_MAX 64
+
+/** #Project 3: Readahead - 요청 큐가 이만큼 차 있으면 readahead를
+ *  줄인다. 미리 읽기가 수요 읽기를 큐에서 밀어내지 않게 하는 상한. */
+#define RA_QUEUE_LIMIT 64
+
+/** #Project 3: Readahead - 직전 읽기가 끝난 지점에서 그대로 이어지는
+ *  읽기를 순차 접근으로 보고, 뒤따라올 섹터들을 디스크 요청 큐를 통해
+ *  버퍼 캐시로 미리 읽어 둔다. 창 크기는 적응적이다: 순차 히트마다
+ *  두 배로 키워(최대 RA_WINDOW_MAX) 스트리밍 읽기의 지연을 숨기고,
+ *  랜덤 접근이 끼어들면 0으로 접어 4KB 레코드 랜덤 리더에게 낭비
+ *  I/O를 만들지 않는다. 실제 발행량은 요청 큐의 남은 자리만큼만으로
+ *  눌러서 readahead가 수요 읽기를 굶기지 않는다. */
+static void check_sequential(struct file *file, off_t ofs, off_t bytes_read) {
+    if (bytes_read > 0 && ofs == file->read_end) {
+        size_t depth = disk_queue_depth(filesys_disk);
+        int room = depth < RA_QUEUE_LIMIT ? (int)(RA_QUEUE_LIMIT - depth) : 0;
+        int cnt;
+
+        file->ra_window = file->ra_window == 0 ? RA_WINDOW_MIN : file->ra_window * 2;
+        if (file->ra_window > RA_WINDOW_MAX)
+            file->ra_window = RA_WINDOW_MAX;
+
+        cnt = file->ra_window < room ? file->ra_window : room;
+        if (cnt > 0)
+            inode_readahead(file->inode, ofs + bytes_read, cnt);
+    } else {
+        file->ra_window = 0;
+    }
+    file->read_end = ofs + bytes_read;
+}
 
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
@@ -15,8 +52,8 @@ struct file *file_open(struct inode *inode) {
         file->pos = 0;
         file->deny_write = false;
 
-        /** #Project 2: Extend File Descriptor - dup_count 초기화 */
-        file->dup_count = 0;
+        /** #Project 2: Extend File Descriptor - 참조 수 초기화 (첫 fd 몫) */
+        file->ref_cnt = 1;
         return file;
     } else {
         inode_close(inode);
@@ -31,10 +68,26 @@ struct file *file_reopen(struct file *file) {
     return file_open(inode_reopen(file->inode));
 }
 
+/* Takes another reference to FILE and returns it.  dup2'd and
+ * fork-shared descriptors point at the one open-file object -- the
+ * inode reference, position, and deny_write state are shared -- so
+ * duplicating a descriptor is a counter bump, not an allocation.
+ * The update is atomic so no lock guards the count. */
+struct file *file_dup_ref(struct file *file) {
+    __atomic_add_fetch(&file->ref_cnt, 1, __ATOMIC_RELAXED);
+    return file;
+}
+
 /* Duplicate the file object including attributes and returns a new file for the
  * same inode as FILE. Returns a null pointer if unsuccessful. */
 struct file *file_duplicate(struct file *file) {
-    struct file *nfile = file_open(inode_reopen(file->inode));
+    struct file *nfile;
+
+    /** #Project 3: Pipe - 끝단 복제는 파이프를 공유한다. */
+    if (file->pipe != NULL)
+        return pipe_dup(file);
+
+    nfile = file_open(inode_reopen(file->inode));
     if (nfile) {
         nfile->pos = file->pos;
         if (file->deny_write)
@@ -43,9 +96,19 @@ struct file *file_duplicate(struct file *file) {
     return nfile;
 }
 
-/* Closes FILE. */
+/* Closes FILE: drops one reference and frees the object when the
+ * last one goes. */
 void file_close(struct file *file) {
     if (file != NULL) {
+        if (__atomic_sub_fetch(&file->ref_cnt, 1, __ATOMIC_ACQ_REL) > 0)
+            return;
+
+        /** #Project 3: Pipe - 끝단 반납; 마지막 끝단이 파이프를 해제한다. */
+        if (file->pipe != NULL) {
+            pipe_release_end(file->pipe, file->pipe_writer);
+            free(file);
+            return;
+        }
         file_allow_write(file);
         inode_close(file->inode);
         free(file);
@@ -63,7 +126,16 @@ struct inode *file_get_inode(struct file *file) {
  * which may be less than SIZE if end of file is reached.
  * Advances FILE's position by the number of bytes read. */
 off_t file_read(struct file *file, void *buffer, off_t size) {
+    /** #Project 3: Direct I/O - 스트리밍 모드는 캐시를 우회하고
+     *  readahead도 걸지 않는다. 한 번 훑고 말 데이터이기 때문이다. */
+    if (file->direct) {
+        off_t bytes_read = inode_read_direct(file->inode, buffer, size, file->pos);
+        file->pos += bytes_read;
+        return bytes_read;
+    }
+
     off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
+    check_sequential(file, file->pos, bytes_read);
     file->pos += bytes_read;
     return bytes_read;
 }
@@ -74,7 +146,12 @@ off_t file_read(struct file *file, void *buffer, off_t size) {
  * which may be less than SIZE if end of file is reached.
  * The file's current position is unaffected. */
 off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs) {
-    return inode_read_at(file->inode, buffer, size, file_ofs);
+    if (file->direct)
+        return inode_read_direct(file->inode, buffer, size, file_ofs);
+
+    off_t bytes_read = inode_read_at(file->inode, buffer, size, file_ofs);
+    check_sequential(file, file_ofs, bytes_read);
+    return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into FILE,
@@ -85,7 +162,9 @@ off_t file_read_at(struct file *file, void *buffer, off_t size, off_t file_ofs)
  * not yet implemented.)
  * Advances FILE's position by the number of bytes read. */
 off_t file_write(struct file *file, const void *buffer, off_t size) {
-    off_t bytes_written = inode_write_at(file->inode, buffer, size, file->pos);
+    off_t bytes_written = file->direct
+                              ? inode_write_direct(file->inode, buffer, size, file->pos)
+                              : inode_write_at(file->inode, buffer, size, file->pos);
     file->pos += bytes_written;
     return bytes_written;
 }
@@ -98,9 +177,30 @@ off_t file_write(struct file *file, const void *buffer, off_t size) {
  * not yet implemented.)
  * The file's current position is unaffected. */
 off_t file_write_at(struct file *file, const void *buffer, off_t size, off_t file_ofs) {
+    if (file->direct)
+        return inode_write_direct(file->inode, buffer, size, file_ofs);
+
     return inode_write_at(file->inode, buffer, size, file_ofs);
 }
 
+/** #Project 3: Sendfile - SRC의 현재 위치에서 SIZE 바이트를 DST의 현재 위치로
+ *  복사한다. 데이터는 버퍼 캐시 섹터 사이에서 직접 이동하며 유저 메모리를
+ *  거치지 않는다. 실제 복사된 바이트 수를 반환하고 양쪽 위치를 전진시킨다. */
+off_t file_sendfile(struct file *dst, struct file *src, off_t size) {
+    off_t bytes_copied = inode_copy_at(dst->inode, src->inode, size, dst->pos, src->pos);
+    src->pos += bytes_copied;
+    dst->pos += bytes_copied;
+    return bytes_copied;
+}
+
+/** #Project 3: Sendfile - FILE의 현재 위치에서 SIZE 바이트를 캐시 섹터에서
+ *  바로 콘솔로 출력한다. 출력된 바이트 수를 반환하고 위치를 전진시킨다. */
+off_t file_send_console(struct file *file, off_t size) {
+    off_t bytes_written = inode_putbuf(file->inode, size, file->pos);
+    file->pos += bytes_written;
+    return bytes_written;
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void file_deny_write(struct file *file) {
@@ -4,10 +4,68 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "filesys/journal.h"
+#include "filesys/page_cache.h"
+#include "threads/synch.h"
+#include "threads/workqueue.h"
 
 static struct file *free_map_file;   /* Free map file. */
 static struct bitmap *free_map;      /* Free map, one bit per disk sector. */
 
+/* The free map lives purely in memory while the file system runs:
+ * allocate and release flip bits and widen a dirty bit range, and
+ * a work item on the kernel work queue persists just that range of
+ * the bitmap through the buffer cache.  No disk I/O sits on the
+ * block-allocation path.  A next-fit cursor starts each scan where
+ * the previous allocation ended, so allocation-heavy workloads do
+ * not rescan the same low sectors over and over. */
+static size_t scan_cursor;           /* Where the next scan starts. */
+static size_t dirty_low, dirty_high; /* Dirty bits [low, high); equal = clean. */
+static struct workqueue fmap_wq;
+static struct work fmap_work;
+static bool fmap_queued;             /* Is fmap_work pending or running? */
+static struct lock fmap_lock;
+
+static void free_map_persist (void *aux);
+
+/* Widens the dirty range to cover the CNT bits at START and, once
+ * the free map file exists, schedules the persist work.  Caller
+ * must hold fmap_lock. */
+static void
+mark_dirty (size_t start, size_t cnt) {
+	if (dirty_low >= dirty_high) {
+		dirty_low = start;
+		dirty_high = start + cnt;
+	} else {
+		if (start < dirty_low)
+			dirty_low = start;
+		if (start + cnt > dirty_high)
+			dirty_high = start + cnt;
+	}
+	if (free_map_file != NULL && !fmap_queued) {
+		fmap_queued = true;
+		workqueue_enqueue (&fmap_wq, &fmap_work, free_map_persist, NULL);
+	}
+}
+
+/* Write-behind work: writes the dirty part of the bitmap to the
+ * free map file.  The write lands in the buffer cache, so the
+ * disk I/O itself is batched further by the cache flusher. */
+static void
+free_map_persist (void *aux UNUSED) {
+	size_t low, high;
+
+	lock_acquire (&fmap_lock);
+	low = dirty_low;
+	high = dirty_high;
+	dirty_low = dirty_high = 0;
+	fmap_queued = false;
+	lock_release (&fmap_lock);
+
+	if (low < high)
+		bitmap_write_range (free_map, free_map_file, low, high - low);
+}
+
 /* Initializes the free map. */
 void
 free_map_init (void) {
@@ -16,21 +74,32 @@ free_map_init (void) {
 		PANIC ("bitmap creation failed--disk is too large");
 	bitmap_mark (free_map, FREE_MAP_SECTOR);
 	bitmap_mark (free_map, ROOT_DIR_SECTOR);
+	bitmap_set_multiple (free_map, JOURNAL_START, JOURNAL_SECTORS, true);
+	bitmap_mark (free_map, PAGECACHE_WARMUP_SECTOR);
+	lock_init (&fmap_lock);
+	workqueue_create (&fmap_wq, "fmap", 1);
 }
 
 /* Allocates CNT consecutive sectors from the free map and stores
  * the first into *SECTORP.
- * Returns true if successful, false if all sectors were
- * available. */
+ * Returns true if successful, false if not enough consecutive
+ * sectors were available.  Scans from the end of the previous
+ * allocation first, wrapping to the start of the disk only when
+ * the tail is exhausted. */
 bool
 free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
-	disk_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
-	if (sector != BITMAP_ERROR
-			&& free_map_file != NULL
-			&& !bitmap_write (free_map, free_map_file)) {
-		bitmap_set_multiple (free_map, sector, cnt, false);
-		sector = BITMAP_ERROR;
+	disk_sector_t sector;
+
+	lock_acquire (&fmap_lock);
+	sector = bitmap_scan_and_flip (free_map, scan_cursor, cnt, false);
+	if (sector == BITMAP_ERROR)
+		sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+	if (sector != BITMAP_ERROR) {
+		scan_cursor = sector + cnt;
+		mark_dirty (sector, cnt);
 	}
+	lock_release (&fmap_lock);
+
 	if (sector != BITMAP_ERROR)
 		*sectorp = sector;
 	return sector != BITMAP_ERROR;
@@ -39,9 +108,11 @@ free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
 /* Makes CNT sectors starting at SECTOR available for use. */
 void
 free_map_release (disk_sector_t sector, size_t cnt) {
+	lock_acquire (&fmap_lock);
 	ASSERT (bitmap_all (free_map, sector, cnt));
 	bitmap_set_multiple (free_map, sector, cnt, false);
-	bitmap_write (free_map, free_map_file);
+	mark_dirty (sector, cnt);
+	lock_release (&fmap_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -54,9 +125,17 @@ free_map_open (void) {
 		PANIC ("can't read free map");
 }
 
-/* Writes the free map to disk and closes the free map file. */
+/* Writes any unpersisted part of the free map to disk and closes
+ * the free map file. */
 void
 free_map_close (void) {
+	lock_acquire (&fmap_lock);
+	if (dirty_low < dirty_high) {
+		bitmap_write_range (free_map, free_map_file, dirty_low,
+				dirty_high - dirty_low);
+		dirty_low = dirty_high = 0;
+	}
+	lock_release (&fmap_lock);
 	file_close (free_map_file);
 }
 
@@ -1,22 +1,49 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#include "filesys/page_cache.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A contiguous run of data sectors. */
+struct extent {
+	disk_sector_t start;                /* First sector of the run. */
+	uint32_t cnt;                       /* Sectors in the run, 0 if unused. */
+};
+
+/* Extents held directly in the inode; larger or more fragmented
+ * files overflow into one indirect block full of extents. */
+#define INODE_EXTENTS 8
+#define EXTENTS_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (struct extent))
+#define MAX_EXTENTS (INODE_EXTENTS + EXTENTS_PER_SECTOR)
+
+/* An extent whose start is EXTENT_HOLE is a hole: its sectors
+ * read back as zeros but occupy no disk space, and are allocated
+ * only when first written.  Sector 0 holds the free map inode and
+ * is never allocated to file data, so the value is unambiguous;
+ * byte_to_sector() likewise returns EXTENT_HOLE for an offset
+ * inside a hole. */
+#define EXTENT_HOLE 0
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * Data lives in a list of extents rather than one contiguous run,
+ * so creation succeeds from whatever free runs exist while
+ * sequential access within an extent stays contiguous. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	disk_sector_t indirect;             /* Extent overflow block, 0 if none. */
+	struct extent extents[INODE_EXTENTS]; /* Direct extents, in file order. */
+	uint32_t unused[DISK_SECTOR_SIZE / 4 - 3 - 2 * INODE_EXTENTS];
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -26,37 +53,471 @@ bytes_to_sectors (off_t size) {
 	return DIV_ROUND_UP (size, DISK_SECTOR_SIZE);
 }
 
+/* One entry of an open inode's flattened extent table. */
+struct ext_run {
+	off_t first;                        /* First file sector covered. */
+	disk_sector_t start;                /* Corresponding disk sector. */
+	uint32_t cnt;                       /* Sectors in the run. */
+};
+
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem helem;             /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct rwlock rw;                   /* Readers share, writers exclude;
+	                                       I/O on distinct inodes never
+	                                       serializes. */
+	struct ext_run *runs;               /* Flattened extent table, or null
+	                                       if not built yet. */
+	size_t run_cnt;                     /* Number of entries in runs. */
+	size_t last_run;                    /* Run that served the last lookup. */
 	struct inode_disk data;             /* Inode content. */
 };
 
+/* Serializes publication of lazily built extent tables.  The
+ * build itself runs under the shared per-inode lock, so two
+ * readers may construct the table concurrently; this lock makes
+ * sure only one copy is installed. */
+static struct lock runs_lock;
+
+/* Builds INODE's flattened extent table: one entry per extent,
+ * direct and indirect, keyed by the first file sector the extent
+ * covers.  Returns false if memory runs out, in which case
+ * lookups fall back to walking the extent list.  The table is
+ * freed whenever the extent list changes. */
+static bool
+build_runs (struct inode *inode) {
+	struct inode_disk *d = &inode->data;
+	struct ext_run *runs;
+	size_t cnt = 0;
+	off_t first = 0;
+	int i;
+
+	runs = malloc ((INODE_EXTENTS + EXTENTS_PER_SECTOR) * sizeof *runs);
+	if (runs == NULL)
+		return false;
+
+	for (i = 0; i < INODE_EXTENTS && d->extents[i].cnt != 0; i++) {
+		runs[cnt].first = first;
+		runs[cnt].start = d->extents[i].start;
+		runs[cnt].cnt = d->extents[i].cnt;
+		first += d->extents[i].cnt;
+		cnt++;
+	}
+	if (d->indirect != 0) {
+		struct extent ind[EXTENTS_PER_SECTOR];
+
+		pagecache_read (filesys_disk, d->indirect, ind);
+		for (i = 0; i < (int) EXTENTS_PER_SECTOR && ind[i].cnt != 0; i++) {
+			runs[cnt].first = first;
+			runs[cnt].start = ind[i].start;
+			runs[cnt].cnt = ind[i].cnt;
+			first += ind[i].cnt;
+			cnt++;
+		}
+	}
+
+	/* Readers share the per-inode lock, so another reader may have
+	 * built and published the table while this one was working.
+	 * Install only the first copy and free the loser's. */
+	lock_acquire (&runs_lock);
+	if (inode->runs == NULL) {
+		inode->run_cnt = cnt;
+		inode->last_run = 0;
+		inode->runs = runs;
+	} else
+		free (runs);
+	lock_release (&runs_lock);
+	return true;
+}
+
+/* Frees INODE's flattened extent table, forcing a rebuild on the
+ * next lookup.  Called when the extent list changes. */
+static void
+invalidate_runs (struct inode *inode) {
+	free (inode->runs);
+	inode->runs = NULL;
+	inode->run_cnt = 0;
+	inode->last_run = 0;
+}
+
+/* Slow path of byte_to_sector(): walks the direct extents, then
+ * the indirect extent block out of the buffer cache.  Used only
+ * when the flattened table could not be allocated. */
+static disk_sector_t
+byte_to_sector_slow (const struct inode *inode, off_t sector_pos) {
+	int i;
+
+	for (i = 0; i < INODE_EXTENTS; i++) {
+		const struct extent *e = &inode->data.extents[i];
+
+		if (e->cnt == 0)
+			return -1;
+		if (sector_pos < (off_t) e->cnt)
+			return e->start == EXTENT_HOLE
+				? EXTENT_HOLE : e->start + sector_pos;
+		sector_pos -= e->cnt;
+	}
+
+	if (inode->data.indirect != 0) {
+		struct extent ind[EXTENTS_PER_SECTOR];
+
+		pagecache_read (filesys_disk, inode->data.indirect, ind);
+		for (i = 0; i < (int) EXTENTS_PER_SECTOR; i++) {
+			if (ind[i].cnt == 0)
+				break;
+			if (sector_pos < (off_t) ind[i].cnt)
+				return ind[i].start == EXTENT_HOLE
+					? EXTENT_HOLE : ind[i].start + sector_pos;
+			sector_pos -= ind[i].cnt;
+		}
+	}
+	return -1;
+}
+
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
- * POS. */
+ * POS.  The run that satisfied the previous lookup is tried
+ * first, so a sequential pass resolves each sector with one
+ * comparison; other offsets binary-search the flattened extent
+ * table, so the cost never scales with the offset. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
+	off_t sector_pos;
+	size_t lo, hi;
+
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
-	else
+	if (pos >= inode->data.length)
 		return -1;
+
+	sector_pos = pos / DISK_SECTOR_SIZE;
+	if (inode->runs == NULL && !build_runs (inode))
+		return byte_to_sector_slow (inode, sector_pos);
+
+	/* Sequential fast path: same run as the previous lookup. */
+	if (inode->last_run < inode->run_cnt) {
+		const struct ext_run *r = &inode->runs[inode->last_run];
+
+		if (sector_pos >= r->first && sector_pos < r->first + (off_t) r->cnt)
+			return r->start == EXTENT_HOLE
+				? EXTENT_HOLE : r->start + (sector_pos - r->first);
+	}
+
+	lo = 0;
+	hi = inode->run_cnt;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		const struct ext_run *r = &inode->runs[mid];
+
+		if (sector_pos < r->first)
+			hi = mid;
+		else if (sector_pos >= r->first + (off_t) r->cnt)
+			lo = mid + 1;
+		else {
+			inode->last_run = mid;
+			return r->start == EXTENT_HOLE
+				? EXTENT_HOLE : r->start + (sector_pos - r->first);
+		}
+	}
+	return -1;
+}
+
+/* Table of open inodes, hashed by sector number, so that opening
+ * a single inode twice returns the same `struct inode' in
+ * constant time however many inodes are open.  The rwlock guards
+ * membership only: lookups share it, insertion and removal take
+ * it exclusively. */
+static struct hash open_inodes;
+static struct rwlock open_inodes_rw;
+
+/* Returns a hash for the inode's sector number. */
+static uint64_t
+inode_hash (const struct hash_elem *e_, void *aux UNUSED) {
+	const struct inode *e = hash_entry (e_, struct inode, helem);
+	return hash_word (e->sector);
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Orders open inodes by sector number. */
+static bool
+inode_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct inode *a = hash_entry (a_, struct inode, helem);
+	const struct inode *b = hash_entry (b_, struct inode, helem);
+	return a->sector < b->sector;
+}
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&open_inodes, inode_hash, inode_less, NULL);
+	rwlock_init (&open_inodes_rw);
+	lock_init (&runs_lock);
+}
+
+/* Zeroes the CNT sectors starting at START through the cache.
+ * The sectors become dirty cache entries without touching the
+ * disk here; they are written out at eviction or flush time. */
+static void
+zero_sectors_cached (disk_sector_t start, size_t cnt) {
+	static char zeros[DISK_SECTOR_SIZE];
+
+	while (cnt-- > 0)
+		pagecache_write (filesys_disk, start++, zeros);
+}
+
+/* Allocates and zeroes one extent of up to *REMAINING sectors
+ * into E, preferring the largest contiguous run the free map can
+ * provide.  Subtracts the extent's size from *REMAINING.  Returns
+ * false if no run at all could be found. */
+static bool
+extent_alloc (struct extent *e, size_t *remaining) {
+	size_t try = *remaining;
+	disk_sector_t start;
+
+	while (try > 0 && !free_map_allocate (try, &start))
+		try /= 2;
+	if (try == 0)
+		return false;
+
+	e->start = start;
+	e->cnt = try;
+	*remaining -= try;
+	zero_sectors_cached (start, try);
+	return true;
+}
+
+/* Returns every allocated sector owned by DISK_INODE - the
+ * non-hole extents, direct and indirect, and the indirect block
+ * itself - to the free map, dropping cached copies first.  Holes
+ * own no sectors and are skipped. */
+static void
+inode_release (const struct inode_disk *disk_inode) {
+	int i;
+
+	for (i = 0; i < INODE_EXTENTS; i++) {
+		const struct extent *e = &disk_inode->extents[i];
+
+		if (e->cnt == 0)
+			break;
+		if (e->start != EXTENT_HOLE) {
+			pagecache_discard (filesys_disk, e->start, e->cnt);
+			free_map_release (e->start, e->cnt);
+		}
+	}
+
+	if (disk_inode->indirect != 0) {
+		struct extent ind[EXTENTS_PER_SECTOR];
+
+		pagecache_read (filesys_disk, disk_inode->indirect, ind);
+		for (i = 0; i < (int) EXTENTS_PER_SECTOR && ind[i].cnt != 0; i++)
+			if (ind[i].start != EXTENT_HOLE) {
+				pagecache_discard (filesys_disk, ind[i].start, ind[i].cnt);
+				free_map_release (ind[i].start, ind[i].cnt);
+			}
+		pagecache_discard (filesys_disk, disk_inode->indirect, 1);
+		free_map_release (disk_inode->indirect, 1);
+	}
+}
+
+/* Loads DISK_INODE's extent list, direct then indirect, into
+ * FLAT, which must hold MAX_EXTENTS entries.  Returns the number
+ * of extents loaded. */
+static size_t
+load_extents (const struct inode_disk *d, struct extent *flat) {
+	size_t cnt = 0;
+	int i;
+
+	for (i = 0; i < INODE_EXTENTS && d->extents[i].cnt != 0; i++)
+		flat[cnt++] = d->extents[i];
+	if (d->indirect != 0) {
+		struct extent ind[EXTENTS_PER_SECTOR];
+
+		pagecache_read (filesys_disk, d->indirect, ind);
+		for (i = 0; i < (int) EXTENTS_PER_SECTOR && ind[i].cnt != 0; i++)
+			flat[cnt++] = ind[i];
+	}
+	return cnt;
+}
+
+/* Stores the CNT extents in FLAT back into DISK_INODE's direct
+ * slots and, if they do not fit there, its indirect block,
+ * allocating that block on first use.  Returns false if CNT
+ * exceeds what the inode can hold or the indirect block cannot be
+ * allocated; DISK_INODE is unchanged in that case.  The caller is
+ * responsible for writing the inode sector itself back. */
+static bool
+store_extents (struct inode_disk *d, const struct extent *flat, size_t cnt) {
+	size_t i;
+
+	if (cnt > MAX_EXTENTS)
+		return false;
+	if (cnt > INODE_EXTENTS && d->indirect == 0
+			&& !free_map_allocate (1, &d->indirect))
+		return false;
+
+	memset (d->extents, 0, sizeof d->extents);
+	for (i = 0; i < cnt && i < INODE_EXTENTS; i++)
+		d->extents[i] = flat[i];
+
+	if (d->indirect != 0) {
+		struct extent ind[EXTENTS_PER_SECTOR];
+
+		memset (ind, 0, sizeof ind);
+		for (i = INODE_EXTENTS; i < cnt; i++)
+			ind[i - INODE_EXTENTS] = flat[i];
+		pagecache_write (filesys_disk, d->indirect, ind);
+	}
+	return true;
+}
+
+/* Coalesces neighbors in FLAT that are contiguous on disk, or
+ * that are both holes, and drops empty entries.  Returns the new
+ * extent count. */
+static size_t
+merge_extents (struct extent *flat, size_t cnt) {
+	size_t i, out = 0;
+
+	for (i = 0; i < cnt; i++) {
+		struct extent *prev = out > 0 ? &flat[out - 1] : NULL;
+
+		if (flat[i].cnt == 0)
+			continue;
+		if (prev != NULL
+				&& ((prev->start == EXTENT_HOLE
+						&& flat[i].start == EXTENT_HOLE)
+					|| (prev->start != EXTENT_HOLE
+						&& flat[i].start != EXTENT_HOLE
+						&& prev->start + prev->cnt == flat[i].start)))
+			prev->cnt += flat[i].cnt;
+		else
+			flat[out++] = flat[i];
+	}
+	return out;
+}
+
+/* Sector runs a single materialization may allocate before giving
+ * up; bounds fragmentation of the extent list. */
+#define MATERIALIZE_RUNS 16
+
+/* Replaces the parts of INODE's holes that overlap file sectors
+ * LO through HI with allocated, zeroed extents, so every sector a
+ * write touches is backed by the disk.  The rest of each hole
+ * stays a hole.  Newly adjacent allocations are merged, so a
+ * stream of appends into a hole still builds long extents.  On
+ * failure the extent list and free map are left as they were.
+ * Caller must hold the inode's write lock. */
+static bool
+inode_materialize (struct inode *inode, off_t lo, off_t hi) {
+	struct extent newruns[MATERIALIZE_RUNS];
+	struct extent *flat = NULL, *out = NULL;
+	size_t n, out_n = 0, new_n = 0, out_cap;
+	bool ok = true;
+	off_t first = 0;
+	size_t i;
+
+	flat = malloc (MAX_EXTENTS * sizeof *flat);
+	out_cap = MAX_EXTENTS + 2 * (MATERIALIZE_RUNS + 1);
+	out = malloc (out_cap * sizeof *out);
+	if (flat == NULL || out == NULL) {
+		ok = false;
+		goto done;
+	}
+	n = load_extents (&inode->data, flat);
+
+	for (i = 0; i < n && ok; i++) {
+		struct extent e = flat[i];
+		off_t a = first, b = first + e.cnt;
+		off_t s, t;
+		size_t remaining;
+
+		first = b;
+		if (e.start != EXTENT_HOLE || b <= lo || a > hi) {
+			out[out_n++] = e;
+			continue;
+		}
+
+		/* Hole overlapping [LO, HI]: keep the leading and trailing
+		 * parts as holes and allocate the middle. */
+		s = a > lo ? a : lo;
+		t = b < hi + 1 ? b : hi + 1;
+		if (s > a) {
+			out[out_n].start = EXTENT_HOLE;
+			out[out_n].cnt = s - a;
+			out_n++;
+		}
+		remaining = t - s;
+		while (remaining > 0) {
+			if (new_n >= MATERIALIZE_RUNS
+					|| !extent_alloc (&newruns[new_n], &remaining)) {
+				ok = false;
+				break;
+			}
+			out[out_n++] = newruns[new_n++];
+		}
+		if (b > t) {
+			out[out_n].start = EXTENT_HOLE;
+			out[out_n].cnt = b - t;
+			out_n++;
+		}
+	}
+
+	if (ok) {
+		out_n = merge_extents (out, out_n);
+		ok = store_extents (&inode->data, out, out_n);
+	}
+	if (ok) {
+		pagecache_write (filesys_disk, inode->sector, &inode->data);
+		invalidate_runs (inode);
+	} else
+		for (i = 0; i < new_n; i++) {
+			pagecache_discard (filesys_disk, newruns[i].start,
+					newruns[i].cnt);
+			free_map_release (newruns[i].start, newruns[i].cnt);
+		}
+
+done:
+	free (flat);
+	free (out);
+	return ok;
+}
+
+/* Grows INODE to NEW_LENGTH bytes.  The new range is recorded as
+ * a hole - it reads back as zeros and is allocated only when
+ * first written - so extension is purely a metadata operation.
+ * Caller must hold the inode's write lock. */
+static bool
+inode_extend (struct inode *inode, off_t new_length) {
+	struct inode_disk *d = &inode->data;
+	struct extent flat[MAX_EXTENTS];
+	size_t needed = bytes_to_sectors (new_length);
+	size_t have = 0;
+	size_t n, i;
+
+	n = load_extents (d, flat);
+	for (i = 0; i < n; i++)
+		have += flat[i].cnt;
+
+	if (needed > have) {
+		if (n > 0 && flat[n - 1].start == EXTENT_HOLE)
+			flat[n - 1].cnt += needed - have;
+		else if (n < MAX_EXTENTS) {
+			flat[n].start = EXTENT_HOLE;
+			flat[n].cnt = needed - have;
+			n++;
+		} else
+			return false;
+		if (!store_extents (d, flat, n))
+			return false;
+	}
+
+	d->length = new_length;
+	pagecache_write (filesys_disk, inode->sector, d);
+	invalidate_runs (inode);
+	return true;
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -80,17 +541,15 @@ inode_create (disk_sector_t sector, off_t length) {
 		size_t sectors = bytes_to_sectors (length);
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
+		/* The whole file starts as one hole: no data sectors are
+		 * allocated or zeroed until something is written, so
+		 * creating even a huge file is a metadata operation. */
+		if (sectors > 0) {
+			disk_inode->extents[0].start = EXTENT_HOLE;
+			disk_inode->extents[0].cnt = sectors;
+		}
+		pagecache_write (filesys_disk, sector, disk_inode);
+		success = true;
 		free (disk_inode);
 	}
 	return success;
@@ -101,18 +560,18 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode key, *inode;
+	struct hash_elem *h;
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
-	}
+	key.sector = sector;
+	rwlock_acquire_read (&open_inodes_rw);
+	h = hash_find (&open_inodes, &key.helem);
+	if (h != NULL)
+		inode_reopen (hash_entry (h, struct inode, helem));
+	rwlock_release_read (&open_inodes_rw);
+	if (h != NULL)
+		return hash_entry (h, struct inode, helem);
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
@@ -120,12 +579,25 @@ inode_open (disk_sector_t sector) {
 		return NULL;
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	rwlock_init (&inode->rw);
+	inode->runs = NULL;
+	inode->run_cnt = 0;
+	inode->last_run = 0;
+	pagecache_read (filesys_disk, inode->sector, &inode->data);
+
+	/* Publish it, unless another opener beat us to it, in which
+	 * case theirs wins and ours is thrown away. */
+	rwlock_acquire_write (&open_inodes_rw);
+	h = hash_insert (&open_inodes, &inode->helem);
+	rwlock_release_write (&open_inodes_rw);
+	if (h != NULL) {
+		free (inode);
+		inode = inode_reopen (hash_entry (h, struct inode, helem));
+	}
 	return inode;
 }
 
@@ -153,19 +625,24 @@ inode_close (struct inode *inode) {
 		return;
 
 	/* Release resources if this was the last opener. */
+	rwlock_acquire_write (&open_inodes_rw);
 	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+		/* Remove from the open-inode table. */
+		hash_delete (&open_inodes, &inode->helem);
+		rwlock_release_write (&open_inodes_rw);
 
-		/* Deallocate blocks if removed. */
+		/* Deallocate blocks if removed.  Cached copies of the freed
+		 * sectors must go too, or they could shadow a future owner. */
 		if (inode->removed) {
+			pagecache_discard (filesys_disk, inode->sector, 1);
 			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+			inode_release (&inode->data);
 		}
 
-		free (inode); 
-	}
+		invalidate_runs (inode);
+		free (inode);
+	} else
+		rwlock_release_write (&open_inodes_rw);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -183,8 +660,8 @@ off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
 
+	rwlock_acquire_read (&inode->rw);
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -200,46 +677,57 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		/* A hole reads back as zeros without touching the disk;
+		 * anything else is copied straight out of the cached
+		 * sector, with no bounce buffer for partial sectors. */
+		if (sector_idx == EXTENT_HOLE)
+			memset (buffer + bytes_read, 0, chunk_size);
+		else
+			pagecache_read_at (filesys_disk, sector_idx,
+					buffer + bytes_read, sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
+	rwlock_release_read (&inode->rw);
 
 	return bytes_read;
 }
 
-/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+ * extending the inode if the write reaches past end of file.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if an error occurs or the disk fills up. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
 	if (inode->deny_write_cnt)
 		return 0;
 
+	rwlock_acquire_write (&inode->rw);
+
+	/* Grow the file if the write reaches past the current end.  If
+	 * the extension falls short the loop below clamps the write to
+	 * whatever length was reached. */
+	if (offset + size > inode->data.length)
+		inode_extend (inode, offset + size);
+
+	/* Back every sector the write touches with the disk.  If some
+	 * holes cannot be materialized, the loop below stops at the
+	 * first one left. */
+	if (size > 0 && offset < inode->data.length) {
+		off_t end = offset + size < inode->data.length
+			? offset + size : inode->data.length;
+
+		inode_materialize (inode, offset / DISK_SECTOR_SIZE,
+				(end - 1) / DISK_SECTOR_SIZE);
+	}
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -251,42 +739,323 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		int min_left = inode_left < sector_left ? inode_left : sector_left;
 
 		/* Number of bytes to actually write into this sector. */
+		int chunk_size = size < min_left ? size : min_left;
+		if (chunk_size <= 0 || sector_idx == EXTENT_HOLE)
+			break;
+
+		/* Copy straight into the cached sector; a partial write of
+		 * an uncached sector reads it in to preserve the bytes
+		 * around the chunk. */
+		pagecache_write_at (filesys_disk, sector_idx,
+				buffer + bytes_written, sector_ofs, chunk_size);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_written += chunk_size;
+	}
+	rwlock_release_write (&inode->rw);
+
+	return bytes_written;
+}
+
+/* Largest number of sectors moved per direct-I/O disk command. */
+#define DIRECT_RUN_MAX 64
+
+/* Reads SIZE bytes from INODE into BUFFER starting at OFFSET,
+ * bypassing the buffer cache for sector-aligned spans: cached
+ * copies are synced out of the cache first, then contiguous disk
+ * runs stream straight into BUFFER with multi-sector reads.
+ * Misaligned head and tail bytes and holes take the ordinary
+ * cached path.  A one-pass scan through a large file thus cannot
+ * evict the whole cache.  Returns the number of bytes read. */
+off_t
+inode_read_direct (struct inode *inode, void *buffer_, off_t size,
+		off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t bytes_read = 0;
+
+	rwlock_acquire_read (&inode->rw);
+	while (size > 0) {
+		/* Disk sector to read, starting byte offset within sector. */
+		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		int sector_ofs = offset % DISK_SECTOR_SIZE;
+
+		/* Bytes left in inode, bytes left in sector, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
+		int min_left = inode_left < sector_left ? inode_left : sector_left;
+
 		int chunk_size = size < min_left ? size : min_left;
 		if (chunk_size <= 0)
 			break;
 
+		if (sector_idx == EXTENT_HOLE)
+			memset (buffer + bytes_read, 0, chunk_size);
+		else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+			/* Aligned full sectors: gather the contiguous disk run
+			 * and move it with one disk command. */
+			size_t cnt = 1;
+
+			while (cnt < DIRECT_RUN_MAX
+					&& (off_t) ((cnt + 1) * DISK_SECTOR_SIZE) <= size
+					&& inode_left >= (off_t) ((cnt + 1) * DISK_SECTOR_SIZE)
+					&& byte_to_sector (inode, offset + cnt * DISK_SECTOR_SIZE)
+						== sector_idx + cnt)
+				cnt++;
+
+			pagecache_sync (filesys_disk, sector_idx, cnt);
+			disk_read_multi (filesys_disk, sector_idx, cnt,
+					buffer + bytes_read);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
+		} else
+			pagecache_read_at (filesys_disk, sector_idx,
+					buffer + bytes_read, sector_ofs, chunk_size);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_read += chunk_size;
+	}
+	rwlock_release_read (&inode->rw);
+
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE starting at OFFSET,
+ * bypassing the buffer cache for sector-aligned spans: contiguous
+ * disk runs stream straight from BUFFER with multi-sector writes,
+ * and stale cached copies of fully overwritten sectors are simply
+ * dropped.  Extension, materialization and the misaligned head
+ * and tail work as in inode_write_at().  Returns the number of
+ * bytes written. */
+off_t
+inode_write_direct (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t bytes_written = 0;
+
+	if (inode->deny_write_cnt)
+		return 0;
+
+	rwlock_acquire_write (&inode->rw);
+
+	if (offset + size > inode->data.length)
+		inode_extend (inode, offset + size);
+
+	if (size > 0 && offset < inode->data.length) {
+		off_t end = offset + size < inode->data.length
+			? offset + size : inode->data.length;
+
+		inode_materialize (inode, offset / DISK_SECTOR_SIZE,
+				(end - 1) / DISK_SECTOR_SIZE);
+	}
+
+	while (size > 0) {
+		/* Sector to write, starting byte offset within sector. */
+		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		int sector_ofs = offset % DISK_SECTOR_SIZE;
+
+		/* Bytes left in inode, bytes left in sector, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
+		int min_left = inode_left < sector_left ? inode_left : sector_left;
+
+		int chunk_size = size < min_left ? size : min_left;
+		if (chunk_size <= 0 || sector_idx == EXTENT_HOLE)
+			break;
+
 		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
+			/* Aligned full sectors: gather the contiguous disk run. */
+			size_t cnt = 1;
 
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
-		}
+			while (cnt < DIRECT_RUN_MAX
+					&& (off_t) ((cnt + 1) * DISK_SECTOR_SIZE) <= size
+					&& inode_left >= (off_t) ((cnt + 1) * DISK_SECTOR_SIZE)
+					&& byte_to_sector (inode, offset + cnt * DISK_SECTOR_SIZE)
+						== sector_idx + cnt)
+				cnt++;
+
+			/* The sectors are fully overwritten, so cached copies
+			 * can be dropped without writing them back. */
+			pagecache_discard (filesys_disk, sector_idx, cnt);
+			disk_write_multi (filesys_disk, sector_idx, cnt,
+					buffer + bytes_written);
+			chunk_size = cnt * DISK_SECTOR_SIZE;
+		} else
+			pagecache_write_at (filesys_disk, sector_idx,
+					buffer + bytes_written, sector_ofs, chunk_size);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_written += chunk_size;
+	}
+	rwlock_release_write (&inode->rw);
+
+	return bytes_written;
+}
+
+/* Copies SIZE bytes of SRC starting at SRC_OFS into DST starting
+ * at DST_OFS, moving the data directly between cached sectors -
+ * it never passes through an intermediate buffer.  DST is
+ * extended if the copy reaches past its end of file.  Returns the
+ * number of bytes actually copied, which may be less than SIZE if
+ * SRC ends first or the disk fills up. */
+off_t
+inode_copy_at (struct inode *dst, struct inode *src, off_t size,
+		off_t dst_ofs, off_t src_ofs) {
+	off_t bytes_copied = 0;
+
+	if (dst->deny_write_cnt)
+		return 0;
+
+	/* A write lock on DST covers both when the two are the same
+	 * inode; otherwise take the locks in address order, so that
+	 * two copies between the same pair of inodes in opposite
+	 * directions cannot deadlock. */
+	if (dst == src)
+		rwlock_acquire_write (&dst->rw);
+	else if (dst < src) {
+		rwlock_acquire_write (&dst->rw);
+		rwlock_acquire_read (&src->rw);
+	} else {
+		rwlock_acquire_read (&src->rw);
+		rwlock_acquire_write (&dst->rw);
+	}
+
+	/* Clamp to what SRC actually has, then grow DST to fit. */
+	if (src_ofs + size > src->data.length)
+		size = src->data.length - src_ofs;
+	if (size > 0 && dst_ofs + size > dst->data.length)
+		inode_extend (dst, dst_ofs + size);
+
+	/* Back every destination sector with the disk, as in
+	 * inode_write_at(); the loop stops at the first hole left. */
+	if (size > 0 && dst_ofs < dst->data.length) {
+		off_t end = dst_ofs + size < dst->data.length
+			? dst_ofs + size : dst->data.length;
+
+		inode_materialize (dst, dst_ofs / DISK_SECTOR_SIZE,
+				(end - 1) / DISK_SECTOR_SIZE);
+	}
+
+	while (size > 0) {
+		/* Sectors under either side, byte offsets within them. */
+		disk_sector_t src_sector = byte_to_sector (src, src_ofs);
+		disk_sector_t dst_sector = byte_to_sector (dst, dst_ofs);
+		int src_sector_ofs = src_ofs % DISK_SECTOR_SIZE;
+		int dst_sector_ofs = dst_ofs % DISK_SECTOR_SIZE;
+
+		/* The chunk must fit both sectors and both files. */
+		off_t src_left = src->data.length - src_ofs;
+		off_t dst_left = dst->data.length - dst_ofs;
+		int max_ofs = src_sector_ofs > dst_sector_ofs
+			? src_sector_ofs : dst_sector_ofs;
+		off_t chunk_size = DISK_SECTOR_SIZE - max_ofs;
+
+		if (chunk_size > size)
+			chunk_size = size;
+		if (chunk_size > src_left)
+			chunk_size = src_left;
+		if (chunk_size > dst_left)
+			chunk_size = dst_left;
+		if (chunk_size <= 0 || dst_sector == EXTENT_HOLE)
+			break;
+
+		if (src_sector == EXTENT_HOLE) {
+			/* A hole in SRC copies as zeros. */
+			static char zeros[DISK_SECTOR_SIZE];
+
+			pagecache_write_at (filesys_disk, dst_sector, zeros,
+					dst_sector_ofs, chunk_size);
+		} else
+			pagecache_copy (filesys_disk, src_sector, src_sector_ofs,
+					dst_sector, dst_sector_ofs, chunk_size);
+
+		/* Advance. */
+		size -= chunk_size;
+		src_ofs += chunk_size;
+		dst_ofs += chunk_size;
+		bytes_copied += chunk_size;
+	}
+
+	if (dst != src)
+		rwlock_release_read (&src->rw);
+	rwlock_release_write (&dst->rw);
+
+	return bytes_copied;
+}
+
+/* Writes SIZE bytes of INODE starting at OFFSET to the console,
+ * straight out of the cached sectors - the data never passes
+ * through a user buffer.  Returns the number of bytes written,
+ * which may be less than SIZE if end of file is reached. */
+off_t
+inode_putbuf (struct inode *inode, off_t size, off_t offset) {
+	off_t bytes_written = 0;
+
+	rwlock_acquire_read (&inode->rw);
+	while (size > 0) {
+		/* Disk sector to print, starting byte offset within sector. */
+		disk_sector_t sector_idx = byte_to_sector (inode, offset);
+		int sector_ofs = offset % DISK_SECTOR_SIZE;
+
+		/* Bytes left in inode, bytes left in sector, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int sector_left = DISK_SECTOR_SIZE - sector_ofs;
+		int min_left = inode_left < sector_left ? inode_left : sector_left;
+
+		/* Number of bytes to actually print from this sector. */
+		int chunk_size = size < min_left ? size : min_left;
+		if (chunk_size <= 0)
+			break;
+
+		if (sector_idx == EXTENT_HOLE) {
+			/* A hole prints as zeros. */
+			static char zeros[DISK_SECTOR_SIZE];
+
+			putbuf (zeros, chunk_size);
+		} else
+			pagecache_putbuf (filesys_disk, sector_idx,
+					sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
+	rwlock_release_read (&inode->rw);
 
 	return bytes_written;
 }
 
+/* Hard cap on sectors scheduled ahead of a sequential reader. */
+#define READAHEAD_MAX 64
+
+/* Schedules asynchronous reads of the next CNT sectors of INODE,
+ * starting at byte offset OFFSET, into the buffer cache.  Called
+ * when a reader looks sequential, so that by the time it asks for
+ * these sectors they are already in the cache and the disk stays
+ * busy instead of idling between requests.  CNT is chosen by the
+ * caller (filesys/file.c grows it adaptively per file) and is
+ * clamped to READAHEAD_MAX here. */
+void
+inode_readahead (struct inode *inode, off_t offset, int cnt) {
+	int i;
+
+	if (cnt > READAHEAD_MAX)
+		cnt = READAHEAD_MAX;
+	for (i = 0; i < cnt; i++, offset += DISK_SECTOR_SIZE) {
+		disk_sector_t sector = byte_to_sector (inode, offset);
+
+		if (sector == (disk_sector_t) -1)
+			break;
+		if (sector != EXTENT_HOLE)      /* Holes have nothing to read. */
+			pagecache_readahead (filesys_disk, sector);
+	}
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
@@ -311,3 +1080,16 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Returns the length recorded in the on-disk inode at SECTOR
+ * without opening it - no allocation, no open-inode table
+ * traffic.  The read comes from the buffer cache, so a stat
+ * following a prefetching readdir never touches the disk. */
+off_t
+inode_peek_length (disk_sector_t sector) {
+	off_t length;
+
+	pagecache_read_at (filesys_disk, sector,
+			&length, offsetof (struct inode_disk, length), sizeof length);
+	return length;
+}
@@ -0,0 +1,127 @@
+#include "filesys/journal.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "threads/synch.h"
+
+/* Write-ahead journal that makes write-back caching crash-safe.
+ *
+ * Before the page cache writes a batch of dirty sectors to their
+ * home locations, the sector images are first written sequentially
+ * into the journal region, followed by a commit header naming
+ * them.  A crash before the header is complete leaves the home
+ * sectors untouched; a crash after it may leave them torn, but the
+ * journal then holds complete images, which journal_recover()
+ * replays at mount.  Because every flush journals before it writes
+ * home, the journal always holds the newest image of each sector
+ * it names, so replaying the last transaction is idempotent and a
+ * single transaction slot suffices. */
+
+#define JOURNAL_MAGIC 0x4a524e4c        /* "JRNL" */
+
+/* Commit header, stored in sector JOURNAL_START.  The images
+ * follow in the next CNT sectors.  Padded to a full sector when
+ * written. */
+struct journal_header {
+	uint32_t magic;                     /* JOURNAL_MAGIC. */
+	uint32_t seq;                       /* Transaction number. */
+	uint32_t cnt;                       /* Number of images. */
+	uint32_t sectors[JOURNAL_SECTORS - 1]; /* Home sector of each image. */
+	uint32_t checksum;                  /* XOR of all fields above. */
+};
+
+static uint32_t journal_seq;
+static struct lock journal_lock;
+static bool journal_up;
+
+/* Returns the checksum over H's fields. */
+static uint32_t
+header_checksum (const struct journal_header *h) {
+	uint32_t sum = h->magic ^ h->seq ^ h->cnt;
+	size_t i;
+
+	for (i = 0; i < JOURNAL_SECTORS - 1; i++)
+		sum ^= h->sectors[i];
+	return sum;
+}
+
+/* Initializes the journal module. */
+void
+journal_init (void) {
+	ASSERT (sizeof (struct journal_header) <= DISK_SECTOR_SIZE);
+	lock_init (&journal_lock);
+	journal_up = true;
+}
+
+/* Commits CNT sector images to the journal: IMAGES holds the data
+ * back to back, SECTORS their home locations.  Returns only once
+ * the commit header is on disk, so the caller may then write the
+ * images to their home sectors knowing a crash cannot lose them.
+ * A no-op until journal_init() has run, so file systems that lay
+ * the journal region out differently are unaffected. */
+void
+journal_commit (const disk_sector_t *sectors, const void *images,
+		size_t cnt) {
+	uint8_t buf[DISK_SECTOR_SIZE];
+	struct journal_header *h = (struct journal_header *) buf;
+	size_t i;
+
+	if (!journal_up)
+		return;
+	ASSERT (cnt > 0 && cnt <= JOURNAL_SECTORS - 1);
+
+	lock_acquire (&journal_lock);
+
+	/* Images first; the transaction exists only once the header
+	 * that follows them is on disk. */
+	disk_write_multi (filesys_disk, JOURNAL_START + 1, cnt, images);
+
+	memset (buf, 0, sizeof buf);
+	h->magic = JOURNAL_MAGIC;
+	h->seq = ++journal_seq;
+	h->cnt = cnt;
+	for (i = 0; i < cnt; i++)
+		h->sectors[i] = sectors[i];
+	h->checksum = header_checksum (h);
+	disk_write (filesys_disk, JOURNAL_START, buf);
+
+	lock_release (&journal_lock);
+}
+
+/* Replays the last committed transaction, if any, writing its
+ * sector images back to their home locations.  Called at mount
+ * before any other structure is read; replay is idempotent, so an
+ * intact file system is simply rewritten with what it already
+ * holds. */
+void
+journal_recover (void) {
+	uint8_t buf[DISK_SECTOR_SIZE];
+	struct journal_header *h = (struct journal_header *) buf;
+	size_t i;
+
+	disk_read (filesys_disk, JOURNAL_START, buf);
+	if (h->magic != JOURNAL_MAGIC
+			|| h->cnt == 0 || h->cnt > JOURNAL_SECTORS - 1
+			|| h->checksum != header_checksum (h))
+		return;
+
+	for (i = 0; i < h->cnt; i++) {
+		uint8_t image[DISK_SECTOR_SIZE];
+
+		disk_read (filesys_disk, JOURNAL_START + 1 + i, image);
+		disk_write (filesys_disk, h->sectors[i], image);
+	}
+	journal_seq = h->seq;
+	printf ("Journal: replayed %"PRDSNu" sectors.\n",
+			(disk_sector_t) h->cnt);
+}
+
+/* Empties the journal by invalidating its header.  Used when the
+ * file system is formatted. */
+void
+journal_clear (void) {
+	static const uint8_t zeros[DISK_SECTOR_SIZE];
+
+	disk_write (filesys_disk, JOURNAL_START, zeros);
+}
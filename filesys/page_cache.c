@@ -1,6 +1,20 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
+#include "filesys/page_cache.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "devices/disk.h"
+#include "filesys/filesys.h"
+#include "filesys/journal.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/workqueue.h"
 #include "vm/vm.h"
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
@@ -15,10 +29,567 @@ static const struct page_operations page_cache_op = {
 
 tid_t page_cache_workerd;
 
+/* The buffer cache proper: a fixed set of PAGECACHE_SIZE sector
+ * buffers fronting all inode I/O.  Entries are found by hashing
+ * (device, sector) and recycled with the clock algorithm; writes
+ * are cached dirty and reach the disk on eviction or at shutdown
+ * through pagecache_flush().  One lock covers lookup, eviction and
+ * the data copies - sectors are small and a hit never touches the
+ * disk, so the critical sections are short except when a miss must
+ * do real I/O. */
+#define PAGECACHE_SIZE 64
+
+struct cache_ent {
+	struct disk *d;             /* Cached device, null while unused. */
+	disk_sector_t sector;       /* Sector number on D. */
+	bool dirty;                 /* Modified since it was read? */
+	bool accessed;              /* Used since the clock hand passed? */
+	bool pinned;                /* Exempt from eviction for a moment? */
+	uint8_t data[DISK_SECTOR_SIZE];
+	struct hash_elem helem;     /* Element in cache_map. */
+};
+
+static struct cache_ent cache[PAGECACHE_SIZE];
+static struct hash cache_map;   /* Maps (device, sector) to entry. */
+static size_t clock_hand;       /* Next eviction candidate. */
+static struct lock cache_lock;
+static bool cache_up;
+
+static long long hit_cnt, miss_cnt;
+
+/* Write-behind, balanced by dirty ratio.  At the background mark a
+ * flush is handed to the kernel work queue: the flusher writes the
+ * dirty entries in ascending sector order, coalescing adjacent dirty
+ * sectors into multi-sector writes, so evictions rarely have to
+ * write synchronously and the elevator sees sorted batches.  A bulk
+ * writer can still dirty entries faster than the worker drains them,
+ * and the eventual storm would bury reads - so above the throttle
+ * mark the writer is made to write one batch itself, capping the
+ * dirty ratio and keeping read latency stable. */
+#define FLUSH_BG_MARK (PAGECACHE_SIZE / 4)  /* Kick the background flusher. */
+#define FLUSH_HI_MARK (PAGECACHE_SIZE / 2)  /* Throttle the writer itself. */
+#define FLUSH_BATCH 8
+
+static struct workqueue flush_wq;
+static struct work flush_work;
+static bool flush_queued;       /* Is flush_work pending or running? */
+static size_t dirty_cnt;        /* Number of dirty entries. */
+
+static void flush_behind (void *aux);
+static bool flush_one_batch (void);
+
+/* Returns a hash for the entry's (device, sector) key. */
+static uint64_t
+cache_hash (const struct hash_elem *e_, void *aux UNUSED) {
+	const struct cache_ent *e = hash_entry (e_, struct cache_ent, helem);
+	return hash_word ((uint64_t) (uintptr_t) e->d ^ e->sector);
+}
+
+/* Orders entries by device, then sector. */
+static bool
+cache_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct cache_ent *a = hash_entry (a_, struct cache_ent, helem);
+	const struct cache_ent *b = hash_entry (b_, struct cache_ent, helem);
+
+	if (a->d != b->d)
+		return a->d < b->d;
+	return a->sector < b->sector;
+}
+
+/* Memory-pressure shrinker.  The sector buffers live in a static
+ * array, so no pages flow back from here directly; what pressure
+ * asks of the buffer cache is to stop pinning memory indirectly.
+ * Cold clean entries are dropped so later evictions are write-free,
+ * and a flush is queued so dirty data stops accumulating. */
+static size_t
+pagecache_shrink (size_t goal UNUSED, void *aux UNUSED) {
+	int i;
+
+	lock_acquire (&cache_lock);
+	for (i = 0; i < PAGECACHE_SIZE; i++) {
+		struct cache_ent *e = &cache[i];
+
+		if (e->d != NULL && !e->dirty && !e->accessed && !e->pinned) {
+			hash_delete (&cache_map, &e->helem);
+			e->d = NULL;
+		}
+	}
+	if (dirty_cnt > 0 && !flush_queued) {
+		flush_queued = true;
+		workqueue_enqueue (&flush_wq, &flush_work, flush_behind, NULL);
+	}
+	lock_release (&cache_lock);
+	return 0;
+}
+
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	if (cache_up)
+		return;
+	hash_init (&cache_map, cache_hash, cache_less, NULL);
+	lock_init (&cache_lock);
+	workqueue_create (&flush_wq, "pcache", 1);
+	palloc_register_shrinker (pagecache_shrink, NULL, "pcache");
+	cache_up = true;
+}
+
+/* Marks E dirty, kicking the write-behind flusher at the background
+ * mark and throttling the dirtier itself above the high mark.
+ * Caller must hold cache_lock. */
+static void
+mark_dirty (struct cache_ent *e) {
+	if (e->dirty)
+		return;
+	e->dirty = true;
+	if (++dirty_cnt >= FLUSH_BG_MARK && !flush_queued) {
+		flush_queued = true;
+		workqueue_enqueue (&flush_wq, &flush_work, flush_behind, NULL);
+	}
+
+	/* Past the throttle mark the writer pays for one batch write
+	 * before its own write completes, so dirtying can never outrun
+	 * the drain by more than a batch. */
+	if (dirty_cnt >= FLUSH_HI_MARK)
+		flush_one_batch ();
+}
+
+/* Returns the cache entry holding SECTOR of D, or a null pointer.
+ * Caller must hold cache_lock. */
+static struct cache_ent *
+cache_lookup (struct disk *d, disk_sector_t sector) {
+	struct cache_ent key;
+	struct hash_elem *h;
+
+	key.d = d;
+	key.sector = sector;
+	h = hash_find (&cache_map, &key.helem);
+	return h != NULL ? hash_entry (h, struct cache_ent, helem) : NULL;
+}
+
+/* Picks an entry to recycle by the clock algorithm: sweep the
+ * entries, giving each accessed entry a second chance, and take
+ * the first one that has not been used since the last sweep.
+ * Caller must hold cache_lock. */
+static struct cache_ent *
+cache_victim (void) {
+	for (;;) {
+		struct cache_ent *e = &cache[clock_hand];
+
+		clock_hand = (clock_hand + 1) % PAGECACHE_SIZE;
+		if (e->pinned)
+			continue;
+		if (e->d == NULL)
+			return e;
+		if (e->accessed) {
+			e->accessed = false;
+			continue;
+		}
+		return e;
+	}
+}
+
+/* Returns the entry caching SECTOR of D, loading it on a miss.
+ * With FILL false the sector is about to be fully overwritten, so
+ * a missing sector is not read from disk.  Caller must hold
+ * cache_lock. */
+static struct cache_ent *
+cache_get (struct disk *d, disk_sector_t sector, bool fill) {
+	struct cache_ent *e = cache_lookup (d, sector);
+
+	if (e == NULL) {
+		e = cache_victim ();
+		if (e->d != NULL) {
+			if (e->dirty) {
+				/* Journal before the home write, so a crash in
+				 * between cannot tear the sector. */
+				if (e->d == filesys_disk)
+					journal_commit (&e->sector, e->data, 1);
+				disk_write (e->d, e->sector, e->data);
+				e->dirty = false;
+				dirty_cnt--;
+			}
+			hash_delete (&cache_map, &e->helem);
+		}
+		e->d = d;
+		e->sector = sector;
+		e->dirty = false;
+		hash_insert (&cache_map, &e->helem);
+		if (fill)
+			disk_read (d, sector, e->data);
+		miss_cnt++;
+	} else
+		hit_cnt++;
+
+	e->accessed = true;
+	return e;
+}
+
+/* Reads SIZE bytes at offset OFS within SECTOR of D into BUFFER,
+ * copying straight out of the cached sector. */
+void
+pagecache_read_at (struct disk *d, disk_sector_t sector, void *buffer,
+		int ofs, int size) {
+	struct cache_ent *e;
+
+	ASSERT (ofs >= 0 && size > 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	e = cache_get (d, sector, true);
+	memcpy (buffer, e->data + ofs, size);
+	lock_release (&cache_lock);
+}
+
+/* Reads SECTOR of D into BUFFER through the cache. */
+void
+pagecache_read (struct disk *d, disk_sector_t sector, void *buffer) {
+	pagecache_read_at (d, sector, buffer, 0, DISK_SECTOR_SIZE);
+}
+
+/* Writes SIZE bytes from BUFFER at offset OFS within SECTOR of D,
+ * copying straight into the cached sector.  A partial write of an
+ * uncached sector reads it in first to preserve the surrounding
+ * bytes; a full-sector write skips the read.  The sector is only
+ * marked dirty here; it reaches the disk on eviction or at
+ * pagecache_flush(). */
+void
+pagecache_write_at (struct disk *d, disk_sector_t sector, const void *buffer,
+		int ofs, int size) {
+	struct cache_ent *e;
+
+	ASSERT (ofs >= 0 && size > 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	e = cache_get (d, sector, ofs > 0 || size < DISK_SECTOR_SIZE);
+	memcpy (e->data + ofs, buffer, size);
+	mark_dirty (e);
+	lock_release (&cache_lock);
+}
+
+/* Writes BUFFER to SECTOR of D through the cache. */
+void
+pagecache_write (struct disk *d, disk_sector_t sector, const void *buffer) {
+	pagecache_write_at (d, sector, buffer, 0, DISK_SECTOR_SIZE);
+}
+
+/* Copies SIZE bytes at offset SRC_OFS within SRC_SECTOR of D to
+ * offset DST_OFS within DST_SECTOR, moving the bytes between the
+ * two cached sectors directly - no intermediate buffer.  Pinning
+ * keeps the source sector from being recycled while the
+ * destination is faulted in. */
+void
+pagecache_copy (struct disk *d, disk_sector_t src_sector, int src_ofs,
+		disk_sector_t dst_sector, int dst_ofs, int size) {
+	ASSERT (src_ofs >= 0 && size > 0 && src_ofs + size <= DISK_SECTOR_SIZE);
+	ASSERT (dst_ofs >= 0 && dst_ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	if (src_sector == dst_sector) {
+		/* Overlapping copy within a single sector. */
+		struct cache_ent *e = cache_get (d, src_sector, true);
+
+		memmove (e->data + dst_ofs, e->data + src_ofs, size);
+		mark_dirty (e);
+	} else {
+		struct cache_ent *src, *dst;
+
+		src = cache_get (d, src_sector, true);
+		src->pinned = true;
+		dst = cache_get (d, dst_sector,
+				dst_ofs > 0 || size < DISK_SECTOR_SIZE);
+		src->pinned = false;
+		memcpy (dst->data + dst_ofs, src->data + src_ofs, size);
+		mark_dirty (dst);
+	}
+	lock_release (&cache_lock);
+}
+
+/* Writes SIZE bytes at offset OFS within SECTOR of D to the
+ * console, straight out of the cached sector. */
+void
+pagecache_putbuf (struct disk *d, disk_sector_t sector, int ofs, int size) {
+	struct cache_ent *e;
+
+	ASSERT (ofs >= 0 && size > 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	lock_acquire (&cache_lock);
+	e = cache_get (d, sector, true);
+	putbuf ((const char *) e->data + ofs, size);
+	lock_release (&cache_lock);
+}
+
+/* Drops CNT sectors starting at SECTOR of D from the cache
+ * without writing them back.  Called when sectors are freed, so a
+ * stale entry can neither serve reads of, nor be flushed over, a
+ * later reallocation of the same sectors. */
+void
+pagecache_discard (struct disk *d, disk_sector_t sector, size_t cnt) {
+	lock_acquire (&cache_lock);
+	while (cnt-- > 0) {
+		struct cache_ent *e = cache_lookup (d, sector++);
+
+		if (e != NULL) {
+			hash_delete (&cache_map, &e->helem);
+			e->d = NULL;
+			if (e->dirty) {
+				e->dirty = false;
+				dirty_cnt--;
+			}
+		}
+	}
+	lock_release (&cache_lock);
+}
+
+/* Writes back and drops CNT sectors starting at SECTOR of D.
+ * Called before a direct read streams the sectors from the disk,
+ * so it sees any newer cached data - and no entries are left
+ * behind for a scan that will not reuse them. */
+void
+pagecache_sync (struct disk *d, disk_sector_t sector, size_t cnt) {
+	lock_acquire (&cache_lock);
+	while (cnt-- > 0) {
+		struct cache_ent *e = cache_lookup (d, sector++);
+
+		if (e != NULL) {
+			if (e->dirty) {
+				if (e->d == filesys_disk)
+					journal_commit (&e->sector, e->data, 1);
+				disk_write (e->d, e->sector, e->data);
+				e->dirty = false;
+				dirty_cnt--;
+			}
+			hash_delete (&cache_map, &e->helem);
+			e->d = NULL;
+		}
+	}
+	lock_release (&cache_lock);
+}
+
+/* A readahead in flight: the disk dispatcher reads the sector
+ * into DATA and the completion callback moves it into the cache. */
+struct readahead {
+	struct disk *d;             /* Device being read. */
+	disk_sector_t sector;       /* Sector number on D. */
+	uint8_t data[DISK_SECTOR_SIZE];
+};
+
+/* Completion callback for a readahead: inserts the sector into
+ * the cache unless it arrived there some other way in the
+ * meantime.  Runs in the disk dispatcher thread, which must never
+ * block on its own request queue, so no write-back can be started
+ * here: if the only victim available is dirty, the readahead is
+ * simply dropped. */
+static void
+readahead_done (void *aux) {
+	struct readahead *ra = aux;
+
+	lock_acquire (&cache_lock);
+	if (cache_lookup (ra->d, ra->sector) == NULL) {
+		struct cache_ent *e = cache_victim ();
+
+		if (e->d == NULL || !e->dirty) {
+			if (e->d != NULL)
+				hash_delete (&cache_map, &e->helem);
+			e->d = ra->d;
+			e->sector = ra->sector;
+			e->dirty = false;
+			e->accessed = false;
+			memcpy (e->data, ra->data, DISK_SECTOR_SIZE);
+			hash_insert (&cache_map, &e->helem);
+		}
+	}
+	lock_release (&cache_lock);
+	free (ra);
+}
+
+/* Schedules an asynchronous read of SECTOR of D into the cache
+ * through the disk request queue.  The caller does not wait; a
+ * later pagecache_read of the sector hits in the cache if the
+ * readahead won the race.  A sector already cached, or a failed
+ * allocation, makes this a no-op. */
+void
+pagecache_readahead (struct disk *d, disk_sector_t sector) {
+	struct readahead *ra;
+	bool cached;
+
+	lock_acquire (&cache_lock);
+	cached = cache_lookup (d, sector) != NULL;
+	lock_release (&cache_lock);
+	if (cached)
+		return;
+
+	ra = malloc (sizeof *ra);
+	if (ra == NULL)
+		return;
+	ra->d = d;
+	ra->sector = sector;
+	disk_submit_read (d, sector, 1, ra->data, readahead_done, ra);
+}
+
+/* Warm-start manifest: the set of file-system sectors resident at
+ * shutdown, persisted in PAGECACHE_WARMUP_SECTOR.  Boot after boot
+ * the appliance reads the same initd binary and configuration
+ * files cold, so the residency set at the previous shutdown is a
+ * good predictor of the first reads after the next mount.
+ * pagecache_warmup() feeds the manifest to the readahead path, so
+ * the prefetch streams through the disk request queue in sector
+ * order while early boot continues. */
+#define WARMUP_MAGIC 0x5741524d         /* "WARM" */
+#define WARMUP_MAX ((DISK_SECTOR_SIZE - 12) / 4)
+
+struct warmup_header {
+	uint32_t magic;             /* WARMUP_MAGIC. */
+	uint32_t cnt;               /* Number of manifest sectors. */
+	uint32_t sectors[WARMUP_MAX]; /* Hot sectors, ascending. */
+	uint32_t checksum;          /* XOR of all fields above. */
+};
+
+/* Returns the checksum over H's fields. */
+static uint32_t
+warmup_checksum (const struct warmup_header *h) {
+	uint32_t sum = h->magic ^ h->cnt;
+	size_t i;
+
+	for (i = 0; i < WARMUP_MAX; i++)
+		sum ^= h->sectors[i];
+	return sum;
+}
+
+/* Orders manifest sectors ascending. */
+static int
+warmup_compare (const void *a_, const void *b_) {
+	const uint32_t *a = a_;
+	const uint32_t *b = b_;
+
+	return *a < *b ? -1 : *a > *b;
+}
+
+/* Writes the warm-start manifest: every file-system sector
+ * resident in the cache right now, sorted so next boot's prefetch
+ * is one elevator pass.  Called at shutdown, alongside the final
+ * flush.  An empty manifest is still written, so a stale one from
+ * an earlier boot cannot outlive the cache contents it described. */
+void
+pagecache_warmup_save (void) {
+	static uint8_t buf[DISK_SECTOR_SIZE];
+	struct warmup_header *h = (struct warmup_header *) buf;
+	int i;
+
+	if (!cache_up)
+		return;
+
+	ASSERT (sizeof (struct warmup_header) <= DISK_SECTOR_SIZE);
+
+	memset (buf, 0, sizeof buf);
+	h->magic = WARMUP_MAGIC;
+	lock_acquire (&cache_lock);
+	for (i = 0; i < PAGECACHE_SIZE && h->cnt < WARMUP_MAX; i++) {
+		struct cache_ent *e = &cache[i];
+
+		if (e->d == filesys_disk && e->sector != PAGECACHE_WARMUP_SECTOR)
+			h->sectors[h->cnt++] = e->sector;
+	}
+	lock_release (&cache_lock);
+
+	qsort (h->sectors, h->cnt, sizeof *h->sectors, warmup_compare);
+	h->checksum = warmup_checksum (h);
+	disk_write (filesys_disk, PAGECACHE_WARMUP_SECTOR, buf);
+}
+
+/* Schedules background prefetch of the sectors the previous boot
+ * left hot.  Called right after mount; the reads go through the
+ * request queue asynchronously, so boot does not wait - the first
+ * file opens either hit in the cache or lose the race and read as
+ * they always did.  A missing or torn manifest is ignored. */
+void
+pagecache_warmup (void) {
+	static uint8_t buf[DISK_SECTOR_SIZE];
+	struct warmup_header *h = (struct warmup_header *) buf;
+	uint32_t i;
+
+	if (!cache_up)
+		return;
+
+	disk_read (filesys_disk, PAGECACHE_WARMUP_SECTOR, buf);
+	if (h->magic != WARMUP_MAGIC || h->cnt > WARMUP_MAX
+			|| h->checksum != warmup_checksum (h))
+		return;
+	for (i = 0; i < h->cnt; i++)
+		if (h->sectors[i] < disk_size (filesys_disk))
+			pagecache_readahead (filesys_disk, h->sectors[i]);
+}
+
+/* Writes the batch of dirty sectors with the lowest sector number
+ * back to disk: up to FLUSH_BATCH adjacent dirty sectors become one
+ * multi-sector write.  Returns false once nothing is dirty.
+ * Caller must hold cache_lock, which stays held across the write
+ * so no one can race a newer copy of these sectors to the disk. */
+static bool
+flush_one_batch (void) {
+	static uint8_t buf[FLUSH_BATCH * DISK_SECTOR_SIZE];
+	disk_sector_t secs[FLUSH_BATCH];
+	struct cache_ent *best = NULL;
+	disk_sector_t start;
+	size_t cnt;
+	int i;
+
+	for (i = 0; i < PAGECACHE_SIZE; i++) {
+		struct cache_ent *e = &cache[i];
+
+		if (e->d != NULL && e->dirty
+				&& (best == NULL || e->d < best->d
+					|| (e->d == best->d && e->sector < best->sector)))
+			best = e;
+	}
+	if (best == NULL)
+		return false;
+
+	start = best->sector;
+	for (cnt = 0; cnt < FLUSH_BATCH; cnt++) {
+		struct cache_ent *e = cache_lookup (best->d, start + cnt);
+
+		if (e == NULL || !e->dirty)
+			break;
+		memcpy (buf + cnt * DISK_SECTOR_SIZE, e->data, DISK_SECTOR_SIZE);
+		secs[cnt] = start + cnt;
+		e->dirty = false;
+		dirty_cnt--;
+	}
+	/* Journal the batch before the home write, so a crash in
+	 * between replays these images instead of leaving torn
+	 * metadata behind. */
+	if (best->d == filesys_disk)
+		journal_commit (secs, buf, cnt);
+	disk_write_multi (best->d, start, cnt, buf);
+	return true;
+}
+
+/* Write-behind worker, run on the kernel work queue.  Flushes
+ * every dirty entry, releasing the lock between batches so cache
+ * users only ever wait for one batch-sized write. */
+static void
+flush_behind (void *aux UNUSED) {
+	lock_acquire (&cache_lock);
+	while (flush_one_batch ()) {
+		lock_release (&cache_lock);
+		thread_cond_resched ();
+		lock_acquire (&cache_lock);
+	}
+	flush_queued = false;
+	lock_release (&cache_lock);
+}
+
+/* Writes every dirty entry back to disk.  Called at shutdown. */
+void
+pagecache_flush (void) {
+	if (!cache_up)
+		return;
+
+	lock_acquire (&cache_lock);
+	while (flush_one_batch ())
+		continue;
+	lock_release (&cache_lock);
 }
 
 /* Initialize the page cache */
@@ -2,6 +2,7 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -17,11 +18,25 @@ typedef uint32_t disk_sector_t;
 
 void disk_init (void);
 void disk_print_stats (void);
+void disk_get_totals (long long *read_sectors, long long *write_sectors,
+		long long *merges);
 
 struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
+size_t disk_queue_depth (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_read_multi (struct disk *, disk_sector_t, size_t, void *);
+void disk_write_multi (struct disk *, disk_sector_t, size_t, const void *);
+
+/* Asynchronous interface.  The transfer is queued and DONE is
+   called with AUX from the per-channel dispatcher thread once it
+   completes; the buffer must stay valid until then. */
+typedef void disk_done_func (void *aux);
+void disk_submit_read (struct disk *, disk_sector_t, size_t, void *,
+		disk_done_func *, void *aux);
+void disk_submit_write (struct disk *, disk_sector_t, size_t, const void *,
+		disk_done_func *, void *aux);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
@@ -6,6 +6,7 @@
 
 void input_init (void);
 void input_putc (uint8_t);
+void input_notify (void);
 uint8_t input_getc (void);
 bool input_full (void);
 
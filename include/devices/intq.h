@@ -1,36 +1,38 @@
 #ifndef DEVICES_INTQ_H
 #define DEVICES_INTQ_H
 
-#include "threads/interrupt.h"
-#include "threads/synch.h"
-
-/* An "interrupt queue", a circular buffer shared between
-   kernel threads and external interrupt handlers.
-
-   Interrupt queue functions can be called from kernel threads or
-   from external interrupt handlers.  Except for intq_init(),
-   interrupts must be off in either case.
-
-   The interrupt queue has the structure of a "monitor".  Locks
-   and condition variables from threads/synch.h cannot be used in
-   this case, as they normally would, because they can only
-   protect kernel threads from one another, not from interrupt
-   handlers. */
-
-/* Queue buffer size, in bytes. */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* An "interrupt queue", a lock-free circular buffer shared
+   between one producer and one consumer, where either side may be
+   an external interrupt handler and the other a kernel thread.
+
+   The data path takes no lock and does not disable interrupts:
+   the producer only writes `head', the consumer only writes
+   `tail', and both indices run free (they are reduced modulo
+   INTQ_BUFSIZE only when indexing the buffer).  Interrupts are
+   disabled only on the slow path, when a thread must sleep on a
+   full or empty queue or wake the other side.
+
+   A producer may enqueue a burst of bytes with intq_putc() and
+   then wake the consumer once with intq_notify(), so a burst
+   costs one wakeup rather than one per byte. */
+
+/* Queue buffer size, in bytes.  Must be a power of 2. */
 #define INTQ_BUFSIZE 64
 
 /* A circular queue of bytes. */
 struct intq {
+	/* Queue. */
+	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
+	size_t head;                /* New data is written here.  Producer-owned. */
+	size_t tail;                /* Old data is read here.  Consumer-owned. */
+
 	/* Waiting threads. */
-	struct lock lock;           /* Only one thread may wait at once. */
 	struct thread *not_full;    /* Thread waiting for not-full condition. */
 	struct thread *not_empty;   /* Thread waiting for not-empty condition. */
-
-	/* Queue. */
-	uint8_t buf[INTQ_BUFSIZE];  /* Buffer. */
-	int head;                   /* New data is written here. */
-	int tail;                   /* Old data is read here. */
 };
 
 void intq_init (struct intq *);
@@ -38,5 +40,6 @@ bool intq_empty (const struct intq *);
 bool intq_full (const struct intq *);
 uint8_t intq_getc (struct intq *);
 void intq_putc (struct intq *, uint8_t);
+void intq_notify (struct intq *);
 
 #endif /* devices/intq.h */
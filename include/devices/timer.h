@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -9,15 +11,51 @@
 
 void timer_init(void);
 void timer_calibrate(void);
+void timer_enter_idle(void);
 
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
 
+/** #Project 3: TSC 시계 - 부팅 이후 나노초. timer_calibrate() 이후 유효. */
+int64_t ktime_ns(void);
+
+/** #Project 3: Boot Timing - TSC 사이클을 마이크로초로 변환. */
+int64_t timer_cycles_to_us(uint64_t cycles);
+
+/** #Project 3: vDSO 시간 페이지 - 틱과 TSC 보정값이 담긴 커널 페이지.
+ *  process.c가 모든 유저 주소 공간의 VDSO_TIME_VADDR에 읽기 전용으로
+ *  매핑한다. 보정 전이면 NULL. */
+void *timer_vdso_page(void);
+
 void timer_sleep(int64_t ticks);
 void timer_msleep(int64_t milliseconds);
 void timer_usleep(int64_t microseconds);
 void timer_nsleep(int64_t nanoseconds);
 
+/** #Project 3: Sub-tick Delay - TSC 보정 busy-wait. 잠들지 않으므로
+ *  인터럽트가 꺼진 구간에서도 안전하다. */
+void ndelay(int64_t nanoseconds);
+void udelay(int64_t microseconds);
+
 void timer_print_stats(void);
 
+/** #Project 3: Kernel Timer - 전용 스레드 없는 틱 단위 콜백. 타이머 휠에
+ *  걸어 두면 만료 시 타이머 softirq(ksoftirqd)에서 인터럽트가 켜진 채
+ *  실행된다. 구조체는 호출자가 소유하며 콜백보다 오래 살아야 한다. */
+typedef void ktimer_func(void *aux);
+
+struct ktimer {
+    ktimer_func *func;     /* 만료 시 실행할 콜백 */
+    void *aux;             /* 콜백 인자 */
+    int64_t expires;       /* 만료 틱 */
+    int64_t period;        /* 0이면 one-shot, 양수면 주기(틱) */
+    struct list_elem elem; /* 휠 버킷 또는 ready 리스트의 원소 */
+    bool active;           /* 휠이나 ready에 걸려 있음 */
+    bool ready;            /* 만료되어 콜백 실행 대기 중 */
+};
+
+void ktimer_init(struct ktimer *t, ktimer_func *func, void *aux);
+void ktimer_start(struct ktimer *t, int64_t delay, int64_t period);
+bool ktimer_cancel(struct ktimer *t);
+
 #endif /* devices/timer.h */
@@ -13,14 +13,29 @@ struct file {
     bool deny_write;     /* Has file_deny_write() been called? */
 
     /** #Project 2: Extend File Descriptor */
-    int dup_count;
+    /** #Project 3: 공유 열린 파일 - 이 객체를 가리키는 fd 참조 수.
+     *  dup2/fork의 공유 fd는 복제 대신 참조만 올리고, 마지막 참조의
+     *  file_close()가 실제로 해제한다. 갱신은 원자적이다. */
+    int ref_cnt;
     /** ---------------------------------- */
+
+    /** #Project 3: Pipe - inode 없는 파이프 끝단이면 비NULL */
+    struct pipe *pipe;
+    bool pipe_writer; /* 쓰기 끝단 여부 */
+
+    /** #Project 3: Readahead - 순차 접근 감지용, 직전 읽기가 끝난 오프셋 */
+    off_t read_end;
+    int ra_window; /* 현재 readahead 창 (섹터 수, 0이면 아직 순차 아님) */
+
+    /** #Project 3: Direct I/O - 버퍼 캐시를 우회하는 스트리밍 모드 여부 */
+    bool direct;
 };
 
 /* Opening and closing files. */
 struct file *file_open(struct inode *);
 struct file *file_reopen(struct file *);
 struct file *file_duplicate(struct file *file);
+struct file *file_dup_ref(struct file *);
 void file_close(struct file *);
 struct inode *file_get_inode(struct file *);
 
@@ -30,6 +45,10 @@ off_t file_read_at(struct file *, void *, off_t size, off_t start);
 off_t file_write(struct file *, const void *, off_t);
 off_t file_write_at(struct file *, const void *, off_t size, off_t start);
 
+/** #Project 3: Sendfile - 유저 메모리를 거치지 않는 파일 간/콘솔 전송 */
+off_t file_sendfile(struct file *dst, struct file *src, off_t size);
+off_t file_send_console(struct file *, off_t size);
+
 /* Preventing writes. */
 void file_deny_write(struct file *);
 void file_allow_write(struct file *);
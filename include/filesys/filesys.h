@@ -16,5 +16,9 @@ void filesys_done (void);
 bool filesys_create (const char *name, off_t initial_size);
 struct file *filesys_open (const char *name);
 bool filesys_remove (const char *name);
+int filesys_create_many (const char *const *names, const off_t *initial_sizes,
+		int cnt);
+int filesys_remove_many (const char *const *names, int cnt);
+off_t filesys_stat (const char *name);
 
 #endif /* filesys/filesys.h */
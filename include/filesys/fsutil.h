@@ -6,5 +6,6 @@ void fsutil_cat (char **argv);
 void fsutil_rm (char **argv);
 void fsutil_put (char **argv);
 void fsutil_get (char **argv);
+void fsutil_bench_disk (char **argv);
 
 #endif /* filesys/fsutil.h */
@@ -0,0 +1,19 @@
+#ifndef FILESYS_JOURNAL_H
+#define FILESYS_JOURNAL_H
+
+#include <stddef.h>
+#include "devices/disk.h"
+
+/* Sectors reserved for the write-ahead journal, right after the
+ * free map and root directory inodes.  Room for one transaction:
+ * a commit header plus up to JOURNAL_SECTORS - 1 sector images. */
+#define JOURNAL_START 2
+#define JOURNAL_SECTORS 16
+
+void journal_init (void);
+void journal_recover (void);
+void journal_clear (void);
+void journal_commit (const disk_sector_t *sectors, const void *images,
+		size_t cnt);
+
+#endif /* filesys/journal.h */
@@ -1,12 +1,35 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
+#include "devices/disk.h"
+#include "filesys/journal.h"
 #include "vm/vm.h"
 
+/* Sector holding the warm-start manifest, right after the journal
+ * region.  Reserved in the free map the same way the journal is. */
+#define PAGECACHE_WARMUP_SECTOR (JOURNAL_START + JOURNAL_SECTORS)
+
 struct page;
 enum vm_type;
 
 struct page_cache {};
 
-void page_cache_init (void);
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+
+/* Buffer cache fronting inode I/O. */
+void pagecache_read (struct disk *, disk_sector_t, void *);
+void pagecache_write (struct disk *, disk_sector_t, const void *);
+void pagecache_read_at (struct disk *, disk_sector_t, void *,
+		int ofs, int size);
+void pagecache_write_at (struct disk *, disk_sector_t, const void *,
+		int ofs, int size);
+void pagecache_copy (struct disk *, disk_sector_t src_sector, int src_ofs,
+		disk_sector_t dst_sector, int dst_ofs, int size);
+void pagecache_putbuf (struct disk *, disk_sector_t, int ofs, int size);
+void pagecache_readahead (struct disk *, disk_sector_t);
+void pagecache_discard (struct disk *, disk_sector_t, size_t cnt);
+void pagecache_sync (struct disk *, disk_sector_t, size_t cnt);
+void pagecache_flush (void);
+void pagecache_warmup (void);
+void pagecache_warmup_save (void);
 #endif
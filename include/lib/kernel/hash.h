@@ -54,11 +54,20 @@ typedef bool hash_less_func (const struct hash_elem *a,
  * data AUX. */
 typedef void hash_action_func (struct hash_elem *e, void *aux);
 
-/* Hash table. */
+/* Hash table.
+
+   A resize does not move every element at once: the outgoing
+   bucket array is kept in OLD_BUCKETS and drained a few buckets
+   at a time by subsequent insertions and deletions, so no single
+   operation ever pays for the whole table. */
 struct hash {
 	size_t elem_cnt;            /* Number of elements in table. */
 	size_t bucket_cnt;          /* Number of buckets, a power of 2. */
 	struct list *buckets;       /* Array of `bucket_cnt' lists. */
+	struct list *old_buckets;   /* Buckets still draining after a resize. */
+	size_t old_bucket_cnt;      /* Number of old buckets, a power of 2. */
+	size_t migrate_idx;         /* Next old bucket to migrate. */
+	uint64_t seed;              /* Per-table seed, mixed into bucket choice. */
 	hash_hash_func *hash;       /* Hash function. */
 	hash_less_func *less;       /* Comparison function. */
 	void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -93,7 +102,11 @@ struct hash_elem *hash_cur (struct hash_iterator *);
 size_t hash_size (struct hash *);
 bool hash_empty (struct hash *);
 
-/* Sample hash functions. */
+/* Sample hash functions.  hash_word is the fast path for
+ * word-size keys (addresses, sector numbers): one multiply
+ * instead of a byte loop.  hash_bytes and hash_string remain for
+ * keys without a word-size representation. */
+uint64_t hash_word (uint64_t);
 uint64_t hash_bytes (const void *, size_t);
 uint64_t hash_string (const char *);
 uint64_t hash_int (int);
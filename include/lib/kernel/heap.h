@@ -0,0 +1,58 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Intrusive pairing heap.
+ *
+ * Like the linked list and hash table, the heap does not use
+ * dynamic allocation: each structure that can be in a heap must
+ * embed a struct heap_elem member, and the heap_entry macro
+ * converts back to the enclosing structure.
+ *
+ * The element that orders first according to the comparison
+ * function sits at the root, so the top element can be peeked in
+ * O(1).  Insertion and melding are O(1); removal (of the root or
+ * an arbitrary element) is O(log n) amortized.  Pass a
+ * "greater than" comparison to get a max-heap. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element.  PREV points at the parent for a first child and
+   at the previous sibling otherwise; a detached element has all
+   three pointers null. */
+struct heap_elem {
+    struct heap_elem *child;   /* First child. */
+    struct heap_elem *sibling; /* Next sibling. */
+    struct heap_elem *prev;    /* Parent or previous sibling. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER) \
+    ((STRUCT *)((uint8_t *)&(HEAP_ELEM)->child - offsetof(STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should order before B
+   (closer to the root). */
+typedef bool heap_less_func(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+
+/* Heap. */
+struct heap {
+    struct heap_elem *root; /* Tree root, or null if empty. */
+    heap_less_func *less;   /* Ordering. */
+    void *aux;              /* Auxiliary data for LESS. */
+};
+
+void heap_init(struct heap *, heap_less_func *, void *aux);
+bool heap_empty(const struct heap *);
+struct heap_elem *heap_top(const struct heap *);
+void heap_insert(struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop(struct heap *);
+void heap_remove(struct heap *, struct heap_elem *);
+void heap_update(struct heap *, struct heap_elem *);
+bool heap_contains(const struct heap *, const struct heap_elem *);
+
+#endif /* lib/kernel/heap.h */
@@ -122,6 +122,7 @@ struct list_elem *list_tail (struct list *);
 void list_insert (struct list_elem *, struct list_elem *);
 void list_splice (struct list_elem *before,
 		struct list_elem *first, struct list_elem *last);
+void list_splice_tail (struct list *dst, struct list *src);
 void list_push_front (struct list *, struct list_elem *);
 void list_push_back (struct list *, struct list_elem *);
 
@@ -160,4 +161,68 @@ void list_unique (struct list *, struct list *duplicates,
 struct list_elem *list_max (struct list *, list_less_func *, void *aux);
 struct list_elem *list_min (struct list *, list_less_func *, void *aux);
 
+/* Counted list: a list plus a size maintained across every
+ * operation, for queue-depth checks that would otherwise pay the
+ * O(n) list_size() walk or track the count by hand.  The wrapped
+ * list must only be modified through the clist_* functions. */
+struct clist {
+	struct list list;           /* Underlying list. */
+	size_t size;                /* Number of elements. */
+};
+
+static inline void
+clist_init (struct clist *cl) {
+	list_init (&cl->list);
+	cl->size = 0;
+}
+
+static inline void
+clist_push_front (struct clist *cl, struct list_elem *elem) {
+	list_push_front (&cl->list, elem);
+	cl->size++;
+}
+
+static inline void
+clist_push_back (struct clist *cl, struct list_elem *elem) {
+	list_push_back (&cl->list, elem);
+	cl->size++;
+}
+
+static inline struct list_elem *
+clist_pop_front (struct clist *cl) {
+	cl->size--;
+	return list_pop_front (&cl->list);
+}
+
+static inline struct list_elem *
+clist_pop_back (struct clist *cl) {
+	cl->size--;
+	return list_pop_back (&cl->list);
+}
+
+/* ELEM must be an element of CL. */
+static inline struct list_elem *
+clist_remove (struct clist *cl, struct list_elem *elem) {
+	cl->size--;
+	return list_remove (elem);
+}
+
+static inline size_t
+clist_size (const struct clist *cl) {
+	return cl->size;
+}
+
+static inline bool
+clist_empty (const struct clist *cl) {
+	return cl->size == 0;
+}
+
+/* Moves every element of SRC to the end of DST in O(1). */
+static inline void
+clist_splice_tail (struct clist *dst, struct clist *src) {
+	list_splice_tail (&dst->list, &src->list);
+	dst->size += src->size;
+	src->size = 0;
+}
+
 #endif /* lib/kernel/list.h */
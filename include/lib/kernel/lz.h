@@ -0,0 +1,40 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+/* Byte-oriented LZ77 compressor in the LZ4 mold.
+
+   The stream is a series of sequences: a token byte whose high
+   nibble is the literal count and low nibble the match length
+   (minus the 4-byte minimum), either nibble extended by
+   additional bytes when it saturates at 15; then the literals;
+   then a two-byte little-endian backward offset.  The final
+   sequence carries literals only and simply exhausts the input.
+
+   Match finding is a single-probe hash of 4-byte windows, so
+   compression is one pass with no allocation; the caller
+   provides LZ_WORKSPACE_SIZE bytes of scratch for the hash
+   table.  Decompression needs no workspace.  The format stores
+   no lengths of its own: the caller is expected to record the
+   compressed and uncompressed sizes, which both sides of a
+   paging or caching tier already track. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Scratch space for lz_compress, in bytes. */
+#define LZ_WORKSPACE_SIZE 2048
+
+/* Compresses SRC_LEN bytes at SRC into DST, using WORKSPACE for
+   the match table.  Returns the compressed size, or 0 if the
+   output does not fit in DST_CAP bytes (incompressible data
+   never fits a DST_CAP below SRC_LEN plus framing). */
+size_t lz_compress (const void *src, size_t src_len, void *dst,
+		size_t dst_cap, void *workspace);
+
+/* Expands SRC_LEN compressed bytes at SRC into exactly DST_LEN
+   bytes at DST.  Returns false if the stream is malformed or
+   produces any other length. */
+bool lz_decompress (const void *src, size_t src_len, void *dst,
+		size_t dst_len);
+
+#endif /* lib/kernel/lz.h */
@@ -0,0 +1,59 @@
+#ifndef __LIB_KERNEL_OMAP_H
+#define __LIB_KERNEL_OMAP_H
+
+/* Open-addressing hash map.
+
+   An alternative to the chained hash table in hash.h for hot
+   lookup paths.  Keys are plain 64-bit integers (an address, a
+   sector number) stored inline next to their value pointer, and
+   collisions are resolved by linear probing through one flat
+   power-of-two array: a probe walks consecutive slots sharing a
+   few cache lines instead of chasing list pointers, and never
+   calls a comparator through a function pointer.
+
+   Values must be non-null; a null value marks a free slot.
+   Deletion backward-shifts the rest of the probe run, so the
+   table never accumulates tombstones. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* One slot: an inline key next to its value. */
+struct omap_slot {
+	uint64_t key;
+	void *val;                  /* Null while the slot is free. */
+};
+
+/* Map. */
+struct omap {
+	struct omap_slot *slots;    /* CAP slots. */
+	size_t cap;                 /* Capacity, a power of two. */
+	size_t cnt;                 /* Occupied slots. */
+};
+
+/* Iterator: a plain scan over the slot array.  Insertions may
+   grow the table and invalidate iterators; deletions of other
+   keys may reorder unvisited entries. */
+struct omap_iterator {
+	const struct omap *m;
+	size_t idx;
+};
+
+/* Destructor for omap_clear() and omap_destroy(). */
+typedef void omap_destroy_func (uint64_t key, void *val);
+
+bool omap_init (struct omap *);
+void omap_clear (struct omap *, omap_destroy_func *);
+void omap_destroy (struct omap *, omap_destroy_func *);
+
+void *omap_find (const struct omap *, uint64_t key);
+bool omap_insert (struct omap *, uint64_t key, void *val);
+void *omap_delete (struct omap *, uint64_t key);
+
+size_t omap_size (const struct omap *);
+
+void omap_first (struct omap_iterator *, const struct omap *);
+void *omap_next (struct omap_iterator *);
+
+#endif /* lib/kernel/omap.h */
@@ -0,0 +1,61 @@
+#ifndef __LIB_KERNEL_PERCPU_H
+#define __LIB_KERNEL_PERCPU_H
+
+/* Per-CPU statistics counters.
+
+   A counter is an array of cache-line-padded slots, one per CPU;
+   an increment touches only the current CPU's line and a read
+   sums across the slots.  That keeps always-on instrumentation
+   off the cache lines of the code being measured and, once more
+   than one CPU runs, keeps two CPUs bumping the same counter
+   from bouncing a line between them.
+
+   Increments are plain (not atomic): a lost tick of a diagnostic
+   counter is not worth an atomic on a hot path.  Pintos runs one
+   CPU today, so pcpu_id() is constant, but every counter built on
+   this is laid out for PCPU_MAX from the start. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Counter slots provisioned per counter.  Today only CPU 0 ever
+   runs; raise this along with pcpu_id() when SMP lands. */
+#define PCPU_MAX 4
+
+/* x86 cache line size in bytes. */
+#define PCPU_CACHELINE 64
+
+/* One slot, padded out to a full cache line. */
+struct pcpu_slot {
+	int64_t val;
+	char pad[PCPU_CACHELINE - sizeof (int64_t)];
+};
+
+/* Counter: one padded slot per CPU. */
+struct pcpu_counter {
+	struct pcpu_slot slot[PCPU_MAX]
+		__attribute__ ((aligned (PCPU_CACHELINE)));
+};
+
+/* Returns the identifier of the executing CPU. */
+static inline size_t
+pcpu_id (void) {
+	return 0;
+}
+
+/* Adds N to counter C on the current CPU. */
+static inline void
+pcpu_add (struct pcpu_counter *c, int64_t n) {
+	c->slot[pcpu_id ()].val += n;
+}
+
+/* Increments counter C on the current CPU. */
+static inline void
+pcpu_inc (struct pcpu_counter *c) {
+	pcpu_add (c, 1);
+}
+
+int64_t pcpu_sum (const struct pcpu_counter *);
+void pcpu_reset (struct pcpu_counter *);
+
+#endif /* lib/kernel/percpu.h */
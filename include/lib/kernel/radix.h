@@ -0,0 +1,55 @@
+#ifndef __LIB_KERNEL_RADIX_H
+#define __LIB_KERNEL_RADIX_H
+
+/* Radix tree keyed by page number.
+
+   Virtual addresses are dense and structured, so instead of
+   hashing them the tree indexes three levels of 512-slot nodes
+   with 9-bit key fields, covering 27 bits of page number (39 bits
+   of address).  Lookups are three dependent loads with no hash
+   function and no comparator callback, and the tree yields keys
+   in sorted order, which gives range walks (munmap, madvise,
+   address-space copy) ordered iteration for free.
+
+   Values must be non-null; interior nodes are allocated one page
+   at a time and pruned as their last slot empties. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Key field width per level and derived constants. */
+#define VM_RADIX_BITS 9
+#define VM_RADIX_SIZE ((uint64_t) 1 << VM_RADIX_BITS)
+#define VM_RADIX_MASK (VM_RADIX_SIZE - 1)
+#define VM_RADIX_LEVELS 3
+
+/* Largest representable key, exclusive. */
+#define VM_RADIX_LIMIT ((uint64_t) 1 << (VM_RADIX_BITS * VM_RADIX_LEVELS))
+
+/* One node: exactly a page of child or value slots. */
+struct vm_radix_node {
+	void *slot[VM_RADIX_SIZE];
+};
+
+/* Tree. */
+struct vm_radix {
+	struct vm_radix_node *root; /* Top-level node, null while empty. */
+	size_t cnt;                 /* Number of values stored. */
+};
+
+/* Destructor for vm_radix_destroy(). */
+typedef void vm_radix_destroy_func (uint64_t key, void *val);
+
+void vm_radix_init (struct vm_radix *);
+void vm_radix_destroy (struct vm_radix *, vm_radix_destroy_func *);
+
+void *vm_radix_find (const struct vm_radix *, uint64_t key);
+bool vm_radix_insert (struct vm_radix *, uint64_t key, void *val);
+void *vm_radix_delete (struct vm_radix *, uint64_t key);
+
+size_t vm_radix_size (const struct vm_radix *);
+
+void *vm_radix_next (const struct vm_radix *, uint64_t start, uint64_t *key);
+
+#endif /* lib/kernel/radix.h */
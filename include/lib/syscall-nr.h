@@ -36,6 +36,143 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MADVISE,                /* Advise the VM layer about a VA range. */
+	SYS_PIPE,                   /* Create a unidirectional data channel. */
+	SYS_SPAWN,                  /* Create a process running an executable. */
+	SYS_READV,                  /* Read into multiple buffers at once. */
+	SYS_WRITEV,                 /* Write from multiple buffers at once. */
+	SYS_SBRK,                   /* Move the program break. */
+	SYS_SHM_OPEN,               /* Open or create a shared-memory segment. */
+	SYS_SHM_MAP,                /* Map a shared-memory segment. */
+	SYS_SUBMIT,                 /* Run a batch of syscalls in one entry. */
+	SYS_SENDFILE,               /* Copy between fds through the page cache. */
+	SYS_PREAD,                  /* Read at an offset, ignoring the position. */
+	SYS_PWRITE,                 /* Write at an offset, ignoring the position. */
+	SYS_CREATE_MANY,            /* Create a batch of files in one entry. */
+	SYS_REMOVE_MANY,            /* Delete a batch of files in one entry. */
+	SYS_FADVISE,                /* Advise the kernel about fd access. */
+	SYS_STAT,                   /* Query a file's size without opening it. */
+	SYS_KSTATS,                 /* Fill a struct kstats with kernel counters. */
+	SYS_VMINSPECT,              /* Snapshot the calling process's page table. */
+	SYS_FUTEX,                  /* Wait on / wake an address (user sync). */
+	SYS_GETRUSAGE,              /* Fill a struct thread_usage for the caller. */
+	SYS_MEMLIMIT,               /* Set the caller's soft resident-set limit. */
+	SYS_CHECKPOINT,             /* Serialize the caller's image to the swap disk. */
+
+	SYS_CNT                     /* Number of syscalls; keep last. */
+};
+
+/* Advice values for madvise. */
+#define MADV_WILLNEED 0         /* Range is needed soon: fetch it now. */
+#define MADV_DONTNEED 1         /* Range is done with: drop frames and slots. */
+#define MADV_SEQUENTIAL 2       /* Range is scanned once: evict behind the cursor. */
+#define MADV_RANDOM 3           /* No usable pattern: normal eviction (default). */
+
+/* Operations for futex. */
+#define FUTEX_WAIT 0            /* Block while *uaddr still equals val. */
+#define FUTEX_WAKE 1            /* Wake up to val waiters on uaddr. */
+
+/* Advice values for fadvise. */
+#define FADV_NORMAL 0           /* Default cached, readahead I/O. */
+#define FADV_DIRECT 1           /* One-pass scan: stream around the cache. */
+
+/* One segment of a readv/writev transfer. */
+struct iovec {
+	void *iov_base;             /* Starting address. */
+	unsigned long iov_len;      /* Number of bytes. */
+};
+
+/* Maximum segments per readv/writev call. */
+#define UIO_MAXIOV 64
+
+/* Maximum names per create_many/remove_many call. */
+#define FS_BATCH_MAX 128
+
+/* One queued operation for the submit() batch syscall.  The kernel
+ * fills RESULT with the operation's return value. */
+struct syscall_desc {
+	unsigned long nr;           /* SYS_* number; file I/O subset only. */
+	unsigned long args[3];      /* Arguments, as the syscall takes them. */
+	long result;                /* Return value, written by the kernel. */
+};
+
+/* Maximum operations per submit() call. */
+#define SUBMIT_MAX 64
+
+/* Structured kernel counters for the kstats() syscall.  VERSION is
+ * written by the kernel; readers check it before trusting the rest,
+ * so fields may be appended (bumping KSTATS_VERSION) without
+ * breaking old binaries.  All counters are monotonic since boot;
+ * fleet monitoring polls deltas. */
+#define KSTATS_VERSION 1
+
+/* Room for VM counters beyond the current enum vm_stat_kind. */
+#define KSTATS_VM_MAX 16
+
+struct kstats {
+	int version;                /* KSTATS_VERSION of the writing kernel. */
+
+	/* Scheduler (threads/thread.c). */
+	long long idle_ticks;       /* Timer ticks spent idle. */
+	long long kernel_ticks;     /* Timer ticks in kernel threads. */
+	long long user_ticks;       /* Timer ticks in user programs. */
+
+	/* Memory (threads/palloc.c). */
+	long long user_free_pages;  /* Free pages in the user pool. */
+	long long kernel_free_pages;/* Free pages in the kernel pool. */
+
+	/* Disk (devices/disk.c), summed across ATA devices. */
+	long long disk_read_sectors;
+	long long disk_write_sectors;
+	long long disk_merges;      /* Requests merged in the queue. */
+
+	/* VM (vm/stat.c), indexed by enum vm_stat_kind. */
+	int vm_stat_cnt;            /* Valid entries in vm_stat[]. */
+	long long vm_stat[KSTATS_VM_MAX];
+};
+
+/* Per-thread CPU usage for the getrusage() syscall.  Cycle totals
+ * are sampled with the TSC at context-switch boundaries, so they are
+ * exact for every completed slice and include the running slice up
+ * to the moment of the call; tick counters give the coarse
+ * user/kernel split the timer interrupt observes. */
+struct thread_usage {
+	long long cpu_us;           /* Total on-CPU time, microseconds. */
+	long long cpu_cycles;       /* Total on-CPU TSC cycles. */
+	long long user_ticks;       /* Timer ticks while running user code. */
+	long long kernel_ticks;     /* Timer ticks while in the kernel. */
+};
+
+/* One page-table entry snapshot for the vminspect() syscall, which
+ * copies the whole address space's worth in one call -- a bulk
+ * replacement for probing pages one trap at a time.  Entries arrive
+ * in ascending address order. */
+struct vm_page_info {
+	void *va;                   /* User virtual address of the page. */
+	int type;                   /* VM type: 0 uninit, 1 anon, 2 file. */
+	char resident;              /* Nonzero if a frame backs the page. */
+	char dirty;                 /* Hardware dirty bit; resident pages only. */
+	long long swap_slot;        /* Swap slot holding the contents, or -1. */
+};
+
+/* Shared read-only time page, mapped at VDSO_TIME_VADDR in every
+ * user address space (the page just below the stack region).  The
+ * calibration fields are written once, before the first process
+ * starts, and never change; TICKS is republished by the timer
+ * interrupt as a single aligned store, so a lock-free reader can
+ * never see a torn value.  gettime() in lib/user/syscall.c turns
+ * this into nanoseconds since boot without entering the kernel. */
+#define VDSO_TIME_VADDR 0x4737f000
+#define VDSO_TIME_MAGIC 0x54494d45  /* "TIME" */
+
+struct vdso_time {
+	unsigned magic;                  /* VDSO_TIME_MAGIC once live. */
+	long long ticks;                 /* Timer ticks since boot. */
+	unsigned long long boot_tsc;     /* TSC value at tick zero. */
+	unsigned long long tsc_per_tick; /* TSC cycles per timer tick. */
+	unsigned long long ns_per_tick;  /* Nanoseconds per timer tick. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -41,6 +42,34 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int madvise (void *addr, size_t length, int advice);
+int pipe (int fds[2]);
+pid_t spawn (const char *cmd_line);
+struct iovec;
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int sendfile (int dst_fd, int src_fd, unsigned length);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int create_many (const char *const *names, const unsigned *sizes, int cnt);
+int remove_many (const char *const *names, int cnt);
+int fadvise (int fd, int advice);
+int stat (const char *file);
+struct kstats;
+int kstats (struct kstats *buf);
+struct vm_page_info;
+int vminspect (struct vm_page_info *buf, int cnt);
+int futex (int *uaddr, int op, int val);
+struct thread_usage;
+int getrusage (struct thread_usage *buf);
+int memlimit (int pages);
+int64_t gettime (void);
+int checkpoint (void);
+void *sbrk (intptr_t increment);
+int shm_open (const char *name, size_t size);
+void *shm_map (int id, void *addr);
+struct syscall_desc;
+int submit (struct syscall_desc *descs, int cnt);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
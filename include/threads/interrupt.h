@@ -73,10 +73,12 @@ typedef void intr_handler_func(struct intr_frame *);
 void intr_init(void);
 void intr_register_ext(uint8_t vec, intr_handler_func *, const char *name);
 void intr_register_int(uint8_t vec, int dpl, enum intr_level, intr_handler_func *, const char *name);
+void intr_install_fast_entry(uint8_t vec, void (*entry)(void));
 bool intr_context(void);
 void intr_yield_on_return(void);
 
 void intr_dump_frame(const struct intr_frame *);
 const char *intr_name(uint8_t vec);
+void intr_print_stats(void);
 
 #endif /* threads/interrupt.h */
@@ -13,4 +13,8 @@
 typedef void intr_stub_func (void);
 extern intr_stub_func *intr_stubs[256];
 
+/* Dedicated page-fault entry that skips the full register save on
+ * the resolve path; see intr-stubs.S and exception.c. */
+void intr0e_fast (void);
+
 #endif /* threads/intr-stubs.h */
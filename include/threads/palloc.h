@@ -19,5 +19,25 @@ void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_user_pool_bounds (void **base, size_t *page_cnt);
+size_t palloc_user_pool_free_cnt (void);
+size_t palloc_kernel_pool_free_cnt (void);
+void palloc_drain_magazine (void);
+void palloc_start_zerod (void);
+
+/* DMA zone: physically contiguous, boundary-constrained buffers
+ * for bus-master devices.  BOUNDARY, if nonzero, is a power-of-two
+ * byte count the allocation must not cross.  Returns zeroed pages,
+ * or a null pointer if the zone cannot satisfy the request. */
+void *palloc_get_dma (size_t page_cnt, size_t boundary);
+void palloc_free_dma (void *, size_t page_cnt);
+
+/* Memory-pressure shrinker: asked to release up to GOAL pages'
+ * worth of memory by the cache's own replacement order; returns
+ * roughly how many pages it released.  Invoked by palloc when the
+ * pools run dry, before the allocation is failed. */
+typedef size_t palloc_shrinker_func (size_t goal, void *aux);
+void palloc_register_shrinker (palloc_shrinker_func *, void *aux,
+		const char *name);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,38 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <list.h>
+#include <stdbool.h>
+
+/* Minimal read-copy-update for reader-heavy, rarely-written kernel
+   lists.  Readers bracket traversals with rcu_read_lock() and
+   rcu_read_unlock(); these touch nothing but a per-thread nesting
+   counter and a global reader count, so a hot-path walk pays no lock
+   and no interrupt toggle.  Writers unlink in place (forward list
+   traversal survives a concurrent list_remove, which leaves the
+   removed node's next pointer intact) and hand the storage to
+   rcu_defer(); the free runs once no reader that might still hold the
+   pointer remains.  See threads/rcu.c. */
+
+/* Deferred-callback type: invoked in thread context once all read
+   sections that predate the rcu_defer() call have ended. */
+typedef void rcu_callback_func(void *aux);
+
+/* Embed one of these in any object whose free is deferred, so the
+   writer path never allocates. */
+struct rcu_head {
+    rcu_callback_func *func; /* Reclamation callback. */
+    void *aux;               /* Argument for FUNC. */
+    struct list_elem elem;   /* Pending-callback list element. */
+};
+
+void rcu_init(void);
+
+void rcu_read_lock(void);
+void rcu_read_unlock(void);
+bool rcu_readers_active(void);
+
+void rcu_defer(struct rcu_head *head, rcu_callback_func *func, void *aux);
+void synchronize_rcu(void);
+
+#endif /* threads/rcu.h */
@@ -0,0 +1,34 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+
+#include "threads/synch.h"
+
+/* Slab cache for fixed-size kernel objects.
+
+   malloc() rounds every request up to a power of 2 and funnels all
+   requests of that class through one shared descriptor, so a hot
+   fixed-size object both wastes the round-up slack and contends on
+   the descriptor lock with unrelated allocations.  A slab cache
+   packs objects of exactly one size into pages of its own, reuses
+   freed objects LIFO so the most recently touched object (still
+   cache-hot) is handed out first, and staggers each new slab's
+   starting offset by a cache line so the same hot field of
+   different objects does not pile onto one cache set. */
+struct slab_cache {
+    const char *name;      /* For debugging. */
+    size_t obj_size;       /* Object size, pointer-aligned. */
+    size_t objs_per_slab;  /* Objects carved from one page. */
+    size_t color_max;      /* Page slack usable for coloring. */
+    size_t color_next;     /* Next slab's color offset. */
+    struct list free_list; /* Free objects across all slabs. */
+    struct lock lock;      /* Per-cache lock. */
+};
+
+void slab_cache_init(struct slab_cache *, const char *name, size_t obj_size);
+void *slab_alloc(struct slab_cache *);
+void slab_free(struct slab_cache *, void *);
+
+#endif /* threads/slab.h */
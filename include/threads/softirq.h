@@ -0,0 +1,19 @@
+#ifndef THREADS_SOFTIRQ_H
+#define THREADS_SOFTIRQ_H
+
+/** #Project 3: Softirq - 하드 인터럽트 핸들러는 최소한의 상태만 기록하고
+ *  softirq_raise()로 pending 비트를 세운다. 미뤄진 작업(bottom half)은
+ *  ksoftirqd 스레드에서 인터럽트가 켜진 채로 실행된다. */
+enum softirq_nr {
+    SOFTIRQ_KBD,   /* 키보드 스캔코드 해석 (devices/kbd.c) */
+    SOFTIRQ_TIMER, /* 만료된 커널 타이머 콜백 (devices/timer.c) */
+    SOFTIRQ_CNT
+};
+
+typedef void softirq_func(void);
+
+void softirq_init(void);
+void softirq_register(enum softirq_nr nr, softirq_func *func);
+void softirq_raise(enum softirq_nr nr);
+
+#endif /* threads/softirq.h */
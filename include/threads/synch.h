@@ -1,25 +1,45 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, max-heap on priority. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t timeout_ticks);
 void sema_self_test (void);
 
+/* Per-lock contention statistics, collected with the ktime_ns()
+   clock for locks that register a (static) stat block via
+   lock_register_stat().  Dumped by lock_print_stats() at
+   shutdown.  Times are in nanoseconds. */
+struct lock_stat {
+	const char *name;           /* Name for the dump. */
+	int64_t acquires;           /* Total acquisitions. */
+	int64_t contended;          /* Acquisitions that had to wait. */
+	int64_t wait_total;         /* Total time spent waiting. */
+	int64_t wait_max;           /* Longest single wait. */
+	int64_t hold_total;         /* Total time the lock was held. */
+	int64_t hold_max;           /* Longest single hold. */
+	int64_t acquired_at;        /* Start of the current hold. */
+	struct list_elem elem;      /* Element in the stat dump list. */
+};
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct lock_stat *stat;     /* Contention stats, or NULL. */
 };
 
 void lock_init (struct lock *);
@@ -27,6 +47,8 @@ void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_register_stat (struct lock *, struct lock_stat *, const char *name);
+void lock_print_stats (void);
 
 /* Condition variable. */
 struct condition {
@@ -35,9 +57,30 @@ struct condition {
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t timeout_ticks);
 void cond_signal(struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.  Any number of readers may hold it at once;
+   writers hold it exclusively.  Waiting writers block the entry of
+   new readers, so a steady stream of readers cannot starve them.
+   State is guarded semaphore-style by disabling interrupts, so the
+   uncontended reader path is a single counter update with no inner
+   lock to contend on. */
+struct rwlock {
+	int readers;                /* Active readers. */
+	bool writing;               /* A writer is active. */
+	int waiting_writers;        /* Writers blocked at entry. */
+	struct list read_waiters;   /* Threads blocked for read access. */
+	struct list write_waiters;  /* Threads blocked for write access. */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+
 /** #Priority Scheduling - Synchronization 함수 */
 
 bool cmp_sem_priority(const struct list_elem *, const struct list_elem *, void *);
@@ -5,13 +5,17 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "threads/interrupt.h"
+#include "threads/rcu.h"
 #include "threads/synch.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/stat.h"
 #endif
 
 
@@ -42,57 +46,79 @@ typedef int tid_t;
 #define FDT_PAGES     3                     // test `multi-oom` 테스트용
 #define FDCOUNT_LIMIT FDT_PAGES * (1 << 9)  // 엔트리가 512개 인 이유: 페이지 크기 4kb / 파일 포인터 8byte
 
+/** #Project 3: Thread 스택 분리 - 커널 스택 할당 페이지 수.
+ *  최하위 페이지는 매핑을 해제한 guard, 그 위가 실제 스택이다. */
+#define THREAD_STACK_PAGES 2
+
+/** #Project 3: Sampling Profiler - 타이머 틱마다 중단된 rip을 담는 스레드별
+ *  링. '-rip-prof' 커널 옵션으로 켜며, 종료 시 히스토그램으로 덤프한 주소를
+ *  kernel.o에 대고 오프라인으로 심볼화한다. */
+#define RIP_PROF_LEN 256  // 2의 거듭제곱 (마스크 인덱싱)
+struct rip_prof {
+    uint64_t rip[RIP_PROF_LEN]; /* 최근 샘플 (free-running head) */
+    uint64_t taken;             /* 총 샘플 수 */
+};
+
+extern bool rip_prof_active;
+
+/** #Project 3: Group Scheduling - 프로세스 트리 단위 CPU 과금. 같은
+ *  우선순위 레벨 안에서는 vtime(지분으로 나눈 누적 틱)이 가장 뒤처진
+ *  그룹의 스레드가 먼저 뽑혀, 넓게 fork한 배치 작업이 싱글 스레드
+ *  서비스를 밀어내지 못한다. */
+struct sched_group {
+    int64_t vtime; /* 지분 가중 누적 CPU 틱 */
+    int shares;    /* CPU 지분 (기본 100) */
+    int refs;      /* 소속 스레드 수 (0이면 슬롯 재사용) */
+};
+
+void thread_sched_group_detach(tid_t tid);
+
+/** #Project 3: CPU 사용량 - 현재 스레드의 적산값 (진행 중 슬라이스 포함) */
+void thread_get_usage(long long *cycles, long long *uticks, long long *kticks);
+
 /* A kernel thread or user process.
  *
- * Each thread structure is stored in its own 4 kB page.  The
- * thread structure itself sits at the very bottom of the page
- * (at offset 0).  The rest of the page is reserved for the
- * thread's kernel stack, which grows downward from the top of
- * the page (at offset 4 kB).  Here's an illustration:
+ * The thread structure is allocated from a slab cache, and the
+ * kernel stack lives in its own THREAD_STACK_PAGES allocation
+ * pointed to by `kstack'.  The lowest stack page is an unmapped
+ * guard page, and the bottom word of the usable stack page holds
+ * a pointer back to the thread structure, which is how
+ * thread_current() finds it from `rsp':
  *
- *      4 kB +---------------------------------+
+ *      8 kB +---------------------------------+
  *           |          kernel stack           |
  *           |                |                |
- *           |                |                |
  *           |                V                |
  *           |         grows downward          |
  *           |                                 |
- *           |                                 |
- *           |                                 |
- *           |                                 |
- *           |                                 |
- *           |                                 |
- *           |                                 |
- *           |                                 |
- *           +---------------------------------+
- *           |              magic              |
- *           |            intr_frame           |
- *           |                :                |
- *           |                :                |
- *           |               name              |
- *           |              status             |
- *      0 kB +---------------------------------+
+ *           |     back-pointer to thread      |
+ *      4 kB +---------------------------------+
+ *           |           guard page            |
+ *           |           (unmapped)            |
+ *  kstack-> +---------------------------------+
  *
  * The upshot of this is twofold:
  *
- *    1. First, `struct thread' must not be allowed to grow too
- *       big.  If it does, then there will not be enough room for
- *       the kernel stack.  Our base `struct thread' is only a
- *       few bytes in size.  It probably should stay well under 1
- *       kB.
+ *    1. A runaway kernel stack faults on the guard page instead
+ *       of silently corrupting the thread structure, so kernel
+ *       functions still should not allocate large structures or
+ *       arrays as non-static local variables.  Use dynamic
+ *       allocation with malloc() or palloc_get_page() instead.
  *
- *    2. Second, kernel stacks must not be allowed to grow too
- *       large.  If a stack overflows, it will corrupt the thread
- *       state.  Thus, kernel functions should not allocate large
- *       structures or arrays as non-static local variables.  Use
- *       dynamic allocation with malloc() or palloc_get_page()
- *       instead.
+ *    2. `struct thread' no longer shares a page with the stack,
+ *       so growing it costs slab space, not stack headroom.  It
+ *       must stay within the slab size limit (a quarter page).
  *
- * The first symptom of either of these problems will probably be
- * an assertion failure in thread_current(), which checks that
- * the `magic' member of the running thread's `struct thread' is
- * set to THREAD_MAGIC.  Stack overflow will normally change this
- * value, triggering the assertion. */
+ * The guard page makes overflow detection a hardware matter: a
+ * runaway stack faults there and userprog/exception.c panics
+ * with a distinct message.  The `magic' member survives only as
+ * a debug-build backstop -- thread_current() ASSERTs that it
+ * still reads THREAD_MAGIC, catching pointer bugs that hand out
+ * something that is not a thread, and like every ASSERT it
+ * compiles out of NDEBUG builds, leaving the hot path check-free
+ * there. */
+struct child_status;
+
 /* The `elem' member has a dual purpose.  It can be an element in
  * the run queue (thread.c), or it can be an element in a
  * semaphore wait list (synch.c).  It can be used these two ways
@@ -100,29 +126,78 @@ typedef int tid_t;
  * ready state is on the run queue, whereas only a thread in the
  * blocked state is on a semaphore wait list. */
 typedef struct thread {
-    /* Owned by thread.c. */
-    tid_t tid;                 /* Thread identifier. */
+    /** #Project 3: Cache Layout - 필드는 온도순으로 묶여 있다. 첫 캐시라인
+     *  (64B)은 스케줄링 이벤트마다 닿는 필드 전용이고, 그 뒤로 동기화/할당
+     *  경로의 warm 필드, 마지막에 디버깅·프로세스 메타데이터 cold 필드가
+     *  온다. 아래 _Static_assert가 hot 그룹의 경계를 지킨다. */
+
+    /* --- Hot: 스케줄러가 모든 이벤트에서 닿는다 (첫 캐시라인) --- */
     enum thread_status status; /* Thread state. */
-    char name[16];             /* Name (for debugging purposes). */
     int priority;              /* Priority. */
-
     /* Shared between thread.c and synch.c. */
     struct list_elem elem; /* List element. */
-
     /** #Project 1: Alarm Clock */
     int64_t wakeup_tick; /* 활성화 틱 */
+    /** #Project 1: Advanced Scheduler (mlfqs면 틱마다) */
+    int niceness;       /* Niceness. */
+    int recent_cpu;     /* 최근 CPU 점유 시간 */
+    int recent_cpu_seq; /* recent_cpu에 decay를 접은 마지막 초 */
+    tid_t tid;          /* Thread identifier. */
 
+    /* --- Warm: 동기화·타이머·페이지 할당 경로 --- */
     /** #Project 1: Priority Donation */
     int original_priority;          /* 기존 Priority */
     struct lock *wait_lock;         /* 대기중인 lock */
-    struct list donations;          /* Donation List. */
-    struct list_elem donation_elem; /* Donation Element. */
+    struct heap donations;          /* Donation max-heap (기부자 우선순위 순) */
+    struct heap_elem donation_elem; /* Donation Element. */
+
+    /** #Project 3: Compact Wait Queue - semaphore 대기열이 우선순위
+     *  max-heap이라 wakeup이 O(log waiters)다. blocked_on은 기부로 키가
+     *  바뀐 대기자를 제 heap에서 찾아 갱신할 때 쓴다. */
+    struct heap_elem wait_elem;     /* semaphore waiters heap 원소 */
+    struct semaphore *blocked_on;   /* 대기 중인 semaphore, 아니면 NULL */
+
+    /** #Project 3: Timed Wait - 타이머 휠 전용 elem. elem은 semaphore
+     *  대기열이 쓰므로, 시한부 대기 스레드는 두 리스트에 동시에 걸린다. */
+    struct list_elem timer_elem;
+    bool timed_wait; /* 시한부 대기로 휠에 등록되어 있음 */
+    bool timed_out;  /* 마지막 시한부 대기가 만료로 끝났음 */
+
+    /** #Project 3: Latency Class - 블록 진입 시각과 깨어난 뒤의 짧은
+     *  우선순위 부스트. 오래 자고 짧게 도는 I/O-bound 스레드를 compute
+     *  job 위 레벨 큐에 태운다. thread.c의 Latency Class 주석 참고. */
+    int64_t block_ns; /* 블록 진입 시각 (ktime_ns), 0이면 기록 없음 */
+    int lat_boost;    /* 남은 부스트 레벨 (레벨 큐 선택에만 반영) */
+    int ready_level;  /* 실제로 들어가 있는 레벨 큐 인덱스 */
+
+    /** #Project 3: RCU - 열려 있는 read 섹션 중첩 깊이. threads/rcu.c 참고 */
+    int rcu_nesting;
+
+    /** #Project 3: CPU 사용량 - 문맥 전환 경계에서 TSC로 적산한다.
+     *  sched_in_tsc는 이 스레드가 마지막으로 CPU를 받은 시점. */
+    uint64_t sched_in_tsc; /* 슬라이스 시작 TSC */
+    uint64_t cpu_cycles;   /* 완료된 슬라이스들의 누적 사이클 */
+    long long utick_cnt;   /* 유저 코드 실행 중 맞은 틱 */
+    long long ktick_cnt;   /* 커널에서 맞은 틱 */
 
-    /** #Project 1: Advanced Scheduler */
-    int niceness;              /* Niceness. */
-    int recent_cpu;            /* 최근 CPU 점유 시간 */
     struct list_elem all_elem; /* 살아있는 모든 Thread 연결 */
 
+    /** #Project 3: Group Scheduling - 이 스레드의 틱이 과금되는 그룹.
+     *  프로세스 트리(spawn된 프로세스와 그 fork 자손)가 한 그룹이다. */
+    struct sched_group *sched_group;
+
+    /** #Project 3: Page Magazine - user pool 단일 페이지 per-thread 캐시.
+     *  pool lock 없이 pop/push하고 배치 단위로만 pool과 주고받는다. */
+    void *page_mag[16];
+    int page_mag_cnt;
+
+    /* --- Cold: 디버깅용, 생성/소멸 시 한 번, 프로세스 메타데이터 --- */
+    char name[16]; /* Name (for debugging purposes). */
+    void *kstack;  /* Kernel stack allocation (guard page first). */
+
+    /** #Project 3: Sampling Profiler ('-rip-prof' 옵션일 때만 할당) */
+    struct rip_prof *rip_prof;
+
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint64_t *pml4; /* Page map level 4 */
@@ -130,30 +205,81 @@ typedef struct thread {
     /** #Project 2: System Call */
     int exit_status;
 
-    int fd_idx;              // 파일 디스크립터 인덱스
+    int fd_idx;              // 파일 디스크립터 high-water mark
     struct file **fdt;       // 파일 디스크립터 테이블
+    struct syscall_prof *syscall_prof;  // syscall 프로파일 (-syscall-prof 옵션)
+    struct bitmap *fd_map;   // 사용 중인 fd 슬롯 비트맵 (최하위 빈 슬롯 O(1) 할당)
     struct file *runn_file;  // 실행중인 파일
 
     struct intr_frame parent_if;  // 부모 프로세스 if
-    struct list child_list;
-    struct list_elem child_elem;
 
-    struct semaphore fork_sema;  // fork가 완료될 때 signal
-    struct semaphore exit_sema;  // 자식 프로세스 종료 signal
-    struct semaphore wait_sema;  // exit_sema를 기다릴 때 사용
+    /** #Project 3: User Copy - 사용자 버퍼 복사 중 해소되지 않는 폴트를
+     *  맞았을 때 복귀할 주소. 복사 루프 밖에서는 NULL이다. */
+    void *usercopy_fixup;
+
+    /** #Project 3: Process Arena - 프로세스 수명 커널 객체용 범프 할당자.
+     *  process_cleanup()에서 페이지째 반납한다. process.c 참고. */
+    void *arena_chunks; /* palloc 페이지 체인 (첫 워드 = 다음 페이지) */
+    size_t arena_used;  /* 선두 페이지에서 쓴 바이트 */
+    void *arena_free;   /* 반납 객체 재활용 리스트 */
+
+    /** #Project 3: 종료 상태 블록 - 좀비 스레드 페이지를 없앤다. */
+    struct child_status *my_status;  // 부모와 공유하는 종료 상태 블록
+    struct hash child_hash;          // 자식 상태 블록 해시 (tid 키)
+    bool child_hash_ready;           // 첫 자식 생성 때 lazy 초기화
     /** ----------------------- */
 #endif
 
 #ifdef VM
     /* Table for whole virtual memory owned by thread. */
     struct supplemental_page_table spt;
+
+    /** #Project 3: Stack Growth - 유저 rsp 저장 (커널 진입 시) */
+    void *user_rsp;
+
+    /* Per-process VM counters; see vm/stat.c. */
+    struct vm_stat vm_stat;
+
+    /* Previous faulting page, for sequential-pattern detection in
+     * the swap readahead path. */
+    void *last_fault_va;
+
+    /* Swap slots this process currently holds; see vm/anon.c. */
+    size_t swap_slots;
+
+    /* Frames this process owns right now and its soft limit, in
+     * pages; zero limit means unlimited.  Over the limit, eviction
+     * prefers this process's own frames; see vm/vm.c. */
+    size_t rss_cnt;
+    size_t rss_limit;
+
+    /** #Project 3: sbrk - 힙 시작과 현재 program break */
+    void *heap_start;
+    void *heap_break;
+
+    /** #Project 3: Thrash Control - 컨트롤러 상태; vm/thrash.c 참고 */
+    bool thrash_park;              /* 다음 폴트 체크포인트에서 정지 */
+    struct semaphore thrash_sema;  /* 정지 동안 down 상태 */
+    struct list_elem thrash_elem;  /* 정지 목록 연결 */
+    long long thrash_last_major;   /* 지난 샘플 시점의 major fault 수 */
 #endif
 
+    /** #Project 3: RCU - all_list 순회자가 남아 있는 동안 스레드 반납을
+     *  미루기 위한 콜백 저장소. do_schedule() 참고 */
+    struct rcu_head rcu;
+
     /* Owned by thread.c. */
     struct intr_frame tf; /* Information for switching */
     unsigned magic;       /* Detects stack overflow. */
 } thread_t;
 
+/** #Project 3: Cache Layout - hot 그룹이 첫 캐시라인(64B)을 벗어나면
+ *  컴파일이 깨진다. 필드를 더할 때 이 경계를 의식하라는 뜻이다. */
+_Static_assert(offsetof(thread_t, status) == 0,
+        "scheduler-hot fields must start the struct");
+_Static_assert(offsetof(thread_t, tid) + sizeof(tid_t) <= 64,
+        "scheduler-hot group must fit in the first cache line");
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
@@ -162,8 +288,13 @@ extern bool thread_mlfqs;
 /** #Project 1: Alarm Clock 함수 */
 void thread_sleep(int64_t ticks);
 void thread_awake(int64_t ticks);
-void update_next_tick_to_awake(int64_t ticks);
-int64_t get_next_tick_to_awake(void);
+
+/** #Project 3: Tickless Idle */
+int64_t thread_earliest_wakeup(void);
+
+/** #Project 3: Timed Wait - 시한부 대기의 휠 등록/해제 (인터럽트 비활성) */
+void thread_register_timeout(int64_t deadline);
+void thread_cancel_timeout(struct thread *th);
 
 /** #Project 1: Priority Scheduling 함수 */
 void test_max_priority(void);
@@ -176,17 +307,22 @@ void refresh_priority(void);
 
 /** #Project 1: Advance Scheduler 함수 */
 void mlfqs_priority(struct thread *t);
-void mlfqs_recent_cpu(struct thread *t);
 void mlfqs_load_avg(void);
 void mlfqs_increment(void);
-void mlfqs_recalc_recent_cpu(void);
-void mlfqs_recalc_priority(void);
 
 void thread_init(void);
 void thread_start(void);
 
 void thread_tick(void);
 void thread_print_stats(void);
+void thread_get_ticks(long long *idle, long long *kernel, long long *user);
+
+/** #Project 3: Thrash Control - 모든 스레드 순회 (인터럽트 비활성 상태로 호출됨) */
+typedef void thread_action_func(struct thread *t, void *aux);
+void thread_foreach(thread_action_func *func, void *aux);
+
+/** #Project 3: Sampling Profiler - 타이머 인터럽트에서 호출 */
+void thread_sample_rip(uint64_t rip);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
@@ -201,6 +337,9 @@ const char *thread_name(void);
 void thread_exit(void) NO_RETURN;
 void thread_yield(void);
 
+/** #Project 3: Cooperative Preemption - 더 높은 우선순위가 READY면 양보 */
+void thread_cond_resched(void);
+
 int thread_get_priority(void);
 void thread_set_priority(int);
 
@@ -0,0 +1,44 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** #Project 3: Event Trace - 전역 lock-free 링에 고정 크기 이벤트를 기록하는
+ *  ftrace류 장치. 스케줄러/페이지 폴트/디스크/시스템 콜 경로에 tracepoint가
+ *  박혀 있고, '-trace' 커널 옵션이나 trace_start()로 켠다. 스톨 직전 수십
+ *  ms 동안 무슨 일이 있었는지를 trace_dump()로 재구성한다. */
+
+/* Tracepoint 종류 */
+enum trace_id {
+    TRACE_SCHED,      /* arg1 = 이전 tid, arg2 = 다음 tid */
+    TRACE_FAULT,      /* arg1 = 폴트 주소, arg2 = write 여부 */
+    TRACE_DISK_READ,  /* arg1 = 섹터 번호, arg2 = 채널*2+디바이스 */
+    TRACE_DISK_WRITE, /* arg1 = 섹터 번호, arg2 = 채널*2+디바이스 */
+    TRACE_SYSCALL,    /* arg1 = 시스템 콜 번호, arg2 = 첫 인자 */
+    TRACE_ID_CNT
+};
+
+/* 이벤트 레코드 하나 (링 슬롯) */
+struct trace_event {
+    uint64_t tsc;  /* 기록 시점 rdtsc */
+    uint64_t id;   /* enum trace_id */
+    uint64_t arg1; /* 이벤트별 인자 1 */
+    uint64_t arg2; /* 이벤트별 인자 2 */
+};
+
+extern bool trace_enabled;
+
+void trace_event(enum trace_id id, uint64_t arg1, uint64_t arg2);
+void trace_start(void);
+void trace_stop(void);
+void trace_dump(void);
+
+/* tracepoint 매크로 - 꺼져 있으면 플래그 검사 한 번이 전부다. */
+#define TRACE(id, arg1, arg2)                                      \
+    do {                                                           \
+        if (trace_enabled)                                         \
+            trace_event(id, (uint64_t)(arg1), (uint64_t)(arg2));   \
+    } while (0)
+
+#endif /* threads/trace.h */
@@ -0,0 +1,36 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdint.h>
+
+/** #Project 3: Workqueue - 백그라운드 작업(스왑 writeback, write-behind,
+ *  readahead 등)을 기능마다 전용 스레드를 만들지 않고 공유 kworker 풀에서
+ *  실행한다. work는 호출자 구조체에 내장하므로 enqueue 경로에 할당이 없어
+ *  softirq 등 어떤 문맥에서도 호출할 수 있다. */
+
+typedef void work_func(void *aux);
+
+/* 실행할 작업 하나. 호출자가 소유하며 실행이 끝나기 전까지 재사용 금지. */
+struct work {
+    work_func *func;       /* 실행할 함수 */
+    void *aux;             /* 함수 인자 */
+    struct list_elem elem; /* 큐 대기 리스트 연결 */
+};
+
+/* 작업 큐. max_active로 큐별 동시 실행 수를 제한한다. */
+struct workqueue {
+    const char *name;      /* 디버깅용 이름 */
+    struct clist pending;  /* 대기 중인 work 목록 (깊이 O(1) 조회) */
+    int active;            /* 현재 실행 중인 work 수 */
+    int max_active;        /* 동시 실행 상한 */
+    int64_t executed;      /* 누적 실행 수 (통계) */
+    struct list_elem elem; /* 전체 큐 리스트 연결 */
+};
+
+void workqueue_init(void);
+void workqueue_create(struct workqueue *wq, const char *name, int max_active);
+void workqueue_enqueue(struct workqueue *wq, struct work *work, work_func *func, void *aux);
+void workqueue_print_stats(void);
+
+#endif /* threads/workqueue.h */
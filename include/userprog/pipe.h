@@ -0,0 +1,15 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+
+struct file;
+struct pipe;
+
+bool pipe_open(struct file **reader, struct file **writer);
+struct file *pipe_dup(struct file *end);
+void pipe_release_end(struct pipe *pipe, bool writer);
+int pipe_read(struct pipe *pipe, void *buffer, unsigned length);
+int pipe_write(struct pipe *pipe, const void *buffer, unsigned length);
+
+#endif /* userprog/pipe.h */
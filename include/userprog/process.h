@@ -5,16 +5,42 @@
 
 tid_t process_create_initd(const char *file_name);
 tid_t process_fork(const char *name, struct intr_frame *if_);
+tid_t process_spawn(const char *cmd_line);
 int process_exec(void *f_name);
 int process_wait(tid_t);
 void process_exit(void);
 void process_activate(struct thread *next);
 
+/** #Project 3: Process Arena - 프로세스 수명 커널 객체 할당 */
+void *process_arena_alloc(size_t size);
+void process_arena_free(void *p, size_t size);
+
+/** #Project 3: Checkpoint/Restore - 주소 공간을 스왑 디스크에 직렬화 */
+#ifdef VM
+int process_checkpoint(void);
+tid_t process_restore(void);
+#endif
+
 /** #Project 2: Command Line Parsing */
-void argument_stack(char **argv, int argc, struct intr_frame *if_);
+bool argument_stack(char *cmd, size_t cmd_len, struct intr_frame *if_);
+
+/** #Project 3: 종료 상태 블록 - 부모와 자식이 refcount로 공유한다. 자식이
+ *  종료되면 상태만 여기 게시하고 스레드 페이지는 즉시 반납되므로 좀비가
+ *  4KB씩 쥐고 있지 않으며, wait()는 부모의 해시에서 이 블록을 O(1)로
+ *  찾는다. */
+struct child_status {
+	tid_t tid;                  /* 자식 tid (해시 키) */
+	int exit_status;            /* 자식의 종료 상태 */
+	bool fork_failed;           /* __do_fork/__do_spawn 실패 표시 */
+	int ref_cnt;                /* 부모 + 자식 */
+	struct semaphore fork_sema; /* 자식 리소스 복제 완료 signal */
+	struct semaphore wait_sema; /* 자식 종료 signal */
+	struct hash_elem elem;      /* 부모 child_hash 요소 */
+};
 
 /** #Project 2: System Call */
-thread_t *get_child_process(int pid);
+bool process_attach_child(thread_t *child);
+void child_status_release(struct child_status *st);
 int process_add_file(struct file *f);
 struct file *process_get_file(int fd);
 int process_close_file(int fd);
@@ -22,12 +48,12 @@ process_insert_file(int fd, struct file *f);
 
 
 struct container{
-	struct file *file ; 
+	struct file *file ;
 	off_t ofs ;
 	size_t page_read_bytes;
 	size_t page_zero_bytes;
 	bool writable;
-
+	void *map_start;	/* mmap: first address of the mapping; NULL for exec segments. */
 };
 
 #define STDIN 1
@@ -2,9 +2,21 @@
 #define USERPROG_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <syscall-nr.h>
 
 void syscall_init(void);
 
+/** #Project 3: Syscall Profile - 프로세스별 호출 수/누적 사이클.
+ *  '-syscall-prof' 커널 옵션으로 켠다. */
+struct syscall_prof {
+    uint64_t cnt[SYS_CNT];    /* 시스템 콜 번호별 호출 수 */
+    uint64_t cycles[SYS_CNT]; /* 시스템 콜 번호별 누적 TSC 사이클 */
+};
+
+extern bool syscall_prof_active;
+
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t)-1)
@@ -14,6 +26,9 @@ typedef int pid_t;
 
 /** #Project 2: System Call */
 void check_address(void *addr);
+void check_buffer(void *addr, size_t len, bool writable);
+bool copy_from_user(void *dst, const void *usrc, size_t size);
+bool copy_to_user(void *udst, const void *src, size_t size);
 
 void halt(void);
 void exit(int status);
@@ -35,4 +50,36 @@ void close(int fd);
 /** #Project 2: Extend File Descriptor (Extra) */
 int dup2(int oldfd, int newfd);
 
+/** #Project 3: Memory Mapped Files */
+#include "filesys/off_t.h"
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
+void munmap(void *addr);
+void *sbrk(intptr_t increment);
+int shm_open(const char *name, size_t size);
+void *shm_map(int id, void *addr);
+int madvise(void *addr, size_t length, int advice);
+int pipe(int *fds);
+pid_t spawn(const char *cmd_line);
+struct iovec;
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
+int sendfile(int dst_fd, int src_fd, unsigned length);
+int pread(int fd, void *buffer, unsigned length, off_t offset);
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset);
+int create_many(const char *const *names, const unsigned *sizes, int cnt);
+int remove_many(const char *const *names, int cnt);
+int fadvise(int fd, int advice);
+int stat(const char *file);
+struct kstats;
+int kstats(struct kstats *buf);
+struct thread_usage;
+int getrusage(struct thread_usage *buf);
+int memlimit(int pages);
+struct vm_page_info;
+int vminspect(struct vm_page_info *buf, int cnt);
+int futex(int *uaddr, int op, int val);
+struct syscall_desc;
+int submit(struct syscall_desc *descs, int cnt);
+int checkpoint(void);
+
 #endif /* userprog/syscall.h */
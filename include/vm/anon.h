@@ -1,18 +1,43 @@
 #ifndef VM_ANON_H
 #define VM_ANON_H
+#include <list.h>
+#include "devices/disk.h"
 #include "vm/vm.h"
 struct page;
 enum vm_type;
 
 
-// add members to store necessary information or state of an anonymous page 
-struct anon_page {
+/* Swap slot index meaning "not swapped out". */
+#define ANON_NO_SLOT SIZE_MAX
 
-    // struct anon_page anon;
+// add members to store necessary information or state of an anonymous page
+struct anon_page {
+    size_t swap_slot;       /* Swap slot holding the contents, or ANON_NO_SLOT. */
 
+    /* Compressed staging tier (zswap); see anon.c. */
+    void *zdata;            /* Compressed copy in the arena, or NULL. */
+    uint32_t zsize;         /* Size of the compressed copy in bytes. */
+    struct list_elem zelem; /* Position in the arena's age list. */
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_release_swap (struct page *page);
+bool swap_set_limit (int pct);
+bool swap_admission_ok (void);
+
+/* Checkpoint support (userprog/process.c).  The last CKPT_META_SLOTS
+ * swap slots are reserved at init as the checkpoint metadata region;
+ * page contents live in ordinary slots handed out below. */
+#define CKPT_META_SLOTS 4
+
+size_t swap_slot_alloc (void);
+bool swap_slot_mark (size_t slot);
+void swap_slot_free (size_t slot);
+void swap_slot_read (size_t slot, void *kva);
+void swap_slot_write (size_t slot, const void *kva);
+disk_sector_t swap_ckpt_meta_start (void);
+void swap_meta_read (size_t sec_ofs, size_t cnt, void *buf);
+void swap_meta_write (size_t sec_ofs, size_t cnt, const void *buf);
 
 #endif
@@ -4,9 +4,14 @@
 #include "vm/vm.h"
 
 struct page;
+struct frame;
 enum vm_type;
 
 struct file_page {
+	struct file *file;      /* Private handle to the backing file. */
+	off_t ofs;              /* Offset of this page in the file. */
+	size_t read_bytes;      /* Bytes backed by the file; rest is zero. */
+	void *map_start;        /* First address of the owning mapping. */
 };
 
 void vm_file_init (void);
@@ -14,4 +19,11 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 void do_munmap (void *va);
+
+void file_teardown_page (struct page *page);
+
+/* Shared read-only page cache, keyed by (inode, offset). */
+bool file_try_share_page (struct page *page);
+void file_share_insert (struct page *page);
+void file_share_remove (struct frame *frame);
 #endif
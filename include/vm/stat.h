@@ -0,0 +1,26 @@
+#ifndef VM_STAT_H
+#define VM_STAT_H
+
+/* Counters for the VM hot paths.  One instance lives in each thread
+ * (charged to whichever thread does the work) and one global instance
+ * accumulates across the whole system. */
+enum vm_stat_kind {
+	VM_STAT_FAULT,        /* Faults resolved by vm_try_handle_fault. */
+	VM_STAT_MAJOR_FAULT,  /* Faults that had to read from disk. */
+	VM_STAT_EVICTION,     /* Frames reclaimed by vm_evict_frame. */
+	VM_STAT_SWAP_IN,      /* Pages read back from the swap disk. */
+	VM_STAT_SWAP_OUT,     /* Pages written to the swap disk. */
+	VM_STAT_COW_BREAK,    /* Private copies made by vm_handle_wp. */
+	VM_STAT_KSM_MERGE,    /* Duplicate frames merged by the KSM scanner. */
+	VM_STAT_CNT
+};
+
+struct vm_stat {
+	long long cnt[VM_STAT_CNT];
+};
+
+void vm_stat_inc (enum vm_stat_kind kind);
+long long vm_stat_read (enum vm_stat_kind kind);
+void vm_stat_dump (void);
+
+#endif /* vm/stat.h */
@@ -0,0 +1,7 @@
+#ifndef VM_THRASH_H
+#define VM_THRASH_H
+
+void vm_thrash_init (void);
+void vm_thrash_checkpoint (void);
+
+#endif /* vm/thrash.h */
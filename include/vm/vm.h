@@ -3,6 +3,8 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include "lib/kernel/hash.h"
+#include "lib/kernel/radix.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -49,6 +51,11 @@ struct page {
 
 	/* Your implementation */
 	struct hash_elem hash_elem ;
+	bool sequential;       /* MADV_SEQUENTIAL hint; evicted ahead of the sweep. */
+	bool perm_ro;          /* Permanently read-only segment (text/rodata), as
+	                          opposed to temporarily read-only under CoW. */
+	struct list_elem map_elem; /* Element of the frame's mapper list. */
+	uint64_t *map_pml4;    /* Page table this mapping lives in. */
 	/* Per-type data are binded into the union.
 	 * Each function automatically detects the current union */
 	union {
@@ -65,6 +72,17 @@ struct page {
 struct frame {
 	void *kva;
 	struct page *page;
+	struct thread *owner;  /* Process whose pml4 maps this frame. */
+	int ref_cnt;           /* Number of pages sharing this frame (CoW). */
+	int pin_cnt;           /* Pinned frames are skipped by eviction. */
+	bool hot;              /* Re-accessed since load; used by 2Q eviction. */
+	bool shm;              /* Shared-memory segment frame; never CoW. */
+	bool text;             /* Shared text frame: owned by the file share
+	                          cache, mapped refcount-free, never evicted. */
+	uint64_t ksm_hash;     /* Content hash at the last KSM pass; 0 = none. */
+	struct list_elem scan_elem; /* Element of the eviction scan set. */
+	bool in_scan;          /* Currently on the scan list. */
+	struct list mappers;   /* Reverse map: every page mapping this frame. */
 };
 
 /* The function table for page operations.
@@ -83,11 +101,45 @@ struct page_operations {
 #define destroy(page) \
 	if ((page)->operations->destroy) (page)->operations->destroy (page)
 
+/* A contiguous region of the address space: one mmap, one exec
+ * segment, or the stack.  The page tree still owns the individual
+ * pages; areas only record which ranges are spoken for, so range
+ * questions (is this range free, may the stack grow here) are one
+ * ordered list walk instead of a page-by-page tree probe. */
+struct vm_area {
+	void *start;           /* First byte of the region. */
+	void *end;             /* One past the last byte (page-aligned). */
+	enum vm_type type;     /* VM_ANON or VM_FILE. */
+	struct file *file;     /* Backing file handle, borrowed for
+	                          bookkeeping only -- never dereferenced
+	                          after registration.  NULL if anonymous. */
+	off_t offset;          /* Starting offset within FILE. */
+	bool grows_down;       /* Stack region: pages appear on demand. */
+	struct list_elem elem; /* Element in spt->areas. */
+};
+
 /* Representation of current process's memory space.
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-	struct hash spt_hash;
+	/* Radix tree from page number to struct page.  User addresses
+	 * are dense, so the fault path resolves a va in three indexed
+	 * loads with no hash function, and the tree yields pages in
+	 * address order for copy and range operations. */
+	struct vm_radix spt_map;
+
+	/* Seqlock over the tree.  Mutations (mmap, munmap, exit) are
+	 * rare next to fault-path lookups, so readers take no lock at
+	 * all: they sample the generation, walk the tree, and retry if
+	 * it moved.  Writers serialize on mut_lock and hold the count
+	 * odd while the tree is inconsistent. */
+	struct lock mut_lock;       /* Serializes mutators. */
+	unsigned gen;               /* Even: stable.  Odd: mutating. */
+
+	/* Regions, sorted by start address.  Mutated only by the owning
+	 * process (mmap, munmap, exec) and read by its own fault path,
+	 * so it needs neither the seqlock nor mut_lock. */
+	struct list areas;
 };
 
 #include "threads/thread.h"
@@ -100,6 +152,15 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
 
+struct vm_area *vm_area_register (struct supplemental_page_table *spt,
+		void *start, size_t length, enum vm_type type, struct file *file,
+		off_t offset, bool grows_down);
+void vm_area_unregister (struct supplemental_page_table *spt, void *start);
+struct vm_area *vm_area_find (struct supplemental_page_table *spt,
+		const void *addr);
+bool vm_area_range_free (struct supplemental_page_table *spt, void *start,
+		size_t length);
+
 void vm_init (void);
 bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 		bool write, bool not_present);
@@ -109,8 +170,23 @@ bool vm_try_handle_fault (struct intr_frame *f, void *addr, bool user,
 bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
 		bool writable, vm_initializer *init, void *aux);
 void vm_dealloc_page (struct page *page);
+void vm_release_frame (struct page *page);
+void vm_frame_ref (struct frame *frame);
+void vm_map_add (struct frame *frame, struct page *page);
 bool vm_claim_page (void *va);
 enum vm_type page_get_type (struct page *page);
+bool vm_set_evict_policy (const char *name);
+bool vm_pin_buffer (const void *buffer, size_t size, bool writable);
+void vm_unpin_buffer (const void *buffer, size_t size);
+int vm_madvise (void *addr, size_t length, int advice);
+struct vm_page_info;
+int vm_inspect_spt (struct vm_page_info *buf, int max);
+int vm_shm_open (const char *name, size_t size);
+void *vm_shm_map (int id, void *addr);
+void vm_reclaim_thread_frames (void);
+
+/* Opt-in same-content page merging; set by the -ksm kernel option. */
+extern bool vm_ksm_requested;
 
 
 
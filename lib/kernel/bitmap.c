@@ -27,6 +27,8 @@ typedef unsigned long elem_type;
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	size_t scan_hint;   /* Where the last scan-and-flip ended;
+	                       later scans resume here (next fit). */
 };
 
 /* Returns the index of the element that contains the bit
@@ -74,6 +76,7 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
+		b->scan_hint = 0;
 		b->bits = malloc (byte_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
 			bitmap_set_all (b, false);
@@ -94,6 +97,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 	ASSERT (block_size >= bitmap_buf_size (bit_cnt));
 
 	b->bit_cnt = bit_cnt;
+	b->scan_hint = 0;
 	b->bits = (elem_type *) (b + 1);
 	bitmap_set_all (b, false);
 	return b;
@@ -263,6 +267,31 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 
 /* Finding set or unset bits. */
 
+/* Returns the index of the first bit at or after START whose
+   value is VALUE, or B's bit count if there is no such bit.
+   Works a whole element at a time: an element holding no such
+   bit costs a single compare, and __builtin_ctzl locates the
+   bit within the interesting element without a bit loop. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, bool value) {
+	size_t idx = start;
+
+	while (idx < b->bit_cnt) {
+		size_t ei = elem_idx (idx);
+		elem_type e = value ? b->bits[ei] : ~b->bits[ei];
+
+		e &= ~(elem_type) 0 << (idx % ELEM_BITS);
+		if (e != 0) {
+			size_t found = ei * ELEM_BITS + __builtin_ctzl (e);
+
+			/* Bits past bit_cnt in the last element are garbage. */
+			return found < b->bit_cnt ? found : b->bit_cnt;
+		}
+		idx = (ei + 1) * ELEM_BITS;
+	}
+	return b->bit_cnt;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
@@ -272,12 +301,24 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
+	if (cnt == 0)
+		return start <= b->bit_cnt ? start : BITMAP_ERROR;
+
 	if (cnt <= b->bit_cnt) {
 		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
+		size_t i = find_bit (b, start, value);
+
+		while (i <= last) {
+			/* Bit I holds VALUE; find the first bit after it that
+			   does not.  If it lies past the group, the group is
+			   complete.  Otherwise no bit up to the mismatch can
+			   start a group either, so resume past it. */
+			size_t mismatch = find_bit (b, i + 1, !value);
+
+			if (mismatch >= i + cnt)
 				return i;
+			i = find_bit (b, mismatch + 1, value);
+		}
 	}
 	return BITMAP_ERROR;
 }
@@ -288,12 +329,22 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    If there is no such group, returns BITMAP_ERROR.
    If CNT is zero, returns 0.
    Bits are set atomically, but testing bits is not atomic with
-   setting them. */
+   setting them.
+   Scanning resumes where the previous scan-and-flip left off
+   when that lies past START, wrapping back to START on failure,
+   so repeated allocations do not rescan the allocated prefix. */
 size_t
 bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t idx = bitmap_scan (b, start, cnt, value);
-	if (idx != BITMAP_ERROR)
+	size_t idx = BITMAP_ERROR;
+
+	if (b->scan_hint > start && b->scan_hint <= b->bit_cnt)
+		idx = bitmap_scan (b, b->scan_hint, cnt, value);
+	if (idx == BITMAP_ERROR)
+		idx = bitmap_scan (b, start, cnt, value);
+	if (idx != BITMAP_ERROR) {
 		bitmap_set_multiple (b, idx, cnt, !value);
+		b->scan_hint = idx + cnt;
+	}
 	return idx;
 }
 
@@ -326,6 +377,27 @@ bitmap_write (const struct bitmap *b, struct file *file) {
 	off_t size = byte_cnt (b->bit_cnt);
 	return file_write_at (file, b->bits, size, 0) == size;
 }
+
+/* Writes the part of B that covers the CNT bits starting at
+   START to FILE, touching only the elements that hold those bits.
+   Returns true if successful, false otherwise. */
+bool
+bitmap_write_range (const struct bitmap *b, struct file *file,
+		size_t start, size_t cnt) {
+	size_t first, last;
+	off_t ofs, size;
+
+	ASSERT (start + cnt <= b->bit_cnt);
+	if (cnt == 0)
+		return true;
+
+	first = elem_idx (start);
+	last = elem_idx (start + cnt - 1);
+	ofs = first * sizeof (elem_type);
+	size = (last - first + 1) * sizeof (elem_type);
+	return file_write_at (file, (const unsigned char *) b->bits + ofs,
+			size, ofs) == size;
+}
 #endif /* FILESYS */
 
 /* Debugging. */
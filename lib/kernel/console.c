@@ -1,6 +1,7 @@
 #include <console.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include "devices/serial.h"
 #include "devices/vga.h"
 #include "threads/init.h"
@@ -10,6 +11,9 @@
 static void vprintf_helper (char, void *);
 static void putchar_have_lock (uint8_t c);
 
+/* Staging buffer size for vprintf() batching. */
+#define CONSOLE_BATCH 128
+
 /* The console lock.
    Both the vga and serial layers do their own locking, so it's
    safe to call them at any time.
@@ -114,36 +118,80 @@ console_locked_by_current_thread (void) {
 /* The standard vprintf() function,
    which is like printf() but uses a va_list.
    Writes its output to both vga display and serial port. */
+/* Formatted output accumulates here and is handed to the serial
+   and vga layers in whole runs, so the per-character cost is a
+   buffer store instead of two layer calls. */
+struct vprintf_batch {
+	char buf[CONSOLE_BATCH];    /* Staged characters. */
+	size_t n;                   /* Number staged. */
+	int char_cnt;               /* Total characters output. */
+};
+
+/* Hands B's staged characters to the serial and vga layers in
+   one call each.  The caller holds the console lock. */
+static void
+flush_batch (struct vprintf_batch *b) {
+	if (b->n > 0) {
+		ASSERT (console_locked_by_current_thread ());
+		write_cnt += b->n;
+		serial_write (b->buf, b->n);
+		vga_write (b->buf, b->n);
+		b->n = 0;
+	}
+}
+
 int
 vprintf (const char *format, va_list args) {
-	int char_cnt = 0;
+	struct vprintf_batch batch;
+
+	/* A format with no conversions is its own output; send it in
+	   bulk like putbuf() instead of a character at a time through
+	   the formatting machinery. */
+	if (strchr (format, '%') == NULL) {
+		size_t n = strlen (format);
+
+		putbuf (format, n);
+		return n;
+	}
+
+	batch.n = 0;
+	batch.char_cnt = 0;
 
 	acquire_console ();
-	__vprintf (format, args, vprintf_helper, &char_cnt);
+	__vprintf (format, args, vprintf_helper, &batch);
+	flush_batch (&batch);
 	release_console ();
 
-	return char_cnt;
+	return batch.char_cnt;
 }
 
 /* Writes string S to the console, followed by a new-line
    character. */
 int
 puts (const char *s) {
+	size_t n = strlen (s);
+
 	acquire_console ();
-	while (*s != '\0')
-		putchar_have_lock (*s++);
-	putchar_have_lock ('\n');
+	write_cnt += n + 1;
+	serial_write (s, n);
+	serial_putc ('\n');
+	vga_write (s, n);
+	vga_putc ('\n');
 	release_console ();
 
 	return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.  The whole
+   buffer goes to each layer in one call, so it costs a copy into
+   the serial transmit ring and one vga run rather than a layer
+   round trip per character. */
 void
 putbuf (const char *buffer, size_t n) {
 	acquire_console ();
-	while (n-- > 0)
-		putchar_have_lock (*buffer++);
+	write_cnt += n;
+	serial_write (buffer, n);
+	vga_write (buffer, n);
 	release_console ();
 }
 
@@ -157,12 +205,16 @@ putchar (int c) {
 	return c;
 }
 
-/* Helper function for vprintf(). */
+/* Helper function for vprintf(): stages C, flushing when the
+   buffer fills. */
 static void
-vprintf_helper (char c, void *char_cnt_) {
-	int *char_cnt = char_cnt_;
-	(*char_cnt)++;
-	putchar_have_lock (c);
+vprintf_helper (char c, void *batch_) {
+	struct vprintf_batch *batch = batch_;
+
+	batch->char_cnt++;
+	batch->buf[batch->n++] = c;
+	if (batch->n >= CONSOLE_BATCH)
+		flush_batch (batch);
 }
 
 /* Writes C to the vga display and serial port.
@@ -18,9 +18,45 @@
 static struct list *find_bucket (struct hash *, struct hash_elem *);
 static struct hash_elem *find_elem (struct hash *, struct list *,
 		struct hash_elem *);
+static struct hash_elem *find_elem_any (struct hash *, struct hash_elem *);
 static void insert_elem (struct hash *, struct list *, struct hash_elem *);
 static void remove_elem (struct hash *, struct hash_elem *);
 static void rehash (struct hash *);
+static void migrate_step (struct hash *);
+static void migrate_finish (struct hash *);
+
+/* Old buckets drained per insert or delete while a resize is in
+   progress.  Bounds the worst case of a single operation at a few
+   list splices instead of a walk over the whole table. */
+#define MIGRATE_STEP 4
+
+/* 2^64 divided by the golden ratio, for Fibonacci hashing: one
+   multiply by this constant spreads consecutive keys across the
+   whole word, so the high bits make a good bucket index even when
+   the keys themselves are sequential. */
+#define HASH_FIB 0x9e3779b97f4a7c15UL
+
+/* Returns a fresh seed for a new table.  Seeding each table
+   differently keeps two tables over the same keys from developing
+   identical collision chains. */
+static uint64_t
+hash_table_seed (void) {
+	static uint64_t seed_gen;
+
+	return ++seed_gen * HASH_FIB;
+}
+
+/* Maps HASH into a table of BUCKET_CNT buckets (a power of 2),
+   seeded with SEED.  A final Fibonacci multiply stands between the
+   user's hash function and the mask, so a cheap hash -- even the
+   identity on a word-size key -- still lands sequential keys in
+   different buckets; the top bits of the product are taken, where
+   the multiply mixes best. */
+static size_t
+bucket_idx (uint64_t hash, uint64_t seed, size_t bucket_cnt) {
+	return ((hash ^ seed) * HASH_FIB) >> (64 - __builtin_ctzll (bucket_cnt))
+		& (bucket_cnt - 1);
+}
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -28,6 +64,10 @@ bool hash_init (struct hash *h,hash_hash_func *hash, hash_less_func *less, void
 	h->elem_cnt = 0;
 	h->bucket_cnt = 4;
 	h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+	h->old_buckets = NULL;
+	h->old_bucket_cnt = 0;
+	h->migrate_idx = 0;
+	h->seed = hash_table_seed ();
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
@@ -52,6 +92,8 @@ void
 hash_clear (struct hash *h, hash_action_func *destructor) {
 	size_t i;
 
+	migrate_finish (h);
+
 	for (i = 0; i < h->bucket_cnt; i++) {
 		struct list *bucket = &h->buckets[i];
 
@@ -81,6 +123,8 @@ void
 hash_destroy (struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear (h, destructor);
+	else
+		migrate_finish (h);
 	free (h->buckets);
 }
 
@@ -90,12 +134,12 @@ hash_destroy (struct hash *h, hash_action_func *destructor) {
    without inserting NEW. */
 struct hash_elem *
 hash_insert (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
+	struct hash_elem *old = find_elem_any (h, new);
 
 	if (old == NULL)
-		insert_elem (h, bucket, new);
+		insert_elem (h, find_bucket (h, new), new);
 
+	migrate_step (h);
 	rehash (h);
 
 	return old;
@@ -105,13 +149,13 @@ hash_insert (struct hash *h, struct hash_elem *new) {
    already in the table, which is returned. */
 struct hash_elem *
 hash_replace (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
+	struct hash_elem *old = find_elem_any (h, new);
 
 	if (old != NULL)
 		remove_elem (h, old);
-	insert_elem (h, bucket, new);
+	insert_elem (h, find_bucket (h, new), new);
 
+	migrate_step (h);
 	rehash (h);
 
 	return old;
@@ -120,7 +164,7 @@ hash_replace (struct hash *h, struct hash_elem *new) {
 /* Finds and returns an element equal to E in hash table H, or a
    null pointer if no equal element exists in the table. */
 struct hash_elem *hash_find (struct hash *h, struct hash_elem *e) {
-	return find_elem (h, find_bucket (h, e), e);
+	return find_elem_any (h, e);
 }
 
 /* Finds, removes, and returns an element equal to E in hash
@@ -133,9 +177,10 @@ struct hash_elem *hash_find (struct hash *h, struct hash_elem *e) {
 
 struct hash_elem *
 hash_delete (struct hash *h, struct hash_elem *e) {
-	struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+	struct hash_elem *found = find_elem_any (h, e);
 	if (found != NULL) {
 		remove_elem (h, found);
+		migrate_step (h);
 		rehash (h);
 	}
 	return found;
@@ -153,6 +198,8 @@ hash_apply (struct hash *h, hash_action_func *action) {
 
 	ASSERT (action != NULL);
 
+	migrate_finish (h);
+
 	for (i = 0; i < h->bucket_cnt; i++) {
 		struct list *bucket = &h->buckets[i];
 		struct list_elem *elem, *next;
@@ -186,6 +233,10 @@ hash_first (struct hash_iterator *i, struct hash *h) {
 	ASSERT (i != NULL);
 	ASSERT (h != NULL);
 
+	/* Iteration walks the bucket array directly, so any resize
+	   still draining must be completed first. */
+	migrate_finish (h);
+
 	i->hash = h;
 	i->bucket = i->hash->buckets;
 	i->elem = list_elem_to_hash_elem (list_head (i->bucket));
@@ -275,12 +326,21 @@ uint64_t
 hash_int (int i) {
 	return hash_bytes (&i, sizeof i);
 }
+
+/* Returns a hash of the word-size key W: a single Fibonacci
+   multiply instead of the byte-at-a-time FNV loop, roughly an
+   order of magnitude cheaper for the 8-byte keys -- addresses,
+   sector numbers -- that dominate the kernel's tables. */
+uint64_t
+hash_word (uint64_t w) {
+	return w * HASH_FIB;
+}
 
 /* Returns the bucket in H that E belongs in. */
 static struct list *
 find_bucket (struct hash *h, struct hash_elem *e) {
-	size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-	return &h->buckets[bucket_idx];
+	return &h->buckets[bucket_idx (h->hash (e, h->aux), h->seed,
+			h->bucket_cnt)];
 }
 
 /* Searches BUCKET in H for a hash element equal to E.  Returns
@@ -297,6 +357,62 @@ find_elem (struct hash *h, struct list *bucket, struct hash_elem *e) {
 	return NULL;
 }
 
+/* Searches H for a hash element equal to E, looking in the old
+   bucket array as well while a resize is still draining.  Returns
+   it if found or a null pointer otherwise. */
+static struct hash_elem *
+find_elem_any (struct hash *h, struct hash_elem *e) {
+	struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+
+	if (found == NULL && h->old_buckets != NULL) {
+		size_t idx = bucket_idx (h->hash (e, h->aux), h->seed,
+				h->old_bucket_cnt);
+
+		if (idx >= h->migrate_idx)
+			found = find_elem (h, &h->old_buckets[idx], e);
+	}
+	return found;
+}
+
+/* Migrates up to MIGRATE_STEP old buckets into the current bucket
+   array, freeing the old array once it is empty.  No-op when no
+   resize is in progress. */
+static void
+migrate_step (struct hash *h) {
+	size_t step;
+
+	if (h->old_buckets == NULL)
+		return;
+
+	for (step = 0; step < MIGRATE_STEP && h->migrate_idx < h->old_bucket_cnt;
+			step++) {
+		struct list *old_bucket = &h->old_buckets[h->migrate_idx++];
+
+		while (!list_empty (old_bucket)) {
+			struct list_elem *elem = list_pop_front (old_bucket);
+			struct list *new_bucket
+				= find_bucket (h, list_elem_to_hash_elem (elem));
+
+			list_push_front (new_bucket, elem);
+		}
+	}
+
+	if (h->migrate_idx >= h->old_bucket_cnt) {
+		free (h->old_buckets);
+		h->old_buckets = NULL;
+		h->old_bucket_cnt = 0;
+		h->migrate_idx = 0;
+	}
+}
+
+/* Completes any resize still in progress, leaving every element
+   in the current bucket array. */
+static void
+migrate_finish (struct hash *h) {
+	while (h->old_buckets != NULL)
+		migrate_step (h);
+}
+
 /* Returns X with its lowest-order bit set to 1 turned off. */
 static inline size_t
 turn_off_least_1bit (size_t x) {
@@ -320,15 +436,16 @@ is_power_of_2 (size_t x) {
    we can still continue. */
 static void
 rehash (struct hash *h) {
-	size_t old_bucket_cnt, new_bucket_cnt;
-	struct list *new_buckets, *old_buckets;
+	size_t new_bucket_cnt;
+	struct list *new_buckets;
 	size_t i;
 
 	ASSERT (h != NULL);
 
-	/* Save old bucket info for later use. */
-	old_buckets = h->buckets;
-	old_bucket_cnt = h->bucket_cnt;
+	/* Only one resize drains at a time; the pending one finishes
+	   through migrate_step() before another can start. */
+	if (h->old_buckets != NULL)
+		return;
 
 	/* Calculate the number of buckets to use now.
 	   We want one bucket for about every BEST_ELEMS_PER_BUCKET.
@@ -341,7 +458,7 @@ rehash (struct hash *h) {
 		new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
 
 	/* Don't do anything if the bucket count wouldn't change. */
-	if (new_bucket_cnt == old_bucket_cnt)
+	if (new_bucket_cnt == h->bucket_cnt)
 		return;
 
 	/* Allocate new buckets and initialize them as empty. */
@@ -355,27 +472,17 @@ rehash (struct hash *h) {
 	for (i = 0; i < new_bucket_cnt; i++)
 		list_init (&new_buckets[i]);
 
-	/* Install new bucket info. */
+	/* Install the new buckets and leave the old ones to drain
+	   incrementally: each subsequent insert or delete migrates a
+	   few old buckets, so no single operation rehashes the whole
+	   table. */
+	h->old_buckets = h->buckets;
+	h->old_bucket_cnt = h->bucket_cnt;
+	h->migrate_idx = 0;
 	h->buckets = new_buckets;
 	h->bucket_cnt = new_bucket_cnt;
 
-	/* Move each old element into the appropriate new bucket. */
-	for (i = 0; i < old_bucket_cnt; i++) {
-		struct list *old_bucket;
-		struct list_elem *elem, *next;
-
-		old_bucket = &old_buckets[i];
-		for (elem = list_begin (old_bucket);
-				elem != list_end (old_bucket); elem = next) {
-			struct list *new_bucket
-				= find_bucket (h, list_elem_to_hash_elem (elem));
-			next = list_next (elem);
-			list_remove (elem);
-			list_push_front (new_bucket, elem);
-		}
-	}
-
-	free (old_buckets);
+	migrate_step (h);
 }
 
 /* Inserts E into BUCKET (in hash table H). */
@@ -394,7 +501,7 @@ remove_elem (struct hash *h, struct hash_elem *e) {
 
 uint64_t hash_func (const struct hash_elem *e, void *aux){
 	struct page *p = hash_entry(e,struct page, hash_elem);
-	return hash_bytes(&(p->va), sizeof(p->va));
+	return hash_word((uint64_t) p->va);
 }
 
 bool less_func (const struct hash_elem *a, const struct hash_elem *b, void *aux){
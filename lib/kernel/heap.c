@@ -0,0 +1,183 @@
+#include "heap.h"
+
+#include "../debug.h"
+
+/* A pairing heap is a heap-ordered multiway tree.  Each node's
+   children form a singly linked sibling list; the `prev' pointer
+   points at the parent for the first child and at the previous
+   sibling otherwise, which lets us detach an arbitrary node in
+   O(1) without a full parent pointer per node.
+
+   Melding two trees hangs the one that orders later under the
+   other as its first child, so insert is a single meld.  Removing
+   a node merges its orphaned children pairwise and melds the
+   result back into the root, giving the usual O(log n) amortized
+   bound. */
+
+static struct heap_elem *meld(struct heap *h, struct heap_elem *a, struct heap_elem *b);
+static struct heap_elem *merge_pairs(struct heap *h, struct heap_elem *first);
+static void detach(struct heap_elem *elem);
+static void scrub(struct heap_elem *elem);
+
+/* Initializes H as an empty heap ordered by LESS given auxiliary
+   data AUX. */
+void heap_init(struct heap *h, heap_less_func *less, void *aux) {
+    ASSERT(h != NULL);
+    ASSERT(less != NULL);
+
+    h->root = NULL;
+    h->less = less;
+    h->aux = aux;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool heap_empty(const struct heap *h) {
+    ASSERT(h != NULL);
+
+    return h->root == NULL;
+}
+
+/* Returns the element of H that orders first, or a null pointer
+   if H is empty.  The element is not removed. */
+struct heap_elem *heap_top(const struct heap *h) {
+    ASSERT(h != NULL);
+
+    return h->root;
+}
+
+/* Inserts ELEM into H. */
+void heap_insert(struct heap *h, struct heap_elem *elem) {
+    ASSERT(h != NULL);
+    ASSERT(elem != NULL);
+
+    scrub(elem);
+    h->root = meld(h, h->root, elem);
+    h->root->prev = NULL;
+}
+
+/* Removes the element of H that orders first and returns it, or
+   returns a null pointer if H is empty. */
+struct heap_elem *heap_pop(struct heap *h) {
+    ASSERT(h != NULL);
+
+    struct heap_elem *top = h->root;
+    if (top == NULL)
+        return NULL;
+
+    h->root = merge_pairs(h, top->child);
+    if (h->root != NULL)
+        h->root->prev = NULL;
+
+    scrub(top);
+    return top;
+}
+
+/* Removes ELEM, which must be in H, from H. */
+void heap_remove(struct heap *h, struct heap_elem *elem) {
+    ASSERT(h != NULL);
+    ASSERT(elem != NULL);
+    ASSERT(heap_contains(h, elem));
+
+    if (elem == h->root) {
+        heap_pop(h);
+        return;
+    }
+
+    detach(elem);
+    h->root = meld(h, h->root, merge_pairs(h, elem->child));
+    h->root->prev = NULL;
+
+    scrub(elem);
+}
+
+/* Restores the heap invariant after the key of ELEM, which must
+   be in H, has changed. */
+void heap_update(struct heap *h, struct heap_elem *elem) {
+    heap_remove(h, elem);
+    heap_insert(h, elem);
+}
+
+/* Returns true if ELEM is in H.  ELEM must either be in H or be
+   detached (removed from whatever heap it was last in); an
+   element currently in some other heap may be misreported. */
+bool heap_contains(const struct heap *h, const struct heap_elem *elem) {
+    ASSERT(h != NULL);
+    ASSERT(elem != NULL);
+
+    return h->root == elem || elem->prev != NULL;
+}
+
+/* Melds trees A and B, either of which may be null, and returns
+   the resulting root. */
+static struct heap_elem *meld(struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+
+    if (h->less(b, a, h->aux)) {
+        struct heap_elem *t = a;
+        a = b;
+        b = t;
+    }
+
+    /* B becomes A's first child. */
+    b->prev = a;
+    b->sibling = a->child;
+    if (a->child != NULL)
+        a->child->prev = b;
+    a->child = b;
+    a->sibling = NULL;
+
+    return a;
+}
+
+/* Merges the sibling list starting at FIRST into a single tree:
+   one left-to-right pass melding adjacent pairs, then a pass
+   folding the pair winners together. */
+static struct heap_elem *merge_pairs(struct heap *h, struct heap_elem *first) {
+    struct heap_elem *pairs = NULL; /* Pair winners, chained via sibling. */
+
+    while (first != NULL) {
+        struct heap_elem *a = first;
+        struct heap_elem *b = a->sibling;
+        first = b != NULL ? b->sibling : NULL;
+
+        a->sibling = a->prev = NULL;
+        if (b != NULL)
+            b->sibling = b->prev = NULL;
+
+        a = meld(h, a, b);
+        a->sibling = pairs;
+        pairs = a;
+    }
+
+    struct heap_elem *result = NULL;
+    while (pairs != NULL) {
+        struct heap_elem *next = pairs->sibling;
+        pairs->sibling = NULL;
+        result = meld(h, result, pairs);
+        pairs = next;
+    }
+
+    return result;
+}
+
+/* Unlinks ELEM, which must not be a root, from its parent's child
+   list.  ELEM keeps its own children. */
+static void detach(struct heap_elem *elem) {
+    ASSERT(elem->prev != NULL);
+
+    if (elem->prev->child == elem)
+        elem->prev->child = elem->sibling; /* First child: prev is the parent. */
+    else
+        elem->prev->sibling = elem->sibling; /* Prev is the previous sibling. */
+
+    if (elem->sibling != NULL)
+        elem->sibling->prev = elem->prev;
+}
+
+/* Marks ELEM detached. */
+static void scrub(struct heap_elem *elem) {
+    elem->child = elem->sibling = elem->prev = NULL;
+}
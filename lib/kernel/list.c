@@ -174,6 +174,16 @@ void list_splice(struct list_elem *before, struct list_elem *first, struct list_
     before->prev = last;
 }
 
+/* Removes every element of SRC and appends them, in order, to
+   the end of DST, leaving SRC empty.  Runs in O(1) no matter how
+   many elements move. */
+void list_splice_tail(struct list *dst, struct list *src) {
+    ASSERT(dst != NULL);
+    ASSERT(src != NULL);
+
+    list_splice(list_end(dst), list_begin(src), list_end(src));
+}
+
 /* Inserts ELEM at the beginning of LIST, so that it becomes the
    front in LIST. */
 void list_push_front(struct list *list, struct list_elem *elem) {
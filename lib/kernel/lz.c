@@ -0,0 +1,192 @@
+#include "lz.h"
+#include <stdint.h>
+#include <string.h>
+
+/* Matches shorter than this cost more to encode than to copy. */
+#define LZ_MIN_MATCH 4
+
+/* Hash table: one 16-bit position per slot, using the workspace
+   the caller provides.  Position 0 doubles as "empty", so stored
+   positions are offset by one. */
+#define LZ_HASH_LOG 10
+#define LZ_HASH_CNT (1 << LZ_HASH_LOG)
+
+/* Reads a potentially unaligned 32-bit little-endian window. */
+static inline uint32_t
+read32 (const uint8_t *p) {
+	uint32_t v;
+
+	memcpy (&v, p, sizeof v);
+	return v;
+}
+
+/* Hashes a 4-byte window into a table slot; Knuth's
+   multiplicative constant spreads the low bytes' entropy. */
+static inline size_t
+hash4 (uint32_t v) {
+	return (v * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+/* Emits one sequence: LIT literals from ANCHOR, then a match of
+   MLEN bytes at backward offset OFF (0 for the final,
+   literal-only sequence).  Returns the new output position, or a
+   null pointer if OEND would be overrun. */
+static uint8_t *
+emit_seq (uint8_t *op, uint8_t *oend, const uint8_t *anchor, size_t lit,
+		size_t off, size_t mlen) {
+	size_t ml = off != 0 ? mlen - LZ_MIN_MATCH : 0;
+	uint8_t *token;
+
+	/* Worst case: token, both nibble extensions, literals, offset. */
+	if ((size_t) (oend - op) < 1 + lit / 255 + 1 + lit
+			+ 2 + ml / 255 + 1)
+		return NULL;
+
+	token = op++;
+	if (lit >= 15) {
+		size_t rest = lit - 15;
+
+		*token = 15 << 4;
+		for (; rest >= 255; rest -= 255)
+			*op++ = 255;
+		*op++ = rest;
+	} else
+		*token = lit << 4;
+	memcpy (op, anchor, lit);
+	op += lit;
+
+	if (off == 0)
+		return op;
+
+	*op++ = off & 0xff;
+	*op++ = off >> 8;
+	if (ml >= 15) {
+		size_t rest = ml - 15;
+
+		*token |= 15;
+		for (; rest >= 255; rest -= 255)
+			*op++ = 255;
+		*op++ = rest;
+	} else
+		*token |= ml;
+	return op;
+}
+
+/* Compresses SRC_LEN bytes at SRC into DST; see lz.h. */
+size_t
+lz_compress (const void *src_, size_t src_len, void *dst_, size_t dst_cap,
+		void *workspace) {
+	const uint8_t *src = src_;
+	const uint8_t *ip = src, *anchor = src;
+	const uint8_t *iend = src + src_len;
+	/* The last windows cannot start a match: a 4-byte probe plus
+	   extension must not read past the end. */
+	const uint8_t *mlimit = src_len > LZ_MIN_MATCH ? iend - LZ_MIN_MATCH : src;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_cap;
+	uint16_t *table = workspace;
+
+	memset (table, 0, LZ_HASH_CNT * sizeof *table);
+
+	while (ip < mlimit) {
+		uint32_t v = read32 (ip);
+		size_t h = hash4 (v);
+		const uint8_t *ref = src + table[h] - 1;
+		bool hit = table[h] != 0 && read32 (ref) == v;
+
+		table[h] = ip - src + 1;
+		if (!hit) {
+			ip++;
+			continue;
+		}
+
+		/* Extend the match as far as the input allows. */
+		const uint8_t *mstart = ip;
+		const uint8_t *mref = ref;
+		size_t mlen = LZ_MIN_MATCH;
+
+		ip += LZ_MIN_MATCH;
+		ref += LZ_MIN_MATCH;
+		while (ip < iend && *ip == *ref) {
+			ip++;
+			ref++;
+			mlen++;
+		}
+
+		op = emit_seq (op, oend, anchor, mstart - anchor,
+				mstart - mref, mlen);
+		if (op == NULL)
+			return 0;
+		anchor = ip;
+	}
+
+	/* Whatever remains goes out as bare literals. */
+	op = emit_seq (op, oend, anchor, iend - anchor, 0, 0);
+	if (op == NULL)
+		return 0;
+	return op - dst;
+}
+
+/* Expands SRC_LEN bytes at SRC into exactly DST_LEN bytes at
+   DST; see lz.h. */
+bool
+lz_decompress (const void *src_, size_t src_len, void *dst_,
+		size_t dst_len) {
+	const uint8_t *ip = src_, *iend = ip + src_len;
+	uint8_t *dst = dst_, *op = dst, *oend = dst + dst_len;
+
+	while (ip < iend) {
+		uint8_t token = *ip++;
+		size_t lit = token >> 4;
+		size_t ml, off;
+		const uint8_t *ref;
+
+		if (lit == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= iend)
+					return false;
+				b = *ip++;
+				lit += b;
+			} while (b == 255);
+		}
+		if (lit > (size_t) (iend - ip) || lit > (size_t) (oend - op))
+			return false;
+		memcpy (op, ip, lit);
+		op += lit;
+		ip += lit;
+
+		/* The final sequence is literals only. */
+		if (ip >= iend)
+			break;
+
+		if (iend - ip < 2)
+			return false;
+		off = ip[0] | (size_t) ip[1] << 8;
+		ip += 2;
+		if (off == 0 || off > (size_t) (op - dst))
+			return false;
+
+		ml = token & 0xf;
+		if (ml == 15) {
+			uint8_t b;
+
+			do {
+				if (ip >= iend)
+					return false;
+				b = *ip++;
+				ml += b;
+			} while (b == 255);
+		}
+		ml += LZ_MIN_MATCH;
+		if (ml > (size_t) (oend - op))
+			return false;
+
+		/* Byte-at-a-time copy: overlapping offsets (run-length
+		   style matches) must replicate earlier output. */
+		ref = op - off;
+		while (ml-- > 0)
+			*op++ = *ref++;
+	}
+	return op == oend;
+}
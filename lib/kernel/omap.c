@@ -0,0 +1,175 @@
+#include "omap.h"
+#include <debug.h>
+#include "threads/malloc.h"
+
+/* Initial capacity; must be a power of two. */
+#define OMAP_MIN_CAP 16
+
+/* Home slot for KEY: multiplicative hashing by the golden-ratio
+   constant spreads the key's entropy, and the power-of-two
+   capacity reduces the result with a mask instead of a divide. */
+static inline size_t
+slot_of (const struct omap *m, uint64_t key) {
+	return (size_t) ((key * 0x9e3779b97f4a7c15ULL) >> 32) & (m->cap - 1);
+}
+
+/* Initializes M as an empty map.  Returns true on success, false
+   if memory allocation failed. */
+bool
+omap_init (struct omap *m) {
+	m->cap = OMAP_MIN_CAP;
+	m->cnt = 0;
+	m->slots = calloc (m->cap, sizeof *m->slots);
+	return m->slots != NULL;
+}
+
+/* Removes every entry from M, passing each to DESTRUCTOR if it
+   is non-null. */
+void
+omap_clear (struct omap *m, omap_destroy_func *destructor) {
+	size_t i;
+
+	for (i = 0; i < m->cap; i++)
+		if (m->slots[i].val != NULL) {
+			if (destructor != NULL)
+				destructor (m->slots[i].key, m->slots[i].val);
+			m->slots[i].val = NULL;
+		}
+	m->cnt = 0;
+}
+
+/* Destroys M, passing each entry to DESTRUCTOR if it is
+   non-null and freeing the slot array. */
+void
+omap_destroy (struct omap *m, omap_destroy_func *destructor) {
+	omap_clear (m, destructor);
+	free (m->slots);
+	m->slots = NULL;
+}
+
+/* Returns the value stored under KEY, or a null pointer if KEY
+   is not in M. */
+void *
+omap_find (const struct omap *m, uint64_t key) {
+	size_t i = slot_of (m, key);
+
+	while (m->slots[i].val != NULL) {
+		if (m->slots[i].key == key)
+			return m->slots[i].val;
+		i = (i + 1) & (m->cap - 1);
+	}
+	return NULL;
+}
+
+/* Doubles M's capacity and reinserts every entry.  Returns false
+   and leaves M unchanged if memory allocation failed. */
+static bool
+omap_grow (struct omap *m) {
+	struct omap_slot *old = m->slots;
+	size_t old_cap = m->cap, i;
+
+	m->slots = calloc (old_cap * 2, sizeof *m->slots);
+	if (m->slots == NULL) {
+		m->slots = old;
+		return false;
+	}
+	m->cap = old_cap * 2;
+
+	for (i = 0; i < old_cap; i++)
+		if (old[i].val != NULL) {
+			size_t j = slot_of (m, old[i].key);
+
+			while (m->slots[j].val != NULL)
+				j = (j + 1) & (m->cap - 1);
+			m->slots[j] = old[i];
+		}
+	free (old);
+	return true;
+}
+
+/* Inserts VAL, which must not be null, under KEY.  Returns true
+   on success, false if KEY is already present or memory
+   allocation failed. */
+bool
+omap_insert (struct omap *m, uint64_t key, void *val) {
+	size_t i;
+
+	ASSERT (val != NULL);
+
+	/* Keep the load below 3/4 so probe runs stay short. */
+	if ((m->cnt + 1) * 4 > m->cap * 3 && !omap_grow (m))
+		return false;
+
+	i = slot_of (m, key);
+	while (m->slots[i].val != NULL) {
+		if (m->slots[i].key == key)
+			return false;
+		i = (i + 1) & (m->cap - 1);
+	}
+	m->slots[i].key = key;
+	m->slots[i].val = val;
+	m->cnt++;
+	return true;
+}
+
+/* Removes KEY from M and returns its value, or a null pointer if
+   KEY was not present. */
+void *
+omap_delete (struct omap *m, uint64_t key) {
+	size_t mask = m->cap - 1;
+	size_t i = slot_of (m, key);
+	size_t j;
+	void *val;
+
+	while (m->slots[i].val != NULL && m->slots[i].key != key)
+		i = (i + 1) & mask;
+	if (m->slots[i].val == NULL)
+		return NULL;
+	val = m->slots[i].val;
+	m->cnt--;
+
+	/* Backward shift: walk the rest of the probe run, moving into
+	   the hole any entry whose home slot lies at or before it, so
+	   lookups never need a tombstone to keep probing. */
+	j = i;
+	for (;;) {
+		size_t home;
+
+		j = (j + 1) & mask;
+		if (m->slots[j].val == NULL)
+			break;
+		home = slot_of (m, m->slots[j].key);
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			m->slots[i] = m->slots[j];
+			i = j;
+		}
+	}
+	m->slots[i].val = NULL;
+	return val;
+}
+
+/* Returns the number of entries in M. */
+size_t
+omap_size (const struct omap *m) {
+	return m->cnt;
+}
+
+/* Initializes IT for iterating over M. */
+void
+omap_first (struct omap_iterator *it, const struct omap *m) {
+	it->m = m;
+	it->idx = 0;
+}
+
+/* Returns the next value in the iteration, or a null pointer
+   when every entry has been visited. */
+void *
+omap_next (struct omap_iterator *it) {
+	while (it->idx < it->m->cap) {
+		const struct omap_slot *s = &it->m->slots[it->idx++];
+
+		if (s->val != NULL)
+			return s->val;
+	}
+	return NULL;
+}
@@ -0,0 +1,24 @@
+#include "percpu.h"
+
+/* Returns the current value of counter C: the sum of every CPU's
+   slot.  The slots are read without synchronization, so the total
+   is approximate while other CPUs are still incrementing, which
+   is fine for statistics. */
+int64_t
+pcpu_sum (const struct pcpu_counter *c) {
+	int64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < PCPU_MAX; i++)
+		sum += c->slot[i].val;
+	return sum;
+}
+
+/* Zeroes counter C on every CPU. */
+void
+pcpu_reset (struct pcpu_counter *c) {
+	size_t i;
+
+	for (i = 0; i < PCPU_MAX; i++)
+		c->slot[i].val = 0;
+}
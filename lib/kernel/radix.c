@@ -0,0 +1,206 @@
+#include "radix.h"
+#include <debug.h>
+#include "threads/malloc.h"
+
+/* Shift amount for LEVEL's key field. */
+static inline int
+level_shift (int level) {
+	return level * VM_RADIX_BITS;
+}
+
+/* Key field of KEY at LEVEL. */
+static inline size_t
+level_index (uint64_t key, int level) {
+	return (key >> level_shift (level)) & VM_RADIX_MASK;
+}
+
+/* Returns true if NODE has no occupied slots. */
+static bool
+node_empty (const struct vm_radix_node *node) {
+	size_t i;
+
+	for (i = 0; i < VM_RADIX_SIZE; i++)
+		if (node->slot[i] != NULL)
+			return false;
+	return true;
+}
+
+/* Initializes R as an empty tree. */
+void
+vm_radix_init (struct vm_radix *r) {
+	r->root = NULL;
+	r->cnt = 0;
+}
+
+/* Frees NODE and its subtree at LEVEL, passing each value and its
+   key (reassembled from PREFIX) to DESTRUCTOR if non-null. */
+static void
+destroy_node (struct vm_radix_node *node, int level, uint64_t prefix,
+		vm_radix_destroy_func *destructor) {
+	size_t i;
+
+	for (i = 0; i < VM_RADIX_SIZE; i++) {
+		if (node->slot[i] == NULL)
+			continue;
+		if (level == 0) {
+			if (destructor != NULL)
+				destructor (prefix | i, node->slot[i]);
+		} else
+			destroy_node (node->slot[i], level - 1,
+					prefix | ((uint64_t) i << level_shift (level)),
+					destructor);
+	}
+	free (node);
+}
+
+/* Destroys R, passing each value to DESTRUCTOR if it is
+   non-null. */
+void
+vm_radix_destroy (struct vm_radix *r, vm_radix_destroy_func *destructor) {
+	if (r->root != NULL) {
+		destroy_node (r->root, VM_RADIX_LEVELS - 1, 0, destructor);
+		r->root = NULL;
+	}
+	r->cnt = 0;
+}
+
+/* Returns the value stored under KEY, or a null pointer if KEY is
+   not in R. */
+void *
+vm_radix_find (const struct vm_radix *r, uint64_t key) {
+	struct vm_radix_node *node = r->root;
+	int level;
+
+	if (key >= VM_RADIX_LIMIT)
+		return NULL;
+
+	for (level = VM_RADIX_LEVELS - 1; node != NULL && level > 0; level--)
+		node = node->slot[level_index (key, level)];
+	return node != NULL ? node->slot[level_index (key, 0)] : NULL;
+}
+
+/* Inserts VAL, which must not be null, under KEY.  Returns true
+   on success, false if KEY is already present or memory
+   allocation failed. */
+bool
+vm_radix_insert (struct vm_radix *r, uint64_t key, void *val) {
+	struct vm_radix_node **slot = (struct vm_radix_node **) &r->root;
+	struct vm_radix_node *node;
+	int level;
+
+	ASSERT (key < VM_RADIX_LIMIT);
+	ASSERT (val != NULL);
+
+	for (level = VM_RADIX_LEVELS - 1; level >= 0; level--) {
+		if (*slot == NULL) {
+			*slot = calloc (1, sizeof **slot);
+			if (*slot == NULL)
+				return false;
+		}
+		node = *slot;
+		if (level == 0)
+			break;
+		slot = (struct vm_radix_node **) &node->slot[level_index (key, level)];
+	}
+
+	if (node->slot[level_index (key, 0)] != NULL)
+		return false;
+	node->slot[level_index (key, 0)] = val;
+	r->cnt++;
+	return true;
+}
+
+/* Removes KEY from R and returns its value, or a null pointer if
+   KEY was not present.  Interior nodes left empty are freed. */
+void *
+vm_radix_delete (struct vm_radix *r, uint64_t key) {
+	struct vm_radix_node *path[VM_RADIX_LEVELS];
+	struct vm_radix_node *node = r->root;
+	void *val;
+	int level;
+
+	ASSERT (key < VM_RADIX_LIMIT);
+
+	for (level = VM_RADIX_LEVELS - 1; level > 0; level--) {
+		if (node == NULL)
+			return NULL;
+		path[level] = node;
+		node = node->slot[level_index (key, level)];
+	}
+	if (node == NULL)
+		return NULL;
+	path[0] = node;
+
+	val = node->slot[level_index (key, 0)];
+	if (val == NULL)
+		return NULL;
+	node->slot[level_index (key, 0)] = NULL;
+	r->cnt--;
+
+	/* Prune now-empty nodes bottom up. */
+	for (level = 0; level < VM_RADIX_LEVELS && node_empty (path[level]);
+			level++) {
+		free (path[level]);
+		if (level + 1 < VM_RADIX_LEVELS)
+			path[level + 1]->slot[level_index (key, level + 1)] = NULL;
+		else
+			r->root = NULL;
+	}
+	return val;
+}
+
+/* Returns the number of values in R. */
+size_t
+vm_radix_size (const struct vm_radix *r) {
+	return r->cnt;
+}
+
+/* Returns the value with the smallest key greater than or equal
+   to START, storing that key in *KEY, or a null pointer if no
+   such value exists.  Iteration idiom:
+
+   uint64_t key = 0;
+   void *val;
+
+   while ((val = vm_radix_next (r, key, &key)) != NULL) {
+   ...do something with KEY and VAL...
+   key++;
+   } */
+void *
+vm_radix_next (const struct vm_radix *r, uint64_t start, uint64_t *key) {
+	uint64_t k = start;
+
+	if (r->root == NULL)
+		return NULL;
+
+	while (k < VM_RADIX_LIMIT) {
+		struct vm_radix_node *node = r->root;
+		int level;
+
+		for (level = VM_RADIX_LEVELS - 1; level >= 0; level--) {
+			int shift = level_shift (level);
+			size_t idx = level_index (k, level);
+
+			while (idx < VM_RADIX_SIZE && node->slot[idx] == NULL)
+				idx++;
+			if (idx >= VM_RADIX_SIZE) {
+				/* Subtree exhausted: advance K past it and restart
+				   the descent from the root. */
+				uint64_t span = (uint64_t) 1 << (shift + VM_RADIX_BITS);
+
+				k = (k & ~(span - 1)) + span;
+				break;
+			}
+			if (idx != level_index (k, level))
+				/* Skipped ahead: clear the lower key fields. */
+				k = (k & ~(((uint64_t) 1 << (shift + VM_RADIX_BITS)) - 1))
+					| ((uint64_t) idx << shift);
+			if (level == 0) {
+				*key = k;
+				return node->slot[idx];
+			}
+			node = node->slot[idx];
+		}
+	}
+	return NULL;
+}
@@ -2,4 +2,9 @@ lib/kernel_SRC  = lib/kernel/debug.c	# Debug helpers.
 lib/kernel_SRC += lib/kernel/list.c	# Doubly-linked lists.
 lib/kernel_SRC += lib/kernel/bitmap.c	# Bitmaps.
 lib/kernel_SRC += lib/kernel/hash.c	# Hash tables.
+lib/kernel_SRC += lib/kernel/omap.c	# Open-addressing hash maps.
+lib/kernel_SRC += lib/kernel/percpu.c	# Per-CPU counters.
+lib/kernel_SRC += lib/kernel/radix.c	# Radix trees.
+lib/kernel_SRC += lib/kernel/heap.c	# Pairing heaps.
+lib/kernel_SRC += lib/kernel/lz.c	# LZ77 compression.
 lib/kernel_SRC += lib/kernel/console.c	# printf(), putchar().
@@ -1,68 +1,118 @@
 #include "random.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include "debug.h"
 
-/* RC4-based pseudo-random number generator (PRNG).
+/* xoshiro256**-based pseudo-random number generator (PRNG).
 
-   RC4 is a stream cipher.  We're not using it here for its
-   cryptographic properties, but because it is easy to implement
-   and its output is plenty random for non-cryptographic
-   purposes.
+   The previous RC4 stream produced one byte per step of a
+   byte-at-a-time state machine over a 256-byte table.  xoshiro256**
+   produces 8 bytes per call from four 64-bit words using only
+   shifts, rotates, xors and one multiply, which keeps randomized
+   decisions on hot paths (eviction tie-breaking, allocator
+   randomization) about as cheap as the bookkeeping around them.
+   Like RC4 here, it is not cryptographic; its output is plenty
+   random for non-cryptographic purposes.
 
-   See http://en.wikipedia.org/wiki/RC4_(cipher) for information
-   on RC4.*/
+   See https://prng.di.unimi.it/ for the generator family.
 
-/* RC4 state. */
-static uint8_t s[256];          /* S[]. */
-static uint8_t s_i, s_j;        /* i, j. */
+   State is kept in cache-line-padded per-CPU slots so concurrent
+   consumers never bounce a line between them; today only slot 0
+   is ever used. */
 
-/* Already initialized? */
-static bool inited;     
+/* State slots provisioned; raise along with random_cpu() when
+   more than one CPU runs. */
+#define RANDOM_PCPU_MAX 4
 
-/* Swaps the bytes pointed to by A and B. */
-static inline void
-swap_byte (uint8_t *a, uint8_t *b) {
-	uint8_t t = *a;
-	*a = *b;
-	*b = t;
+/* Cache line size in bytes. */
+#define RANDOM_CACHELINE 64
+
+/* Per-CPU generator state, padded to a full cache line. */
+struct random_state {
+	uint64_t s[4];              /* xoshiro256** state; never all zero. */
+	bool inited;                /* Already seeded? */
+	char pad[RANDOM_CACHELINE - 4 * sizeof (uint64_t) - sizeof (bool)];
+};
+
+static struct random_state rstate[RANDOM_PCPU_MAX]
+	__attribute__ ((aligned (RANDOM_CACHELINE)));
+
+/* Returns the state slot for the executing CPU. */
+static inline struct random_state *
+random_cpu (void) {
+	return &rstate[0];
+}
+
+/* Rotates X left by K bits. */
+static inline uint64_t
+rotl (uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
 }
 
-/* Initializes or reinitializes the PRNG with the given SEED. */
+/* splitmix64 step, used only to expand a seed into initial state
+   words that are well mixed and never all zero. */
+static uint64_t
+splitmix64 (uint64_t *x) {
+	uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* Advances RS and returns the next 64 random bits. */
+static uint64_t
+random_next (struct random_state *rs) {
+	uint64_t *s = rs->s;
+	uint64_t result = rotl (s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl (s[3], 45);
+
+	return result;
+}
+
+/* Initializes or reinitializes the PRNG with the given SEED.
+   Every state slot is reseeded, so sequences are deterministic
+   for a given seed regardless of which CPU consumes them. */
 void
 random_init (unsigned seed) {
-	uint8_t *seedp = (uint8_t *) &seed;
-	int i;
-	uint8_t j;
-
-	for (i = 0; i < 256; i++) 
-		s[i] = i;
-	for (i = j = 0; i < 256; i++) {
-		j += s[i] + seedp[i % sizeof seed];
-		swap_byte (s + i, s + j);
-	}
+	uint64_t x = seed;
+	int cpu, i;
 
-	s_i = s_j = 0;
-	inited = true;
+	for (cpu = 0; cpu < RANDOM_PCPU_MAX; cpu++) {
+		for (i = 0; i < 4; i++)
+			rstate[cpu].s[i] = splitmix64 (&x);
+		rstate[cpu].inited = true;
+	}
 }
 
-/* Writes SIZE random bytes into BUF. */
+/* Writes SIZE random bytes into BUF, 8 bytes per generator
+   step. */
 void
 random_bytes (void *buf_, size_t size) {
-	uint8_t *buf;
+	struct random_state *rs = random_cpu ();
+	uint8_t *buf = buf_;
 
-	if (!inited)
+	if (!rs->inited)
 		random_init (0);
 
-	for (buf = buf_; size-- > 0; buf++) {
-		uint8_t s_k;
+	while (size >= sizeof (uint64_t)) {
+		uint64_t r = random_next (rs);
 
-		s_i++;
-		s_j += s[s_i];
-		swap_byte (s + s_i, s + s_j);
+		memcpy (buf, &r, sizeof r);
+		buf += sizeof r;
+		size -= sizeof r;
+	}
+	if (size > 0) {
+		uint64_t r = random_next (rs);
 
-		s_k = s[s_i] + s[s_j];
-		*buf = s[s_k];
+		memcpy (buf, &r, size);
 	}
 }
 
@@ -71,7 +121,10 @@ random_bytes (void *buf_, size_t size) {
    0...n (exclusive). */
 unsigned long
 random_ulong (void) {
-	unsigned long ul;
-	random_bytes (&ul, sizeof ul);
-	return ul;
+	struct random_state *rs = random_cpu ();
+
+	if (!rs->inited)
+		random_init (0);
+
+	return random_next (rs);
 }
@@ -129,6 +129,17 @@ static const struct integer_base base_o = {8, "01234567", 0, 3};
 static const struct integer_base base_x = {16, "0123456789abcdef", 'x', 4};
 static const struct integer_base base_X = {16, "0123456789ABCDEF", 'X', 4};
 
+/* Digit pairs "00" through "99", for converting decimal numbers
+   two digits per division instead of one.  64-bit division may go
+   through the software helpers in lib/arithmetic.c, so halving
+   the divisions matters on the console path. */
+static const char two_digits[] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
 static const char *parse_conversion (const char *format,
 		struct printf_conversion *,
 		va_list *);
@@ -468,12 +479,44 @@ format_integer (uintmax_t value, bool is_signed, bool negative,
 	   will output the buffer's content in reverse. */
 	cp = buf;
 	digit_cnt = 0;
-	while (value > 0) {
-		if ((c->flags & GROUP) && digit_cnt > 0 && digit_cnt % b->group == 0)
-			*cp++ = ',';
-		*cp++ = b->digits[value % b->base];
-		value /= b->base;
-		digit_cnt++;
+	if (b->base == 16 || b->base == 8) {
+		/* Power-of-two base: shift and mask, no division at all. */
+		int shift = b->base == 16 ? 4 : 3;
+
+		while (value > 0) {
+			if ((c->flags & GROUP) && digit_cnt > 0 && digit_cnt % b->group == 0)
+				*cp++ = ',';
+			*cp++ = b->digits[value & (b->base - 1)];
+			value >>= shift;
+			digit_cnt++;
+		}
+	} else if (b->base == 10 && !(c->flags & GROUP)) {
+		/* Decimal: emit two digits per division via the lookup
+		   table.  Grouping interleaves commas at digit granularity,
+		   so it keeps the generic loop below. */
+		while (value >= 100) {
+			const char *pair = two_digits + value % 100 * 2;
+
+			value /= 100;
+			*cp++ = pair[1];
+			*cp++ = pair[0];
+		}
+		if (value >= 10) {
+			const char *pair = two_digits + value * 2;
+
+			*cp++ = pair[1];
+			*cp++ = pair[0];
+		} else if (value > 0)
+			*cp++ = '0' + value;
+		digit_cnt = cp - buf;
+	} else {
+		while (value > 0) {
+			if ((c->flags & GROUP) && digit_cnt > 0 && digit_cnt % b->group == 0)
+				*cp++ = ',';
+			*cp++ = b->digits[value % b->base];
+			value /= b->base;
+			digit_cnt++;
+		}
 	}
 
 	/* Append enough zeros to match precision.
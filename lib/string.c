@@ -1,6 +1,13 @@
 #include <string.h>
 #include <debug.h>
 
+/* Size from which memcpy/memset switch to `rep' string
+   instructions.  Below it the setup cost dominates; above it the
+   microcoded move handles whole cache lines per cycle (ERMSB),
+   roughly an order of magnitude faster than a byte loop on
+   page-sized blocks. */
+#define REP_THRESHOLD 128
+
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
 void *
@@ -11,6 +18,13 @@ memcpy (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
+	if (size >= REP_THRESHOLD) {
+		asm volatile ("rep movsb"
+				: "+D" (dst), "+S" (src), "+c" (size)
+				:: "memory");
+		return dst_;
+	}
+
 	while (size-- > 0)
 		*dst++ = *src++;
 
@@ -28,6 +42,13 @@ memmove (void *dst_, const void *src_, size_t size) {
 	ASSERT (src != NULL || size == 0);
 
 	if (dst < src) {
+		/* A forward copy is overlap-safe with `rep movsb' too. */
+		if (size >= REP_THRESHOLD) {
+			asm volatile ("rep movsb"
+					: "+D" (dst), "+S" (src), "+c" (size)
+					:: "memory");
+			return dst_;
+		}
 		while (size-- > 0)
 			*dst++ = *src++;
 	} else {
@@ -260,6 +281,14 @@ memset (void *dst_, int value, size_t size) {
 
 	ASSERT (dst != NULL || size == 0);
 
+	if (size >= REP_THRESHOLD) {
+		asm volatile ("rep stosb"
+				: "+D" (dst), "+c" (size)
+				: "a" ((unsigned char) value)
+				: "memory");
+		return dst_;
+	}
+
 	while (size-- > 0)
 		*dst++ = value;
 
@@ -115,6 +115,115 @@ void munmap(void *addr) {
     syscall1(SYS_MUNMAP, addr);
 }
 
+int madvise(void *addr, size_t length, int advice) {
+    return syscall3(SYS_MADVISE, addr, length, advice);
+}
+
+int pipe(int fds[2]) {
+    return syscall1(SYS_PIPE, fds);
+}
+
+pid_t spawn(const char *cmd_line) {
+    return (pid_t)syscall1(SYS_SPAWN, cmd_line);
+}
+
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int sendfile(int dst_fd, int src_fd, unsigned length) {
+    return syscall3(SYS_SENDFILE, dst_fd, src_fd, length);
+}
+
+int pread(int fd, void *buffer, unsigned length, off_t offset) {
+    return syscall4(SYS_PREAD, fd, buffer, length, offset);
+}
+
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset) {
+    return syscall4(SYS_PWRITE, fd, buffer, length, offset);
+}
+
+int create_many(const char *const *names, const unsigned *sizes, int cnt) {
+    return syscall3(SYS_CREATE_MANY, names, sizes, cnt);
+}
+
+int remove_many(const char *const *names, int cnt) {
+    return syscall2(SYS_REMOVE_MANY, names, cnt);
+}
+
+int fadvise(int fd, int advice) {
+    return syscall2(SYS_FADVISE, fd, advice);
+}
+
+int stat(const char *file) {
+    return syscall1(SYS_STAT, file);
+}
+
+int kstats(struct kstats *buf) {
+    return syscall1(SYS_KSTATS, buf);
+}
+
+int vminspect(struct vm_page_info *buf, int cnt) {
+    return syscall2(SYS_VMINSPECT, buf, cnt);
+}
+
+int futex(int *uaddr, int op, int val) {
+    return syscall3(SYS_FUTEX, uaddr, op, val);
+}
+
+int getrusage(struct thread_usage *buf) {
+    return syscall1(SYS_GETRUSAGE, buf);
+}
+
+int memlimit(int pages) {
+    return syscall1(SYS_MEMLIMIT, pages);
+}
+
+/* Serializes this process's image to the swap disk.  Returns 0 to the
+   caller, 1 in the process resumed by the `restore` boot action, and
+   -1 on failure (fork convention). */
+int checkpoint(void) {
+    return syscall0(SYS_CHECKPOINT);
+}
+
+/* Nanoseconds since boot, without entering the kernel.  Reads the
+   read-only time page mapped at VDSO_TIME_VADDR and converts the TSC
+   with the same quotient/remainder split the kernel's ktime_ns()
+   uses.  The ticks field is live too but the TSC gives sub-tick
+   resolution for free.  Returns -1 if the page carries no valid
+   magic (kernel booted without calibration). */
+int64_t gettime(void) {
+    const volatile struct vdso_time *vt = (const volatile struct vdso_time *)VDSO_TIME_VADDR;
+    uint64_t lo, hi;
+
+    if (vt->magic != VDSO_TIME_MAGIC)
+        return -1;
+
+    __asm __volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    uint64_t delta = ((hi << 32) | lo) - vt->boot_tsc;
+    return (delta / vt->tsc_per_tick) * vt->ns_per_tick + (delta % vt->tsc_per_tick) * vt->ns_per_tick / vt->tsc_per_tick;
+}
+
+void *sbrk(intptr_t increment) {
+    return (void *)syscall1(SYS_SBRK, increment);
+}
+
+int shm_open(const char *name, size_t size) {
+    return syscall2(SYS_SHM_OPEN, name, size);
+}
+
+void *shm_map(int id, void *addr) {
+    return (void *)syscall2(SYS_SHM_MAP, id, addr);
+}
+
+int submit(struct syscall_desc *descs, int cnt) {
+    return syscall2(SYS_SUBMIT, descs, cnt);
+}
+
 bool chdir(const char *dir) {
     return syscall1(SYS_CHDIR, dir);
 }
@@ -0,0 +1,71 @@
+/* Metadata rate benchmark: create, open, and delete in one
+   directory.
+
+   Creates a batch of files in the root directory, timing each
+   operation, then times opening and finally removing every one.
+   The open and remove passes walk the directory's name lookup
+   each time, so these distributions track dir_lookup cost as the
+   directory fills. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define FILE_CNT 128
+
+static uint64_t samples[FILE_CNT];
+
+static void
+file_name (char *name, size_t size, size_t i)
+{
+  snprintf (name, size, "bf%03zu", i);
+}
+
+void
+test_main (void)
+{
+  char name[16];
+  size_t i;
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      uint64_t start;
+
+      file_name (name, sizeof name, i);
+      start = bench_rdtsc ();
+      if (!create (name, 0))
+        fail ("create \"%s\"", name);
+      samples[i] = bench_rdtsc () - start;
+    }
+  bench_report ("create_cycles", samples, FILE_CNT);
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      uint64_t start;
+      int fd;
+
+      file_name (name, sizeof name, i);
+      start = bench_rdtsc ();
+      fd = open (name);
+      samples[i] = bench_rdtsc () - start;
+      if (fd < 2)
+        fail ("open \"%s\"", name);
+      close (fd);
+    }
+  bench_report ("open_cycles", samples, FILE_CNT);
+
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      uint64_t start;
+
+      file_name (name, sizeof name, i);
+      start = bench_rdtsc ();
+      if (!remove (name))
+        fail ("remove \"%s\"", name);
+      samples[i] = bench_rdtsc () - start;
+    }
+  bench_report ("unlink_cycles", samples, FILE_CNT);
+}
@@ -0,0 +1,49 @@
+/* Random 512-byte read IOPS benchmark.
+
+   Fills a file, then issues random single-sector reads through
+   seek/read and reports the per-operation cycle distribution.
+   Random offsets come from the deterministic PRNG so every run
+   touches the same sequence of sectors. */
+
+#include <random.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define FILE_SIZE (256 * 1024)
+#define IO_SIZE 512
+#define OP_CNT 2048
+
+static char block[4096];
+static uint64_t samples[OP_CNT];
+
+void
+test_main (void)
+{
+  size_t ofs, i;
+  int fd;
+
+  CHECK (create ("bench.dat", FILE_SIZE), "create \"bench.dat\"");
+  CHECK ((fd = open ("bench.dat")) > 1, "open \"bench.dat\"");
+  for (ofs = 0; ofs < FILE_SIZE; ofs += sizeof block)
+    if (write (fd, block, sizeof block) != (int) sizeof block)
+      fail ("write %zu bytes at offset %zu", sizeof block, ofs);
+
+  random_init (0);
+  for (i = 0; i < OP_CNT; i++)
+    {
+      uint64_t start;
+
+      ofs = random_ulong () % (FILE_SIZE / IO_SIZE) * IO_SIZE;
+      start = bench_rdtsc ();
+      seek (fd, ofs);
+      if (read (fd, block, IO_SIZE) != IO_SIZE)
+        fail ("read %d bytes at offset %zu", IO_SIZE, ofs);
+      samples[i] = bench_rdtsc () - start;
+    }
+  close (fd);
+
+  bench_report ("rand_read_512_cycles", samples, OP_CNT);
+}
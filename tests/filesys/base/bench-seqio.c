@@ -0,0 +1,58 @@
+/* Sequential read/write bandwidth benchmark.
+
+   Writes and then reads back a file through the read/write
+   syscalls at several block sizes and reports each pass as a
+   [BENCH] throughput line (events are bytes, so cycles_per_event
+   is cycles per byte).  Compare against the raw_disk_read line
+   from the bench-disk kernel action to separate syscall-path
+   overhead from device cost. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define FILE_SIZE (256 * 1024)
+#define MAX_BLOCK 32768
+
+static char block[MAX_BLOCK];
+
+static const size_t block_sizes[] = {512, 4096, MAX_BLOCK};
+#define BLOCK_SIZE_CNT (sizeof block_sizes / sizeof *block_sizes)
+
+void
+test_main (void)
+{
+  size_t bi;
+
+  CHECK (create ("bench.dat", FILE_SIZE), "create \"bench.dat\"");
+
+  for (bi = 0; bi < BLOCK_SIZE_CNT; bi++)
+    {
+      size_t bs = block_sizes[bi];
+      char name[32];
+      uint64_t start;
+      size_t ofs;
+      int fd;
+
+      CHECK ((fd = open ("bench.dat")) > 1, "open \"bench.dat\" for write");
+      start = bench_rdtsc ();
+      for (ofs = 0; ofs < FILE_SIZE; ofs += bs)
+        if (write (fd, block, bs) != (int) bs)
+          fail ("write %zu bytes at offset %zu", bs, ofs);
+      snprintf (name, sizeof name, "seq_write_bs%zu", bs);
+      bench_report_rate (name, FILE_SIZE, bench_rdtsc () - start);
+      close (fd);
+
+      CHECK ((fd = open ("bench.dat")) > 1, "open \"bench.dat\" for read");
+      start = bench_rdtsc ();
+      for (ofs = 0; ofs < FILE_SIZE; ofs += bs)
+        if (read (fd, block, bs) != (int) bs)
+          fail ("read %zu bytes at offset %zu", bs, ofs);
+      snprintf (name, sizeof name, "seq_read_bs%zu", bs);
+      bench_report_rate (name, FILE_SIZE, bench_rdtsc () - start);
+      close (fd);
+    }
+}
@@ -0,0 +1,129 @@
+/* Wakeup-to-run latency benchmark.
+
+   A top-priority waiter blocks on a semaphore that a signaler
+   thread ups right after returning from timer_sleep(), while N
+   background threads churn the ready queue.  Each sample is the
+   TSC delta from just before sema_up() to the waiter's first
+   instruction after sema_down() returns: the unblock, ready
+   queue insert, preemption, and switch path under load.  Run at
+   several N to see how latency scales with ready queue depth;
+   this is the number the O(1) ready queue and timer wheel are
+   meant to hold flat.
+
+   Works with either scheduler, but lives with the mlfqs family
+   because load is what it is about. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "tests/threads/tests.h"
+#include "intrinsic.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define SAMPLE_CNT 64
+
+static const int churn_levels[] = {1, 16, 128};
+#define CHURN_LEVEL_CNT (sizeof churn_levels / sizeof *churn_levels)
+
+static struct semaphore wake_sema;      /* Downed by the waiter. */
+static struct semaphore ack_sema;       /* Waiter is done sampling. */
+static struct semaphore done_sema;      /* Thread exit notifications. */
+static volatile uint64_t signal_tsc;    /* TSC just before sema_up. */
+static volatile bool benchmark_done;    /* Stops churn and helper threads. */
+static uint64_t samples[SAMPLE_CNT];
+
+static int
+compare_sample (const void *a_, const void *b_)
+{
+  const uint64_t *a = a_;
+  const uint64_t *b = b_;
+
+  return *a < *b ? -1 : *a > *b;
+}
+
+/* Spins until the benchmark finishes, keeping the ready queue
+   populated. */
+static void
+churn_thread (void *aux UNUSED)
+{
+  while (!benchmark_done)
+    continue;
+  sema_up (&done_sema);
+}
+
+/* Wakes from the timer wheel, stamps the TSC, and signals the
+   waiter. */
+static void
+signal_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < SAMPLE_CNT; i++)
+    {
+      timer_sleep (1);
+      signal_tsc = rdtsc ();
+      sema_up (&wake_sema);
+      sema_down (&ack_sema);
+    }
+  sema_up (&done_sema);
+}
+
+/* Top-priority waiter: stamps the TSC the moment it runs again. */
+static void
+waiter_thread (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < SAMPLE_CNT; i++)
+    {
+      sema_down (&wake_sema);
+      samples[i] = rdtsc () - signal_tsc;
+      sema_up (&ack_sema);
+    }
+  sema_up (&done_sema);
+}
+
+void
+test_mlfqs_wakeup (void)
+{
+  size_t level;
+
+  for (level = 0; level < CHURN_LEVEL_CNT; level++)
+    {
+      int churn_cnt = churn_levels[level];
+      int i;
+
+      sema_init (&wake_sema, 0);
+      sema_init (&ack_sema, 0);
+      sema_init (&done_sema, 0);
+      benchmark_done = false;
+
+      for (i = 0; i < churn_cnt; i++)
+        {
+          char name[24];
+
+          snprintf (name, sizeof name, "churn-%d", i);
+          thread_create (name, PRI_DEFAULT, churn_thread, NULL);
+        }
+      thread_create ("waiter", PRI_MAX, waiter_thread, NULL);
+      thread_create ("signaler", PRI_DEFAULT, signal_thread, NULL);
+
+      /* Wait for the waiter and signaler, then stop the churn. */
+      sema_down (&done_sema);
+      sema_down (&done_sema);
+      benchmark_done = true;
+      for (i = 0; i < churn_cnt; i++)
+        sema_down (&done_sema);
+
+      qsort (samples, SAMPLE_CNT, sizeof *samples, compare_sample);
+      printf ("[BENCH] wakeup_n%d min=%llu median=%llu p99=%llu cycles\n",
+              churn_cnt,
+              (unsigned long long) samples[0],
+              (unsigned long long) samples[SAMPLE_CNT / 2],
+              (unsigned long long) samples[SAMPLE_CNT * 99 / 100]);
+    }
+
+  pass ();
+}
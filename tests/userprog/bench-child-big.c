@@ -0,0 +1,16 @@
+/* Large child for the bench-lifecycle spawn benchmark.  The
+   partially initialized blob lands in the data segment, so the
+   ELF on disk is half a megabyte: the spawn time difference
+   against bench-child-small is load cost, and with lazy loading
+   it should nearly vanish since the blob is never touched. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+
+static const char blob[512 * 1024] = {1};
+
+int
+main (void)
+{
+  return blob[0] - 1;
+}
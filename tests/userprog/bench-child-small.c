@@ -0,0 +1,11 @@
+/* Minimal child for the bench-lifecycle spawn benchmark: exits
+   as soon as it is loaded. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+
+int
+main (void)
+{
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* Process lifecycle latency benchmark.
+
+   Measures fork latency at several parent RSS levels (the
+   supplemental page table copy scales with resident pages, so
+   this quantifies its memcpy cost and any copy-on-write win),
+   full spawn round trips against a small and a large binary
+   (quantifying ELF load cost and lazy loading), and wait/exit
+   turnaround across a batch of children.  Results print as
+   [BENCH] lines in TSC cycles.  Run with bench-child-small and
+   bench-child-big put onto the file system disk. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define MAX_RSS_PAGES 256
+#define FORK_ITERS 16
+#define SPAWN_ITERS 8
+#define CHILD_CNT 16
+
+static char rss_pages[MAX_RSS_PAGES * PAGE_SIZE];
+static uint64_t samples[FORK_ITERS];
+
+static const size_t rss_levels[] = {1, 64, MAX_RSS_PAGES};
+#define RSS_LEVEL_CNT (sizeof rss_levels / sizeof *rss_levels)
+
+/* Times FORK_ITERS forks of an immediately exiting child and
+   reports them under NAME.  Only the parent-side fork return is
+   timed; the wait is not. */
+static void
+bench_fork (const char *name)
+{
+  size_t i;
+
+  for (i = 0; i < FORK_ITERS; i++)
+    {
+      uint64_t start = bench_rdtsc ();
+      pid_t child = fork ("bench-forked");
+
+      if (child == 0)
+        exit (0);
+      samples[i] = bench_rdtsc () - start;
+      if (wait (child) != 0)
+        fail ("forked child exited abnormally");
+    }
+  bench_report (name, samples, FORK_ITERS);
+}
+
+/* Times SPAWN_ITERS full fork/exec/wait round trips of BINARY
+   and reports them under NAME. */
+static void
+bench_spawn (const char *name, const char *binary)
+{
+  size_t i;
+
+  for (i = 0; i < SPAWN_ITERS; i++)
+    {
+      uint64_t start = bench_rdtsc ();
+      pid_t child = fork ("bench-spawned");
+
+      if (child == 0)
+        {
+          exec ((char *) binary);
+          fail ("exec \"%s\"", binary);
+        }
+      wait (child);
+      samples[i] = bench_rdtsc () - start;
+    }
+  bench_report (name, samples, SPAWN_ITERS);
+}
+
+void
+test_main (void)
+{
+  char name[32];
+  pid_t children[CHILD_CNT];
+  uint64_t start;
+  size_t level, i;
+
+  /* Fork latency as a function of parent RSS. */
+  for (level = 0; level < RSS_LEVEL_CNT; level++)
+    {
+      size_t pages = rss_levels[level];
+
+      for (i = 0; i < pages; i++)
+        rss_pages[i * PAGE_SIZE] = 1;
+      snprintf (name, sizeof name, "fork_rss%zu_cycles", pages);
+      bench_fork (name);
+    }
+
+  /* Spawn round trip against small and large binaries. */
+  bench_spawn ("spawn_small_cycles", "bench-child-small");
+  bench_spawn ("spawn_big_cycles", "bench-child-big");
+
+  /* Wait/exit turnaround with many children. */
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      children[i] = fork ("bench-batch");
+      if (children[i] == 0)
+        exit (0);
+    }
+  start = bench_rdtsc ();
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (children[i]) != 0)
+      fail ("batch child exited abnormally");
+  bench_report_rate ("wait_exit_turnaround", CHILD_CNT,
+                     bench_rdtsc () - start);
+}
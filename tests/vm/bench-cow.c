@@ -0,0 +1,47 @@
+/* Copy-on-write break cost benchmark.
+
+   The parent populates a run of pages and forks.  The child's
+   first write to each inherited page breaks the share: fault,
+   fresh frame, page copy, remap.  The child times each write and
+   reports the cycle distribution, then the parent verifies its
+   own copies survived. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 64
+
+static char shared_pages[PAGE_COUNT * PAGE_SIZE];
+static uint64_t samples[PAGE_COUNT];
+
+void
+test_main (void)
+{
+	pid_t child;
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++)
+		shared_pages[i * PAGE_SIZE] = (char) i;
+
+	child = fork ("bench-cow-child");
+	if (child == 0) {
+		for (i = 0; i < PAGE_COUNT; i++) {
+			uint64_t start = bench_rdtsc ();
+
+			shared_pages[i * PAGE_SIZE] = (char) (i + 1);
+			samples[i] = bench_rdtsc () - start;
+		}
+		bench_report ("cow_break_cycles", samples, PAGE_COUNT);
+		exit (0);
+	}
+
+	if (wait (child) != 0)
+		fail ("child exited abnormally");
+	for (i = 0; i < PAGE_COUNT; i++)
+		if (shared_pages[i * PAGE_SIZE] != (char) i)
+			fail ("child write leaked into parent page %zu", i);
+}
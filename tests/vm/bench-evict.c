@@ -0,0 +1,40 @@
+/* Eviction throughput benchmark.
+
+   Sweeps a working set larger than the user pool several times.
+   After the first pass every touch both swaps a page in and
+   forces another out, so sustained cycles per page is the cost
+   of the full eviction pipeline: victim selection, writeback,
+   swap-in.  Reports each pass as a throughput line; pass 0 is
+   the zero-fill baseline for comparison. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (20 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+#define PASS_CNT 3
+
+static char big_chunks[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+	size_t pass, i;
+
+	for (pass = 0; pass < PASS_CNT; pass++) {
+		char name[32];
+		uint64_t start = bench_rdtsc ();
+
+		for (i = 0; i < PAGE_COUNT; i++)
+			big_chunks[i * PAGE_SIZE] = (char) (i + pass);
+
+		snprintf (name, sizeof name, "evict_pass%zu", pass);
+		bench_report_rate (name, PAGE_COUNT, bench_rdtsc () - start);
+	}
+}
@@ -0,0 +1,59 @@
+/* Concurrent page-fault scalability benchmark.
+
+   Forks N children that each touch their own copy of an
+   untouched lazy region -- disjoint address spaces, so every
+   touch is an independent zero-fill fault -- and times the whole
+   batch from first fork to last wait.  Reported as aggregate
+   faults per run for N = 1..8, so cycles_per_event is the
+   effective cost of a fault with N fault streams contending on
+   the user pool, the frame table, and the SPT paths.  Flat
+   scaling across N is the acceptance criterion for the
+   allocator and locking work. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 256
+#define MAX_CHILDREN 8
+
+static char lazy_pages[PAGE_COUNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  int n;
+
+  for (n = 1; n <= MAX_CHILDREN; n *= 2)
+    {
+      pid_t children[MAX_CHILDREN];
+      char name[32];
+      uint64_t start;
+      int i;
+
+      start = bench_rdtsc ();
+      for (i = 0; i < n; i++)
+        {
+          children[i] = fork ("bench-faulter");
+          if (children[i] == 0)
+            {
+              size_t pg;
+
+              for (pg = 0; pg < PAGE_COUNT; pg++)
+                lazy_pages[pg * PAGE_SIZE] = (char) pg;
+              exit (0);
+            }
+        }
+      for (i = 0; i < n; i++)
+        if (wait (children[i]) != 0)
+          fail ("faulter child exited abnormally");
+
+      snprintf (name, sizeof name, "par_fault_n%d", n);
+      bench_report_rate (name, (uint64_t) n * PAGE_COUNT,
+                         bench_rdtsc () - start);
+    }
+}
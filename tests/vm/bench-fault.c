@@ -0,0 +1,38 @@
+/* Minor-fault latency benchmark.
+
+   Touches a run of lazily allocated anonymous pages for the
+   first time and times each touch, so every sample is one
+   zero-fill page fault: entry, SPT lookup, frame grab, install,
+   return.  Reports the cycle distribution. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 256
+
+static char lazy_pages[PAGE_COUNT * PAGE_SIZE];
+static uint64_t samples[PAGE_COUNT];
+
+void
+test_main (void)
+{
+	size_t i;
+
+	for (i = 0; i < PAGE_COUNT; i++) {
+		char *p = &lazy_pages[i * PAGE_SIZE];
+		uint64_t start;
+
+		if (get_phys_addr (p) != 0)
+			fail ("page %zu resident before first touch", i);
+
+		start = bench_rdtsc ();
+		*p = 1;
+		samples[i] = bench_rdtsc () - start;
+	}
+
+	bench_report ("minor_fault_cycles", samples, PAGE_COUNT);
+}
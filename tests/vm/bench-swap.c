@@ -0,0 +1,52 @@
+/* Major-fault latency benchmark.
+
+   Run with MEMORY smaller than the working set (swap-anon uses
+   20 MB against a 10 MB machine; same here) so the first writing
+   pass pushes earlier pages out to swap.  The second pass then
+   times the touch of each page that is no longer resident --
+   each sample is one swap-in, disk read included.  Reports the
+   cycle distribution over the evicted pages only. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (20 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunks[CHUNK_SIZE];
+static uint64_t samples[PAGE_COUNT];
+
+void
+test_main (void)
+{
+	size_t cnt = 0;
+	size_t i;
+
+	/* Populate the whole set; the tail of this pass evicts its
+	   head. */
+	for (i = 0; i < PAGE_COUNT; i++)
+		big_chunks[i * PAGE_SIZE] = (char) i;
+
+	/* Time the swap-ins. */
+	for (i = 0; i < PAGE_COUNT; i++) {
+		char *p = &big_chunks[i * PAGE_SIZE];
+		uint64_t start;
+
+		if (get_phys_addr (p) != 0)
+			continue;
+
+		start = bench_rdtsc ();
+		if (*p != (char) i)
+			fail ("data is inconsistent in page %zu", i);
+		samples[cnt++] = bench_rdtsc () - start;
+	}
+
+	if (cnt == 0)
+		fail ("nothing was evicted; is MEMORY too large?");
+	bench_report ("major_fault_cycles", samples, cnt);
+}
@@ -0,0 +1,47 @@
+/* Shared reporting for the VM benchmark programs (bench-*.c).
+
+   Every figure goes out on a single [BENCH] line with key=value
+   fields so tracking tooling can scrape it from the run log
+   without caring about the surrounding test chatter. */
+
+#include "tests/vm/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static int
+compare_sample (const void *a_, const void *b_)
+{
+	const uint64_t *a = a_;
+	const uint64_t *b = b_;
+
+	return *a < *b ? -1 : *a > *b;
+}
+
+/* Sorts CNT SAMPLES in place and prints METRIC's distribution. */
+void
+bench_report (const char *metric, uint64_t *samples, size_t cnt)
+{
+	uint64_t total = 0;
+	size_t i;
+
+	qsort (samples, cnt, sizeof *samples, compare_sample);
+	for (i = 0; i < cnt; i++)
+		total += samples[i];
+	printf ("[BENCH] %s n=%zu min=%llu median=%llu p99=%llu avg=%llu\n",
+			metric, cnt,
+			(unsigned long long) samples[0],
+			(unsigned long long) samples[cnt / 2],
+			(unsigned long long) samples[cnt * 99 / 100],
+			(unsigned long long) (total / cnt));
+}
+
+/* Prints METRIC as a throughput figure: EVENTS over CYCLES. */
+void
+bench_report_rate (const char *metric, uint64_t events, uint64_t cycles)
+{
+	printf ("[BENCH] %s events=%llu cycles=%llu cycles_per_event=%llu\n",
+			metric,
+			(unsigned long long) events,
+			(unsigned long long) cycles,
+			(unsigned long long) (cycles / (events > 0 ? events : 1)));
+}
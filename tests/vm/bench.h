@@ -0,0 +1,21 @@
+#ifndef TESTS_VM_BENCH_H
+#define TESTS_VM_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Reads the TSC from user mode; CR4.TSD is not set, so rdtsc is
+   legal at CPL 3. */
+static inline uint64_t
+bench_rdtsc (void)
+{
+	uint32_t lo, hi;
+
+	asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
+void bench_report (const char *metric, uint64_t *samples, size_t cnt);
+void bench_report_rate (const char *metric, uint64_t events, uint64_t cycles);
+
+#endif /* tests/vm/bench.h */
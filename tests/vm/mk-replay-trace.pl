@@ -0,0 +1,30 @@
+#! /usr/bin/perl
+# Packs a text trace listing into the binary format vm-replay.c
+# expects.  One event per line, '#' comments and blank lines
+# ignored:
+#
+#	r PAGE		read page PAGE
+#	w PAGE		write page PAGE
+#	fork COUNT	child replays the next COUNT events
+#	exit		stop replaying this process
+#
+# Usage: mk-replay-trace.pl < trace.txt > trace.bin
+use strict;
+use warnings;
+
+my %opcodes = (r => 0, w => 1, fork => 2, exit => 3);
+my @events;
+
+while (<STDIN>) {
+    chomp;
+    s/#.*//;
+    next unless /\S/;
+    my @fields = split;
+    my ($op, $arg) = @fields;
+    defined $opcodes{$op} or die "line $.: unknown op '$op'\n";
+    $arg = 0 if !defined $arg;
+    $arg =~ /^\d+$/ or die "line $.: bad argument '$arg'\n";
+    push @events, pack ("VV", $opcodes{$op}, $arg);
+}
+
+print "VMRT", pack ("V", scalar @events), @events;
@@ -0,0 +1,163 @@
+/* Trace-driven VM replay tool.
+
+   Replays a captured fault trace against the running kernel and
+   scores it with the vm_stat counters, so eviction-policy changes
+   can be compared on real access patterns instead of the synthetic
+   sweeps in bench-*.c.  Run by hand like the benchmarks: put a
+   trace file on the file system (pintos --p or fsutil put), then
+
+	vm-replay TRACE
+
+   and scrape the [BENCH] lines.  MEMORY should be set small enough
+   that the trace's working set actually evicts.
+
+   Trace format (little-endian throughout): an 8-byte header, the
+   magic "VMRT" then a 32-bit event count, followed by one 8-byte
+   record per event, a 32-bit opcode and a 32-bit argument:
+
+	0 TOUCH_R  read page ARG of the replay region
+	1 TOUCH_W  write page ARG
+	2 FORK     fork; the child replays the next ARG events and
+		   exits, the parent waits and skips them
+	3 EXIT     stop replaying this process
+
+   Page numbers are taken modulo the region size so traces captured
+   from a larger address space still run.  mk-replay-trace.pl packs
+   a readable text listing into this format. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "vm/stat.h"
+#include "tests/lib.h"
+#include "tests/vm/bench.h"
+
+#define PAGE_SIZE 4096
+#define REPLAY_PAGES 2048
+#define REPLAY_MAX_EVENTS 65536
+
+enum replay_op {
+	REPLAY_TOUCH_R,
+	REPLAY_TOUCH_W,
+	REPLAY_FORK,
+	REPLAY_EXIT
+};
+
+struct replay_event {
+	uint32_t op;
+	uint32_t arg;
+};
+
+static char region[REPLAY_PAGES * PAGE_SIZE];
+static struct replay_event events[REPLAY_MAX_EVENTS];
+static char sink;
+
+/* The vm_stat counters worth a scoreboard line, in enum order. */
+static const struct {
+	enum vm_stat_kind kind;
+	const char *name;
+} scored_stats[] = {
+	{VM_STAT_FAULT, "faults"},
+	{VM_STAT_MAJOR_FAULT, "major_faults"},
+	{VM_STAT_EVICTION, "evictions"},
+	{VM_STAT_SWAP_IN, "swap_ins"},
+	{VM_STAT_SWAP_OUT, "swap_outs"},
+	{VM_STAT_COW_BREAK, "cow_breaks"},
+};
+
+/* Replays CNT events starting at START.  FORK recurses into the
+   child's slice of the tape; the parent waits, then resumes past
+   it, so the interleaving is deterministic run to run. */
+static void
+replay (size_t start, size_t cnt)
+{
+	size_t end = start + cnt;
+	size_t i = start;
+
+	while (i < end) {
+		const struct replay_event *e = &events[i++];
+
+		switch (e->op) {
+		case REPLAY_TOUCH_R:
+			sink += region[(e->arg % REPLAY_PAGES) * PAGE_SIZE];
+			break;
+
+		case REPLAY_TOUCH_W:
+			region[(e->arg % REPLAY_PAGES) * PAGE_SIZE] = (char) e->arg;
+			break;
+
+		case REPLAY_FORK: {
+			pid_t child;
+
+			if (e->arg > end - i)
+				fail ("event %zu: fork body runs off the tape", i - 1);
+			child = fork ("vm-replay-child");
+			if (child == 0) {
+				replay (i, e->arg);
+				exit (0);
+			}
+			if (wait (child) != 0)
+				fail ("event %zu: child exited abnormally", i - 1);
+			i += e->arg;
+			break;
+		}
+
+		case REPLAY_EXIT:
+			return;
+
+		default:
+			fail ("event %zu: unknown opcode %u", i - 1, e->op);
+		}
+	}
+}
+
+int
+main (int argc, char *argv[])
+{
+	const char *trace = argc > 1 ? argv[1] : "trace.bin";
+	struct kstats before, after;
+	unsigned char header[8];
+	uint64_t start, cycles;
+	uint32_t cnt;
+	int handle;
+	size_t i;
+
+	test_name = "vm-replay";
+	msg ("begin");
+
+	CHECK ((handle = open (trace)) > 1, "open \"%s\"", trace);
+	CHECK (read (handle, header, sizeof header) == sizeof header,
+			"read \"%s\" header", trace);
+	if (memcmp (header, "VMRT", 4))
+		fail ("\"%s\": missing VMRT signature", trace);
+	cnt = header[4] | (uint32_t) header[5] << 8
+		| (uint32_t) header[6] << 16 | (uint32_t) header[7] << 24;
+	if (cnt > REPLAY_MAX_EVENTS)
+		fail ("\"%s\": %u events, limit is %u",
+				trace, cnt, (unsigned) REPLAY_MAX_EVENTS);
+	CHECK (read (handle, events, cnt * sizeof *events)
+			== (int) (cnt * sizeof *events),
+			"read %u events from \"%s\"", cnt, trace);
+	close (handle);
+
+	CHECK (kstats (&before) == 0, "kstats before");
+	start = bench_rdtsc ();
+	replay (0, cnt);
+	cycles = bench_rdtsc () - start;
+	CHECK (kstats (&after) == 0, "kstats after");
+
+	bench_report_rate ("replay_events", cnt, cycles);
+	for (i = 0; i < sizeof scored_stats / sizeof *scored_stats; i++) {
+		int k = scored_stats[i].kind;
+
+		if (k >= after.vm_stat_cnt)
+			break;
+		printf ("[BENCH] replay_%s count=%lld\n", scored_stats[i].name,
+				after.vm_stat[k] - before.vm_stat[k]);
+	}
+
+	msg ("end");
+	return 0;
+}
@@ -2,6 +2,7 @@
 
 #include <console.h>
 #include <debug.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <random.h>
 #include <stddef.h>
@@ -12,6 +13,7 @@
 
 #include "devices/input.h"
 #include "devices/kbd.h"
+#include "intrinsic.h"
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
@@ -22,6 +24,9 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/softirq.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/exception.h"
@@ -33,6 +38,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/stat.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -63,6 +69,46 @@ static void usage(void);
 
 static void print_stats(void);
 
+/** #Project 3: Boot Timing - 초기화 단계별 TSC 스탬프.
+ *  CI처럼 하루에 수천 번 부팅하는 워크플로에서 부팅 지연 회귀를 단계에
+ *  귀속시키기 위한 것. 각 단계가 끝날 때 boot_phase_mark()가 직전 마크
+ *  이후의 사이클 수를 기록하고, timer_calibrate() 이후에 한 줄로 출력한다.
+ *  보정 전 단계도 원시 사이클로 쌓아 두었다가 나중에 변환한다. */
+#define BOOT_PHASE_MAX 12
+
+struct boot_phase {
+    const char *name;   /* 단계 이름 */
+    uint64_t cycles;    /* 직전 마크 이후 TSC 사이클 */
+};
+
+static struct boot_phase boot_phases[BOOT_PHASE_MAX];
+static size_t boot_phase_cnt;
+static uint64_t boot_phase_tsc;
+
+/* 직전 마크 이후 구간을 NAME 단계로 기록합니다. */
+static void boot_phase_mark(const char *name) {
+    uint64_t now = rdtsc();
+
+    if (boot_phase_cnt < BOOT_PHASE_MAX) {
+        boot_phases[boot_phase_cnt].name = name;
+        boot_phases[boot_phase_cnt].cycles = now - boot_phase_tsc;
+        boot_phase_cnt++;
+    }
+    boot_phase_tsc = now;
+}
+
+/* 부팅 단계별 소요 시간을 한 줄로 출력합니다. */
+static void boot_phase_report(void) {
+    uint64_t total = 0;
+
+    printf("Boot timing:");
+    for (size_t i = 0; i < boot_phase_cnt; i++) {
+        printf(" %s %" PRId64 " us,", boot_phases[i].name, timer_cycles_to_us(boot_phases[i].cycles));
+        total += boot_phases[i].cycles;
+    }
+    printf(" total %" PRId64 " us\n", timer_cycles_to_us(total));
+}
+
 int main(void) NO_RETURN;
 
 /* Pintos main program. */
@@ -72,10 +118,12 @@ int main(void) {
 
     /* BSS를 지우고 시스템의 RAM 크기를 가져옵니다. */
     bss_init();
+    boot_phase_tsc = rdtsc();
 
     /* 명령줄을 인수로 나누고 옵션을 구문 분석합니다. */
     argv = read_command_line();
     argv = parse_options(argv);
+    boot_phase_mark("cmdline");
 
     /* 잠금을 사용할 수 있도록 스레드로 초기화한 다음 콘솔 잠금을 활성화합니다. */
     thread_init();
@@ -85,6 +133,7 @@ int main(void) {
     mem_end = palloc_init();
     malloc_init();
     paging_init(mem_end);
+    boot_phase_mark("memory");
 
 #ifdef USERPROG
     tss_init();
@@ -99,22 +148,34 @@ int main(void) {
     exception_init();
     syscall_init();
 #endif
+    boot_phase_mark("intr");
+
     /* 스레드 스케줄러를 시작하고 인터럽트를 활성화합니다. */
     thread_start();
+    softirq_init();
+    workqueue_init();
+    mmu_pool_init();
+    palloc_start_zerod();
     serial_init_queue();
+    boot_phase_mark("sched");
     timer_calibrate();
+    boot_phase_mark("calibrate");
 
 #ifdef FILESYS
     /* Initialize file system. */
     disk_init();
+    boot_phase_mark("disk");
     filesys_init(format_filesys);
+    boot_phase_mark("filesys");
 #endif
 
 #ifdef VM
     vm_init();
+    boot_phase_mark("vm");
 #endif
 
     printf("Boot complete.\n");
+    boot_phase_report();
 
     /* 커널 명령줄에 지정된 작업을 실행니다. */
     run_actions(argv);
@@ -228,11 +289,27 @@ static char **parse_options(char **argv) {
             random_init(atoi(value));
         else if (!strcmp(name, "-mlfqs"))
             thread_mlfqs = true;
+#ifdef VM
+        else if (!strcmp(name, "-evict")) {
+            if (!vm_set_evict_policy(value))
+                PANIC("unknown eviction policy `%s' (use -h for help)", value);
+        } else if (!strcmp(name, "-swap-limit")) {
+            if (!swap_set_limit(atoi(value)))
+                PANIC("swap limit `%s' out of range (1-100)", value);
+        } else if (!strcmp(name, "-ksm"))
+            vm_ksm_requested = true;
+#endif
 #ifdef USERPROG
         else if (!strcmp(name, "-ul"))
             user_page_limit = atoi(value);
         else if (!strcmp(name, "-threads-tests"))
             thread_tests = true;
+        else if (!strcmp(name, "-syscall-prof"))
+            syscall_prof_active = true;
+        else if (!strcmp(name, "-rip-prof"))
+            rip_prof_active = true;
+        else if (!strcmp(name, "-trace"))
+            trace_start();
 #endif
         else
             PANIC("unknown option `%s' (use -h for help)", name);
@@ -241,6 +318,24 @@ static char **parse_options(char **argv) {
     return argv;
 }
 
+#ifdef VM
+/* Dumps the global VM counters; see vm/stat.c. */
+static void dump_vm_stats(char **argv UNUSED) {
+    vm_stat_dump();
+}
+
+/* Restores the checkpoint image from the swap disk, if one exists,
+   and waits for the resumed process to finish. */
+static void run_restore(char **argv UNUSED) {
+    tid_t tid = process_restore();
+
+    if (tid == TID_ERROR)
+        printf("restore: no checkpoint image\n");
+    else
+        process_wait(tid);
+}
+#endif
+
 /* Runs the task specified in ARGV[1]. */
 static void run_task(char **argv) {
     const char *task = argv[1];
@@ -272,7 +367,10 @@ static void run_actions(char **argv) {
     static const struct action actions[] = {
         {"run", 2, run_task},
 #ifdef FILESYS
-        {"ls", 1, fsutil_ls}, {"cat", 2, fsutil_cat}, {"rm", 2, fsutil_rm}, {"put", 2, fsutil_put}, {"get", 2, fsutil_get},
+        {"ls", 1, fsutil_ls}, {"cat", 2, fsutil_cat}, {"rm", 2, fsutil_rm}, {"put", 2, fsutil_put}, {"get", 2, fsutil_get}, {"bench-disk", 1, fsutil_bench_disk},
+#endif
+#ifdef VM
+        {"vmstat", 1, dump_vm_stats}, {"restore", 1, run_restore},
 #endif
         {NULL, 0, NULL},
     };
@@ -319,6 +417,10 @@ static void usage(void) {
         "Use these actions indirectly via `pintos' -g and -p options:\n"
         "  put FILE           Put FILE into file system from scratch disk.\n"
         "  get FILE           Get FILE from file system into scratch disk.\n"
+#endif
+#ifdef VM
+        "  vmstat             Print virtual memory statistics.\n"
+        "  restore            Resume the process image checkpointed on the swap disk.\n"
 #endif
         "\nOptions:\n"
         "  -h                 Print this help message and power off.\n"
@@ -329,6 +431,16 @@ static void usage(void) {
 #ifdef USERPROG
         "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
+#ifdef VM
+        "  -evict=POLICY      Use eviction POLICY: clock (default), wsclock, 2q.\n"
+        "  -swap-limit=PCT    Throttle anon memory above PCT%% swap occupancy.\n"
+        "  -ksm               Merge identical anonymous pages in the background.\n"
+#endif
+#ifdef USERPROG
+        "  -syscall-prof      Dump per-process syscall counts and cycles at exit.\n"
+#endif
+        "  -rip-prof          Sample interrupted rip per tick, dump at thread exit.\n"
+        "  -trace             Record sched/fault/disk/syscall events, dump at exit.\n"
     );
     power_off();
 }
@@ -352,11 +464,15 @@ void power_off(void) {
 static void print_stats(void) {
     timer_print_stats();
     thread_print_stats();
+    lock_print_stats();
+    if (trace_enabled)
+        trace_dump();
 #ifdef FILESYS
     disk_print_stats();
 #endif
     console_print_stats();
     kbd_print_stats();
+    intr_print_stats();
 #ifdef USERPROG
     exception_print_stats();
 #endif
@@ -2,6 +2,7 @@
 
 #include <debug.h>
 #include <inttypes.h>
+#include <percpu.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -89,6 +90,16 @@ static intr_handler_func *intr_handlers[INTR_CNT];
 /* Names for each interrupt, for debugging purposes. */
 static const char *intr_names[INTR_CNT];
 
+/** #Project 3: IRQ 지연 계측 - 벡터별 호출 횟수와 누적 TSC 사이클
+ *  (per-CPU 카운터), 그리고 1회 최대 사이클 워터마크. 어떤 핸들러가
+ *  CPU를 얼마나 먹고 최악에 얼마나 오래 도는지를 벡터 단위로 남겨,
+ *  어느 핸들러부터 softirq로 쪼갤지 판단하는 근거로 쓴다. 갱신은
+ *  percpu.h와 같은 철학으로 비원자적이다 - 진단 카운터의 틱 하나가
+ *  핫패스의 원자 연산보다 싸다. */
+static struct pcpu_counter intr_calls[INTR_CNT];
+static struct pcpu_counter intr_cycles[INTR_CNT];
+static uint64_t intr_max_cycles[INTR_CNT];
+
 /* External interrupts are those generated by devices outside the
    CPU, such as the timer.  External interrupts run with
    interrupts turned off, so they never nest, nor are they ever
@@ -284,6 +295,14 @@ static void pic_end_of_interrupt(int irq) {
 }
 /* Interrupt handlers. */
 
+/** #Project 3: Page Fault Fast Path - VEC_NO의 IDT 게이트를 공용 스텁 대신
+ *  전용 어셈블리 진입점으로 바꾼다. intr_register_int()로 먼저 등록해 둔
+ *  핸들러는 전용 진입점이 느린 경로로 되돌릴 때의 디스패치용으로 남는다. */
+void intr_install_fast_entry(uint8_t vec_no, intr_stub_func *entry) {
+    ASSERT(intr_handlers[vec_no] != NULL);
+    make_intr_gate(&idt[vec_no], entry, 0);
+}
+
 /* 모든 인터럽트, 오류 및 예외에 대한 처리기입니다. 이 함수는 intr-stubs.S의
    어셈블리 언어 인터럽트 스텁에 의해 호출됩니다. FRAME은 인터럽트와 인터럽트된
    스레드의 레지스터를 설명합니다. */
@@ -305,9 +324,17 @@ void intr_handler(struct intr_frame *frame) {
 
     /* Invoke the interrupt's handler. */
     handler = intr_handlers[frame->vec_no];
-    if (handler != NULL)
+    if (handler != NULL) {
+        /** #Project 3: IRQ 지연 계측 - 핸들러 전후 TSC로 소요 시간 집계 */
+        uint64_t start = rdtsc();
         handler(frame);
-    else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+        uint64_t delta = rdtsc() - start;
+
+        pcpu_inc(&intr_calls[frame->vec_no]);
+        pcpu_add(&intr_cycles[frame->vec_no], delta);
+        if (delta > intr_max_cycles[frame->vec_no])
+            intr_max_cycles[frame->vec_no] = delta;
+    } else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
         /* 핸들러는 없지만 이 인터럽트는 하드웨어 결함이나 하드웨어 경쟁 조건으로 인해
            허위로 트리거될 수 있습니다. 무시하세요. */
     } else {
@@ -349,3 +376,21 @@ void intr_dump_frame(const struct intr_frame *f) {
 const char *intr_name(uint8_t vec) {
     return intr_names[vec];
 }
+
+/** #Project 3: IRQ 지연 계측 - 한 번이라도 들어온 벡터별로 호출 횟수,
+ *  누적/최대 소요 시간을 출력한다. 사이클→µs 변환은 보정 이후에만
+ *  유효하다(timer_cycles_to_us 참고). */
+void intr_print_stats(void) {
+    int vec;
+
+    for (vec = 0; vec < INTR_CNT; vec++) {
+        int64_t calls = pcpu_sum(&intr_calls[vec]);
+        if (calls == 0)
+            continue;
+
+        printf("Intr %#04x (%s): %" PRId64 " calls, %" PRId64 " us total, max %" PRId64 " us\n",
+               vec, intr_names[vec], calls,
+               timer_cycles_to_us((uint64_t)pcpu_sum(&intr_cycles[vec])),
+               timer_cycles_to_us(intr_max_cycles[vec]));
+    }
+}
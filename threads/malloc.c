@@ -32,9 +32,12 @@
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
-   descriptor.  We handle those by allocating contiguous pages
-   with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   descriptor.  Requests up to LARGE_MAX go to the large-object
+   tier below, which carves spans out of multi-page chunks with
+   best-fit selection and split/coalesce of free runs; anything
+   bigger still goes straight to the page allocator, with the
+   allocation size stuck at the beginning of the block's arena
+   header. */
 
 /* Descriptor. */
 struct desc {
@@ -63,6 +66,58 @@ struct block {
 static struct desc descs[10]; /* Descriptors. */
 static size_t desc_cnt;       /* Number of descriptors. */
 
+/* Large-object tier.
+
+   Mid-size kernel buffers -- iovec staging, compressed swap
+   blobs, request arrays -- fall between the 2 kB descriptor
+   ceiling and a handful of pages.  Sending them through
+   palloc_get_multiple() rounds each one up to whole pages and
+   walks the allocator's contiguous-run scan.  Instead we keep
+   LARGE_CHUNK_PAGES-page chunks and carve them into spans: a
+   64-byte header directly precedes each allocation, free
+   neighbors coalesce through the size/prev_size offsets, and
+   allocation picks the best-fitting free span so big runs stay
+   intact for big requests.  A chunk whose single free span
+   covers it entirely goes back to the page allocator. */
+
+#define SPAN_ALIGN 64                 /* Span granularity (one cache line). */
+#define LARGE_CHUNK_PAGES 16          /* Pages per chunk (64 kB). */
+#define LARGE_MAX (4 * PGSIZE)        /* Biggest request served by spans. */
+
+/* Span magics: in use vs. on the free list. */
+#define SPAN_USED_MAGIC 0x51a9bd04
+#define SPAN_FREE_MAGIC 0x51a9bd05
+
+/* Chunk magic, for asserts only. */
+#define CHUNK_MAGIC 0xc4a21f8e
+
+/* Header directly preceding every span body.  free() tells spans
+   apart from descriptor and big blocks by the magic plus the
+   self pointer: matching both by accident would take adjacent
+   user data spelling out its own address. */
+struct span {
+    unsigned magic;        /* SPAN_USED_MAGIC or SPAN_FREE_MAGIC. */
+    struct span *self;     /* Points at this header. */
+    size_t size;           /* Span bytes, header included. */
+    size_t prev_size;      /* Size of the span before us; 0 if first. */
+    struct chunk *chunk;   /* Owning chunk. */
+    struct list_elem elem; /* Free-span list element (when free). */
+    uint8_t pad[8];        /* Pad the header to SPAN_ALIGN. */
+};
+_Static_assert(sizeof(struct span) == SPAN_ALIGN, "span header must be one span unit");
+
+/* Chunk header, at the start of every chunk's first page. */
+struct chunk {
+    unsigned magic;                        /* CHUNK_MAGIC. */
+    uint8_t pad[SPAN_ALIGN - sizeof(unsigned)]; /* Keep spans aligned. */
+};
+
+/* Bytes of span space per chunk. */
+#define CHUNK_SPACE (LARGE_CHUNK_PAGES * PGSIZE - sizeof(struct chunk))
+
+static struct list large_free; /* All free spans, every chunk. */
+static struct lock large_lock; /* Guards spans and the free list. */
+
 static struct arena *block_to_arena(struct block *);
 static struct block *arena_to_block(struct arena *, size_t idx);
 
@@ -78,6 +133,142 @@ void malloc_init(void) {
         list_init(&d->free_list);
         lock_init(&d->lock);
     }
+
+    list_init(&large_free);
+    lock_init(&large_lock);
+}
+
+/* Returns P's span header if P is a large-tier allocation, else
+   a null pointer.  Descriptor blocks sit within the first 64
+   bytes of their page while span bodies are 64-byte aligned, so
+   the header read below never strays outside P's own allocation. */
+static struct span *ptr_to_span(void *p) {
+    struct span *sp;
+
+    if (pg_ofs(p) != 0 && pg_ofs(p) < sizeof(struct span))
+        return NULL;
+    sp = (struct span *)p - 1;
+    return sp->magic == SPAN_USED_MAGIC && sp->self == sp ? sp : NULL;
+}
+
+/* Returns the span after SP within its chunk, or a null pointer
+   if SP is the chunk's last. */
+static struct span *span_next(struct span *sp) {
+    uint8_t *end = (uint8_t *)sp->chunk + LARGE_CHUNK_PAGES * PGSIZE;
+    uint8_t *next = (uint8_t *)sp + sp->size;
+
+    return next < end ? (struct span *)next : NULL;
+}
+
+/* Carves the tail of SP off into a new free span if enough
+   remains past NEED bytes to be worth tracking. */
+static void span_split(struct span *sp, size_t need) {
+    struct span *rest, *next;
+
+    if (sp->size - need < 2 * sizeof(struct span))
+        return;
+
+    rest = (struct span *)((uint8_t *)sp + need);
+    rest->magic = SPAN_FREE_MAGIC;
+    rest->self = rest;
+    rest->size = sp->size - need;
+    rest->prev_size = need;
+    rest->chunk = sp->chunk;
+    sp->size = need;
+
+    next = span_next(rest);
+    if (next != NULL)
+        next->prev_size = rest->size;
+    list_push_front(&large_free, &rest->elem);
+}
+
+/* Serves a SIZE-byte request from the span tier, growing it by a
+   chunk if no free span fits.  Returns a null pointer if the
+   page allocator cannot supply a chunk. */
+static void *large_alloc(size_t size) {
+    size_t need = ROUND_UP(size, SPAN_ALIGN) + sizeof(struct span);
+    struct span *best = NULL;
+    struct list_elem *e;
+
+    lock_acquire(&large_lock);
+
+    /* Best fit: the smallest free span that holds NEED, so big
+       runs survive for requests that actually need them. */
+    for (e = list_begin(&large_free); e != list_end(&large_free); e = list_next(e)) {
+        struct span *sp = list_entry(e, struct span, elem);
+
+        if (sp->size >= need && (best == NULL || sp->size < best->size))
+            best = sp;
+    }
+
+    if (best == NULL) {
+        struct chunk *c = palloc_get_multiple(0, LARGE_CHUNK_PAGES);
+
+        if (c == NULL) {
+            lock_release(&large_lock);
+            return NULL;
+        }
+        c->magic = CHUNK_MAGIC;
+
+        best = (struct span *)(c + 1);
+        best->magic = SPAN_FREE_MAGIC;
+        best->self = best;
+        best->size = CHUNK_SPACE;
+        best->prev_size = 0;
+        best->chunk = c;
+        list_push_front(&large_free, &best->elem);
+    }
+
+    list_remove(&best->elem);
+    span_split(best, need);
+    best->magic = SPAN_USED_MAGIC;
+
+    lock_release(&large_lock);
+    return best + 1;
+}
+
+/* Returns SP to the free list, coalescing with free neighbors;
+   a chunk left with one all-covering free span goes back to the
+   page allocator. */
+static void large_free_span(struct span *sp) {
+    struct span *next, *prev;
+
+    lock_acquire(&large_lock);
+
+#ifndef NDEBUG
+    /* Clear the body to help detect use-after-free bugs. */
+    memset(sp + 1, 0xcc, sp->size - sizeof *sp);
+#endif
+    sp->magic = SPAN_FREE_MAGIC;
+
+    /* Fold a free right neighbor into us. */
+    next = span_next(sp);
+    if (next != NULL && next->magic == SPAN_FREE_MAGIC) {
+        list_remove(&next->elem);
+        sp->size += next->size;
+        next = span_next(sp);
+    }
+
+    /* Fold us into a free left neighbor. */
+    if (sp->prev_size != 0) {
+        prev = (struct span *)((uint8_t *)sp - sp->prev_size);
+        if (prev->magic == SPAN_FREE_MAGIC) {
+            list_remove(&prev->elem);
+            prev->size += sp->size;
+            sp = prev;
+        }
+    }
+
+    if (next != NULL)
+        next->prev_size = sp->size;
+
+    if (sp->size == CHUNK_SPACE) {
+        /* Nothing else lives in the chunk: give the pages back. */
+        palloc_free_multiple(sp->chunk, LARGE_CHUNK_PAGES);
+    } else
+        list_push_front(&large_free, &sp->elem);
+
+    lock_release(&large_lock);
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -97,6 +288,17 @@ void *malloc(size_t size) {
         if (d->block_size >= size)
             break;
     if (d == descs + desc_cnt) {
+        /* Mid-size request: the span tier avoids both the whole-page
+           rounding and the contiguous-run scan.  On failure (no
+           chunk available) fall through to the page allocator,
+           which may still find a smaller run. */
+        if (size <= LARGE_MAX) {
+            void *p = large_alloc(size);
+
+            if (p != NULL)
+                return p;
+        }
+
         /* SIZE is too big for any descriptor.
            Allocate enough pages to hold SIZE plus an arena. */
         size_t page_cnt = DIV_ROUND_UP(size + sizeof *a, PGSIZE);
@@ -164,10 +366,16 @@ void *calloc(size_t a, size_t b) {
 
 /* Returns the number of bytes allocated for BLOCK. */
 static size_t block_size(void *block) {
+    struct span *sp = ptr_to_span(block);
     struct block *b = block;
-    struct arena *a = block_to_arena(b);
-    struct desc *d = a->desc;
+    struct arena *a;
+    struct desc *d;
 
+    if (sp != NULL)
+        return sp->size - sizeof *sp;
+
+    a = block_to_arena(b);
+    d = a->desc;
     return d != NULL ? d->block_size : PGSIZE * a->free_cnt - pg_ofs(block);
 }
 
@@ -197,9 +405,19 @@ void *realloc(void *old_block, size_t new_size) {
    malloc(), calloc(), or realloc(). */
 void free(void *p) {
     if (p != NULL) {
+        struct span *sp = ptr_to_span(p);
         struct block *b = p;
-        struct arena *a = block_to_arena(b);
-        struct desc *d = a->desc;
+        struct arena *a;
+        struct desc *d;
+
+        /* Large-tier span: handled entirely by the span allocator. */
+        if (sp != NULL) {
+            large_free_span(sp);
+            return;
+        }
+
+        a = block_to_arena(b);
+        d = a->desc;
 
         if (d != NULL) {
             /* It's a normal block.  We handle it here. */
@@ -1,14 +1,196 @@
 #include "threads/mmu.h"
 
+#include <debug.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
 
 #include "intrinsic.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
+
+/* Recycling pool of zeroed page-table pages.
+ *
+ * Address-space construction used to take a kernel-pool page per
+ * paging structure and process exit freed them all back, so heavy
+ * fork/exit churn was constant traffic through the pool lock.
+ * Freed paging pages park on a dirty list instead; a background
+ * task zeroes them in batches onto a clean list, and the walk
+ * functions allocate pre-zeroed pages from it with only a brief
+ * interrupt-off window. */
+#define PTPOOL_MAX 64  /* Pages parked per list. */
+#define PTPOOL_LOWAT 8 /* Refill the clean list below this. */
+
+static void *pt_clean[PTPOOL_MAX]; /* Zeroed, ready to hand out. */
+static size_t pt_clean_cnt;
+static void *pt_dirty[PTPOOL_MAX]; /* Returned, awaiting zeroing. */
+static size_t pt_dirty_cnt;
+static struct workqueue ptpool_wq;
+static struct work ptpool_work;
+static bool ptpool_queued;
+static bool ptpool_ready;
+
+static void ptpool_zero(void *aux);
+
+/* Schedules the background zeroing task unless it is already
+ * queued. */
+static void ptpool_kick(void) {
+    enum intr_level old_level = intr_disable();
+    bool queued = ptpool_queued;
+    if (!queued && ptpool_ready)
+        ptpool_queued = true;
+    intr_set_level(old_level);
+
+    if (!queued && ptpool_ready)
+        workqueue_enqueue(&ptpool_wq, &ptpool_work, ptpool_zero, NULL);
+}
+
+/* Background task: zeroes parked dirty pages onto the clean list
+ * and tops the clean list up from the kernel pool if draining
+ * left it below the low-water mark. */
+static void ptpool_zero(void *aux UNUSED) {
+    enum intr_level old_level = intr_disable();
+    ptpool_queued = false;
+    intr_set_level(old_level);
+
+    for (;;) {
+        void *page;
+        bool room;
+
+        old_level = intr_disable();
+        page = pt_dirty_cnt > 0 ? pt_dirty[--pt_dirty_cnt] : NULL;
+        intr_set_level(old_level);
+        if (page == NULL)
+            break;
+
+        memset(page, 0, PGSIZE);
+
+        old_level = intr_disable();
+        room = pt_clean_cnt < PTPOOL_MAX;
+        if (room)
+            pt_clean[pt_clean_cnt++] = page;
+        intr_set_level(old_level);
+        if (!room)
+            palloc_free_page(page);
+    }
+
+    for (;;) {
+        void *page;
+        bool need;
+
+        old_level = intr_disable();
+        need = pt_clean_cnt < PTPOOL_LOWAT;
+        intr_set_level(old_level);
+        if (!need)
+            break;
+
+        page = palloc_get_page(PAL_ZERO);
+        if (page == NULL)
+            break;
+
+        old_level = intr_disable();
+        if (pt_clean_cnt < PTPOOL_MAX) {
+            pt_clean[pt_clean_cnt++] = page;
+            page = NULL;
+        }
+        intr_set_level(old_level);
+        if (page != NULL) {
+            palloc_free_page(page);
+            break;
+        }
+    }
+}
+
+/* Allocates a zeroed page-table page, preferring the pool and
+ * falling back to the kernel pool when it is empty. */
+static void *pt_alloc(void) {
+    void *page = NULL;
+    bool low;
+
+    enum intr_level old_level = intr_disable();
+    if (pt_clean_cnt > 0)
+        page = pt_clean[--pt_clean_cnt];
+    low = pt_clean_cnt < PTPOOL_LOWAT;
+    intr_set_level(old_level);
+
+    if (low)
+        ptpool_kick();
+    if (page == NULL)
+        page = palloc_get_page(PAL_ZERO);
+    return page;
+}
+
+/* Returns a page-table page to the pool for background zeroing,
+ * or to the kernel pool if the dirty list is full. */
+static void pt_free(void *page) {
+    enum intr_level old_level = intr_disable();
+    if (ptpool_ready && pt_dirty_cnt < PTPOOL_MAX) {
+        pt_dirty[pt_dirty_cnt++] = page;
+        page = NULL;
+    }
+    intr_set_level(old_level);
+
+    if (page != NULL)
+        palloc_free_page(page);
+    else
+        ptpool_kick();
+}
+
+/* Starts the page-table page pool.  Must run after
+ * workqueue_init(); before that the pool falls back to plain
+ * palloc calls. */
+void mmu_pool_init(void) {
+    workqueue_create(&ptpool_wq, "ptpool", 1);
+    ptpool_ready = true;
+    ptpool_kick();
+}
+
+/* Batched TLB invalidation.
+ *
+ * Tearing down a large mmap region clears one PTE per page, and each
+ * clear used to issue its own invlpg.  A caller about to unmap many
+ * pages opens a batch instead: pml4_clear_page() then only records
+ * the addresses, and pml4_flush_end() replays them as individual
+ * invlpgs while the region was small, or reloads CR3 once -- a full
+ * TLB flush at constant cost -- when it was not.  The batch belongs
+ * to the opening thread, so clears issued concurrently by eviction
+ * on behalf of another address space still flush immediately. */
+#define TLB_BATCH_MAX 32 /* Above this, one CR3 reload is cheaper. */
+
+static struct thread *tlb_batch_owner;
+static void *tlb_batch_page[TLB_BATCH_MAX];
+static size_t tlb_batch_cnt;
+static bool tlb_batch_full;
+
+/* Opens a TLB invalidation batch owned by the current thread.
+ * Batches do not nest. */
+void pml4_flush_begin(void) {
+    ASSERT(tlb_batch_owner == NULL);
+    tlb_batch_cnt = 0;
+    tlb_batch_full = false;
+    tlb_batch_owner = thread_current();
+}
+
+/* Closes the current thread's batch and performs the deferred
+ * invalidations against PML4: per-page invlpg below the threshold,
+ * one full CR3 reload above it.  A pml4 that is not active needs no
+ * flush at all; its stale entries die with the next activation. */
+void pml4_flush_end(uint64_t *pml4) {
+    ASSERT(tlb_batch_owner == thread_current());
+    tlb_batch_owner = NULL;
+
+    if (rcr3() != vtop(pml4))
+        return;
+    if (tlb_batch_full)
+        lcr3(rcr3());
+    else
+        for (size_t i = 0; i < tlb_batch_cnt; i++)
+            invlpg((uint64_t)tlb_batch_page[i]);
+}
 
 static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create) {
     int idx = PDX(va);
@@ -16,7 +198,7 @@ static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create) {
         uint64_t *pte = (uint64_t *)pdp[idx];
         if (!((uint64_t)pte & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc();
                 if (new_page)
                     pdp[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
                 else
@@ -37,7 +219,7 @@ static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create) {
         uint64_t *pde = (uint64_t *)pdpe[idx];
         if (!((uint64_t)pde & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc();
                 if (new_page) {
                     pdpe[idx] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
                     allocated = 1;
@@ -49,7 +231,7 @@ static uint64_t *pdpe_walk(uint64_t *pdpe, const uint64_t va, int create) {
         pte = pgdir_walk(ptov(PTE_ADDR(pdpe[idx])), va, create);
     }
     if (pte == NULL && allocated) {
-        palloc_free_page((void *)ptov(PTE_ADDR(pdpe[idx])));
+        pt_free((void *)ptov(PTE_ADDR(pdpe[idx])));
         pdpe[idx] = 0;
     }
     return pte;
@@ -69,7 +251,7 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create) {
         uint64_t *pdpe = (uint64_t *)pml4e[idx];
         if (!((uint64_t)pdpe & PTE_P)) {
             if (create) {
-                uint64_t *new_page = palloc_get_page(PAL_ZERO);
+                uint64_t *new_page = pt_alloc();
                 if (new_page) {
                     // 페이지 테이블 엔트리를 사용자 모드에서 접근 가능하도록 
                     // 페이지를 읽기/쓰기가 가능하도록
@@ -84,7 +266,7 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create) {
         pte = pdpe_walk(ptov(PTE_ADDR(pml4e[idx])), va, create);
     }
     if (pte == NULL && allocated) {
-        palloc_free_page((void *)ptov(PTE_ADDR(pml4e[idx])));
+        pt_free((void *)ptov(PTE_ADDR(pml4e[idx])));
         pml4e[idx] = 0;
     }
     return pte;
@@ -95,93 +277,120 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create) {
  * Returns the new page directory, or a null pointer if memory
  * allocation fails. */
 uint64_t *pml4_create(void) {
-    uint64_t *pml4 = palloc_get_page(0);
+    uint64_t *pml4 = pt_alloc();
     if (pml4)
         memcpy(pml4, base_pml4, PGSIZE);
     return pml4;
 }
 
-static bool pt_for_each(uint64_t *pt, pte_for_each_func *func, void *aux, unsigned pml4_index, unsigned pdp_index, unsigned pdx_index) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pte = &pt[i];
-        if (((uint64_t)*pte) & PTE_P) {
-            void *va = (void *)(((uint64_t)pml4_index << PML4SHIFT) | ((uint64_t)pdp_index << PDPESHIFT) | ((uint64_t)pdx_index << PDXSHIFT) | ((uint64_t)i << PTXSHIFT));
-            if (!func(pte, va, aux))
-                return false;
+/* Entries per paging structure. */
+#define PT_ENTRIES (PGSIZE / sizeof(uint64_t *))
+
+/* Applies FUNC to every maximal run of consecutive present entries
+ * in the page table PT, which maps addresses starting at VA_BASE.
+ * One linear 512-entry scan per PT page: no per-entry calls back up
+ * the levels, and the hardware prefetcher sees a sequential sweep. */
+static bool pt_scan(uint64_t *pt, uint64_t va_base, pte_run_for_each_func *func, void *aux) {
+    for (unsigned i = 0; i < PT_ENTRIES;) {
+        unsigned run;
+        if (!(pt[i] & PTE_P)) {
+            i++;
+            continue;
         }
+        run = i + 1;
+        while (run < PT_ENTRIES && (pt[run] & PTE_P))
+            run++;
+        if (!func(&pt[i], (void *)(va_base | ((uint64_t)i << PTXSHIFT)), run - i, aux))
+            return false;
+        i = run;
     }
     return true;
 }
 
-static bool pgdir_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, unsigned pml4_index, unsigned pdp_index) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pte = ptov((uint64_t *)pdp[i]);
-        if (((uint64_t)pte) & PTE_P)
-            if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index, pdp_index, i))
-                return false;
+/* Applies FUNC to each run of consecutive present ptes, including
+ * kernel ones.  The upper three levels are plain nested loops over
+ * cached node pointers -- nothing recursive, constant stack. */
+bool pml4_for_each_run(uint64_t *pml4, pte_run_for_each_func *func, void *aux) {
+    for (unsigned i0 = 0; i0 < PT_ENTRIES; i0++) {
+        uint64_t *pdp;
+        if (!(pml4[i0] & PTE_P))
+            continue;
+        pdp = ptov(PTE_ADDR(pml4[i0]));
+        for (unsigned i1 = 0; i1 < PT_ENTRIES; i1++) {
+            uint64_t *pgdir;
+            if (!(pdp[i1] & PTE_P))
+                continue;
+            pgdir = ptov(PTE_ADDR(pdp[i1]));
+            for (unsigned i2 = 0; i2 < PT_ENTRIES; i2++) {
+                uint64_t va_base;
+                if (!(pgdir[i2] & PTE_P))
+                    continue;
+                va_base = ((uint64_t)i0 << PML4SHIFT) | ((uint64_t)i1 << PDPESHIFT) | ((uint64_t)i2 << PDXSHIFT);
+                if (!pt_scan(ptov(PTE_ADDR(pgdir[i2])), va_base, func, aux))
+                    return false;
+            }
+        }
     }
     return true;
 }
 
-static bool pdp_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, unsigned pml4_index) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pde = ptov((uint64_t *)pdp[i]);
-        if (((uint64_t)pde) & PTE_P)
-            if (!pgdir_for_each((uint64_t *)PTE_ADDR(pde), func, aux, pml4_index, i))
-                return false;
-    }
+/* Adapter so the single-entry interface rides the run traversal. */
+struct pte_each_frame {
+    pte_for_each_func *func;
+    void *aux;
+};
+
+static bool pte_each_run(uint64_t *pte, void *va, size_t cnt, void *aux) {
+    struct pte_each_frame *f = aux;
+    for (size_t i = 0; i < cnt; i++)
+        if (!f->func(&pte[i], (uint8_t *)va + i * PGSIZE, f->aux))
+            return false;
     return true;
 }
 
 /* Apply FUNC to each available pte entries including kernel's. */
 bool pml4_for_each(uint64_t *pml4, pte_for_each_func *func, void *aux) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pdpe = ptov((uint64_t *)pml4[i]);
-        if (((uint64_t)pdpe) & PTE_P)
-            if (!pdp_for_each((uint64_t *)PTE_ADDR(pdpe), func, aux, i))
-                return false;
-    }
-    return true;
-}
-
-static void pt_destroy(uint64_t *pt) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pte = ptov((uint64_t *)pt[i]);
-        if (((uint64_t)pte) & PTE_P)
-            palloc_free_page((void *)PTE_ADDR(pte));
-    }
-    palloc_free_page((void *)pt);
-}
-
-static void pgdir_destroy(uint64_t *pdp) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pte = ptov((uint64_t *)pdp[i]);
-        if (((uint64_t)pte) & PTE_P)
-            pt_destroy(PTE_ADDR(pte));
-    }
-    palloc_free_page((void *)pdp);
-}
-
-static void pdpe_destroy(uint64_t *pdpe) {
-    for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
-        uint64_t *pde = ptov((uint64_t *)pdpe[i]);
-        if (((uint64_t)pde) & PTE_P)
-            pgdir_destroy((void *)PTE_ADDR(pde));
-    }
-    palloc_free_page((void *)pdpe);
+    struct pte_each_frame f = {func, aux};
+    return pml4_for_each_run(pml4, pte_each_run, &f);
 }
 
-/* Destroys pml4e, freeing all the pages it references. */
+/* Destroys pml4e, freeing all the pages it references.  Iterative
+ * for the same reason as pml4_for_each_run: each present structure
+ * page is freed after one linear scan of its entries. */
 void pml4_destroy(uint64_t *pml4) {
     if (pml4 == NULL)
         return;
     ASSERT(pml4 != base_pml4);
 
     /* if PML4 (vaddr) >= 1, it's kernel space by define. */
-    uint64_t *pdpe = ptov((uint64_t *)pml4[0]);
-    if (((uint64_t)pdpe) & PTE_P)
-        pdpe_destroy((void *)PTE_ADDR(pdpe));
-    palloc_free_page((void *)pml4);
+    if (pml4[0] & PTE_P) {
+        uint64_t *pdp = ptov(PTE_ADDR(pml4[0]));
+        for (unsigned i1 = 0; i1 < PT_ENTRIES; i1++) {
+            uint64_t *pgdir;
+            if (!(pdp[i1] & PTE_P))
+                continue;
+            pgdir = ptov(PTE_ADDR(pdp[i1]));
+            for (unsigned i2 = 0; i2 < PT_ENTRIES; i2++) {
+                uint64_t *pt;
+                if (!(pgdir[i2] & PTE_P))
+                    continue;
+                pt = ptov(PTE_ADDR(pgdir[i2]));
+#ifndef VM
+                /* With VM, data frames belong to the frame table and are
+                   released (possibly to a copy-on-write sharer) by
+                   supplemental_page_table_kill before we get here; only the
+                   paging structures themselves are ours to free. */
+                for (unsigned i3 = 0; i3 < PT_ENTRIES; i3++)
+                    if (pt[i3] & PTE_P)
+                        palloc_free_page(ptov(PTE_ADDR(pt[i3])));
+#endif
+                pt_free(pt);
+            }
+            pt_free(pgdir);
+        }
+        pt_free(pdp);
+    }
+    pt_free((void *)pml4);
 }
 
 /* Loads page directory PD into the CPU's page directory base
@@ -238,7 +447,12 @@ void pml4_clear_page(uint64_t *pml4, void *upage) {
 
     if (pte != NULL && (*pte & PTE_P) != 0) {
         *pte &= ~PTE_P;
-        if (rcr3() == vtop(pml4))
+        if (tlb_batch_owner == thread_current()) {
+            if (tlb_batch_cnt < TLB_BATCH_MAX)
+                tlb_batch_page[tlb_batch_cnt++] = upage;
+            else
+                tlb_batch_full = true;
+        } else if (rcr3() == vtop(pml4))
             invlpg((uint64_t)upage);
     }
 }
@@ -3,6 +3,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -10,8 +11,10 @@
 #include <string.h>
 
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -28,22 +31,174 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
+/* Allocation is a binary buddy system layered over each pool: free
+   blocks of 2^order pages sit on per-order free lists, so getting a
+   block is a pop (splitting a larger block at most BUDDY_MAX_ORDER
+   times) instead of a linear bitmap scan, and freeing merges a block
+   with its equally-sized "buddy" back up.  The bitmap remains the
+   source of truth for which pages are allocated (and still backs the
+   asserts and free-page counts); the free lists and the per-page
+   order map are an index over it.  Requests are rounded up to the
+   next power of two, so a 3-page request occupies a 4-page block --
+   the recorded order, not the caller's count, is what gets freed. */
+#define BUDDY_MAX_ORDER 10 /* Largest block: 2^10 pages = 4 MB. */
+#define BUDDY_ORDER_CNT (BUDDY_MAX_ORDER + 1)
+
+/* Single-page user-pool allocations — one per page fault once VM is
+   live — additionally go through a small per-thread "magazine" of
+   free pages (struct thread's page_mag).  The magazine is touched
+   only by its owning thread, so the common-case get/free is a plain
+   array pop/push with no pool lock; the pool lock is taken only to
+   refill or drain a batch at a time.  Pages sitting in a magazine
+   stay marked used in the bitmap.  Interrupt context bypasses the
+   magazines. */
+#define PAGE_MAG_SIZE 16 /* Must match page_mag[] in struct thread. */
+#define PAGE_MAG_BATCH 8 /* Pages moved per refill/drain. */
+
+/* A free block, overlaid on its own first page. */
+struct free_block {
+    struct list_elem elem; /* Free list element. */
+};
+
+/** #Project 3: Background Zeroing - PAL_ZERO의 4KB memset을 폴트 경로에서
+ *  떼어낸다. idle 우선순위의 zerod 스레드가 한가할 때 user pool의 빈
+ *  페이지를 미리 0으로 채워 두고, PAL_ZERO 단일 페이지 할당은 이 목록을
+ *  먼저 집는다. 목록이 비었을 때만 기존처럼 동기 memset으로 돌아간다.
+ *  목록 연결용 list_elem이 페이지 앞부분을 더럽히므로 꺼낼 때 그
+ *  16바이트만 다시 지운다. 목록의 페이지는 매거진처럼 비트맵에서 사용중
+ *  상태를 유지한다. */
+#define ZERO_TARGET 64 /* 미리 0으로 채워 둘 페이지 수 */
+
+static struct list zero_list;       /* 0으로 채워진 user pool 페이지 */
+static size_t zero_cnt;             /* zero_list 길이 (pool lock 보호) */
+static struct semaphore zerod_sema; /* free 경로가 zerod를 깨우는 신호 */
+static bool zerod_running;          /* zerod 스레드 생성 완료 여부 */
+
+static void zerod(void *aux);
+
+/** #Project 3: Memory Pressure - shrinker 레지스트리. 버퍼 캐시, dentry
+ *  캐시, 선제 0 페이지 목록처럼 물리 메모리를 쥐고 있는 캐시가 자신을
+ *  등록해 두면, 풀이 바닥났을 때 palloc이 각 캐시에 제 교체 순서대로
+ *  N 페이지 반납을 요청한 뒤 할당을 한 번 더 시도한다. 메모리가 먼저
+ *  잡은 쪽이 아니라 지금 필요한 쪽으로 흐르게 하는 장치다. */
+#define SHRINKER_MAX 4
+
+struct shrinker {
+    palloc_shrinker_func *func; /* 반납 요청 콜백 */
+    void *aux;                  /* 콜백 인자 */
+    const char *name;           /* 디버깅용 이름 */
+};
+
+static struct shrinker shrinkers[SHRINKER_MAX];
+static int shrinker_cnt;
+static bool shrinking; /* 재진입 방지 (shrinker가 할당에 실패하는 경우) */
+
+void palloc_register_shrinker(palloc_shrinker_func *func, void *aux, const char *name) {
+    ASSERT(shrinker_cnt < SHRINKER_MAX);
+    shrinkers[shrinker_cnt].func = func;
+    shrinkers[shrinker_cnt].aux = aux;
+    shrinkers[shrinker_cnt].name = name;
+    shrinker_cnt++;
+}
+
+/** 등록된 캐시들에 GOAL 페이지 반납을 요청한다. shrinker는 잠들 수
+ *  있으므로(디스크 쓰기 등) 인터럽트 문맥에서는 부르지 않는다. */
+static size_t palloc_shrink(size_t goal) {
+    size_t got = 0;
+
+    if (shrinking || intr_context())
+        return 0;
+
+    shrinking = true;
+    for (int i = 0; i < shrinker_cnt; i++)
+        got += shrinkers[i].func(goal, shrinkers[i].aux);
+    shrinking = false;
+    return got;
+}
+
+/** #Project 3: DMA Zone - 버스마스터 DMA용 물리 연속 버퍼 구역.
+ *  palloc_get_multiple()은 연속성은 주지만 정렬/경계는 보장하지 않아,
+ *  예컨대 16페이지 bounce 버퍼가 PRD가 금지하는 64KB 물리 경계를 걸칠
+ *  수 있다. 부팅 때 kernel pool에서 64KB 정렬된 구간을 잘라내 경계
+ *  제약을 아는 first-fit으로 따로 관리한다. 구역이 작고(64페이지) 할당
+ *  패턴이 단순해(장치 초기화 때 몇 번) 비트맵 scan으로는 표현할 수 없는
+ *  경계 검사를 바이트 맵 위에서 직접 한다. */
+#define DMA_ZONE_PAGES 64 /* 256KB: 채널 두 개의 bounce 버퍼 + 여유 */
+
+static uint8_t *dma_base;                /* 구역 시작(64KB 정렬), 못 잘랐으면 NULL */
+static uint8_t dma_used[DMA_ZONE_PAGES]; /* 페이지별 사용 여부 */
+static struct lock dma_lock;
+
 /* A memory pool. */
 struct pool {
-    struct lock lock;        /* Mutual exclusion. */
-    struct bitmap *used_map; /* Bitmap of free pages. */
-    uint8_t *base;           /* Base of pool. */
+    struct lock lock;                         /* Mutual exclusion. */
+    struct bitmap *used_map;                  /* Bitmap of free pages. */
+    uint8_t *base;                            /* Base of pool. */
+    struct list free_lists[BUDDY_ORDER_CNT];  /* Free blocks per order. */
+    uint8_t *block_order;                     /* Per-page order of the block starting there. */
 };
 
-/* Two pools: one for kernel data, one for user pages. */
-static struct pool kernel_pool, user_pool;
+/* One pool for kernel data; the user memory is split below. */
+static struct pool kernel_pool;
+
+/** #Project 3: User Pool 분할 - user pool 하나의 lock을 모든 폴트 경로가
+ *  나눠 쓰면 멀티 프로세스 실행이 그 lock 하나에 직렬화된다. user 영역을
+ *  연속한 K개의 sub-pool로 잘라 각자 lock/bitmap/free list를 갖게 하고,
+ *  프로세스는 tid 해시로 home sub-pool에 배정한다. home이 바닥나면 다른
+ *  sub-pool로 넘어가므로 가용 메모리는 그대로다. 주소 공간은 전체가
+ *  연속이라 frame table 인덱싱은 변하지 않는다. SMP가 오면 해시 대신
+ *  CPU 번호를 쓰는 per-CPU pool의 디딤돌이다. */
+#define USER_SUBPOOL_CNT 4
+
+static struct pool user_pools[USER_SUBPOOL_CNT];
+static size_t user_subpool_cnt;            /* 실제 sub-pool 수 */
+static struct lock zero_lock;              /* zero_list/zero_cnt 보호 (sub-pool 공용) */
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
-static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
+static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end,
+                      const char *name);
 
 static bool page_from_pool(const struct pool *, void *page);
 
+/** #Project 3: User Pool 분할 - PAGE가 속한 sub-pool, 없으면 NULL. */
+static struct pool *user_pool_of(void *page) {
+    for (size_t i = 0; i < user_subpool_cnt; i++)
+        if (page_from_pool(&user_pools[i], page))
+            return &user_pools[i];
+    return NULL;
+}
+
+/** #Project 3: Buddy Allocator 보조 함수 */
+static void buddy_push(struct pool *p, size_t idx, size_t order);
+static size_t buddy_alloc(struct pool *p, size_t order);
+static void buddy_free(struct pool *p, size_t idx);
+static void buddy_seed(struct pool *p);
+static size_t user_buddy_alloc(size_t order, struct pool **pool_out);
+
+/** zero_list shrinker - 선제 0 페이지는 순수한 여유 재고이므로 제일
+ *  먼저 버디로 돌아간다. */
+static size_t zero_shrink(size_t goal, void *aux UNUSED) {
+    size_t freed = 0;
+
+    while (freed < goal) {
+        void *page = NULL;
+
+        lock_acquire(&zero_lock);
+        if (zero_cnt > 0) {
+            page = list_entry(list_pop_front(&zero_list), struct free_block, elem);
+            zero_cnt--;
+        }
+        lock_release(&zero_lock);
+
+        if (page == NULL)
+            break;
+        palloc_free_page(page);
+        freed++;
+    }
+    return freed;
+}
+
 /* multiboot info */
 struct multiboot_info {
     uint32_t flags;
@@ -156,7 +311,8 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
                         break;
                     }
                     // generate kernel pool
-                    init_pool(&kernel_pool, &free_start, region_start, start + rem * PGSIZE);
+                    init_pool(&kernel_pool, &free_start, region_start, start + rem * PGSIZE,
+                              "kernel-pool");
                     // Transition to the next state
                     if (rem == size_in_pg) {
                         rem = user_pages;
@@ -184,8 +340,26 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
         }
     }
 
-    // generate the user pool
-    init_pool(&user_pool, &free_start, region_start, end);
+    /** #Project 3: User Pool 분할 - user 영역을 연속한 sub-pool로 자른다.
+     *  sub-pool마다 자체 bitmap을 가지므로 buddy 인덱스는 각자의 base
+     *  기준이고, 경계 정렬 조건은 페이지 정렬뿐이다. */
+    static const char *subpool_names[USER_SUBPOOL_CNT] = {
+        "user-pool-0", "user-pool-1", "user-pool-2", "user-pool-3",
+    };
+    uint64_t user_region_pages = (end - region_start) / PGSIZE;
+    uint64_t sub_start = region_start;
+
+    user_subpool_cnt = USER_SUBPOOL_CNT;
+    while (user_subpool_cnt > 1 && user_region_pages / user_subpool_cnt == 0)
+        user_subpool_cnt--;
+
+    for (size_t i = 0; i < user_subpool_cnt; i++) {
+        uint64_t sub_end = i == user_subpool_cnt - 1
+                               ? end
+                               : sub_start + (user_region_pages / user_subpool_cnt) * PGSIZE;
+        init_pool(&user_pools[i], &free_start, sub_start, sub_end, subpool_names[i]);
+        sub_start = sub_end;
+    }
 
     // Iterate over the e820_entry. Setup the usable.
     uint64_t usable_bound = (uint64_t)free_start;
@@ -209,8 +383,8 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
         split:
             if (page_from_pool(&kernel_pool, (void *)start))
                 pool = &kernel_pool;
-            else if (page_from_pool(&user_pool, (void *)start))
-                pool = &user_pool;
+            else if ((pool = user_pool_of((void *)start)) != NULL)
+                ;
             else
                 NOT_REACHED();
 
@@ -229,6 +403,82 @@ static void populate_pools(struct area *base_mem, struct area *ext_mem) {
     }
 }
 
+/** #Project 3: DMA Zone - kernel pool에서 64KB 정렬된 DMA_ZONE_PAGES
+ *  연속 구간을 찾아 예약한다. kernel pool은 물리 메모리에 선형으로
+ *  매핑되어 있고 KERN_BASE가 64KB의 배수이므로 가상 주소 정렬이 곧
+ *  물리 주소 정렬이다. buddy_seed() 전에 불러야 구역이 free list에
+ *  실리지 않는다. */
+static void dma_zone_carve(void) {
+    struct pool *p = &kernel_pool;
+    size_t n = bitmap_size(p->used_map);
+    size_t align = 0x10000 / PGSIZE; /* 64KB, 페이지 단위 */
+    size_t base_pg = (uintptr_t)p->base / PGSIZE;
+    size_t first = (align - base_pg % align) % align;
+
+    for (size_t idx = first; idx + DMA_ZONE_PAGES <= n; idx += align) {
+        if (!bitmap_none(p->used_map, idx, DMA_ZONE_PAGES))
+            continue;
+
+        bitmap_set_multiple(p->used_map, idx, DMA_ZONE_PAGES, true);
+        dma_base = p->base + idx * PGSIZE;
+        return;
+    }
+}
+
+/** #Project 3: DMA Zone - 물리 연속 PAGE_CNT 페이지를 할당한다.
+ *  BOUNDARY가 0이 아니면(2의 거듭제곱 바이트) 구간이 그 물리 경계를
+ *  걸치지 않음을 보장한다. 내용은 0으로 채워 돌려주고, 맞는 자리가
+ *  없거나 구역 자체가 없으면 NULL을 돌려준다. */
+void *palloc_get_dma(size_t page_cnt, size_t boundary) {
+    ASSERT(page_cnt > 0 && page_cnt <= DMA_ZONE_PAGES);
+    ASSERT(boundary == 0 || (boundary & (boundary - 1)) == 0);
+
+    if (dma_base == NULL)
+        return NULL;
+
+    lock_acquire(&dma_lock);
+    for (size_t start = 0; start + page_cnt <= DMA_ZONE_PAGES; start++) {
+        uintptr_t pa = vtop(dma_base + start * PGSIZE);
+
+        /* 경계 검사: 첫 바이트와 끝 바이트가 같은 BOUNDARY 칸에 있어야 한다. */
+        if (boundary != 0 && pa / boundary != (pa + page_cnt * PGSIZE - 1) / boundary)
+            continue;
+
+        size_t i;
+        for (i = 0; i < page_cnt; i++)
+            if (dma_used[start + i])
+                break;
+        if (i < page_cnt) {
+            start += i; /* 사용 중인 페이지 뒤에서부터 다시 본다. */
+            continue;
+        }
+
+        memset(&dma_used[start], 1, page_cnt);
+        lock_release(&dma_lock);
+
+        void *pages = dma_base + start * PGSIZE;
+        memset(pages, 0, page_cnt * PGSIZE);
+        return pages;
+    }
+    lock_release(&dma_lock);
+    return NULL;
+}
+
+/** #Project 3: DMA Zone - palloc_get_dma()로 받은 구간을 반납한다. */
+void palloc_free_dma(void *pages, size_t page_cnt) {
+    size_t start = ((uint8_t *)pages - dma_base) / PGSIZE;
+
+    ASSERT(dma_base != NULL && pg_ofs(pages) == 0);
+    ASSERT(start + page_cnt <= DMA_ZONE_PAGES);
+
+    lock_acquire(&dma_lock);
+    for (size_t i = 0; i < page_cnt; i++) {
+        ASSERT(dma_used[start + i]);
+        dma_used[start + i] = 0;
+    }
+    lock_release(&dma_lock);
+}
+
 /* Initializes the page allocator and get the memory size */
 uint64_t palloc_init(void) {
     /* End of the kernel as recorded by the linker.
@@ -242,27 +492,245 @@ uint64_t palloc_init(void) {
     printf("\tbase_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n", base_mem.start, base_mem.end, base_mem.size / 1024);
     printf("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n", ext_mem.start, ext_mem.end, ext_mem.size / 1024);
     populate_pools(&base_mem, &ext_mem);
+
+    /** #Project 3: DMA Zone - buddy free list를 만들기 전에 잘라낸다. */
+    lock_init(&dma_lock);
+    dma_zone_carve();
+
+    /* Build the buddy free lists from the final bitmap state. */
+    buddy_seed(&kernel_pool);
+    for (size_t i = 0; i < user_subpool_cnt; i++)
+        buddy_seed(&user_pools[i]);
+
+    lock_init(&zero_lock);
+    list_init(&zero_list);
+    palloc_register_shrinker(zero_shrink, NULL, "zero");
     return ext_mem.end;
 }
 
+/* Records a free block of 2^ORDER pages starting at page IDX of P
+   and puts it on the matching free list. */
+static void buddy_push(struct pool *p, size_t idx, size_t order) {
+    struct free_block *b = (struct free_block *)(p->base + idx * PGSIZE);
+
+    p->block_order[idx] = order;
+    list_push_front(&p->free_lists[order], &b->elem);
+}
+
+/* Allocates a block of 2^ORDER pages from P, splitting a larger
+   block if necessary.  Returns the block's first page index, or
+   SIZE_MAX if nothing large enough is free.  P's lock must be
+   held. */
+static size_t buddy_alloc(struct pool *p, size_t order) {
+    for (size_t o = order; o < BUDDY_ORDER_CNT; o++) {
+        if (list_empty(&p->free_lists[o]))
+            continue;
+
+        struct free_block *b = list_entry(list_pop_front(&p->free_lists[o]), struct free_block, elem);
+        size_t idx = ((uint8_t *)b - p->base) / PGSIZE;
+
+        /* Split off and give back the upper halves until the block
+           is the requested size. */
+        while (o > order) {
+            o--;
+            buddy_push(p, idx + ((size_t)1 << o), o);
+        }
+
+        p->block_order[idx] = order;
+        bitmap_set_multiple(p->used_map, idx, (size_t)1 << order, true);
+        return idx;
+    }
+
+    return SIZE_MAX;
+}
+
+/* Frees the block starting at page IDX of P, merging it with its
+   buddy as long as the buddy is a free block of the same order.
+   P's lock must be held. */
+static void buddy_free(struct pool *p, size_t idx) {
+    size_t order = p->block_order[idx];
+    size_t pool_pages = bitmap_size(p->used_map);
+
+    bitmap_set_multiple(p->used_map, idx, (size_t)1 << order, false);
+
+    while (order < BUDDY_MAX_ORDER) {
+        size_t buddy = idx ^ ((size_t)1 << order);
+
+        if (buddy + ((size_t)1 << order) > pool_pages)
+            break;
+        if (bitmap_test(p->used_map, buddy))
+            break; /* Buddy (or its first page) is allocated. */
+        if (p->block_order[buddy] != order)
+            break; /* Buddy is split into smaller free blocks. */
+
+        struct free_block *b = (struct free_block *)(p->base + buddy * PGSIZE);
+        list_remove(&b->elem);
+
+        idx = idx < buddy ? idx : buddy;
+        order++;
+    }
+
+    buddy_push(p, idx, order);
+}
+
+/* Carves the free runs recorded in P's bitmap into aligned
+   power-of-two blocks and populates the free lists.  Called once
+   at boot, after populate_pools() has marked the usable pages. */
+static void buddy_seed(struct pool *p) {
+    size_t n = bitmap_size(p->used_map);
+
+    for (int o = 0; o < BUDDY_ORDER_CNT; o++)
+        list_init(&p->free_lists[o]);
+
+    size_t idx = 0;
+    while (idx < n) {
+        if (bitmap_test(p->used_map, idx)) {
+            idx++;
+            continue;
+        }
+
+        /* Find the end of this free run. */
+        size_t run_end = idx;
+        while (run_end < n && !bitmap_test(p->used_map, run_end))
+            run_end++;
+
+        /* Greedily carve it into the largest aligned blocks. */
+        size_t cur = idx;
+        while (cur < run_end) {
+            size_t o = cur == 0 ? BUDDY_MAX_ORDER : (size_t)__builtin_ctzll(cur);
+            if (o > BUDDY_MAX_ORDER)
+                o = BUDDY_MAX_ORDER;
+            while (cur + ((size_t)1 << o) > run_end)
+                o--;
+            buddy_push(p, cur, o);
+            cur += (size_t)1 << o;
+        }
+
+        idx = run_end;
+    }
+}
+
+/** #Project 3: User Pool 분할 - home sub-pool부터 시작해 전부를 돌며
+ *  2^ORDER 블록을 할당한다. 성공하면 블록의 페이지 인덱스를 돌려주고
+ *  *POOL_OUT에 해당 sub-pool을 적는다. 전부 바닥이면 SIZE_MAX. */
+static size_t user_buddy_alloc(size_t order, struct pool **pool_out) {
+    size_t home = (size_t)thread_current()->tid % user_subpool_cnt;
+
+    for (size_t i = 0; i < user_subpool_cnt; i++) {
+        struct pool *p = &user_pools[(home + i) % user_subpool_cnt];
+
+        lock_acquire(&p->lock);
+        size_t idx = buddy_alloc(p, order);
+        lock_release(&p->lock);
+
+        if (idx != SIZE_MAX) {
+            *pool_out = p;
+            return idx;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
    If PAL_USER is set, the pages are obtained from the user pool,
    otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
    then the pages are filled with zeros.  If too few pages are
    available, returns a null pointer, unless PAL_ASSERT is set in
    FLAGS, in which case the kernel panics. */
+/** #Project 3: Memory Pressure - 버디 할당 시도를 한 군데로 모은다.
+ *  실패-축소-재시도 경로가 같은 코드를 쓴다. */
+static void *buddy_try_alloc(bool user, size_t order) {
+    if (user) {
+        struct pool *src;
+        size_t page_idx = user_buddy_alloc(order, &src);
+
+        if (page_idx != SIZE_MAX)
+            return src->base + PGSIZE * page_idx;
+    } else {
+        lock_acquire(&kernel_pool.lock);
+        size_t page_idx = buddy_alloc(&kernel_pool, order);
+        lock_release(&kernel_pool.lock);
+
+        if (page_idx != SIZE_MAX)
+            return kernel_pool.base + PGSIZE * page_idx;
+    }
+    return NULL;
+}
+
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt) {
-    struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+    bool user = flags & PAL_USER;
+    void *pages = NULL;
+
+    /** #Project 3: Background Zeroing - 미리 0으로 채워진 페이지가 있으면
+     *  memset 없이 바로 내준다. */
+    if (page_cnt == 1 && (flags & (PAL_USER | PAL_ZERO)) == (PAL_USER | PAL_ZERO) && zero_cnt > 0) {
+        lock_acquire(&zero_lock);
+        if (zero_cnt > 0) {
+            pages = list_entry(list_pop_front(&zero_list), struct free_block, elem);
+            zero_cnt--;
+        }
+        lock_release(&zero_lock);
 
-    lock_acquire(&pool->lock);
-    size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
-    lock_release(&pool->lock);
-    void *pages;
+        if (pages != NULL) {
+            /* list_elem이 차지했던 앞 16바이트만 다시 지운다. */
+            memset(pages, 0, sizeof(struct free_block));
+            return pages;
+        }
+    }
 
-    if (page_idx != BITMAP_ERROR)
-        pages = pool->base + PGSIZE * page_idx;
-    else
-        pages = NULL;
+    /* Fast path: single user page from the current thread's magazine. */
+    if (page_cnt == 1 && user && !intr_context()) {
+        struct thread *t = thread_current();
+
+        if (t->page_mag_cnt == 0) {
+            /** #Project 3: User Pool 분할 - 배치 리필은 home sub-pool의
+             *  lock 한 번으로 끝낸다. home이 비어 있으면 아래의 일반
+             *  경로가 다른 sub-pool로 넘어간다. */
+            struct pool *home = &user_pools[(size_t)t->tid % user_subpool_cnt];
+
+            lock_acquire(&home->lock);
+            while (t->page_mag_cnt < PAGE_MAG_BATCH) {
+                size_t idx = buddy_alloc(home, 0);
+                if (idx == SIZE_MAX)
+                    break;
+                t->page_mag[t->page_mag_cnt++] = home->base + PGSIZE * idx;
+            }
+            lock_release(&home->lock);
+        }
+
+        if (t->page_mag_cnt > 0)
+            pages = t->page_mag[--t->page_mag_cnt];
+    }
+
+    /* Round the request up to the next power of two. */
+    size_t order = 0;
+    while (((size_t)1 << order) < page_cnt)
+        order++;
+
+    if (pages == NULL && page_cnt > 0 && order <= BUDDY_MAX_ORDER)
+        pages = buddy_try_alloc(user, order);
+
+    /** #Project 3: Background Zeroing - buddy가 바닥났으면 0 페이지 재고를
+     *  털어서라도 내준다. zerod가 쥔 페이지 때문에 할당이 실패하면 안 된다. */
+    if (pages == NULL && page_cnt == 1 && user) {
+        lock_acquire(&zero_lock);
+        if (zero_cnt > 0) {
+            pages = list_entry(list_pop_front(&zero_list), struct free_block, elem);
+            zero_cnt--;
+        }
+        lock_release(&zero_lock);
+
+        if (pages != NULL) {
+            memset(pages, 0, sizeof(struct free_block));
+            return pages; /* PAL_ZERO 여부와 무관하게 이미 0이다. */
+        }
+    }
+
+    /** #Project 3: Memory Pressure - 모든 풀이 바닥났다: 등록된 캐시를
+     *  줄여 보고, 뭐라도 돌아왔으면 한 번 더 시도한다. */
+    if (pages == NULL && page_cnt > 0 && order <= BUDDY_MAX_ORDER && palloc_shrink(page_cnt) > 0)
+        pages = buddy_try_alloc(user, order);
 
     if (pages) {
         if (flags & PAL_ZERO)
@@ -297,8 +765,8 @@ void palloc_free_multiple(void *pages, size_t page_cnt) {
 
     if (page_from_pool(&kernel_pool, pages))
         pool = &kernel_pool;
-    else if (page_from_pool(&user_pool, pages))
-        pool = &user_pool;
+    else if ((pool = user_pool_of(pages)) != NULL)
+        ;
     else
         NOT_REACHED();
 
@@ -308,7 +776,39 @@ void palloc_free_multiple(void *pages, size_t page_cnt) {
     memset(pages, 0xcc, PGSIZE * page_cnt);
 #endif
     ASSERT(bitmap_all(pool->used_map, page_idx, page_cnt));
-    bitmap_set_multiple(pool->used_map, page_idx, page_cnt, false);
+    ASSERT(((size_t)1 << pool->block_order[page_idx]) >= page_cnt);
+
+    /* Fast path: stash a single user page in the thread's magazine,
+       draining a batch back to the pool when it is full. */
+    if (page_cnt == 1 && pool != &kernel_pool && !intr_context()) {
+        struct thread *t = thread_current();
+
+        if (t->page_mag_cnt == PAGE_MAG_SIZE) {
+            /** #Project 3: User Pool 분할 - 매거진의 페이지는 여러
+             *  sub-pool에서 왔을 수 있어 페이지마다 제 sub-pool을 찾아
+             *  돌려준다. 드레인은 PAGE_MAG_BATCH번의 free마다 한 번이라
+             *  lock 횟수 증가는 미미하다. */
+            for (int i = 0; i < PAGE_MAG_BATCH; i++) {
+                void *page = t->page_mag[--t->page_mag_cnt];
+                struct pool *src = user_pool_of(page);
+
+                lock_acquire(&src->lock);
+                buddy_free(src, pg_no(page) - pg_no(src->base));
+                lock_release(&src->lock);
+            }
+        }
+
+        t->page_mag[t->page_mag_cnt++] = pages;
+        return;
+    }
+
+    lock_acquire(&pool->lock);
+    buddy_free(pool, page_idx);
+    lock_release(&pool->lock);
+
+    /** #Project 3: Background Zeroing - 재고가 얕으면 zerod를 깨운다. */
+    if (pool != &kernel_pool && zerod_running && zero_cnt < ZERO_TARGET)
+        sema_up(&zerod_sema);
 }
 
 /* Frees the page at PAGE. */
@@ -316,15 +816,126 @@ void palloc_free_page(void *page) {
     palloc_free_multiple(page, 1);
 }
 
+/* Reports the bounds of the user pool: *BASE receives the kernel
+   virtual address of its first page and *PAGE_CNT the number of
+   pages it contains.  The VM subsystem sizes its frame table from
+   this, so a user-pool kva maps to a frame table index with a
+   single subtract-and-shift. */
+void palloc_user_pool_bounds(void **base, size_t *page_cnt) {
+    size_t cnt = 0;
+
+    /* The sub-pools are contiguous slices of one region, so the user
+       memory is still a single kva range. */
+    for (size_t i = 0; i < user_subpool_cnt; i++)
+        cnt += bitmap_size(user_pools[i].used_map);
+
+    *base = user_pools[0].base;
+    *page_cnt = cnt;
+}
+
+/* Returns the current thread's magazine pages to the user pool.
+   Called on thread exit so cached pages do not die with the
+   thread. */
+void palloc_drain_magazine(void) {
+    struct thread *t = thread_current();
+
+    if (t->page_mag_cnt == 0)
+        return;
+
+    while (t->page_mag_cnt > 0) {
+        void *page = t->page_mag[--t->page_mag_cnt];
+        struct pool *src = user_pool_of(page);
+
+        lock_acquire(&src->lock);
+        buddy_free(src, pg_no(page) - pg_no(src->base));
+        lock_release(&src->lock);
+    }
+}
+
+/* Returns the number of currently free pages in the user pool. */
+size_t palloc_user_pool_free_cnt(void) {
+    size_t cnt = 0;
+
+    for (size_t i = 0; i < user_subpool_cnt; i++) {
+        struct pool *p = &user_pools[i];
+
+        lock_acquire(&p->lock);
+        cnt += bitmap_count(p->used_map, 0, bitmap_size(p->used_map), false);
+        lock_release(&p->lock);
+    }
+    return cnt;
+}
+
+/** #Project 3: Background Zeroing - zerod 본체. PRI_MIN이라 실행 큐가 빌
+ *  때만 돌며, 사실상 idle이 hlt할 사이클로 페이지를 지운다. buddy에서
+ *  페이지를 꺼내 0으로 채운 뒤 zero_list에 쌓는다. 여유 페이지가 재고
+ *  목표 이하로 내려가면 손을 떼서 할당과 재고 쌓기가 경합하지 않게 한다. */
+static void zerod(void *aux UNUSED) {
+    for (;;) {
+        sema_down(&zerod_sema);
+
+        while (zero_cnt < ZERO_TARGET && palloc_user_pool_free_cnt() > ZERO_TARGET) {
+            struct pool *src;
+            size_t idx = user_buddy_alloc(0, &src);
+            if (idx == SIZE_MAX)
+                break;
+
+            void *page = src->base + PGSIZE * idx;
+            memset(page, 0, PGSIZE);
+
+            lock_acquire(&zero_lock);
+            list_push_front(&zero_list, &((struct free_block *)page)->elem);
+            zero_cnt++;
+            lock_release(&zero_lock);
+        }
+
+        /* 일하는 동안 쌓인 신호는 한 번으로 합친다. */
+        while (sema_try_down(&zerod_sema))
+            continue;
+    }
+}
+
+/** #Project 3: Background Zeroing - zerod 스레드 시작. 스케줄러가 돌기
+ *  시작한 뒤 main에서 한 번 호출된다. */
+void palloc_start_zerod(void) {
+    sema_init(&zerod_sema, 0);
+
+    if (thread_create("zerod", PRI_MIN, zerod, NULL) == TID_ERROR)
+        return;
+
+    zerod_running = true;
+    sema_up(&zerod_sema); /* 첫 재고를 채운다. */
+}
+
+/* Returns the number of currently free pages in the kernel pool. */
+size_t palloc_kernel_pool_free_cnt(void) {
+    size_t cnt;
+
+    lock_acquire(&kernel_pool.lock);
+    cnt = bitmap_count(kernel_pool.used_map, 0,
+                       bitmap_size(kernel_pool.used_map), false);
+    lock_release(&kernel_pool.lock);
+    return cnt;
+}
+
 /* Initializes pool P as starting at START and ending at END */
-static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
+static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end,
+                      const char *name) {
     /* We'll put the pool's used_map at its base.
        Calculate the space needed for the bitmap
        and subtract it from the pool's size. */
     uint64_t pgcnt = (end - start) / PGSIZE;
     size_t bm_pages = DIV_ROUND_UP(bitmap_buf_size(pgcnt), PGSIZE) * PGSIZE;
+    size_t order_pages = ROUND_UP(pgcnt, PGSIZE);
 
     lock_init(&p->lock);
+
+    /** #Project 3: Lock 통계 - pool lock 경합 집계 */
+    static struct lock_stat pool_lock_stats[USER_SUBPOOL_CNT + 1];
+    static size_t pool_stat_cnt;
+    ASSERT(pool_stat_cnt < USER_SUBPOOL_CNT + 1);
+    lock_register_stat(&p->lock, &pool_lock_stats[pool_stat_cnt++], name);
+
     p->used_map = bitmap_create_in_buf(pgcnt, *bm_base, bm_pages);
     p->base = (void *)start;
 
@@ -332,6 +943,12 @@ static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t e
     bitmap_set_all(p->used_map, true);
 
     *bm_base += bm_pages;
+
+    /* Per-page block-order map for the buddy allocator, one byte per
+       page, carved from the same boot-time region as the bitmap. */
+    p->block_order = *bm_base;
+    memset(p->block_order, 0, order_pages);
+    *bm_base += order_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
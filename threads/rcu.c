@@ -0,0 +1,128 @@
+#include "threads/rcu.h"
+
+#include <debug.h>
+
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* One-CPU RCU.  The grace-period rule degenerates nicely on a
+   uniprocessor: a deferred free may run as soon as no thread is
+   inside a read section, because a reader that starts after the
+   writer unlinked the object can no longer reach it.  We track that
+   with a single reader count -- each thread contributes one while its
+   outermost read section is open -- and drain the pending-callback
+   list whenever the count returns to zero.  Waiting for the count
+   rather than for a per-reader generation over-waits when read
+   sections overlap continuously, but none of our read sections block,
+   so in practice the count touches zero constantly.
+
+   The counters are plain ints in the spirit of the per-CPU counters:
+   they are only ever touched from thread context, and an interrupt
+   handler never enters a read section, so no atomics are needed.  An
+   SMP port would make the reader count per-CPU and turn the
+   quiescent test into a scheduler-pass handshake. */
+
+static int rcu_readers;         /* Threads in an outermost read section. */
+static struct list rcu_pending; /* rcu_heads awaiting quiescence. */
+static struct list rcu_waiters; /* synchronize_rcu() sleepers. */
+
+/* A synchronize_rcu() caller parked until the next quiescent point.
+   Lives on the caller's stack. */
+struct rcu_waiter {
+    struct semaphore sema; /* Up'd at quiescence. */
+    struct list_elem elem; /* Element in rcu_waiters. */
+};
+
+void rcu_init(void) {
+    list_init(&rcu_pending);
+    list_init(&rcu_waiters);
+}
+
+/* Opens a read section.  Nestable; costs two increments. */
+void rcu_read_lock(void) {
+    if (thread_current()->rcu_nesting++ == 0)
+        rcu_readers++;
+}
+
+/* Runs every deferred callback and wakes every waiter.  Called when
+   the reader count reaches zero; the callbacks run in the calling
+   thread's context and may block. */
+static void rcu_quiescent(void) {
+    struct list cbs;
+    enum intr_level old_level;
+
+    list_init(&cbs);
+
+    old_level = intr_disable();
+    while (!list_empty(&rcu_pending))
+        list_push_back(&cbs, list_pop_front(&rcu_pending));
+    while (!list_empty(&rcu_waiters)) {
+        struct rcu_waiter *w = list_entry(list_pop_front(&rcu_waiters), struct rcu_waiter, elem);
+
+        sema_up(&w->sema);
+    }
+    intr_set_level(old_level);
+
+    while (!list_empty(&cbs)) {
+        struct rcu_head *head = list_entry(list_pop_front(&cbs), struct rcu_head, elem);
+
+        head->func(head->aux);
+    }
+}
+
+/* Closes a read section; the outermost close of the last reader
+   reclaims everything deferred in the meantime. */
+void rcu_read_unlock(void) {
+    struct thread *curr = thread_current();
+
+    ASSERT(curr->rcu_nesting > 0);
+
+    if (--curr->rcu_nesting == 0 && --rcu_readers == 0)
+        rcu_quiescent();
+}
+
+/* True while any thread holds a read section open. */
+bool rcu_readers_active(void) {
+    return rcu_readers > 0;
+}
+
+/* Schedules FUNC(AUX) to run once every read section open right now
+   has ended.  HEAD is storage inside the object being reclaimed.
+   With no readers the callback runs immediately, so the common
+   uncontended case costs what a direct free would. */
+void rcu_defer(struct rcu_head *head, rcu_callback_func *func, void *aux) {
+    enum intr_level old_level;
+
+    if (rcu_readers == 0) {
+        func(aux);
+        return;
+    }
+
+    head->func = func;
+    head->aux = aux;
+    old_level = intr_disable();
+    list_push_back(&rcu_pending, &head->elem);
+    intr_set_level(old_level);
+}
+
+/* Blocks until every read section open at the time of the call has
+   ended.  Must not be called from inside a read section. */
+void synchronize_rcu(void) {
+    struct rcu_waiter w;
+    enum intr_level old_level;
+
+    ASSERT(!intr_context());
+    ASSERT(thread_current()->rcu_nesting == 0);
+
+    old_level = intr_disable();
+    if (rcu_readers == 0) {
+        intr_set_level(old_level);
+        return;
+    }
+    sema_init(&w.sema, 0);
+    list_push_back(&rcu_waiters, &w.elem);
+    intr_set_level(old_level);
+
+    sema_down(&w.sema);
+}
@@ -0,0 +1,100 @@
+#include "threads/slab.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab is a page from the page allocator carved into equal-size
+   objects, offset from the page start by the slab's "color" (a
+   multiple of a cache line, cycling through the slack the objects
+   leave at the end of the page).  All free objects of a cache sit
+   on one LIFO free list, threaded through the objects themselves.
+
+   Slab pages are not returned to the page allocator: the objects
+   cached here (struct page and friends) track the population of
+   live processes, so a cache's high-water mark is quickly reached
+   and reclaiming pages would only churn.  This mirrors the free
+   list that malloc()'s descriptors keep, minus the per-arena
+   accounting needed to give pages back. */
+
+/* One cache line per color step. */
+#define SLAB_COLOR_STRIDE 64
+
+/* A free object, overlaid on the object's own storage. */
+struct free_obj {
+    struct list_elem elem; /* Free list element. */
+};
+
+/* Initializes CACHE to hand out objects of OBJ_SIZE bytes.  NAME
+   is for debugging only. */
+void slab_cache_init(struct slab_cache *cache, const char *name, size_t obj_size) {
+    ASSERT(cache != NULL);
+    ASSERT(obj_size >= sizeof(struct free_obj));
+    ASSERT(obj_size <= PGSIZE / 4);
+
+    cache->name = name;
+    cache->obj_size = ROUND_UP(obj_size, sizeof(void *));
+    cache->objs_per_slab = PGSIZE / cache->obj_size;
+    cache->color_max = PGSIZE - cache->objs_per_slab * cache->obj_size;
+    cache->color_next = 0;
+    list_init(&cache->free_list);
+    lock_init(&cache->lock);
+}
+
+/* Carves a fresh page into objects for CACHE, pushing them all
+   onto the free list.  Called with the cache lock held.  Returns
+   false if no page was available. */
+static bool slab_grow(struct slab_cache *cache) {
+    uint8_t *page = palloc_get_page(0);
+    if (page == NULL)
+        return false;
+
+    /* Rotate this slab's starting offset through the page slack. */
+    size_t color = cache->color_next;
+    cache->color_next += SLAB_COLOR_STRIDE;
+    if (cache->color_next > cache->color_max)
+        cache->color_next = 0;
+
+    for (size_t i = 0; i < cache->objs_per_slab; i++) {
+        struct free_obj *obj = (struct free_obj *)(page + color + i * cache->obj_size);
+        list_push_back(&cache->free_list, &obj->elem);
+    }
+
+    return true;
+}
+
+/* Returns an object from CACHE, growing it by a slab if the free
+   list is empty, or a null pointer if memory is exhausted.  The
+   object's contents are whatever its previous user left there. */
+void *slab_alloc(struct slab_cache *cache) {
+    ASSERT(cache != NULL);
+
+    lock_acquire(&cache->lock);
+    if (list_empty(&cache->free_list) && !slab_grow(cache)) {
+        lock_release(&cache->lock);
+        return NULL;
+    }
+
+    struct free_obj *obj = list_entry(list_pop_front(&cache->free_list), struct free_obj, elem);
+    lock_release(&cache->lock);
+
+    return obj;
+}
+
+/* Returns PTR, which must have come from CACHE, to the cache.
+   The object goes to the front of the free list so the next
+   allocation reuses it while it is still cache-hot. */
+void slab_free(struct slab_cache *cache, void *ptr) {
+    ASSERT(cache != NULL);
+
+    if (ptr == NULL)
+        return;
+
+    struct free_obj *obj = ptr;
+    lock_acquire(&cache->lock);
+    list_push_front(&cache->free_list, &obj->elem);
+    lock_release(&cache->lock);
+}
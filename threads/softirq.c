@@ -0,0 +1,64 @@
+#include "threads/softirq.h"
+
+#include <debug.h>
+#include <stdint.h>
+
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** #Project 3: Softirq 전역 변수 */
+static softirq_func *softirq_handlers[SOFTIRQ_CNT];  // 등록된 bottom half
+static uint32_t softirq_pending;                     // bit N = SOFTIRQ N 대기 중
+static struct semaphore softirq_sema;                // raise마다 up
+static bool softirq_ready;                           // ksoftirqd 가동 여부
+
+/** #Project 3: Softirq - 미뤄 둔 작업을 인터럽트가 켜진 채로 실행하는
+ *  데몬. 하드 핸들러가 세운 pending 비트를 통째로 가져와 순서대로 돈다. */
+static void ksoftirqd(void *aux UNUSED) {
+    for (;;) {
+        sema_down(&softirq_sema);
+
+        enum intr_level old_level = intr_disable();
+        uint32_t pending = softirq_pending;
+        softirq_pending = 0;
+        intr_set_level(old_level);
+
+        for (int nr = 0; nr < SOFTIRQ_CNT; nr++)
+            if ((pending & (1u << nr)) && softirq_handlers[nr] != NULL)
+                softirq_handlers[nr]();
+    }
+}
+
+/** #Project 3: Softirq - 데몬 스레드 기동. 스케줄러가 돌기 시작한 뒤
+ *  (thread_start() 이후) 호출해야 한다. */
+void softirq_init(void) {
+    sema_init(&softirq_sema, 0);
+    softirq_ready = true;
+    thread_create("ksoftirqd", PRI_MAX, ksoftirqd, NULL);
+
+    /* 데몬이 뜨기 전에 raise된 작업이 있으면 바로 처리시킨다. */
+    if (softirq_pending != 0)
+        sema_up(&softirq_sema);
+}
+
+/** #Project 3: Softirq - bottom half 등록. 번호당 핸들러 하나. */
+void softirq_register(enum softirq_nr nr, softirq_func *func) {
+    ASSERT(nr < SOFTIRQ_CNT);
+    ASSERT(softirq_handlers[nr] == NULL);
+
+    softirq_handlers[nr] = func;
+}
+
+/** #Project 3: Softirq - 하드 핸들러에서 호출. pending 비트만 세우고
+ *  데몬을 깨우므로 인터럽트 비활성 구간에 머무는 시간이 최소화된다. */
+void softirq_raise(enum softirq_nr nr) {
+    ASSERT(nr < SOFTIRQ_CNT);
+
+    enum intr_level old_level = intr_disable();
+    softirq_pending |= 1u << nr;
+    intr_set_level(old_level);
+
+    if (softirq_ready)
+        sema_up(&softirq_sema);
+}
@@ -31,9 +31,15 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "devices/timer.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 
+/** #Project 3: Adaptive Mutex - block 전에 holder가 실행 중인 동안 spin할
+ *  최대 반복 횟수. lock 보유 시간 중앙값이 context switch 두 번 비용보다
+ *  훨씬 짧다는 프로파일에 맞춘 값. */
+#define LOCK_SPIN_LIMIT 1024
+
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
    manipulating it:
@@ -43,11 +49,17 @@
 
    - up or "V": increment the value (and wake up one waiting
    thread, if any). */
+/** #Project 3: Compact Wait Queue - waiters heap 비교자. 유효 우선순위가
+ *  높은 쪽이 루트로 온다. */
+static bool cmp_wait_priority(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+    return heap_entry(a, thread_t, wait_elem)->priority > heap_entry(b, thread_t, wait_elem)->priority;
+}
+
 void sema_init(struct semaphore *sema, unsigned value) {
     ASSERT(sema != NULL);
 
     sema->value = value;
-    list_init(&sema->waiters);
+    heap_init(&sema->waiters, cmp_wait_priority, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,9 +78,10 @@ void sema_down(struct semaphore *sema) {
 
     old_level = intr_disable();
     while (sema->value == 0) {
-        /** #Priority Scheduling - Synchronization sema_priority 순서대로 waiters에 삽입  */
-        list_insert_ordered(&sema->waiters, &thread_current()->elem, cmp_priority, NULL);
-        // list_push_back(&sema->waiters, &thread_current()->elem);
+        /** #Project 3: Compact Wait Queue - O(1) heap 삽입. blocked_on을
+         *  걸어 두면 기부로 우선순위가 바뀔 때 키를 갱신할 수 있다. */
+        thread_current()->blocked_on = sema;
+        heap_insert(&sema->waiters, &thread_current()->wait_elem);
         thread_block();
     }
     sema->value--;
@@ -107,16 +120,62 @@ void sema_up(struct semaphore *sema) {
     ASSERT(sema != NULL);
 
     old_level = intr_disable();
-    if (!list_empty(&sema->waiters)) {
-        /** #Priority Scheduling - Synchronization waiter list 정렬 */
-        list_sort(&sema->waiters, cmp_priority, NULL);
-        thread_unblock(list_entry(list_pop_front(&sema->waiters), struct thread, elem));
+    if (!heap_empty(&sema->waiters)) {
+        /** #Project 3: Compact Wait Queue - 정렬 없이 루트 pop 한 번.
+         *  기부로 바뀐 키는 donate_priority가 그때그때 heap_update로
+         *  반영해 두므로 루트가 곧 최고 유효 우선순위다. */
+        struct thread *th = heap_entry(heap_pop(&sema->waiters), struct thread, wait_elem);
+
+        th->blocked_on = NULL;
+
+        /** #Project 3: Timed Wait - 시한부 대기자면 타이머 휠 등록을 O(1)로
+         *  해제하고 깨운다. 만료 경로는 thread_awake가 처리한다. */
+        thread_cancel_timeout(th);
+        thread_unblock(th);
     }
     sema->value++;
     test_max_priority();
     intr_set_level(old_level);
 }
 
+
+/** #Project 3: Timed Wait - sema_down이되 TIMEOUT_TICKS 안에 얻지 못하면
+ *  포기한다. 대기자는 semaphore 대기열과 타이머 휠에 동시에 걸리고,
+ *  먼저 일어난 쪽이 다른 쪽 등록을 O(1)로 걷어낸다(sema_up의
+ *  thread_cancel_timeout / thread_awake의 만료 처리). 획득하면 true,
+ *  만료로 끝나면 false. 가짜 타임아웃을 흉내 내려 폴링하던 경로들을
+ *  대체한다. */
+bool sema_down_timeout(struct semaphore *sema, int64_t timeout_ticks) {
+    struct thread *curr = thread_current();
+    int64_t deadline = timer_ticks() + timeout_ticks;
+    enum intr_level old_level;
+
+    ASSERT(sema != NULL);
+    ASSERT(!intr_context());
+
+    old_level = intr_disable();
+    while (sema->value == 0) {
+        /* 깨워졌지만 다른 스레드가 먼저 가로챈 경우 같은 기한으로 다시
+           기다린다. 기한이 이미 지났으면 그대로 포기한다. */
+        if (timer_ticks() >= deadline) {
+            intr_set_level(old_level);
+            return false;
+        }
+        curr->timed_out = false;
+        curr->blocked_on = sema;
+        heap_insert(&sema->waiters, &curr->wait_elem);
+        thread_register_timeout(deadline);
+        thread_block();
+        if (curr->timed_out) {
+            intr_set_level(old_level);
+            return false;
+        }
+    }
+    sema->value--;
+    intr_set_level(old_level);
+    return true;
+}
+
 static void sema_test_helper(void *sema_);
 
 /* Self-test for semaphores that makes control "ping-pong"
@@ -168,6 +227,61 @@ void lock_init(struct lock *lock) {
 
     lock->holder = NULL;
     sema_init(&lock->semaphore, 1);
+    lock->stat = NULL;
+}
+
+/** #Project 3: Lock 통계 - 등록된 stat 블록 전체 (lock_print_stats 출력용) */
+static struct list lock_stat_list;
+static bool lock_stat_list_initd;
+
+/** #Project 3: Lock 통계 - LOCK에 정적 stat 블록을 붙인다. 이후의
+ *  acquire/release마다 경합 수와 대기/보유 시간이 집계된다. */
+void lock_register_stat(struct lock *lock, struct lock_stat *stat, const char *name) {
+    ASSERT(lock != NULL && stat != NULL);
+    ASSERT(lock->stat == NULL);
+
+    memset(stat, 0, sizeof *stat);
+    stat->name = name;
+    lock->stat = stat;
+
+    enum intr_level old_level = intr_disable();
+    if (!lock_stat_list_initd) {
+        list_init(&lock_stat_list);
+        lock_stat_list_initd = true;
+    }
+    list_push_back(&lock_stat_list, &stat->elem);
+    intr_set_level(old_level);
+}
+
+/** #Project 3: Lock 통계 - 획득이 끝난 시점의 집계 갱신 */
+static void lock_stat_acquired(struct lock_stat *st, bool contended, int64_t wait_start) {
+    if (st == NULL)
+        return;
+
+    st->acquires++;
+    if (contended) {
+        int64_t wait = ktime_ns() - wait_start;
+        st->contended++;
+        st->wait_total += wait;
+        if (wait > st->wait_max)
+            st->wait_max = wait;
+    }
+    st->acquired_at = ktime_ns();
+}
+
+/** #Project 3: Lock 통계 - 등록된 lock별 경합/대기/보유 시간 출력 (us 단위) */
+void lock_print_stats(void) {
+    if (!lock_stat_list_initd)
+        return;
+
+    for (struct list_elem *e = list_begin(&lock_stat_list); e != list_end(&lock_stat_list); e = list_next(e)) {
+        struct lock_stat *st = list_entry(e, struct lock_stat, elem);
+
+        printf("Lock %s: %lld acquires (%lld contended), wait %lld/%lld us, hold %lld/%lld us (total/max)\n",
+               st->name, (long long)st->acquires, (long long)st->contended,
+               (long long)(st->wait_total / 1000), (long long)(st->wait_max / 1000),
+               (long long)(st->hold_total / 1000), (long long)(st->hold_max / 1000));
+    }
 }
 
 /* LOCK을 획득하고 필요한 경우 사용할 수 있을 때까지 절전 모드로 유지됩니다.
@@ -181,13 +295,41 @@ void lock_acquire(struct lock *lock) {
     ASSERT(!intr_context());
     ASSERT(!lock_held_by_current_thread(lock));
 
-    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 wait를 하게 될 lock 포인터 저장 후 대기 리스트에 추가하고 priority donation 수행 */
+    /** #Project 3: Lock 통계 - 경합 여부와 대기 시작 시각. stat이 없는
+     *  lock은 NULL 비교 한 번이 전부다. */
+    struct lock_stat *st = lock->stat;
+    bool contended = st != NULL && lock->holder != NULL;
+    int64_t wait_start = contended ? ktime_ns() : 0;
+
+    /** #Project 3: Adaptive Mutex - holder가 다른 CPU에서 실행 중인 동안만
+     *  짧게 spin한다. 실행 중인 holder는 곧 release할 가능성이 높아 context
+     *  switch 두 번보다 싸다. 단일 CPU에서는 우리가 실행 중인 이상 holder가
+     *  THREAD_RUNNING일 수 없어 즉시 빠져나가므로 비용이 없다. */
+    for (int spin = 0; spin < LOCK_SPIN_LIMIT; spin++) {
+        thread_t *holder = lock->holder;
+        if (holder == NULL || holder->status != THREAD_RUNNING)
+            break;
+
+        if (sema_try_down(&lock->semaphore)) {
+            lock->holder = thread_current();
+            lock_stat_acquired(st, contended, wait_start);
+            return;
+        }
+
+        __asm __volatile("pause" : : : "memory");
+    }
+
+    /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 wait를 하게 될 lock 포인터 저장 후 donation heap에 추가하고 priority donation 수행.
+     *  heap 삽입부터 sema_down까지를 인터럽트 비활성으로 묶어, release 쪽의
+     *  remove_with_lock이 보는 waiters와 donation heap이 항상 일치하게 한다. */
     thread_t *t = thread_current();
+    enum intr_level old_level = intr_disable();
     if (lock->holder != NULL) {
         t->wait_lock = lock;
-        list_push_back(&lock->holder->donations, &t->donation_elem);
-        if (!thread_mlfqs)
+        if (!thread_mlfqs) {
+            heap_insert(&lock->holder->donations, &t->donation_elem);
             donate_priority();
+        }
     }
 
     sema_down(&lock->semaphore);
@@ -195,6 +337,9 @@ void lock_acquire(struct lock *lock) {
     /** #Priority Donation 기다리고 있던 lock 포인터 반환 후 holder 갱신 */
     t->wait_lock = NULL;
     lock->holder = t;
+    intr_set_level(old_level);
+
+    lock_stat_acquired(st, contended, wait_start);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -210,8 +355,10 @@ bool lock_try_acquire(struct lock *lock) {
     ASSERT(!lock_held_by_current_thread(lock));
 
     success = sema_try_down(&lock->semaphore);
-    if (success)
+    if (success) {
         lock->holder = thread_current();
+        lock_stat_acquired(lock->stat, false, 0);
+    }
     return success;
 }
 
@@ -222,6 +369,16 @@ void lock_release(struct lock *lock) {
     ASSERT(lock != NULL);
     ASSERT(lock_held_by_current_thread(lock));
 
+    /** #Project 3: Lock 통계 - 보유 시간 집계 */
+    if (lock->stat != NULL) {
+        struct lock_stat *st = lock->stat;
+        int64_t hold = ktime_ns() - st->acquired_at;
+
+        st->hold_total += hold;
+        if (hold > st->hold_max)
+            st->hold_max = hold;
+    }
+
     lock->holder = NULL;
 
     /** #Priority Donation & Advanced Scheduler mlfqs 스케줄러 비활성화시 현재 쓰레드 대기 리스트 및 priority 갱신  */
@@ -292,6 +449,48 @@ void cond_wait(struct condition *cond, struct lock *lock) {
     lock_acquire(lock);
 }
 
+
+/** #Project 3: Timed Wait - cond_wait이되 TIMEOUT_TICKS 안에 신호가 없으면
+ *  포기한다. 만료와 cond_signal이 경합하면 신호가 이긴 것으로 친다:
+ *  락을 다시 잡은 시점에 대기열에서 이미 빠져 있으면 그 신호를 소비하고
+ *  true를 반환해, 신호가 허공에 사라지지 않게 한다. */
+bool cond_wait_timeout(struct condition *cond, struct lock *lock, int64_t timeout_ticks) {
+    struct semaphore_elem waiter;
+    bool ok;
+
+    ASSERT(cond != NULL);
+    ASSERT(lock != NULL);
+    ASSERT(!intr_context());
+    ASSERT(lock_held_by_current_thread(lock));
+
+    sema_init(&waiter.semaphore, 0);
+    /** #Priority Scheduling - Synchronization sema_priority 순서대로 waiters에 삽입  */
+    list_insert_ordered(&cond->waiters, &waiter.elem, cmp_sem_priority, NULL);
+    lock_release(lock);
+    ok = sema_down_timeout(&waiter.semaphore, timeout_ticks);
+    lock_acquire(lock);
+
+    if (!ok) {
+        struct list_elem *e;
+        bool queued = false;
+
+        for (e = list_begin(&cond->waiters); e != list_end(&cond->waiters); e = list_next(e))
+            if (e == &waiter.elem) {
+                queued = true;
+                break;
+            }
+        if (queued)
+            list_remove(&waiter.elem);
+        else {
+            /* 만료 직후 cond_signal이 우리를 꺼내 sema_up까지 마친
+               경우다. 밀린 up을 소비하고 정상 기상으로 처리한다. */
+            sema_down(&waiter.semaphore);
+            ok = true;
+        }
+    }
+    return ok;
+}
+
 /* If any threads are waiting on COND (protected by LOCK), then
    this function signals one of them to wake up from its wait.
    LOCK must be held before calling this function.
@@ -334,17 +533,93 @@ bool cmp_sem_priority(const struct list_elem *a, const struct list_elem *b, void
     if (sema_a == NULL || sema_b == NULL)
         return false;
 
-    struct list *list_a = &(sema_a->semaphore.waiters);
-    struct list *list_b = &(sema_b->semaphore.waiters);
+    /** #Project 3: Compact Wait Queue - heap 루트가 곧 최고 우선순위 대기자 */
+    struct heap *heap_a = &sema_a->semaphore.waiters;
+    struct heap *heap_b = &sema_b->semaphore.waiters;
 
-    if (list_a == NULL || list_b == NULL)
+    if (heap_empty(&sema_a->semaphore.waiters))
         return false;
+    if (heap_empty(&sema_b->semaphore.waiters))
+        return true;
 
-    thread_t *thread_a = list_entry(list_begin(list_a), thread_t, elem);
-    thread_t *thread_b = list_entry(list_begin(list_b), thread_t, elem);
-
-    if (thread_a == NULL || thread_b == NULL)
-        return false;
+    thread_t *thread_a = heap_entry(heap_top(heap_a), thread_t, wait_elem);
+    thread_t *thread_b = heap_entry(heap_top(heap_b), thread_t, wait_elem);
 
     return thread_a->priority > thread_b->priority;
-}
\ No newline at end of file
+}
+/* Initializes RW as a new reader-writer lock. */
+void rwlock_init(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    rw->readers = 0;
+    rw->writing = false;
+    rw->waiting_writers = 0;
+    list_init(&rw->read_waiters);
+    list_init(&rw->write_waiters);
+}
+
+/* Acquires RW for shared (read) access.  Readers are held back while
+   a writer is active or waiting, so writers cannot starve.  The
+   uncontended path is a single interrupt-disabled counter update. */
+void rwlock_acquire_read(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    enum intr_level old_level = intr_disable();
+    while (rw->writing || rw->waiting_writers > 0) {
+        list_insert_ordered(&rw->read_waiters, &thread_current()->elem, cmp_priority, NULL);
+        thread_block();
+    }
+    rw->readers++;
+    intr_set_level(old_level);
+}
+
+/* Releases shared access to RW; the last reader out lets a waiting
+   writer in. */
+void rwlock_release_read(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    enum intr_level old_level = intr_disable();
+    ASSERT(rw->readers > 0);
+    if (--rw->readers == 0 && !list_empty(&rw->write_waiters)) {
+        list_sort(&rw->write_waiters, cmp_priority, NULL);
+        thread_unblock(list_entry(list_pop_front(&rw->write_waiters), struct thread, elem));
+        test_max_priority();
+    }
+    intr_set_level(old_level);
+}
+
+/* Acquires RW for exclusive (write) access. */
+void rwlock_acquire_write(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+    ASSERT(!intr_context());
+
+    enum intr_level old_level = intr_disable();
+    while (rw->writing || rw->readers > 0) {
+        rw->waiting_writers++;
+        list_insert_ordered(&rw->write_waiters, &thread_current()->elem, cmp_priority, NULL);
+        thread_block();
+        rw->waiting_writers--;
+    }
+    rw->writing = true;
+    intr_set_level(old_level);
+}
+
+/* Releases exclusive access to RW.  A waiting writer is preferred;
+   otherwise every waiting reader is let in together. */
+void rwlock_release_write(struct rwlock *rw) {
+    ASSERT(rw != NULL);
+
+    enum intr_level old_level = intr_disable();
+    ASSERT(rw->writing);
+    rw->writing = false;
+    if (!list_empty(&rw->write_waiters)) {
+        list_sort(&rw->write_waiters, cmp_priority, NULL);
+        thread_unblock(list_entry(list_pop_front(&rw->write_waiters), struct thread, elem));
+    } else {
+        while (!list_empty(&rw->read_waiters))
+            thread_unblock(list_entry(list_pop_front(&rw->read_waiters), struct thread, elem));
+    }
+    test_max_priority();
+    intr_set_level(old_level);
+}
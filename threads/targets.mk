@@ -3,7 +3,12 @@ threads_SRC += threads/thread.c		# Thread management core.
 threads_SRC += threads/interrupt.c	# Interrupt core.
 threads_SRC += threads/intr-stubs.S	# Interrupt stubs.
 threads_SRC += threads/synch.c		# Synchronization.
+threads_SRC += threads/softirq.c	# Deferred interrupt work.
+threads_SRC += threads/workqueue.c	# Background work-queue pool.
+threads_SRC += threads/trace.c		# Kernel event trace ring.
 threads_SRC += threads/palloc.c		# Page allocator.
 threads_SRC += threads/malloc.c		# Subpage allocator.
+threads_SRC += threads/slab.c		# Slab caches for fixed-size objects.
+threads_SRC += threads/rcu.c		# Deferred reclamation for shared lists.
 threads_SRC += threads/start.S		# Startup code.
 threads_SRC += threads/mmu.c		    # Memory management unit related things.
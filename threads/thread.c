@@ -6,16 +6,26 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "threads/fixed_point.h"
 #include "threads/flags.h"
+#include "threads/malloc.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/rcu.h"
+#include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
+#include "lib/kernel/bitmap.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
 #include "userprog/process.h"
+#include "userprog/syscall.h"
 #endif
 
 /* Random value for struct thread's `magic' member.
@@ -27,23 +37,49 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/** #Project 1: Alarm Clock 전역 변수 */
-static struct list sleep_list;
-static int64_t next_tick_to_awake;
+/** #Project 3: 타이머 휠 - 잠든 스레드를 wakeup_tick의 하위 비트로 버킷에
+ *  나눠 담는다. 틱마다 지금 만료되는 버킷 하나만 보므로 틱당 비용이 잠든
+ *  스레드 수와 무관하고, 삽입은 push-to-tail로 O(1)이다. 휠 한 바퀴보다
+ *  먼 엔트리는 같은 버킷에 남겨 두고 다음 바퀴에 다시 본다. */
+#define TIMER_WHEEL_SIZE 64  // 2의 거듭제곱 (마스크 인덱싱)
+static struct list timer_wheel[TIMER_WHEEL_SIZE];
+static size_t sleeper_cnt;  // 잠든 스레드 수 (빈 휠 early-out용)
 
 /* List of processes in THREAD_READY state, that is, processes
    that are ready to run but not actually running. */
-static struct list ready_list;
+/** #Project 3: O(1) 스케줄러 - 우선순위 레벨별 큐 + 비어 있지 않은 레벨
+ *  비트맵. enqueue는 push-to-tail, 선택은 find-first-set + pop이라 둘 다
+ *  실행 큐 길이와 무관하다. 인터럽트 비활성 구간에서만 접근한다. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_bitmap;  // bit N = 레벨 N 큐가 비어 있지 않음
+static size_t ready_cnt;       // 러너블 스레드 수 (mlfqs load_avg용)
 
 /** #Project 1: Advanced Scheduler */
 static struct list all_list;
 
+/** #Project 3: Group Scheduling - 그룹 슬롯 풀. 커널 스레드와 아직
+ *  분리되지 않은 프로세스는 root_group에 과금된다. 새로 깨어난 그룹이
+ *  쌓인 부채(낮은 vtime)로 CPU를 독점하지 못하게, 스케줄러가 마지막으로
+ *  고른 그룹의 vtime을 바닥(group_min_vtime)으로 끌어올린다. */
+#define SCHED_GROUP_MAX 16
+#define SCHED_SHARES_DEFAULT 100
+#define SCHED_VTIME_UNIT (SCHED_SHARES_DEFAULT << 10)  // 기본 지분이면 틱당 1024
+
+static struct sched_group sched_groups[SCHED_GROUP_MAX];
+static struct sched_group root_group = {.shares = SCHED_SHARES_DEFAULT, .refs = 1};
+static int64_t group_min_vtime;
+
 /* Idle thread. */
 static struct thread *idle_thread;
 
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
+/** #Project 3: Thread 스택 분리 - struct thread 슬랩 캐시. 스택과 분리되어
+ *  스레드당 바닥 비용이 슬랩 오브젝트 하나 + 스택 할당으로 내려가고,
+ *  all_list 순회(mlfqs 재계산)가 캐시 친화적으로 된다. */
+static struct slab_cache thread_cache;
+
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
@@ -62,14 +98,43 @@ static unsigned thread_ticks; /* # of timer ticks since last yield. */
 /** #Project 1: Advanced Scheduler */
 int load_avg;
 
+/** #Project 3: Incremental MLFQS - 초당 decay 계수 이력 링. 타이머 인터럽트는
+ *  전역 계수만 기록하고, 각 스레드는 다시 주목받을 때(깨어날 때, nice 변경,
+ *  매 틱의 현재 스레드) 밀린 초만큼 계수를 접어 넣는다. 이력보다 오래 잠든
+ *  스레드는 점화식의 수렴값으로 근사한다. */
+#define DECAY_HIST 64                       // 2의 거듭제곱 (마스크 인덱싱)
+static int decay_coef[DECAY_HIST];          // 초 N의 2L/(2L+1) (17.14 고정소수점)
+static int decay_seq;                       // 지금까지 기록한 초 수
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/** #Project 3: Sampling Profiler - '-rip-prof' 커널 옵션으로 켠다 */
+bool rip_prof_active;
+
 static void kernel_thread(thread_func *, void *aux);
+static bool cmp_donation_priority(const struct heap_elem *, const struct heap_elem *, void *aux);
+
+/** #Project 3: Thread 스택 분리 - 스택 최하위 페이지의 매핑 토글.
+ *  커널 매핑의 하위 페이지 테이블은 모든 주소공간이 공유하므로 base_pml4의
+ *  PTE 하나만 고치면 전역으로 적용된다. 해제된 동안 프레임을 pool에
+ *  돌려줄 수 없으므로, 스레드가 죽을 때 복원한 뒤에야 스택을 반납한다. */
+static void stack_guard_set(void *guard, bool protect) {
+    uint64_t *pte = pml4e_walk(base_pml4, (uint64_t)guard, 0);
+    ASSERT(pte != NULL);
+
+    if (protect)
+        *pte &= ~(uint64_t)PTE_P;
+    else
+        *pte |= PTE_P;
+    invlpg((uint64_t)guard);
+}
 
 static void idle(void *aux UNUSED);
+static void thread_discard(struct thread *);
+static void mlfqs_fold(struct thread *);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
@@ -80,11 +145,12 @@ static tid_t allocate_tid(void);
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
 /* Returns the running thread.
- * Read the CPU's stack pointer `rsp', and then round that
- * down to the start of a page.  Since `struct thread' is
- * always at the beginning of a page and the stack pointer is
- * somewhere in the middle, this locates the curent thread. */
-#define running_thread() ((struct thread *)(pg_round_down(rrsp())))
+ * Read the CPU's stack pointer `rsp', round that down to the
+ * start of the stack page, and read the back-pointer planted at
+ * its bottom word.  Overflow detection itself is the guard
+ * page's job (see exception.c); is_thread()'s magic check is a
+ * debug-only sanity net on top. */
+#define running_thread() (*(struct thread **)(pg_round_down(rrsp())))
 
 // Global descriptor table for the thread_start.
 // Because the gdt will be setup after the thread_init, we should
@@ -112,17 +178,28 @@ void thread_init(void) {
 
     /* Init the globla thread context */
     lock_init(&tid_lock);
-    list_init(&ready_list);
+    for (int i = 0; i <= PRI_MAX; i++)
+        list_init(&ready_queues[i]);
     list_init(&destruction_req);
 
-    /** #Project 1: Alarm Clock sleep list 초기화 */
-    list_init(&sleep_list);
+    /** #Project 3: 타이머 휠 버킷 초기화 */
+    for (int i = 0; i < TIMER_WHEEL_SIZE; i++)
+        list_init(&timer_wheel[i]);
 
     /** #Project 1: Advanced Scheduler all list 초기화 */
     list_init(&all_list);
-
-    /* Set up a thread structure for the running thread. */
-    initial_thread = running_thread();
+    rcu_init();
+
+    /** #Project 3: Thread 스택 분리 - struct thread 슬랩 캐시. 첫 할당은
+     *  palloc이 준비된 뒤(thread_create)에 일어난다. */
+    slab_cache_init(&thread_cache, "thread", sizeof(struct thread));
+
+    /* Set up a thread structure for the running thread.  부팅 스택은
+       loader가 잡아 준 페이지를 그대로 쓰므로 struct만 정적으로 두고,
+       running_thread()가 찾도록 스택 페이지 바닥에 back-pointer를 심는다. */
+    static struct thread boot_thread;
+    initial_thread = &boot_thread;
+    *(struct thread **)pg_round_down(rrsp()) = initial_thread;
     init_thread(initial_thread, "main", PRI_DEFAULT);
 
     initial_thread->status = THREAD_RUNNING;
@@ -156,15 +233,75 @@ void thread_tick(void) {
     if (t == idle_thread)
         idle_ticks++;
 #ifdef USERPROG
-    else if (t->pml4 != NULL)
+    else if (t->pml4 != NULL) {
         user_ticks++;
+        t->utick_cnt++; /** #Project 3: CPU 사용량 - 스레드별 과금 */
+    }
 #endif
-    else
+    else {
         kernel_ticks++;
+        t->ktick_cnt++;
+    }
+
+    /** #Project 3: Group Scheduling - idle을 제외하고 틱을 그룹에 과금 */
+    if (t != idle_thread)
+        t->sched_group->vtime += SCHED_VTIME_UNIT / t->sched_group->shares;
 
     /* Enforce preemption. */
-    if (++thread_ticks >= TIME_SLICE)
+    if (++thread_ticks >= TIME_SLICE) {
+        /** #Project 3: Latency Class - 슬라이스를 끝까지 썼으면 '짧게
+         *  돌고 자는' 스레드가 아니므로 부스트를 몰수한다. */
+        t->lat_boost = 0;
         intr_yield_on_return();
+    }
+}
+
+/** #Project 3: Sampling Profiler - 타이머 인터럽트가 넘겨준, 중단 시점의
+ *  rip을 현재 스레드의 링에 기록한다. 링은 free-running head라 항상 최근
+ *  RIP_PROF_LEN개를 유지한다. */
+void thread_sample_rip(uint64_t rip) {
+    struct rip_prof *prof = thread_current()->rip_prof;
+
+    if (prof != NULL)
+        prof->rip[prof->taken++ & (RIP_PROF_LEN - 1)] = rip;
+}
+
+/** #Project 3: Sampling Profiler - 링에 남은 샘플을 주소 히스토그램으로
+ *  덤프하고 반납한다. 타이머가 더 쓰지 못하게 먼저 떼어낸다. */
+static void rip_prof_dump(struct thread *t) {
+    enum intr_level old_level = intr_disable();
+    struct rip_prof *prof = t->rip_prof;
+    t->rip_prof = NULL;
+    intr_set_level(old_level);
+
+    if (prof == NULL || prof->taken == 0) {
+        free(prof);
+        return;
+    }
+
+    size_t n = prof->taken < RIP_PROF_LEN ? prof->taken : RIP_PROF_LEN;
+    printf("%s: %llu rip samples, last %zu:\n", t->name, (unsigned long long)prof->taken, n);
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t addr = prof->rip[i];
+        size_t cnt = 0;
+        bool seen = false;
+
+        for (size_t j = 0; j < n; j++) {
+            if (prof->rip[j] != addr)
+                continue;
+            if (j < i) {
+                seen = true;  // 앞에서 이미 출력한 주소
+                break;
+            }
+            cnt++;
+        }
+
+        if (!seen)
+            printf("  %p: %zu\n", (void *)addr, cnt);
+    }
+
+    free(prof);
 }
 
 /* Prints thread statistics. */
@@ -172,6 +309,38 @@ void thread_print_stats(void) {
     printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n", idle_ticks, kernel_ticks, user_ticks);
 }
 
+/** #Project 3: Kernel Stats - 틱 카운터를 커널 통계 시스템 콜에 제공한다. */
+void thread_get_ticks(long long *idle, long long *kernel, long long *user) {
+    *idle = idle_ticks;
+    *kernel = kernel_ticks;
+    *user = user_ticks;
+}
+
+/** #Project 3: CPU 사용량 - 현재 스레드의 누적 CPU 소비를 돌려준다. 진행
+ *  중인 슬라이스는 지금 시점까지를 얹되, 적산값 자체는 문맥 전환 경계에서만
+ *  갱신되므로 단조 증가가 유지된다. */
+void thread_get_usage(long long *cycles, long long *uticks, long long *kticks) {
+    struct thread *t = thread_current();
+
+    *cycles = t->cpu_cycles + (rdtsc() - t->sched_in_tsc);
+    *uticks = t->utick_cnt;
+    *kticks = t->ktick_cnt;
+}
+
+/** #Project 3: Thrash Control - 살아있는 모든 스레드에 FUNC을 적용한다.
+ *  RCU read 섹션 안에서 돌므로 인터럽트를 끄지 않는다: 동시에 빠진
+ *  스레드는 next 포인터가 살아 있어 순회가 이어지고, 그 구조체 반납은
+ *  섹션이 끝날 때까지 미뤄진다(do_schedule 참고). FUNC은 블록하거나
+ *  스레드를 만들면 안 된다. */
+void thread_foreach(thread_action_func *func, void *aux) {
+    struct list_elem *e;
+
+    rcu_read_lock();
+    for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+        func(list_entry(e, struct thread, all_elem), aux);
+    rcu_read_unlock();
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -194,32 +363,78 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
     ASSERT(function != NULL);
 
     /* Allocate thread. */
-    t = palloc_get_page(PAL_ZERO);
+    t = slab_alloc(&thread_cache);
     if (t == NULL)
         return TID_ERROR;
 
+    /** #Project 3: Thread 스택 분리 - guard 페이지 + 커널 스택 할당.
+     *  스택 페이지 바닥의 back-pointer로 running_thread()가 t를 찾는다. */
+    uint8_t *kstack = palloc_get_multiple(PAL_ZERO, THREAD_STACK_PAGES);
+    if (kstack == NULL) {
+        slab_free(&thread_cache, t);
+        return TID_ERROR;
+    }
+
     /* Initialize thread. */
     init_thread(t, name, priority);
+
+    /** #Project 3: Group Scheduling - 생성자의 그룹을 물려받는다. fork
+     *  자손은 부모 트리에 과금되고, 새 트리는 process_spawn 쪽에서
+     *  thread_sched_group_detach()로 분리한다. */
+    root_group.refs--;
+    t->sched_group = thread_current()->sched_group;
+    t->sched_group->refs++;
+
+    t->kstack = kstack;
+    *(struct thread **)(kstack + PGSIZE) = t;
+    stack_guard_set(kstack, true);
     tid = t->tid = allocate_tid();
+
+    /** #Project 3: Sampling Profiler - 옵션이 켜진 경우에만 할당; 실패해도
+     *  샘플만 빠질 뿐 스레드 생성은 계속한다. */
+    if (rip_prof_active)
+        t->rip_prof = calloc(1, sizeof(struct rip_prof));
 #ifdef USERPROG
     /** #Project 2: System Call - 구조체 초기화 */
     t->fdt = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
-    if (t->fdt == NULL)
+    if (t->fdt == NULL) {
+        thread_discard(t);
+        return TID_ERROR;
+    }
+
+    t->fd_map = bitmap_create(FDCOUNT_LIMIT);
+    if (t->fd_map == NULL) {
+        palloc_free_multiple(t->fdt, FDT_PAGES);
+        thread_discard(t);
         return TID_ERROR;
+    }
 
     t->exit_status = 0;  // exit_status 초기화
 
+    /** #Project 3: Syscall Profile - 옵션이 켜진 경우에만 할당; 실패해도
+     *  프로파일만 빠질 뿐 스레드 생성은 계속한다. */
+    if (syscall_prof_active)
+        t->syscall_prof = calloc(1, sizeof(struct syscall_prof));
+
     t->fd_idx = 3;
     t->fdt[0] = STDIN;   // stdin 예약된 자리 (dummy)
     t->fdt[1] = STDOUT;  // stdout 예약된 자리 (dummy)
     t->fdt[2] = STDERR;  // stderr 예약된 자리 (dummy)
+    bitmap_set_multiple(t->fd_map, 0, 3, true);
     /** ---------------------------------------- */
 
-    /** #Project 2: System Call - 현재 스레드의 자식 리스트에 추가 */
-    list_push_back(&thread_current()->child_list, &t->child_elem);
+    /** #Project 3: 종료 상태 블록 - 부모 child_hash에 등록. 자식이 죽으면
+     *  스레드 페이지는 바로 반납되고 wait()는 이 블록만 본다. */
+    if (!process_attach_child(t)) {
+        bitmap_destroy(t->fd_map);
+        palloc_free_multiple(t->fdt, FDT_PAGES);
+        thread_discard(t);
+        return TID_ERROR;
+    }
 #endif
     /* Call the kernel_thread if it scheduled.
      * Note) rdi is 1st argument, and rsi is 2nd argument. */
+    t->tf.rsp = (uint64_t)kstack + THREAD_STACK_PAGES * PGSIZE - sizeof(void *);
     t->tf.rip = (uintptr_t)kernel_thread;
     t->tf.R.rdi = (uint64_t)function;
     t->tf.R.rsi = (uint64_t)aux;
@@ -248,10 +463,97 @@ tid_t thread_create(const char *name, int priority, thread_func *function, void
 void thread_block(void) {
     ASSERT(!intr_context());
     ASSERT(intr_get_level() == INTR_OFF);
+
+    /** #Project 3: Latency Class - 잔 시간 측정의 시작점을 찍는다. */
+    thread_current()->block_ns = ktime_ns();
     thread_current()->status = THREAD_BLOCKED;
     schedule();
 }
 
+/** #Project 3: Latency Class - 디스크 완료나 키 입력으로 오래 잔 뒤
+ *  깨어난 스레드는 대개 짧게 돌고 다시 잔다. 잔 시간을 부스트 레벨로
+ *  환산해 레벨 큐 '선택'에만 얹으면, 에코 경로 같은 I/O-bound 스레드가
+ *  같은 priority의 compute job을 앞질러 나간다. priority 필드나 donation
+ *  에는 손대지 않고, 슬라이스를 끝까지 쓰면(CPU-bound로 판명) 부스트를
+ *  즉시 몰수한다. */
+#define LAT_SLEEP_UNIT_NS (20 * 1000000) /* 부스트 1레벨당 잠 20ms */
+#define LAT_BOOST_MAX 4
+
+/** #Project 3: O(1) 스케줄러 보조 함수 - 인터럽트 비활성 상태에서만 호출.
+ *  enqueue는 해당 레벨 큐 tail에 넣고 비트만 세운다. 부스트만큼 위
+ *  레벨에 들어갈 수 있으므로 실제 레벨을 ready_level에 적어 둔다. */
+static void ready_enqueue(thread_t *t) {
+    int level = t->priority + t->lat_boost;
+
+    if (level > PRI_MAX)
+        level = PRI_MAX;
+
+    /** #Project 3: Group Scheduling - 오래 쉰 그룹의 부채 탕감 */
+    if (t->sched_group->vtime < group_min_vtime)
+        t->sched_group->vtime = group_min_vtime;
+
+    t->ready_level = level;
+    list_push_back(&ready_queues[level], &t->elem);
+    ready_bitmap |= 1ULL << level;
+    ready_cnt++;
+}
+
+/** #Project 3: O(1) 스케줄러 - find-first-set으로 가장 높은 비어 있지 않은
+ *  레벨을 찾아 pop. 실행 큐가 비어 있으면 NULL. */
+static thread_t *ready_pop(void) {
+    if (ready_bitmap == 0)
+        return NULL;
+
+    int level = 63 - __builtin_clzll(ready_bitmap);
+    struct list *q = &ready_queues[level];
+
+    /** #Project 3: Group Scheduling - 우선순위는 여전히 절대적이고, 같은
+     *  레벨 안에서만 그룹 vtime이 가장 뒤처진 스레드를 고른다. 엄격한
+     *  미만 비교라 같은 그룹끼리는 기존 FIFO(라운드로빈) 순서 그대로다.
+     *  레벨 큐는 짧은 것이 보통이라 이 스캔이 O(1) enqueue를 해치지
+     *  않는다. */
+    struct list_elem *best = list_begin(q);
+    for (struct list_elem *e = list_next(best); e != list_end(q); e = list_next(e)) {
+        thread_t *bt = list_entry(best, thread_t, elem);
+        thread_t *et = list_entry(e, thread_t, elem);
+
+        if (et->sched_group->vtime < bt->sched_group->vtime)
+            best = e;
+    }
+
+    thread_t *t = list_entry(best, thread_t, elem);
+    list_remove(best);
+    group_min_vtime = t->sched_group->vtime;
+
+    if (list_empty(&ready_queues[level]))
+        ready_bitmap &= ~(1ULL << level);
+    ready_cnt--;
+
+    return t;
+}
+
+/** #Project 3: O(1) 스케줄러 - 실행 큐 최고 우선순위 peek. 비어 있으면
+ *  PRI_MIN - 1을 반환해 어떤 비교에서도 지도록 한다. */
+static int ready_top_priority(void) {
+    if (ready_bitmap == 0)
+        return PRI_MIN - 1;
+
+    return 63 - __builtin_clzll(ready_bitmap);
+}
+
+/** #Project 3: O(1) 스케줄러 - READY 스레드의 우선순위가 바뀌면 새 레벨
+ *  큐로 옮긴다. (기존 정렬 리스트는 이 경우 제자리에 둬서 순서가 어긋났다.)
+ *  부스트 때문에 들어간 레벨이 priority와 다를 수 있으므로 ready_level을
+ *  기준으로 빼낸다. */
+static void ready_requeue(thread_t *t) {
+    list_remove(&t->elem);
+    if (list_empty(&ready_queues[t->ready_level]))
+        ready_bitmap &= ~(1ULL << t->ready_level);
+    ready_cnt--;
+
+    ready_enqueue(t);
+}
+
 /* Transitions a blocked thread T to the ready-to-run state.
    This is an error if T is not blocked.  (Use thread_yield() to
    make the running thread ready.)
@@ -268,9 +570,25 @@ void thread_unblock(struct thread *t) {
     old_level = intr_disable();
     ASSERT(t->status == THREAD_BLOCKED);
 
-    /** #Project 1: Priority Scheduling 우선순위 순으로 정렬되어 list에 삽입 */
-    list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
-    // list_push_back(&ready_list, &t->elem);
+    /** #Project 3: Incremental MLFQS - 잠든 동안 밀린 decay를 접어 넣고
+     *  우선순위를 갱신한 뒤에 레벨 큐를 고른다. */
+    if (thread_mlfqs) {
+        mlfqs_fold(t);
+        mlfqs_priority(t);
+    }
+
+    /** #Project 3: Latency Class - 잔 시간을 부스트 레벨로 환산한다.
+     *  mlfqs는 recent_cpu로 같은 효과를 이미 내므로 제외한다. */
+    if (!thread_mlfqs && t->block_ns != 0) {
+        int64_t slept = ktime_ns() - t->block_ns;
+        int boost = slept / LAT_SLEEP_UNIT_NS;
+
+        t->lat_boost = boost > LAT_BOOST_MAX ? LAT_BOOST_MAX : boost;
+        t->block_ns = 0;
+    }
+
+    /** #Project 3: O(1) 스케줄러 - 레벨 큐 tail 삽입이라 실행 큐 길이와 무관 */
+    ready_enqueue(t);
     t->status = THREAD_READY;
     intr_set_level(old_level);
 }
@@ -309,9 +627,21 @@ void thread_exit(void) {
 #ifdef USERPROG
     process_exit();
 #endif
+    /** #Project 3: Page Magazine - 캐시해 둔 user pool 페이지 반납 */
+    palloc_drain_magazine();
+
+    /** #Project 3: Sampling Profiler - 남은 샘플 히스토그램 덤프 */
+    if (thread_current()->rip_prof != NULL)
+        rip_prof_dump(thread_current());
+
     /** #Project 1: Advanced Scheduler 스레드 종료 시 all_list에서 제거 */
-    if (thread_mlfqs)
-        list_remove(&thread_current()->all_elem);
+    list_remove(&thread_current()->all_elem);
+
+    /** #Project 3: Group Scheduling - 그룹 탈퇴. refs가 0이 되면 풀 슬롯이
+     *  재사용 가능해진다. */
+    thread_current()->sched_group->refs--;
+    thread_current()->sched_group = &root_group;
+    root_group.refs++;
 
     /* 상태를 죽어가는 것으로 설정하고 다른 프로세스를 예약
        이 쓰레드는 Schedule_tail()을 호출하는 동안 파괴됨 */
@@ -320,6 +650,40 @@ void thread_exit(void) {
     NOT_REACHED();
 }
 
+/** #Project 3: Group Scheduling - tid 스레드를 새 그룹으로 분리한다.
+ *  process_spawn/process_create_initd가 새 프로세스 트리의 뿌리를 만들 때
+ *  호출하며, 새 그룹은 group_min_vtime에서 출발해 기존 그룹을 밀어내지
+ *  않는다. 풀이 가득 차면 기존 그룹에 그대로 남는다(과금만 합산). */
+void thread_sched_group_detach(tid_t tid) {
+    /** #Project 3: RCU - all_list는 RCU read 섹션만으로 안전하게 걷는다 */
+    rcu_read_lock();
+
+    struct thread *t = NULL;
+    for (struct list_elem *e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+        struct thread *cand = list_entry(e, struct thread, all_elem);
+        if (cand->tid == tid) {
+            t = cand;
+            break;
+        }
+    }
+
+    if (t != NULL) {
+        for (int i = 0; i < SCHED_GROUP_MAX; i++) {
+            struct sched_group *g = &sched_groups[i];
+            if (g->refs == 0) {
+                g->vtime = group_min_vtime;
+                g->shares = SCHED_SHARES_DEFAULT;
+                g->refs = 1;
+                t->sched_group->refs--;
+                t->sched_group = g;
+                break;
+            }
+        }
+    }
+
+    rcu_read_unlock();
+}
+
 /* Yields the CPU.  The current thread is not put to sleep and
    may be scheduled again immediately at the scheduler's whim. */
 void thread_yield(void) {
@@ -330,9 +694,8 @@ void thread_yield(void) {
 
     old_level = intr_disable();
     if (curr != idle_thread)
-        /** #Project 1: Priority Scheduling 우선순위 순으로 정렬되어 list에 삽입 */
-        list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
-    // list_push_back(&ready_list, &curr->elem);
+        /** #Project 3: O(1) 스케줄러 - 레벨 큐 tail 삽입이라 실행 큐 길이와 무관 */
+        ready_enqueue(curr);
     do_schedule(THREAD_READY);
     intr_set_level(old_level);
 }
@@ -363,6 +726,7 @@ void thread_set_nice(int nice UNUSED) {
     thread_t *t = thread_current();
 
     enum intr_level old_level = intr_disable();
+    mlfqs_fold(t);  // 이전 nice로 밀린 decay부터 접는다
     t->niceness = nice;
     mlfqs_priority(t);
     test_max_priority();
@@ -394,6 +758,7 @@ int thread_get_recent_cpu(void) {
     thread_t *t = thread_current();
 
     enum intr_level old_level = intr_disable();
+    mlfqs_fold(t);
     int recent_cpu = fp_to_int_round(mult_mixed(t->recent_cpu, 100));  // 출력시 소수 2번째 자리까지 출력하기 위함
     intr_set_level(old_level);
 
@@ -420,6 +785,9 @@ static void idle(void *idle_started_ UNUSED) {
         intr_disable();
         thread_block();
 
+        /** #Project 3: Tickless Idle - 다음 깨울 시각까지 주기 틱을 끈다. */
+        timer_enter_idle();
+
         /* Re-enable interrupts and wait for the next one.
 
            The `sti' instruction disables interrupts until the
@@ -436,6 +804,33 @@ static void idle(void *idle_started_ UNUSED) {
     }
 }
 
+/** #Project 3: Thread 스택 분리 - 생성 도중 실패한 스레드 되돌리기.
+ *  guard 매핑을 복원해야 스택 프레임을 pool에 돌려줄 수 있다. */
+/** #Project 3: RCU - 죽은 스레드의 스택과 구조체를 실제로 반납한다.
+ *  독자가 없으면 rcu_defer()가 즉시 부르고, 아니면 마지막 read 섹션이
+ *  닫힐 때 불린다. */
+static void thread_reclaim(void *t_) {
+    struct thread *t = t_;
+
+    stack_guard_set(t->kstack, false);
+    palloc_free_multiple(t->kstack, THREAD_STACK_PAGES);
+    slab_free(&thread_cache, t);
+}
+
+static void thread_discard(struct thread *t) {
+    /* init_thread는 스케줄러와 무관하게 all_list에 넣으므로 제거도
+       무조건이어야 한다. 안 빼면 다음 thread_foreach가 slab으로
+       돌아간 메모리를 걷는다. */
+    list_remove(&t->all_elem);
+
+    /* init_thread/thread_create가 잡은 그룹 참조 반납 */
+    t->sched_group->refs--;
+
+    stack_guard_set(t->kstack, false);
+    palloc_free_multiple(t->kstack, THREAD_STACK_PAGES);
+    slab_free(&thread_cache, t);
+}
+
 /* Function used as the basis for a kernel thread. */
 static void kernel_thread(thread_func *function, void *aux) {
     ASSERT(function != NULL);
@@ -455,19 +850,27 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     memset(t, 0, sizeof *t);
     t->status = THREAD_BLOCKED;
     strlcpy(t->name, name, sizeof t->name);
-    t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
 
     if (thread_mlfqs) {
         /** #Project 1: Advanced Scheduler 자료구조 초기화 */
+        t->recent_cpu_seq = decay_seq;
         mlfqs_priority(t);
-        list_push_back(&all_list, &t->all_elem);
     } else {
         /** #Project 1: Priority Donation 자료구조 초기화 */
         t->priority = priority;
     }
 
+    /** #Project 3: Thrash Control - 스케줄러와 무관하게 모든 스레드를
+     *  all_list에 넣는다. mlfqs 재계산과 thread_foreach가 같이 쓴다. */
+    list_push_back(&all_list, &t->all_elem);
+
     t->wait_lock = NULL;
-    list_init(&t->donations);
+    heap_init(&t->donations, cmp_donation_priority, NULL);
+
+    /** #Project 3: Group Scheduling - 생성자(thread_create)가 자기 그룹을
+     *  물려주기 전까지는 root_group 소속이다. */
+    t->sched_group = &root_group;
+    root_group.refs++;
 
     t->magic = THREAD_MAGIC;
 
@@ -480,10 +883,6 @@ static void init_thread(struct thread *t, const char *name, int priority) {
     /** #Project 2: System Call  */
     t->runn_file = NULL;
 
-    list_init(&t->child_list);
-    sema_init(&t->fork_sema, 0);
-    sema_init(&t->exit_sema, 0);
-    sema_init(&t->wait_sema, 0);
     /** -----------------------  */
 #endif
 }
@@ -494,10 +893,9 @@ static void init_thread(struct thread *t, const char *name, int priority) {
    will be in the run queue.)  If the run queue is empty, return
    idle_thread. */
 static struct thread *next_thread_to_run(void) {
-    if (list_empty(&ready_list))
-        return idle_thread;
-    else
-        return list_entry(list_pop_front(&ready_list), struct thread, elem);
+    thread_t *t = ready_pop();
+
+    return t != NULL ? t : idle_thread;
 }
 
 /* Use iretq to launch the thread *** 실제로 context switching을 하는 함수 *** */
@@ -612,7 +1010,13 @@ static void do_schedule(int status) {
     ASSERT(thread_current()->status == THREAD_RUNNING);
     while (!list_empty(&destruction_req)) {
         struct thread *victim = list_entry(list_pop_front(&destruction_req), struct thread, elem);
-        palloc_free_page(victim);
+
+        /** #Project 3: Thread 스택 분리 - guard 복원 후 스택과 struct 반납.
+         *  부팅 스레드는 정적 struct에 loader 스택이라 반납할 것이 없다.
+         *  RCU: all_list 순회자가 선점된 채 이 스레드를 가리키고 있을 수
+         *  있으므로, 독자가 남아 있으면 반납을 quiescent 시점으로 미룬다. */
+        if (victim->kstack != NULL)
+            rcu_defer(&victim->rcu, thread_reclaim, victim);
     }
     thread_current()->status = status;
     schedule();
@@ -625,6 +1029,19 @@ static void schedule(void) {
     ASSERT(intr_get_level() == INTR_OFF);
     ASSERT(curr->status != THREAD_RUNNING);
     ASSERT(is_thread(next));
+
+    /** #Project 3: Event Trace - 문맥 전환 기록 */
+    if (curr != next)
+        TRACE(TRACE_SCHED, curr->tid, next->tid);
+
+    /** #Project 3: CPU 사용량 - 슬라이스 경계에서 TSC를 한 번 읽어 나가는
+     *  스레드에 적산하고 들어오는 스레드의 시작점을 찍는다. */
+    if (curr != next) {
+        uint64_t now = rdtsc();
+
+        curr->cpu_cycles += now - curr->sched_in_tsc;
+        next->sched_in_tsc = now;
+    }
     /* Mark us as running. */
     next->status = THREAD_RUNNING;
 
@@ -666,7 +1083,7 @@ static tid_t allocate_tid(void) {
     return tid;
 }
 
-/** #Project 1: Alarm Clock 쓰레드 비활성화 함수 */
+/** #Project 3: 타이머 휠 - 활성화 틱의 버킷에 넣고 block */
 void thread_sleep(int64_t ticks) {
     thread_t *curr = thread_current();
 
@@ -676,53 +1093,116 @@ void thread_sleep(int64_t ticks) {
         enum intr_level old_level;
         old_level = intr_disable();  // pause interrupt
 
-        update_next_tick_to_awake(curr->wakeup_tick = ticks);  // update awake ticks
-
-        list_push_back(&sleep_list, &curr->elem);  // push to sleep_list
+        curr->wakeup_tick = ticks;
+        list_push_back(&timer_wheel[ticks & (TIMER_WHEEL_SIZE - 1)], &curr->timer_elem);
+        sleeper_cnt++;
 
         thread_block();  // block this thread
 
         intr_set_level(old_level);  // continue interrupt
     }
 }
-/** #Project 1: Alarm Clock 쓰레드 활성화 함수 */
+
+/** #Project 3: Tickless Idle - 타이머 휠 전체에서 가장 이른 wakeup_tick을
+ *  반환한다. 잠든 스레드가 없으면 INT64_MAX. idle 진입 시에만 불리므로
+ *  O(sleepers)여도 틱 경로에는 영향이 없다. 인터럽트 비활성 상태에서 호출. */
+int64_t thread_earliest_wakeup(void) {
+    int64_t earliest = INT64_MAX;
+
+    if (sleeper_cnt == 0)
+        return earliest;
+
+    for (int i = 0; i < TIMER_WHEEL_SIZE; i++) {
+        struct list_elem *e = list_begin(&timer_wheel[i]);
+        while (e != list_end(&timer_wheel[i])) {
+            thread_t *th = list_entry(e, thread_t, timer_elem);
+            if (th->wakeup_tick < earliest)
+                earliest = th->wakeup_tick;
+            e = list_next(e);
+        }
+    }
+
+    return earliest;
+}
+
+/** #Project 3: 타이머 휠 - 지금 틱의 버킷만 순회하며 만료된 스레드를 깨운다.
+ *  휠 한 바퀴 이상 남은 엔트리는 제자리에 두고 다음 바퀴에 다시 본다. */
 void thread_awake(int64_t wakeup_tick) {
-    next_tick_to_awake = INT64_MAX;
+    if (sleeper_cnt == 0)
+        return;
 
-    struct list_elem *sleeping = list_begin(&sleep_list);  // take sleeping thread
+    struct list *bucket = &timer_wheel[wakeup_tick & (TIMER_WHEEL_SIZE - 1)];
+    struct list batch;
     thread_t *th;
 
-    while (sleeping != list_end(&sleep_list)) {  // for all sleeping threads
-        th = list_entry(sleeping, thread_t, elem);
+    /** #Project 3: 공유 버킷은 O(1) splice 한 번으로 통째로 비우고, 로컬
+     *  리스트에서 만료 여부를 가린다. 휠 한 바퀴 이상 남은 엔트리만 버킷에
+     *  되돌려 다음 바퀴에 다시 본다. */
+    list_init(&batch);
+    list_splice_tail(&batch, bucket);
+
+    while (!list_empty(&batch)) {
+        th = list_entry(list_pop_front(&batch), thread_t, timer_elem);
 
         if (wakeup_tick >= th->wakeup_tick) {
-            sleeping = list_remove(&th->elem);  // delete thread
-            thread_unblock(th);                 // unblock thread
+            /** #Project 3: Timed Wait - 시한부 대기자는 semaphore 대기열에도
+             *  걸려 있다. 만료 표시 후 대기열에서 O(1)로 빼내고 깨운다. */
+            if (th->timed_wait) {
+                heap_remove(&th->blocked_on->waiters, &th->wait_elem);
+                th->blocked_on = NULL;
+                th->timed_wait = false;
+                th->timed_out = true;
+            }
+            sleeper_cnt--;
+            thread_unblock(th);  // unblock thread
         } else {
-            update_next_tick_to_awake(th->wakeup_tick);  // update wakeup_tick
-            sleeping = list_next(sleeping);              // move to next sleeping thread
+            list_push_back(bucket, &th->timer_elem);  // 아직 한 바퀴 이상 남음
         }
     }
 }
 
-/** #Project 1: Alarm Clock 다음 활성화 tick 갱신 함수 */
-void update_next_tick_to_awake(int64_t ticks) {
-    next_tick_to_awake = (next_tick_to_awake > ticks) ? ticks : next_tick_to_awake;
-}
+/** #Project 3: Timed Wait - 현재 스레드를 DEADLINE 틱의 휠 버킷에 시한부
+ *  대기로 등록한다. 호출자(synch.c)가 semaphore 대기열 삽입과 block을
+ *  인터럽트 비활성으로 묶는다. */
+void thread_register_timeout(int64_t deadline) {
+    thread_t *curr = thread_current();
+
+    ASSERT(intr_get_level() == INTR_OFF);
 
-/** #Project 1: Alarm Clock 현재 next_tick_to_awake 값 리턴 함수 */
-int64_t get_next_tick_to_awake(void) {
-    return next_tick_to_awake;
+    curr->wakeup_tick = deadline;
+    curr->timed_wait = true;
+    list_push_back(&timer_wheel[deadline & (TIMER_WHEEL_SIZE - 1)], &curr->timer_elem);
+    sleeper_cnt++;
 }
 
-/** #Project 1: Priority Scheduling ready_list에서 우선 순위가 가장 높은 쓰레드와 현재 쓰레드의 우선 순위를 비교 */
-void test_max_priority(void) {
-    if (list_empty(&ready_list))
+/** #Project 3: Timed Wait - TH가 만료 전에 깨워졌다면 휠 등록을 O(1)로
+ *  해제한다. sema_up이 대기자를 꺼낼 때 호출하며, 시한부 대기가 아니면
+ *  플래그 확인 한 번으로 끝난다. */
+void thread_cancel_timeout(thread_t *th) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    if (!th->timed_wait)
         return;
 
-    thread_t *th = list_entry(list_front(&ready_list), thread_t, elem);
+    list_remove(&th->timer_elem);
+    th->timed_wait = false;
+    sleeper_cnt--;
+}
+
+/** #Project 3: Cooperative Preemption - 긴 커널 루프(SPT 복사/해체, fsutil
+ *  전송, 캐시 flush 등)에 끼워 넣는 양보 지점. 더 높은 우선순위 스레드가
+ *  READY일 때만 양보하므로 루프마다 불러도 비용은 비트맵 peek 한 번이다.
+ *  틱 경계(TIME_SLICE)만 기다리던 선점 지연을 루프 단위로 줄인다. */
+void thread_cond_resched(void) {
+    ASSERT(!intr_context());
+
+    if (thread_current()->priority < ready_top_priority())
+        thread_yield();
+}
 
-    if (thread_current()->priority < th->priority) {
+/** #Project 1: Priority Scheduling ready_list에서 우선 순위가 가장 높은 쓰레드와 현재 쓰레드의 우선 순위를 비교 */
+void test_max_priority(void) {
+    if (thread_current()->priority < ready_top_priority()) {
         /** Project 2: Panic 방지 */
         if (intr_context())
             intr_yield_on_return();
@@ -742,53 +1222,87 @@ bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *au
     return thread_a->priority > thread_b->priority;
 }
 
+/** #Project 3: Donation Heap - 기부자 max-heap 비교 함수 (우선순위 높은 쪽이 root) */
+static bool cmp_donation_priority(const struct heap_elem *a, const struct heap_elem *b, void *aux UNUSED) {
+    return heap_entry(a, thread_t, donation_elem)->priority > heap_entry(b, thread_t, donation_elem)->priority;
+}
+
 /** #Project 1: Priority Donation 현재 쓰레드가 기다리고 있는 lock과 연결된 모든 쓰레드들을 순회하며
  *  현재 쓰레드의 우선순위를 lock을 보유하고 있는 쓰레드에게 기부한다. */
 void donate_priority() {
     thread_t *t = thread_current();
     int priority = t->priority;
 
+    /** #Project 3: O(1) 스케줄러 - 기부받은 holder가 READY 상태면 새 레벨
+     *  큐로 옮겨야 하므로 인터럽트를 끄고 순회한다. */
+    enum intr_level old_level = intr_disable();
+
     for (int depth = 0; depth < 8; depth++) {
         if (t->wait_lock == NULL)
             break;
 
-        t = t->wait_lock->holder;
-        t->priority = priority;
+        thread_t *holder = t->wait_lock->holder;
+
+        /** #Project 3: Donation Heap - t의 우선순위가 바뀌었으니 holder의
+         *  heap에 있는 t의 키도 갱신한다. */
+        heap_update(&holder->donations, &t->donation_elem);
+
+        int old_priority = holder->priority;
+        holder->priority = priority;
+        if (holder->status == THREAD_READY && old_priority != priority)
+            ready_requeue(holder);
+        /** #Project 3: Compact Wait Queue - holder가 semaphore 대기 중이면
+         *  그 waiters heap의 키도 바뀐 것이므로 제자리를 찾아 준다. */
+        else if (holder->blocked_on != NULL && old_priority != priority)
+            heap_update(&holder->blocked_on->waiters, &holder->wait_elem);
+
+        t = holder;
+    }
+
+    intr_set_level(old_level);
+}
+
+/** #Project 3: Compact Wait Queue - E를 루트로 하는 waiters 서브트리의
+ *  모든 대기자를 DONATIONS에서 걷어낸다. 이미 이전 holder의 release에서
+ *  떨어져 나간 엔트리는 heap_contains로 걸러진다. */
+static void strip_lock_donations(struct heap_elem *e, struct heap *donations) {
+    while (e != NULL) {
+        strip_lock_donations(e->child, donations);
+
+        thread_t *donor = heap_entry(e, thread_t, wait_elem);
+        if (heap_contains(donations, &donor->donation_elem))
+            heap_remove(donations, &donor->donation_elem);
+
+        e = e->sibling;
     }
 }
 
-/** #Project 1: Priority Donation 현재 쓰레드의 waiters 리스트를 확인하여 해지할 lock을 보유하고 있는
- *  엔트리를 삭제한다. */
+/** #Project 1: Priority Donation 해지할 lock을 기다리는 기부자들의 엔트리를 donation heap에서 삭제한다.
+ *  기부자는 곧 lock semaphore의 waiters이므로 그 heap만 걸으면 된다. */
 void remove_with_lock(struct lock *lock) {
     thread_t *t = thread_current();
-    struct list_elem *curr = list_begin(&t->donations);
-    thread_t *curr_thread = NULL;
 
-    while (curr != list_end(&t->donations)) {
-        curr_thread = list_entry(curr, thread_t, donation_elem);
+    enum intr_level old_level = intr_disable();
 
-        if (curr_thread->wait_lock == lock)
-            list_remove(&curr_thread->donation_elem);
+    /** #Project 3: Compact Wait Queue - waiters가 heap이 되어 pairing
+     *  tree를 직접 걷는다. 대기자 수는 짧아 재귀 깊이는 문제되지 않는다. */
+    strip_lock_donations(lock->semaphore.waiters.root, &t->donations);
 
-        curr = list_next(curr);
-    }
+    intr_set_level(old_level);
 }
 
 /** #Project 1: Priority Donation 쓰레드의 우선순위가 변경되었을 때, donation을 고려하여 우선순위를
  *  다시 결정하는 함수 */
 void refresh_priority(void) {
     /* 현재 쓰레드의 우선순위를 기부 받기 전의 우선순위로 변경.
-    현재 쓰레드의 waiters 리스트에서 가장 높은 우선순위를 현재 쓰레드의 우선순위와 비교 후 우선순위 결정 */
+    donation heap의 root가 곧 최고 우선순위 기부자이므로 정렬 없이 O(1) peek으로 결정한다. */
     thread_t *t = thread_current();
     t->priority = t->original_priority;
 
-    if (list_empty(&t->donations))
+    if (heap_empty(&t->donations))
         return;
 
-    list_sort(&t->donations, cmp_priority, NULL);
-
-    struct list_elem *max_elem = list_front(&t->donations);
-    thread_t *max_thread = list_entry(max_elem, thread_t, donation_elem);
+    thread_t *max_thread = heap_entry(heap_top(&t->donations), thread_t, donation_elem);
 
     if (t->priority < max_thread->priority)
         t->priority = max_thread->priority;
@@ -799,27 +1313,58 @@ void mlfqs_priority(struct thread *t) {
     if (t == idle_thread)
         return;
 
-    t->priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->niceness * 2));
+    int new_priority = fp_to_int(add_mixed(div_mixed(t->recent_cpu, -4), PRI_MAX - t->niceness * 2));
+
+    /** #Project 3: O(1) 스케줄러 - 레벨 큐 인덱스로 쓰이므로 범위를 벗어나지
+     *  않게 clamp하고, READY 스레드면 새 레벨 큐로 옮긴다. */
+    if (new_priority > PRI_MAX)
+        new_priority = PRI_MAX;
+    if (new_priority < PRI_MIN)
+        new_priority = PRI_MIN;
+
+    int old_priority = t->priority;
+    t->priority = new_priority;
+    if (t->status == THREAD_READY && old_priority != new_priority)
+        ready_requeue(t);
 }
 
-/** #Project 1: Advanced Scheduler MLFQS Recent Cpu 계산하는 함수 */
-void mlfqs_recent_cpu(struct thread *t) {
-    if (t == idle_thread)
+/** #Project 3: Incremental MLFQS - t의 recent_cpu에 밀린 초들의 decay를
+ *  접어 넣는다. r' = c*r + nice를 밀린 초마다 그 초의 계수로 적용하되,
+ *  이력(DECAY_HIST초)보다 오래 밀렸으면 이미 수렴했다고 보고 점화식의
+ *  고정점 nice/(1-c)로 근사한다. */
+static void mlfqs_fold(struct thread *t) {
+    if (t == idle_thread || t->recent_cpu_seq == decay_seq)
         return;
 
-    t->recent_cpu = add_mixed(mult_fp(div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1)), t->recent_cpu), t->niceness);
+    if (decay_seq - t->recent_cpu_seq >= DECAY_HIST) {
+        int coef = decay_coef[(decay_seq - 1) & (DECAY_HIST - 1)];
+        t->recent_cpu = div_fp(int_to_fp(t->niceness), sub_fp(int_to_fp(1), coef));
+    } else {
+        while (t->recent_cpu_seq < decay_seq) {
+            int coef = decay_coef[t->recent_cpu_seq & (DECAY_HIST - 1)];
+            t->recent_cpu = add_mixed(mult_fp(coef, t->recent_cpu), t->niceness);
+            t->recent_cpu_seq++;
+        }
+    }
+
+    t->recent_cpu_seq = decay_seq;
 }
 
 /** #Project 1: Advanced Scheduler MLFQS Load Average 계산하는 함수 */
 void mlfqs_load_avg(void) {
     int ready_threads;
 
-    ready_threads = list_size(&ready_list);
+    ready_threads = ready_cnt;
 
     if (thread_current() != idle_thread)
         ready_threads++;
 
     load_avg = add_fp(mult_fp(div_fp(int_to_fp(59), int_to_fp(60)), load_avg), mult_mixed(div_fp(int_to_fp(1), int_to_fp(60)), ready_threads));
+
+    /** #Project 3: Incremental MLFQS - 이번 초의 decay 계수만 기록하고
+     *  스레드 순회는 하지 않는다. */
+    decay_coef[decay_seq & (DECAY_HIST - 1)] = div_fp(mult_mixed(load_avg, 2), add_mixed(mult_mixed(load_avg, 2), 1));
+    decay_seq++;
 }
 
 /** #Project 1: Advanced Scheduler MLFQS Recent CPU에 1을 더하는 함수 */
@@ -827,31 +1372,7 @@ void mlfqs_increment(void) {
     if (thread_current() == idle_thread)
         return;
 
+    /** #Project 3: Incremental MLFQS - 더하기 전에 밀린 decay부터 접는다 */
+    mlfqs_fold(thread_current());
     thread_current()->recent_cpu = add_mixed(thread_current()->recent_cpu, 1);
 }
-
-/** #Project 1: Advanced Scheduler MLFQS 모든 Recent CPU 재계산 */
-void mlfqs_recalc_recent_cpu(void) {
-    struct list_elem *e = list_begin(&all_list);
-    thread_t *t = NULL;
-
-    while (e != list_end(&all_list)) {
-        t = list_entry(e, thread_t, all_elem);
-        mlfqs_recent_cpu(t);
-
-        e = list_next(e);
-    }
-}
-
-/** #Project 1: Advanced Scheduler MLFQS 모든 Priority 재계산 */
-void mlfqs_recalc_priority(void) {
-    struct list_elem *e = list_begin(&all_list);
-    thread_t *t = NULL;
-
-    while (e != list_end(&all_list)) {
-        t = list_entry(e, thread_t, all_elem);
-        mlfqs_priority(t);
-
-        e = list_next(e);
-    }
-}
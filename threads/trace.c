@@ -0,0 +1,64 @@
+#include "threads/trace.h"
+
+#include <stdio.h>
+
+#include "intrinsic.h"
+
+/** #Project 3: Event Trace 전역 변수 */
+#define TRACE_LEN 4096  // 2의 거듭제곱 (마스크 인덱싱)
+
+bool trace_enabled;
+
+static struct trace_event trace_ring[TRACE_LEN];  // 이벤트 링 (BSS, 128KB)
+static uint64_t trace_head;                       // free-running 기록 위치
+
+/* 덤프용 이벤트 이름 (enum trace_id 순서) */
+static const char *trace_names[TRACE_ID_CNT] = {
+    "sched", "fault", "disk-read", "disk-write", "syscall",
+};
+
+/** #Project 3: Event Trace - 이벤트 기록. 슬롯 예약을 atomic 증가로 하므로
+ *  인터럽트 핸들러와 스레드가 락 없이 섞여 불러도 레코드를 덮어쓰지 않는다.
+ *  (기록 도중 선점되면 그 슬롯 하나가 덜 쓰인 채 남을 수 있는데, 덤프에서
+ *  tsc가 0인 슬롯으로 드러난다.) */
+void trace_event(enum trace_id id, uint64_t arg1, uint64_t arg2) {
+    struct trace_event *ev = &trace_ring[__atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED) & (TRACE_LEN - 1)];
+
+    ev->tsc = 0;  // 슬롯 재사용 표시 (아래 기록이 끝나기 전 덤프 대비)
+    ev->id = id;
+    ev->arg1 = arg1;
+    ev->arg2 = arg2;
+    ev->tsc = rdtsc();
+}
+
+/** #Project 3: Event Trace - 기록 시작/중단. 스톨을 재현한 직후
+ *  trace_stop()을 불러 링을 얼려 두고 덤프하는 식으로 쓴다. */
+void trace_start(void) {
+    trace_enabled = true;
+}
+
+void trace_stop(void) {
+    trace_enabled = false;
+}
+
+/** #Project 3: Event Trace - 링 내용을 오래된 것부터 시리얼 콘솔로 덤프 */
+void trace_dump(void) {
+    bool was_enabled = trace_enabled;
+    trace_enabled = false;  // 덤프 자체가 이벤트를 만들며 링을 밀어내지 않게
+
+    uint64_t head = trace_head;
+    uint64_t start = head > TRACE_LEN ? head - TRACE_LEN : 0;
+
+    printf("Trace: %llu events, dumping %llu:\n", (unsigned long long)head, (unsigned long long)(head - start));
+    for (uint64_t i = start; i < head; i++) {
+        struct trace_event *ev = &trace_ring[i & (TRACE_LEN - 1)];
+
+        if (ev->tsc == 0)
+            continue;  // 기록이 끝나지 않은 슬롯
+        printf("  %llu %s %llu %llu\n", (unsigned long long)ev->tsc,
+               ev->id < TRACE_ID_CNT ? trace_names[ev->id] : "?",
+               (unsigned long long)ev->arg1, (unsigned long long)ev->arg2);
+    }
+
+    trace_enabled = was_enabled;
+}
@@ -0,0 +1,118 @@
+#include "threads/workqueue.h"
+
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/** #Project 3: Workqueue 전역 변수 */
+#define KWORKER_CNT 2 /* 공유 kworker 스레드 수 */
+
+static struct list workqueues;     // 등록된 모든 큐
+static struct semaphore work_sema; // 디스패치 가능한 작업마다 up
+static bool wq_ready;              // kworker 가동 여부
+
+/** #Project 3: Workqueue - 디스패치할 작업 하나를 고른다. 대기 작업이 있고
+ *  동시 실행 상한에 여유가 있는 큐에서 맨 앞 work를 꺼내 active를 올린다.
+ *  인터럽트 비활성 상태에서 호출해야 한다. */
+static struct work *workqueue_pick(struct workqueue **wq_out) {
+    ASSERT(intr_get_level() == INTR_OFF);
+
+    for (struct list_elem *e = list_begin(&workqueues); e != list_end(&workqueues); e = list_next(e)) {
+        struct workqueue *wq = list_entry(e, struct workqueue, elem);
+
+        if (!clist_empty(&wq->pending) && wq->active < wq->max_active) {
+            wq->active++;
+            *wq_out = wq;
+            return list_entry(clist_pop_front(&wq->pending), struct work, elem);
+        }
+    }
+
+    return NULL;
+}
+
+/** #Project 3: Workqueue - kworker 데몬. 깨울 때마다 디스패치 가능한 작업을
+ *  찾아 인터럽트가 켜진 채로 실행한다. 상한에 막혀 가져올 작업이 없으면
+ *  토큰만 소비하고 다시 잔다 — 실행을 마친 kworker가 상한이 풀릴 때 다시
+ *  깨워 주므로 작업이 유실되지 않는다. */
+static void kworker(void *aux UNUSED) {
+    for (;;) {
+        sema_down(&work_sema);
+
+        enum intr_level old_level = intr_disable();
+        struct workqueue *wq;
+        struct work *work = workqueue_pick(&wq);
+        intr_set_level(old_level);
+
+        if (work == NULL)
+            continue;
+
+        work->func(work->aux);
+
+        old_level = intr_disable();
+        wq->active--;
+        wq->executed++;
+        bool more = !clist_empty(&wq->pending);
+        intr_set_level(old_level);
+
+        if (more)
+            sema_up(&work_sema);
+    }
+}
+
+/** #Project 3: Workqueue - kworker 풀 기동. 스케줄러가 돌기 시작한 뒤
+ *  (thread_start() 이후) 호출해야 한다. */
+void workqueue_init(void) {
+    list_init(&workqueues);
+    sema_init(&work_sema, 0);
+    wq_ready = true;
+
+    for (int i = 0; i < KWORKER_CNT; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "kworker/%d", i);
+        thread_create(name, PRI_DEFAULT, kworker, NULL);
+    }
+}
+
+/** #Project 3: Workqueue - 큐 등록. 정적/전역 workqueue 구조체를 넘긴다. */
+void workqueue_create(struct workqueue *wq, const char *name, int max_active) {
+    ASSERT(wq_ready);
+    ASSERT(max_active > 0);
+
+    wq->name = name;
+    clist_init(&wq->pending);
+    wq->active = 0;
+    wq->max_active = max_active;
+    wq->executed = 0;
+
+    enum intr_level old_level = intr_disable();
+    list_push_back(&workqueues, &wq->elem);
+    intr_set_level(old_level);
+}
+
+/** #Project 3: Workqueue - 작업 제출. 리스트 조작만 하고 kworker를 깨우므로
+ *  softirq나 인터럽트 문맥에서도 호출할 수 있다. */
+void workqueue_enqueue(struct workqueue *wq, struct work *work, work_func *func, void *aux) {
+    work->func = func;
+    work->aux = aux;
+
+    enum intr_level old_level = intr_disable();
+    clist_push_back(&wq->pending, &work->elem);
+    intr_set_level(old_level);
+
+    sema_up(&work_sema);
+}
+
+/** #Project 3: Workqueue - 큐별 누적 실행 수 출력 */
+void workqueue_print_stats(void) {
+    enum intr_level old_level = intr_disable();
+    for (struct list_elem *e = list_begin(&workqueues); e != list_end(&workqueues); e = list_next(e)) {
+        struct workqueue *wq = list_entry(e, struct workqueue, elem);
+        printf("Workqueue %s: %" PRId64 " executed, %d active, %zu pending\n", wq->name, wq->executed, wq->active,
+               clist_size(&wq->pending));
+    }
+    intr_set_level(old_level);
+}
@@ -1,16 +1,72 @@
 #include "userprog/exception.h"
 
+#include <debug.h>
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <random.h>
+
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "threads/interrupt.h"
+#include "threads/intr-stubs.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/gdt.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/** #Project 3: Fault Triage - 폴트 분류 카운터와 폭주 시 주소 표본.
+ *  스래시 이벤트를 추적하려고 printf를 박아 재빌드하면 타이밍이 바뀌어
+ *  버그가 숨는다. 대신 에러 코드 조합별([user][write][not_present])
+ *  카운터와 해소 결과 카운터를 항상 켜 두고, 폴트 빈도가 문턱을 넘는
+ *  동안만 폴트 주소를 레저버 샘플링으로 작은 버퍼에 담는다. 폭주가
+ *  수백만 폴트여도 표본은 대표성 있는 32개로 남고 콘솔은 조용하다.
+ *  증가는 비원자 평문이라 핫패스 비용이 사실상 없다. */
+static long long fault_class_cnt[2][2][2]; /* [user][write][not_present] */
+static long long fault_resolved_cnt;       /* vm_try_handle_fault가 해소 */
+static long long fault_fixup_cnt;          /* usercopy 픽스업으로 복귀 */
+static long long fault_fatal_cnt;          /* 프로세스 종료로 끝남 */
+
+#define FAULT_SAMPLE_CNT 32                     /* 레저버 크기 */
+#define FAULT_STORM_WINDOW_NS (100 * 1000000LL) /* 빈도 측정 창: 100ms */
+#define FAULT_STORM_THRESHOLD 2000              /* 창당 폴트 수 문턱 */
+
+static void *fault_samples[FAULT_SAMPLE_CNT]; /* 표본 주소 */
+static long long fault_sample_seen;           /* 레저버에 제안된 폴트 수 */
+static int64_t storm_win_start;               /* 현재 측정 창의 시작 */
+static long long storm_win_faults;            /* 창 안에서 센 폴트 수 */
+static bool storm_active;                     /* 직전 창이 문턱을 넘었음 */
+
+/** #Project 3: Fault Triage - 폴트 하나를 분류 카운터에 적산하고, 폭주
+ *  중이면 주소를 레저버에 제안한다. n번째 제안은 확률 k/n으로 임의
+ *  슬롯을 대체하므로 버퍼는 폭주 전체에서 균등 표본이 된다. */
+static void fault_account(void *fault_addr, bool user, bool write, bool not_present) {
+    int64_t now = ktime_ns();
+
+    fault_class_cnt[user][write][not_present]++;
+
+    if (now - storm_win_start > FAULT_STORM_WINDOW_NS) {
+        storm_active = storm_win_faults > FAULT_STORM_THRESHOLD;
+        storm_win_start = now;
+        storm_win_faults = 0;
+    }
+    storm_win_faults++;
+
+    if (storm_active) {
+        long long n = ++fault_sample_seen;
+
+        if (n <= FAULT_SAMPLE_CNT)
+            fault_samples[n - 1] = fault_addr;
+        else {
+            long long slot = random_ulong() % n;
+            if (slot < FAULT_SAMPLE_CNT)
+                fault_samples[slot] = fault_addr;
+        }
+    }
+}
+
 static void kill(struct intr_frame *);
 static void page_fault(struct intr_frame *);
 
@@ -56,11 +112,38 @@ void exception_init(void) {
        We need to disable interrupts for page faults because the
        fault address is stored in CR2 and needs to be preserved. */
     intr_register_int(14, 0, INTR_OFF, page_fault, "#PF Page-Fault Exception");
+
+    /** #Project 3: Page Fault Fast Path - 해결 경로에서 전체 레지스터 저장을
+       생략하는 전용 진입점으로 게이트를 교체한다. 위 page_fault 등록은
+       전용 진입점이 느린 경로로 넘길 때의 디스패치용으로 유지된다. */
+    intr_install_fast_entry(14, intr0e_fast);
 }
 
 /* Prints exception statistics. */
 void exception_print_stats(void) {
+    static const char *src_names[2] = {"kernel", "user"};
+    static const char *acc_names[2] = {"read", "write"};
+    static const char *pres_names[2] = {"protection", "absent"};
+    int u, w, p;
+
     printf("Exception: %lld page faults\n", page_fault_cnt);
+
+    /** #Project 3: Fault Triage - 분류/결과 카운터와 폭주 표본 출력 */
+    for (u = 0; u < 2; u++)
+        for (w = 0; w < 2; w++)
+            for (p = 0; p < 2; p++)
+                if (fault_class_cnt[u][w][p] != 0)
+                    printf("Exception: %lld %s %s faults on %s pages\n", fault_class_cnt[u][w][p], src_names[u], acc_names[w], pres_names[p]);
+    printf("Exception: %lld resolved, %lld fixups, %lld fatal\n", fault_resolved_cnt, fault_fixup_cnt, fault_fatal_cnt);
+
+    if (fault_sample_seen > 0) {
+        long long cnt = fault_sample_seen < FAULT_SAMPLE_CNT ? fault_sample_seen : FAULT_SAMPLE_CNT;
+        long long i;
+
+        printf("Exception: fault storm, %lld addresses sampled from %lld:\n", cnt, fault_sample_seen);
+        for (i = 0; i < cnt; i++)
+            printf("  %p\n", fault_samples[i]);
+    }
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -99,6 +182,36 @@ static void kill(struct intr_frame *f) {
     }
 }
 
+/** #Project 3: Page Fault Fast Path - intr-stubs.S의 전용 0x0e 진입점이
+   caller-saved 레지스터만 저장한 부분 프레임으로 호출한다. 폴트가 해결되면
+   0이 아닌 값을 돌려 바로 iretq 하게 하고, 실패하면 다음 폴트로 CR2가
+   덮였을 수 있으므로 복원해 두고 0을 돌려 전체 프레임 완성 후 아래
+   page_fault()로 다시 디스패치되게 한다. */
+uint64_t page_fault_fast(struct intr_frame *f);
+uint64_t page_fault_fast(struct intr_frame *f) {
+    void *fault_addr = (void *)rcr2();
+    bool user = (f->error_code & PF_U) != 0;
+    bool write = (f->error_code & PF_W) != 0;
+    bool not_present = (f->error_code & PF_P) == 0;
+
+    intr_enable();
+
+    /** #Project 3: Fault Triage - 모든 #PF는 이 진입점을 먼저 지나므로
+       분류 적산은 여기 한 번이면 된다. */
+    fault_account(fault_addr, user, write, not_present);
+
+#ifdef VM
+    if (vm_try_handle_fault(f, fault_addr, user, write, not_present)) {
+        page_fault_cnt++;
+        fault_resolved_cnt++;
+        return 1;
+    }
+#endif
+
+    __asm __volatile("movq %0, %%cr2" ::"r"(fault_addr));
+    return 0;
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -132,14 +245,45 @@ static void page_fault(struct intr_frame *f) {
     write = (f->error_code & PF_W) != 0;
     user = (f->error_code & PF_U) != 0;
 
+    /* A kernel access inside the current thread's stack guard page is a
+       kernel stack overflow, caught deterministically by the unmapped
+       page below the stack.  The back-pointer at the bottom of the
+       usable stack page is still intact at this point -- the guard sits
+       below it -- so thread_current() is safe to consult.  Panic
+       distinctly rather than falling through to the generic fault
+       path. */
+    if (!user && not_present) {
+        struct thread *t = thread_current();
+        if (t->kstack != NULL && fault_addr >= t->kstack &&
+            fault_addr < (void *)((uint8_t *)t->kstack + PGSIZE))
+            PANIC("Kernel stack overflow in thread '%s' (fault at %p, rip=%p)", t->name, fault_addr, (void *)f->rip);
+    }
+
 #ifdef VM
     /* For project 3 and later. */
-    if (vm_try_handle_fault(f, fault_addr, user, write, not_present))
+    if (vm_try_handle_fault(f, fault_addr, user, write, not_present)) {
+        fault_resolved_cnt++; /* 분류는 fast 진입점에서 이미 적산됨 */
         return;
+    }
 #endif
 
+    /** #Project 3: User Copy - 커널이 사용자 버퍼를 복사하다(syscall.c의
+       usercopy) 해소되지 않는 폴트를 맞은 경우. 걸려 있는 픽스업 주소로
+       rip을 돌려 복사 루프 밖으로 복귀시키면, 호출자는 남은 바이트 수로
+       실패를 알게 된다. 프로세스를 죽이지 않고 EFAULT로 처리한다. */
+    if (!user) {
+        struct thread *t = thread_current();
+        if (t->usercopy_fixup != NULL) {
+            f->rip = (uint64_t)t->usercopy_fixup;
+            t->usercopy_fixup = NULL;
+            fault_fixup_cnt++;
+            return;
+        }
+    }
+
     /* Count page faults. */
     page_fault_cnt++;
+    fault_fatal_cnt++;
 
     exit(-1); /** Test Case 가 Hardware 수준에서 페이지 폴트를 호출하기 때문에 Test Case 통과를 위해서 exception을 수정해야함. */
 
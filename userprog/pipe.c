@@ -0,0 +1,180 @@
+/* pipe.c: In-kernel pipes.
+ *
+ * A pipe is a single-producer/single-consumer byte ring sized in
+ * pages, modeled on devices/intq.c but built for throughput: the head
+ * index is advanced only by the writer and the tail only by the
+ * reader, so bulk memcpy transfers run with no lock at all.  The lock
+ * and conditions exist purely to sleep and wake when the ring runs
+ * full or empty -- once per blocking transition, never per byte. */
+
+#include "userprog/pipe.h"
+
+#include <string.h>
+
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Ring capacity.  16KB lets a producer stay a full syscall ahead of
+ * its consumer before anyone blocks. */
+#define PIPE_BUF_PAGES 4
+
+struct pipe {
+    uint8_t *buf;               /* Page-sized ring of bytes. */
+    size_t size;                /* Capacity in bytes. */
+    size_t head;                /* Free-running write index; writer only. */
+    size_t tail;                /* Free-running read index; reader only. */
+    int readers;                /* Open read ends. */
+    int writers;                /* Open write ends. */
+    struct lock lock;           /* Guards sleeping/waking only. */
+    struct condition not_empty; /* Readers wait here when empty. */
+    struct condition not_full;  /* Writers wait here when full. */
+};
+
+/* Makes a struct file wrapping one end of PIPE. */
+static struct file *pipe_end_open(struct pipe *pipe, bool writer) {
+    struct file *end = calloc(1, sizeof *end);
+
+    if (end == NULL)
+        return NULL;
+    end->pipe = pipe;
+    end->pipe_writer = writer;
+    if (writer)
+        pipe->writers++;
+    else
+        pipe->readers++;
+    return end;
+}
+
+/* Creates a pipe and its two ends.  Returns true with *READER and
+ * *WRITER set on success, false with nothing allocated on failure. */
+bool pipe_open(struct file **reader, struct file **writer) {
+    struct pipe *pipe = calloc(1, sizeof *pipe);
+
+    if (pipe == NULL)
+        return false;
+    pipe->buf = palloc_get_multiple(PAL_ZERO, PIPE_BUF_PAGES);
+    if (pipe->buf == NULL) {
+        free(pipe);
+        return false;
+    }
+    pipe->size = PIPE_BUF_PAGES * PGSIZE;
+    lock_init(&pipe->lock);
+    cond_init(&pipe->not_empty);
+    cond_init(&pipe->not_full);
+
+    *reader = pipe_end_open(pipe, false);
+    *writer = pipe_end_open(pipe, true);
+    if (*reader == NULL || *writer == NULL) {
+        free(*reader);
+        free(*writer);
+        palloc_free_multiple(pipe->buf, PIPE_BUF_PAGES);
+        free(pipe);
+        return false;
+    }
+    return true;
+}
+
+/* Duplicates pipe END for fork: the new struct file shares the pipe
+ * and direction, and the end count keeps the pipe alive. */
+struct file *pipe_dup(struct file *end) {
+    return pipe_end_open(end->pipe, end->pipe_writer);
+}
+
+/* Drops one WRITER or reader end of PIPE.  The peers are woken so a
+ * blocked reader sees EOF (or a blocked writer a broken pipe); the
+ * last end out frees the pipe. */
+void pipe_release_end(struct pipe *pipe, bool writer) {
+    bool dead;
+
+    lock_acquire(&pipe->lock);
+    if (writer)
+        pipe->writers--;
+    else
+        pipe->readers--;
+    dead = pipe->readers == 0 && pipe->writers == 0;
+    cond_broadcast(&pipe->not_empty, &pipe->lock);
+    cond_broadcast(&pipe->not_full, &pipe->lock);
+    lock_release(&pipe->lock);
+
+    if (dead) {
+        palloc_free_multiple(pipe->buf, PIPE_BUF_PAGES);
+        free(pipe);
+    }
+}
+
+/* Reads up to LENGTH bytes from PIPE into BUFFER.  Blocks only while
+ * the ring is empty and a writer still exists; returns the byte count
+ * (0 is end of file: empty ring, no writers left). */
+int pipe_read(struct pipe *pipe, void *buffer, unsigned length) {
+    uint8_t *buf = buffer;
+    size_t bytes = 0;
+
+    while (bytes < length) {
+        size_t avail = pipe->head - pipe->tail;
+        size_t chunk, ofs;
+
+        if (avail == 0) {
+            /* Return what we have; block only with nothing in hand. */
+            if (bytes > 0 || pipe->writers == 0)
+                break;
+            lock_acquire(&pipe->lock);
+            while (pipe->head == pipe->tail && pipe->writers > 0)
+                cond_wait(&pipe->not_empty, &pipe->lock);
+            lock_release(&pipe->lock);
+            continue;
+        }
+
+        chunk = length - bytes < avail ? length - bytes : avail;
+        ofs = pipe->tail % pipe->size;
+        if (chunk > pipe->size - ofs)
+            chunk = pipe->size - ofs; /* Up to the wrap point. */
+        memcpy(buf + bytes, pipe->buf + ofs, chunk);
+        pipe->tail += chunk;
+        bytes += chunk;
+
+        lock_acquire(&pipe->lock);
+        cond_signal(&pipe->not_full, &pipe->lock);
+        lock_release(&pipe->lock);
+    }
+    return bytes;
+}
+
+/* Writes LENGTH bytes from BUFFER into PIPE.  Blocks only while the
+ * ring is full and a reader still exists; returns the byte count, or
+ * -1 once no reader is left to consume the data. */
+int pipe_write(struct pipe *pipe, const void *buffer, unsigned length) {
+    const uint8_t *buf = buffer;
+    size_t bytes = 0;
+
+    while (bytes < length) {
+        size_t space = pipe->size - (pipe->head - pipe->tail);
+        size_t chunk, ofs;
+
+        if (pipe->readers == 0)
+            return bytes > 0 ? (int)bytes : -1;
+
+        if (space == 0) {
+            lock_acquire(&pipe->lock);
+            while (pipe->head - pipe->tail == pipe->size && pipe->readers > 0)
+                cond_wait(&pipe->not_full, &pipe->lock);
+            lock_release(&pipe->lock);
+            continue;
+        }
+
+        chunk = length - bytes < space ? length - bytes : space;
+        ofs = pipe->head % pipe->size;
+        if (chunk > pipe->size - ofs)
+            chunk = pipe->size - ofs; /* Up to the wrap point. */
+        memcpy(pipe->buf + ofs, buf + bytes, chunk);
+        pipe->head += chunk;
+        bytes += chunk;
+
+        lock_acquire(&pipe->lock);
+        cond_signal(&pipe->not_empty, &pipe->lock);
+        lock_release(&pipe->lock);
+    }
+    return bytes;
+}
@@ -6,29 +6,40 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <syscall-nr.h>
 
+#include "devices/timer.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
+#include "filesys/inode.h"
+#include "lib/kernel/bitmap.h"
 #include "filesys/filesys.h"
 #include "intrinsic.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #include "userprog/process.h"
 
 
 #ifdef VM
+#include "vm/anon.h"
 #include "vm/vm.h"
 #endif
 
 static void process_cleanup(void);
+#ifdef VM
+static void ckpt_lock_init_once(void);
+#endif
 static bool load(const char *file_name, struct intr_frame *if_);
+static void elf_cache_init(void);
 static void initd(void *f_name);
 static void __do_fork(void *);
 
@@ -37,6 +48,70 @@ static void process_init(void) {
     struct thread *current = thread_current();
 }
 
+/** #Project 3: 종료 상태 블록 - 해시/수명 관리 헬퍼 */
+static uint64_t child_status_hash(const struct hash_elem *e, void *aux UNUSED) {
+    return hash_word(hash_entry(e, struct child_status, elem)->tid);
+}
+
+static bool child_status_less(const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+    return hash_entry(a, struct child_status, elem)->tid < hash_entry(b, struct child_status, elem)->tid;
+}
+
+/** 참조 하나를 반납한다. 마지막 참조가 블록을 해제한다. */
+void child_status_release(struct child_status *st) {
+    enum intr_level old_level = intr_disable();
+    int left = --st->ref_cnt;
+    intr_set_level(old_level);
+
+    if (left == 0)
+        free(st);
+}
+
+static void child_status_destructor(struct hash_elem *e, void *aux UNUSED) {
+    child_status_release(hash_entry(e, struct child_status, elem));
+}
+
+/** CHILD의 상태 블록을 만들어 현재 스레드(부모)의 child_hash에 넣는다.
+ *  thread_create에서 호출된다. */
+bool process_attach_child(thread_t *child) {
+    thread_t *parent = thread_current();
+    struct child_status *st;
+
+    if (!parent->child_hash_ready) {
+        if (!hash_init(&parent->child_hash, child_status_hash, child_status_less, NULL))
+            return false;
+        parent->child_hash_ready = true;
+    }
+
+    st = malloc(sizeof *st);
+    if (st == NULL)
+        return false;
+
+    st->tid = child->tid;
+    st->exit_status = 0;
+    st->fork_failed = false;
+    st->ref_cnt = 2;  // 부모 + 자식
+    sema_init(&st->fork_sema, 0);
+    sema_init(&st->wait_sema, 0);
+    hash_insert(&parent->child_hash, &st->elem);
+    child->my_status = st;
+    return true;
+}
+
+/** 현재 스레드의 자식 TID의 상태 블록을 O(1)로 찾는다. */
+static struct child_status *child_status_find(tid_t tid) {
+    thread_t *curr = thread_current();
+    struct child_status key;
+    struct hash_elem *e;
+
+    if (!curr->child_hash_ready)
+        return NULL;
+
+    key.tid = tid;
+    e = hash_find(&curr->child_hash, &key.elem);
+    return e != NULL ? hash_entry(e, struct child_status, elem) : NULL;
+}
+
 /* FILE_NAME에서 로드된 "initd"라는 첫 번째 사용자 영역 프로그램을 시작합니다.
  * 새 스레드는 process_create_initd()가 반환되기 전에 예약될 수 있습니다
  * (심지어 종료될 수도 있음). initd의 스레드 ID를 반환하거나 스레드를 생성할 수
@@ -46,6 +121,13 @@ tid_t process_create_initd(const char *file_name) {
     char *fn_copy;
     tid_t tid;
 
+    /** #Project 3: ELF 헤더 캐시 - 첫 exec 전에 단일 스레드 경로에서 초기화 */
+    elf_cache_init();
+#ifdef VM
+    /** #Project 3: Checkpoint - 같은 단일 스레드 경로에서 락 초기화 */
+    ckpt_lock_init_once();
+#endif
+
     /* FILE_NAME의 사본을 만듭니다.
      * 그렇지 않으면 호출자와 load() 사이에 race가 발생합니다. */
     fn_copy = palloc_get_page(0);
@@ -65,6 +147,9 @@ tid_t process_create_initd(const char *file_name) {
     tid = thread_create(file_name, PRI_DEFAULT, initd, fn_copy);
     if (tid == TID_ERROR)
         palloc_free_page(fn_copy);
+    else
+        /** #Project 3: Group Scheduling - initd가 새 프로세스 트리의 뿌리 */
+        thread_sched_group_detach(tid);
     return tid;
 }
 
@@ -96,11 +181,11 @@ tid_t process_fork(const char *name, struct intr_frame *if_ UNUSED) {
     if (tid == TID_ERROR)
         return TID_ERROR;
 
-    thread_t *child = get_child_process(tid);
+    struct child_status *st = child_status_find(tid);
 
-    sema_down(&child->fork_sema);  // 생성만 해놓고 자식 프로세스가 __do_fork에서 fork_sema를 sema_up 해줄 때까지 대기
+    sema_down(&st->fork_sema);  // 생성만 해놓고 자식 프로세스가 __do_fork에서 fork_sema를 sema_up 해줄 때까지 대기
 
-    if (child->exit_status == TID_ERROR)
+    if (st->fork_failed)
         return TID_ERROR;
 
     return tid;  // 부모 프로세스의 리턴값 : 생성한 자식 프로세스의 tid
@@ -120,6 +205,11 @@ static bool duplicate_pte(uint64_t *pte, void *va, void *aux) {
     if (is_kernel_vaddr(va))
         return true;
 
+    /** #Project 3: vDSO 시간 페이지 - 공유 커널 페이지는 복제 대상이
+     *  아니다. __do_fork가 같은 페이지를 자식에 다시 매핑한다. */
+    if (va == (void *)VDSO_TIME_VADDR)
+        return true;
+
     /* 2. Resolve VA from the parent's page map level 4. */
     parent_page = pml4_get_page(parent->pml4, va);
     if (parent_page == NULL)
@@ -147,6 +237,55 @@ static bool duplicate_pte(uint64_t *pte, void *va, void *aux) {
 }
 #endif
 
+/** #Project 3: fork 가속 - 부모 fd 테이블을 한 번에 복사합니다. 탐색 상한은
+ *  FDCOUNT_LIMIT이 아니라 fd_idx high-water mark이고, dup2로 공유된 파일
+ *  (ref_cnt > 1)만 사전을 거쳐 자식에서도 같은 객체를 공유합니다. 나머지는
+ *  사전 탐색 없이 곧바로 복제됩니다. (fork의 fd는 위치가 독립이어야 하므로
+ *  복제 자체는 남는다; 공유 fd만 참조 수로 해결된다.) */
+static bool process_dup_fdt(struct thread *current, struct thread *parent) {
+    struct dict_elem dup_file_dict[DICTLEN];
+    int dup_idx = 0;
+
+    current->fd_idx = parent->fd_idx;
+    for (int fd = 0; fd < parent->fd_idx; fd++) {
+        struct file *file = parent->fdt[fd];
+        if (file == NULL)
+            continue;
+
+        if (file <= STDERR) {  // 콘솔 sentinel은 값 그대로
+            current->fdt[fd] = file;
+            bitmap_set(current->fd_map, fd, true);
+            continue;
+        }
+
+        struct file *dup = NULL;
+
+        if (file->ref_cnt > 1) {
+            for (int i = 0; i < dup_idx; i++) {
+                if (dup_file_dict[i].key == (uintptr_t)file) {
+                    dup = file_dup_ref((struct file *)dup_file_dict[i].value);  // 자식 쪽 공유 참조 복원
+                    break;
+                }
+            }
+        }
+
+        if (dup == NULL) {
+            dup = file_duplicate(file);
+            if (dup == NULL)
+                return false;
+            if (file->ref_cnt > 1 && dup_idx < DICTLEN) {
+                dup_file_dict[dup_idx].key = (uintptr_t)file;
+                dup_file_dict[dup_idx++].value = (uintptr_t)dup;
+            }
+        }
+
+        current->fdt[fd] = dup;
+        bitmap_set(current->fd_map, fd, true);
+    }
+
+    return true;
+}
+
 /** #Project 2: System Call - 부모의 실행 컨텍스트를 복사하는 스레드 함수입니다.
  *  Hint) parent->tf는 프로세스의 사용자 영역 컨텍스트를 보유하지 않습니다.
  *       즉, process_fork의 두 번째 인수를 이 함수에 전달해야 합니다.
@@ -174,11 +313,24 @@ static void __do_fork(void *aux) {
     supplemental_page_table_init(&current->spt);
     if (!supplemental_page_table_copy(&current->spt, &parent->spt))
         goto error;
+
+    /** #Project 3: sbrk - 힙 경계도 주소 공간의 일부다. */
+    current->heap_start = parent->heap_start;
+    current->heap_break = parent->heap_break;
+
+    /** #Project 3: RSS Limit - 소프트 상주 한도는 상속된다. */
+    current->rss_limit = parent->rss_limit;
 #else
     if (!pml4_for_each(parent->pml4, duplicate_pte, parent))  // Page Table 통째로 복제
         goto error;
 #endif
 
+    /** #Project 3: vDSO 시간 페이지 - SPT에도 pml4 복제에도 실리지 않는
+     *  날 PTE이므로 자식에 직접 다시 매핑한다. */
+    void *vdso = timer_vdso_page();
+    if (vdso != NULL && !pml4_set_page(current->pml4, (void *)VDSO_TIME_VADDR, vdso, false))
+        goto error;
+
     /* TODO: Your code goes here.
      * TODO: Hint) 파일 객체를 복제하려면 include/filesys/file.h에서 `file_duplicate`를 사용하세요.
          이 함수가 부모의 리소스를 성공적으로 복제할 때까지 부모는 fork()에서 반환되어서는 안 됩니다. */
@@ -186,52 +338,441 @@ static void __do_fork(void *aux) {
         goto error;
 
     /** #Project 2: Extend File Descriptor - fd 복제 */
-    struct dict_elem dup_file_dict[DICTLEN];
-    int dup_idx = 0;
+    if (!process_dup_fdt(current, parent))
+        goto error;
+
+    sema_up(&current->my_status->fork_sema);  // fork 프로세스가 정상적으로 완료됐으므로 부모 unblock
+
+    process_init();
+
+    /* Finally, switch to the newly created process. */
+    if (succ)
+        do_iret(&if_);  // 정상 종료 시 자식 Process를 수행하러 감
+
+error:
+    current->my_status->fork_failed = true;  // sema_up 전에 게시해야 부모가 본다
+    sema_up(&current->my_status->fork_sema);  // 복제에 실패했으므로 부모 unblock
+    exit(TID_ERROR);
+}
+
+/** #Project 3: Spawn - __do_spawn에 전달되는 인자 묶음 */
+struct spawn_aux {
+    struct thread *parent; /* fd 테이블 복사 원본 */
+    char *cmd;             /* 커맨드 라인 사본 (palloc 페이지) */
+};
+
+/** #Project 3: Spawn - 부모 주소 공간을 복제하지 않고 fd 테이블만 복사한 뒤
+ *  곧바로 새 실행 파일을 적재하는 스레드 함수입니다. */
+static void __do_spawn(void *aux_) {
+    struct spawn_aux *aux = aux_;
+    struct thread *parent = aux->parent;
+    struct thread *current = thread_current();
+    char *cmd = aux->cmd;
+
+    free(aux);
+
+#ifdef VM
+    supplemental_page_table_init(&current->spt);
+#endif
+    process_init();
+
+    if (parent->fd_idx >= FDCOUNT_LIMIT)
+        goto error;
+
+    /** fd 테이블 복사 - __do_fork와 같은 경로를 쓴다. 주소 공간은 load()가
+     *  새로 만들므로 복제하지 않는다. */
+    if (!process_dup_fdt(current, parent))
+        goto error;
+
+    sema_up(&current->my_status->fork_sema);  // 부모 리소스 복사가 끝났으므로 부모 unblock
+
+    if (process_exec(cmd) < 0)
+        exit(TID_ERROR);
+    NOT_REACHED();
+
+error:
+    palloc_free_page(cmd);
+    current->my_status->fork_failed = true;  // sema_up 전에 게시해야 부모가 본다
+    sema_up(&current->my_status->fork_sema);
+    exit(TID_ERROR);
+}
+
+/** #Project 3: Spawn - fork + exec 결합. supplemental_page_table_copy를 거치지
+ *  않으므로 exec이 바로 버릴 부모 주소 공간 사본을 만들지 않습니다. 자식 스레드
+ *  ID를 반환하거나 실패 시 TID_ERROR를 반환합니다. */
+tid_t process_spawn(const char *cmd_line) {
+    thread_t *curr = thread_current();
+
+    struct spawn_aux *aux = malloc(sizeof *aux);
+    if (aux == NULL)
+        return TID_ERROR;
+
+    aux->parent = curr;
+    aux->cmd = palloc_get_page(0);
+    if (aux->cmd == NULL) {
+        free(aux);
+        return TID_ERROR;
+    }
+    strlcpy(aux->cmd, cmd_line, PGSIZE);
+
+    /* 스레드 이름은 프로그램 이름만 사용한다. */
+    char name[16];
+    strlcpy(name, cmd_line, sizeof name);
+    char *ptr;
+    strtok_r(name, " ", &ptr);
+
+    tid_t tid = thread_create(name, PRI_DEFAULT, __do_spawn, aux);
+    if (tid == TID_ERROR) {
+        palloc_free_page(aux->cmd);
+        free(aux);
+        return TID_ERROR;
+    }
+
+    /** #Project 3: Group Scheduling - spawn된 프로세스는 새 트리의 뿌리가
+     *  되어 별도 그룹으로 과금된다(fork 자손은 이 그룹을 물려받는다). */
+    thread_sched_group_detach(tid);
+
+    struct child_status *st = child_status_find(tid);
+
+    sema_down(&st->fork_sema);  // fd 테이블 복사가 끝날 때까지 대기
+
+    if (st->fork_failed)
+        return TID_ERROR;
+
+    return tid;
+}
+
+#ifdef VM
+/** #Project 3: Checkpoint - 프로세스 이미지 직렬화 포맷. 메타데이터는
+ *  스왑 디스크 꼭대기의 예약 구역(vm/anon.h의 CKPT_META_SLOTS)에,
+ *  페이지 내용은 일반 스왑 슬롯에 들어간다. 구역 레이아웃: 섹터 0 헤더,
+ *  섹터 1 fd 레코드, 섹터 2부터 페이지 레코드. 모든 페이지는 직렬화
+ *  전에 상주시켜 내용 그대로 떠내므로, 복원된 이미지는 실행 파일이나
+ *  지연 로드 문맥 없이도 완결적이다. 파이프와 공유 메모리 세그먼트는
+ *  재부팅을 건널 수 없으므로 체크포인트가 거부된다. */
+#define CKPT_MAGIC 0x434b5054 /* "CKPT" */
+#define CKPT_META_SECTORS (CKPT_META_SLOTS * (PGSIZE / DISK_SECTOR_SIZE))
+#define CKPT_FD_MAX (DISK_SECTOR_SIZE / sizeof(struct ckpt_fd))
+#define CKPT_PAGE_MAX ((CKPT_META_SECTORS - 2) * (DISK_SECTOR_SIZE / sizeof(struct ckpt_page)))
+
+struct ckpt_header {
+    uint32_t magic;      /* CKPT_MAGIC이면 유효한 이미지 */
+    uint32_t page_cnt;   /* 페이지 레코드 수 */
+    uint32_t fd_cnt;     /* fd 레코드 수 */
+    uint32_t runn_sector; /* 실행 파일 inode 섹터, 없으면 0 */
+    uint64_t heap_start;
+    uint64_t heap_break;
+    uint64_t rss_limit;
+    char name[16];       /* 스레드 이름 */
+    struct intr_frame tf; /* 재개 지점의 유저 레지스터 */
+};
+
+struct ckpt_fd {
+    int32_t fd;
+    uint32_t inode_sector; /* 0이면 콘솔 sentinel */
+    uint32_t pos;
+    uint32_t flags; /* bit 0: deny_write, 상위 비트: sentinel 값 */
+};
+
+struct ckpt_page {
+    uint64_t va;
+    uint32_t slot;     /* 내용이 든 스왑 슬롯 */
+    uint32_t writable;
+};
+
+/* 메타 구역 스테이징 버퍼. 동시 checkpoint 호출은 ckpt_lock으로
+ * 직렬화한다. restore는 부팅 경로(유저 프로세스 시작 전)라 락 없이
+ * 단독으로 쓴다. */
+static uint8_t ckpt_meta[CKPT_META_SECTORS][DISK_SECTOR_SIZE];
+static struct lock ckpt_lock;
+static bool ckpt_lock_ready;
+
+static void ckpt_lock_init_once(void) {
+    /* 부팅 경로(단일 스레드)에서만 불리므로 경쟁이 없다. */
+    if (!ckpt_lock_ready) {
+        lock_init(&ckpt_lock);
+        ckpt_lock_ready = true;
+    }
+}
+
+/** #Project 3: Checkpoint - 현재 프로세스 이미지를 스왑 디스크에 직렬화
+ *  한다. SPT를 정렬 순회(vm_radix_next)로 걸으며 페이지마다 고정-쓰기-
+ *  해제를 반복하고, 페이지 내용은 멀티 섹터 쓰기(swap_slot_write)로
+ *  나간다. 저장한 쪽에는 0이 반환되고, 재부팅 후 'restore' 액션으로
+ *  깨어난 쪽은 1이 반환된 것처럼 재개된다 (fork 관례). 실패 시 -1. */
+int process_checkpoint(void) {
+    thread_t *curr = thread_current();
+
+    if (swap_ckpt_meta_start() == 0 || !ckpt_lock_ready)
+        return -1;
+
+    /* fork와 같은 트릭: 유저 레지스터는 커널 스택 꼭대기의 intr_frame에 있다. */
+    struct intr_frame *f = (pg_round_up(rrsp()) - sizeof(struct intr_frame));
+
+    lock_acquire(&ckpt_lock);
+    memset(ckpt_meta, 0, sizeof ckpt_meta);
+
+    struct ckpt_header *h = (struct ckpt_header *)ckpt_meta[0];
+    struct ckpt_fd *fds = (struct ckpt_fd *)ckpt_meta[1];
+    struct ckpt_page *recs = (struct ckpt_page *)ckpt_meta[2];
+    uint32_t cnt = 0, fdc = 0;
+
+    /* fd 테이블: 콘솔 sentinel은 값만, 일반 파일은 inode 섹터 + 오프셋.
+     * 파이프는 재부팅을 건널 수 없다. */
+    for (int fd = 0; fd < curr->fd_idx; fd++) {
+        struct file *file = curr->fdt[fd];
 
-    current->fd_idx = parent->fd_idx;  // fdt 및 idx 복제
-    struct file *file;
-    for (int fd = 0; fd < FDCOUNT_LIMIT; fd++) {
-        file = parent->fdt[fd];
         if (file == NULL)
             continue;
+        if (fdc >= CKPT_FD_MAX)
+            goto fail;
+
+        struct ckpt_fd *r = &fds[fdc];
+
+        r->fd = fd;
+        if (file <= STDERR) {
+            r->inode_sector = 0;
+            r->flags = (uint32_t)(uintptr_t)file << 1;
+        } else {
+            if (file->pipe != NULL || file_get_inode(file) == NULL)
+                goto fail;
+            r->inode_sector = inode_get_inumber(file_get_inode(file));
+            r->pos = file_tell(file);
+            r->flags = file->deny_write ? 1 : 0;
+        }
+        fdc++;
+    }
 
-        bool is_exist = false;
+    /* 주소 공간: 페이지마다 상주·고정시킨 뒤 스왑 슬롯으로 떠낸다. */
+    uint64_t key = 0;
+    struct page *page;
 
-        for (int i = 0; i <= dup_idx; i++) {
-            if (dup_file_dict[i].key == file) {
-                current->fdt[fd] = file_duplicate(file);
-                is_exist = true;
-                break;
-            }
+    while ((page = vm_radix_next(&curr->spt.spt_map, key, &key)) != NULL) {
+        key++;
+        if (cnt >= CKPT_PAGE_MAX)
+            goto fail;
+        if (!vm_pin_buffer(page->va, PGSIZE, false))
+            goto fail;
+
+        size_t slot = swap_slot_alloc();
+
+        if (slot == ANON_NO_SLOT) {
+            vm_unpin_buffer(page->va, PGSIZE);
+            goto fail;
         }
+        swap_slot_write(slot, page->frame->kva);
+        vm_unpin_buffer(page->va, PGSIZE);
 
-        if (is_exist)
-            continue;
+        recs[cnt].va = (uint64_t)page->va;
+        recs[cnt].slot = slot;
+        recs[cnt].writable = page->writable;
+        cnt++;
+    }
 
-        if (file > STDERR)
-            current->fdt[fd] = file_duplicate(file);
-        else
-            current->fdt[fd] = file;
+    h->magic = CKPT_MAGIC;
+    h->page_cnt = cnt;
+    h->fd_cnt = fdc;
+    h->runn_sector = curr->runn_file != NULL ? inode_get_inumber(file_get_inode(curr->runn_file)) : 0;
+    h->heap_start = (uint64_t)curr->heap_start;
+    h->heap_break = (uint64_t)curr->heap_break;
+    h->rss_limit = curr->rss_limit;
+    strlcpy(h->name, curr->name, sizeof h->name);
+    memcpy(&h->tf, f, sizeof h->tf);
+
+    /* 레코드 섹터를 먼저, 헤더(magic 포함)를 마지막에 쓴다. 중간에
+     *  전원이 나가면 이미지는 그냥 없는 것이 된다. */
+    swap_meta_write(1, CKPT_META_SECTORS - 1, ckpt_meta[1]);
+    swap_meta_write(0, 1, ckpt_meta[0]);
+    lock_release(&ckpt_lock);
+    return 0;
+
+fail:
+    for (uint32_t i = 0; i < cnt; i++)
+        swap_slot_free(recs[i].slot);
+    lock_release(&ckpt_lock);
+    return -1;
+}
+
+/** #Project 3: Checkpoint - 이미지를 되살리는 스레드 함수. __do_fork의
+ *  뼈대를 따르되 복제 원본이 부모가 아니라 스왑 디스크의 레코드다. */
+static void restore_main(void *aux UNUSED) {
+    struct ckpt_header *h = (struct ckpt_header *)ckpt_meta[0];
+    struct ckpt_fd *fds = (struct ckpt_fd *)ckpt_meta[1];
+    struct ckpt_page *recs = (struct ckpt_page *)ckpt_meta[2];
+    thread_t *curr = thread_current();
+
+    supplemental_page_table_init(&curr->spt);
+    process_init();
+
+    curr->pml4 = pml4_create();
+    if (curr->pml4 == NULL)
+        PANIC("restore: out of memory");
+    process_activate(curr);
+
+    /** #Project 3: vDSO 시간 페이지 - load()와 같은 매핑 */
+    void *vdso = timer_vdso_page();
+    if (vdso != NULL)
+        pml4_set_page(curr->pml4, (void *)VDSO_TIME_VADDR, vdso, false);
+
+    curr->heap_start = (void *)h->heap_start;
+    curr->heap_break = (void *)h->heap_break;
+    curr->rss_limit = h->rss_limit;
+
+    /* 페이지 복원: 익명 페이지로 재구성하고 슬롯은 읽는 즉시 반납한다. */
+    for (uint32_t i = 0; i < h->page_cnt; i++) {
+        void *va = (void *)recs[i].va;
+
+        if (!vm_alloc_page(VM_ANON, va, recs[i].writable) || !vm_claim_page(va))
+            PANIC("restore: cannot rebuild page at %p", va);
+
+        struct page *page = spt_find_page(&curr->spt, va);
 
-        if (dup_idx < DICTLEN) {
-            dup_file_dict[dup_idx].key = file;
-            dup_file_dict[dup_idx++].value = current->fdt[fd];
+        swap_slot_read(recs[i].slot, page->frame->kva);
+        swap_slot_free(recs[i].slot);
+    }
+
+    /* fd 테이블 복원 */
+    for (uint32_t i = 0; i < h->fd_cnt; i++) {
+        struct ckpt_fd *r = &fds[i];
+        struct file *file;
+
+        if (r->inode_sector == 0) {
+            file = (struct file *)(uintptr_t)(r->flags >> 1);
+        } else {
+            file = file_open(inode_open(r->inode_sector));
+            if (file == NULL)
+                PANIC("restore: lost file behind fd %d", r->fd);
+            file_seek(file, r->pos);
+            if (r->flags & 1)
+                file_deny_write(file);
         }
-        /** -------------------------------------------------------------- */
+        curr->fdt[r->fd] = file;
+        bitmap_set(curr->fd_map, r->fd, true);
+        if (r->fd >= curr->fd_idx)
+            curr->fd_idx = r->fd + 1;
     }
 
-    sema_up(&current->fork_sema);  // fork 프로세스가 정상적으로 완료됐으므로 현재 fork용 sema unblock
+    if (h->runn_sector != 0) {
+        curr->runn_file = file_open(inode_open(h->runn_sector));
+        if (curr->runn_file != NULL)
+            file_deny_write(curr->runn_file);
+    }
 
-    process_init();
+    /* 저장 시점의 레지스터로 복귀. 복원된 쪽은 checkpoint()가 1을
+     *  반환한 것으로 본다 (fork 관례). */
+    struct intr_frame if_;
 
-    /* Finally, switch to the newly created process. */
-    if (succ)
-        do_iret(&if_);  // 정상 종료 시 자식 Process를 수행하러 감
+    memcpy(&if_, &h->tf, sizeof if_);
+    if_.R.rax = 1;
+    do_iret(&if_);
+    NOT_REACHED();
+}
 
-error:
-    sema_up(&current->fork_sema);  // 복제에 실패했으므로 현재 fork용 sema unblock
-    exit(TID_ERROR);
+/** #Project 3: Checkpoint - 부팅 시 'restore' 액션 진입점. 유효한 헤더가
+ *  있으면 이미지 슬롯을 먼저 점유하고(복원 중 스왑아웃과 충돌 방지),
+ *  디스크의 헤더를 무효화한 뒤(이미지는 한 번만 소비된다) 복원 스레드를
+ *  만들어 tid를 반환한다. 이미지가 없으면 TID_ERROR. */
+tid_t process_restore(void) {
+    ckpt_lock_init_once();
+
+    if (swap_ckpt_meta_start() == 0)
+        return TID_ERROR;
+
+    swap_meta_read(0, 1, ckpt_meta[0]);
+
+    struct ckpt_header *h = (struct ckpt_header *)ckpt_meta[0];
+
+    if (h->magic != CKPT_MAGIC)
+        return TID_ERROR;
+    swap_meta_read(1, CKPT_META_SECTORS - 1, ckpt_meta[1]);
+
+    struct ckpt_page *recs = (struct ckpt_page *)ckpt_meta[2];
+
+    for (uint32_t i = 0; i < h->page_cnt; i++)
+        if (!swap_slot_mark(recs[i].slot))
+            PANIC("restore: image slot %u already taken", recs[i].slot);
+
+    /* 디스크의 헤더만 무효화한다. 메모리 사본으로 복원을 계속한다. */
+    static uint8_t zero_sec[DISK_SECTOR_SIZE];
+    swap_meta_write(0, 1, zero_sec);
+
+    tid_t tid = thread_create(h->name, PRI_DEFAULT, restore_main, NULL);
+
+    if (tid == TID_ERROR)
+        return TID_ERROR;
+    thread_sched_group_detach(tid);
+    return tid;
+}
+#endif
+
+/** #Project 3: Exec Prefetch - 최근 exec 대상의 연쇄(어떤 바이너리 다음에
+ *  어떤 바이너리가 실행됐는지)를 기록해 두고, 같은 바이너리가 다시 exec
+ *  되면 지난번 후속 바이너리의 앞부분(ELF 헤더 + 첫 text 섹터들)을 디스크
+ *  요청 큐로 미리 읽어 둔다. 셸/테스트 하니스처럼 같은 순서로 exec을
+ *  반복하는 워크로드에서 다음 exec의 콜드 스타트 헤더 읽기가 현재
+ *  프로세스 셋업과 겹쳐져 가려진다. 예측이 빗나가도 버퍼 캐시에 섹터 몇
+ *  개가 더 올라올 뿐이다. */
+#define EXEC_CHAIN_LEN 8
+
+struct exec_chain_entry {
+    char name[16]; /* exec된 프로그램 이름 */
+    char next[16]; /* 지난번에 그 다음으로 exec된 프로그램 ("" = 미정) */
+};
+
+static struct exec_chain_entry exec_chain[EXEC_CHAIN_LEN];
+static int exec_chain_clock;  // round-robin 교체 지점
+static char exec_chain_last[16];
+static struct lock exec_chain_lock;
+
+/** 연쇄를 갱신하고, CMD의 프로그램에 대해 기억해 둔 후속 바이너리 이름을
+ *  PRED에 담아 준다. 후속이 없으면 PRED는 빈 문자열. */
+static void exec_chain_update(const char *cmd, char pred[16]) {
+    char name[16];
+
+    strlcpy(name, cmd, sizeof name);
+    char *space = strchr(name, ' ');
+    if (space != NULL)
+        *space = '\0';
+
+    pred[0] = '\0';
+
+    lock_acquire(&exec_chain_lock);
+
+    struct exec_chain_entry *self = NULL;
+    for (int i = 0; i < EXEC_CHAIN_LEN; i++) {
+        struct exec_chain_entry *ce = &exec_chain[i];
+        if (ce->name[0] != '\0' && !strcmp(ce->name, exec_chain_last))
+            strlcpy(ce->next, name, sizeof ce->next);  // 직전 exec의 후속은 나
+        if (ce->name[0] != '\0' && !strcmp(ce->name, name))
+            self = ce;
+    }
+
+    if (self == NULL) {
+        self = &exec_chain[exec_chain_clock];
+        exec_chain_clock = (exec_chain_clock + 1) % EXEC_CHAIN_LEN;
+        strlcpy(self->name, name, sizeof self->name);
+        self->next[0] = '\0';
+    }
+    strlcpy(pred, self->next, 16);
+    strlcpy(exec_chain_last, name, sizeof exec_chain_last);
+
+    lock_release(&exec_chain_lock);
+}
+
+/** 예측된 다음 바이너리의 머리 부분을 비동기로 버퍼 캐시에 올린다. */
+static void exec_prefetch(const char *pred) {
+    if (pred[0] == '\0')
+        return;
+
+    struct file *file = filesys_open(pred);
+    if (file == NULL)
+        return;
+
+    /* ELF 헤더 + 첫 text 페이지 두 장 몫. 읽기는 요청 큐에 적재만 하고
+     * 돌아오므로 현재 exec의 셋업과 겹쳐 진행된다. */
+    inode_readahead(file_get_inode(file), 0, PGSIZE / DISK_SECTOR_SIZE);
+    inode_readahead(file_get_inode(file), PGSIZE, PGSIZE / DISK_SECTOR_SIZE);
+    file_close(file);
 }
 
 /* Switch the current execution context to the f_name.
@@ -240,6 +781,16 @@ int process_exec(void *f_name) {
     char *file_name = f_name;
     bool success;
 
+    /** #Project 3: Zero-copy Exec - 토큰화 전에 명령행 전체 길이를 잡아 둔다 */
+    size_t cmd_len = strlen(file_name) + 1;
+
+    /** #Project 3: Exec Prefetch - 다음에 올 법한 바이너리의 머리를 지금
+     *  요청 큐에 적재해 두면, 이 exec의 주소 공간 셋업과 디스크 읽기가
+     *  겹친다. */
+    char pred[16];
+    exec_chain_update(file_name, pred);
+    exec_prefetch(pred);
+
     /* 스레드 구조에서는 intr_frame을 사용할 수 없습니다.
      * 현재 쓰레드가 재스케줄 되면 실행 정보를 멤버에게 저장하기 때문입니다. */
     struct intr_frame if_;
@@ -250,13 +801,12 @@ int process_exec(void *f_name) {
     /* We first kill the current context */
     process_cleanup();
 
-    /** #Project 2: Command Line Parsing - 문자열 분리 */
-    char *ptr, *arg;
-    int argc = 0;
-    char *argv[64];
-
-    for (arg = strtok_r(file_name, " ", &ptr); arg != NULL; arg = strtok_r(NULL, " ", &ptr))
-        argv[argc++] = arg;
+    /** #Project 3: Zero-copy Exec - load에는 프로그램 이름만 필요하므로 첫
+     *  공백만 NUL로 바꾼다. 나머지 토큰화는 argument_stack이 스택 페이지에
+     *  올린 사본 위에서 한 번에 한다. */
+    char *space = strchr(file_name, ' ');
+    if (space != NULL)
+        *space = '\0';
 
     /* And then load the binary */
     success = load(file_name, &if_);
@@ -265,7 +815,13 @@ int process_exec(void *f_name) {
     if (!success)
         return -1;
 
-    argument_stack(argv, argc, &if_);
+    if (space != NULL)
+        *space = ' ';  // 스택 이미지에는 원본 명령행이 통째로 올라간다
+
+    if (!argument_stack(file_name, cmd_len, &if_)) {
+        palloc_free_page(file_name);
+        return -1;
+    }
 
     palloc_free_page(file_name);
 
@@ -285,16 +841,18 @@ int process_exec(void *f_name) {
 int process_wait(tid_t child_tid UNUSED) {
     /* XXX: Hint) process_wait(initd)인 경우 pintos가 종료됩니다. process_wait를 구현하기
        전에 여기에 무한 루프를 추가하는 것이 좋습니다. */
-    thread_t *child = get_child_process(child_tid);
-    if (child == NULL)
+    thread_t *curr = thread_current();
+    struct child_status *st = child_status_find(child_tid);
+    if (st == NULL)  // 자식이 아니거나 이미 wait함
         return -1;
 
-    sema_down(&child->wait_sema);  // 자식 프로세스가 종료될 때 까지 대기.
+    sema_down(&st->wait_sema);  // 자식 프로세스가 종료될 때 까지 대기.
 
-    int exit_status = child->exit_status;
-    list_remove(&child->child_elem);
+    int exit_status = st->exit_status;
 
-    sema_up(&child->exit_sema);  // 자식 프로세스가 죽을 수 있도록 signal
+    /* 같은 tid를 두 번 wait할 수 없도록 해시에서 빼고 참조를 반납한다. */
+    hash_delete(&curr->child_hash, &st->elem);
+    child_status_release(st);
 
     return exit_status;
 }
@@ -313,15 +871,104 @@ void process_exit(void) {
     file_close(curr->runn_file);  // 현재 프로세스가 실행중인 파일 종료
 
     palloc_free_multiple(curr->fdt, FDT_PAGES);
+    bitmap_destroy(curr->fd_map);
+    curr->fd_map = NULL;
+
+    /** #Project 3: Syscall Profile - 종료 메시지 곁에 프로파일을 덤프한다. */
+    if (curr->syscall_prof != NULL) {
+        struct syscall_prof *prof = curr->syscall_prof;
+
+        for (int i = 0; i < SYS_CNT; i++)
+            if (prof->cnt[i] > 0)
+                printf("%s: syscall %d: %llu calls, %llu cycles\n", curr->name, i,
+                       (unsigned long long)prof->cnt[i], (unsigned long long)prof->cycles[i]);
+
+        free(prof);
+        curr->syscall_prof = NULL;
+    }
 
     process_cleanup();
 
-    sema_up(&curr->wait_sema);  // 자식 프로세스가 종료될 때까지 대기하는 부모에게 signal
+    /** #Project 3: 종료 상태 블록 - 자식들의 블록 참조를 반납한다. 살아 있는
+     *  자식은 고아가 되어 자기 참조만으로 산다. */
+    if (curr->child_hash_ready) {
+        hash_destroy(&curr->child_hash, child_status_destructor);
+        curr->child_hash_ready = false;
+    }
 
-    sema_down(&curr->exit_sema);  // 부모 프로세스가 종료될 떄까지 대기
+    /** 종료 상태를 게시하고 부모를 깨운다. 이 스레드 페이지는 스케줄러가
+     *  즉시 반납한다 - 좀비가 4KB를 쥐고 부모를 기다리지 않는다. */
+    struct child_status *st = curr->my_status;
+    if (st != NULL) {
+        st->exit_status = curr->exit_status;
+        curr->my_status = NULL;
+        sema_up(&st->wait_sema);
+        child_status_release(st);
+    }
 }
 
 /* Free the current process's resources. */
+/** #Project 3: Process Arena - 프로세스 수명이 같은 작은 커널 객체
+ *  (lazy-load container 등) 전용 범프 할당자. palloc 페이지를 체인으로
+ *  이어 포인터 증가만으로 할당하고, 종료 시 process_cleanup()이 페이지째
+ *  반납하므로 전역 malloc 디스크립터가 프로세스 생성/소멸마다 경합
+ *  지점이 되지 않는다. 중간 반납 객체는 재활용 리스트로 돌아가며,
+ *  리스트 머리에 기록해 둔 크기가 맞지 않으면 그냥 범프한다. */
+#define ARENA_ALIGN 16
+
+struct arena_freeobj {
+    size_t size;                /* 반납 당시의 (올림된) 크기 */
+    struct arena_freeobj *next; /* 다음 재활용 객체 */
+};
+
+void *process_arena_alloc(size_t size) {
+    struct thread *curr = thread_current();
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ASSERT(size <= PGSIZE - ARENA_ALIGN);
+
+    struct arena_freeobj *fo = curr->arena_free;
+    if (fo != NULL && fo->size >= size) {
+        curr->arena_free = fo->next;
+        return fo;
+    }
+
+    if (curr->arena_chunks == NULL || curr->arena_used + size > PGSIZE) {
+        void *page = palloc_get_page(0);
+        if (page == NULL)
+            return NULL;
+        *(void **)page = curr->arena_chunks;
+        curr->arena_chunks = page;
+        curr->arena_used = ARENA_ALIGN;  // 체인 포인터 워드를 건너뛰고 정렬 유지
+    }
+
+    void *p = (uint8_t *)curr->arena_chunks + curr->arena_used;
+    curr->arena_used += size;
+    return p;
+}
+
+void process_arena_free(void *p, size_t size) {
+    struct thread *curr = thread_current();
+    struct arena_freeobj *fo = p;
+
+    fo->size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    fo->next = curr->arena_free;
+    curr->arena_free = fo;
+}
+
+/** #Project 3: Process Arena - 아레나 페이지를 통째로 반납한다. */
+static void process_arena_release(void) {
+    struct thread *curr = thread_current();
+
+    while (curr->arena_chunks != NULL) {
+        void *next = *(void **)curr->arena_chunks;
+        palloc_free_page(curr->arena_chunks);
+        curr->arena_chunks = next;
+    }
+    curr->arena_used = 0;
+    curr->arena_free = NULL;
+}
+
 static void process_cleanup(void) {
     struct thread *curr = thread_current();
 
@@ -334,6 +981,11 @@ static void process_cleanup(void) {
      * to the kernel-only page directory. */
     pml4 = curr->pml4;
     if (pml4 != NULL) {
+        /** #Project 3: vDSO 시간 페이지 - 공유 커널 페이지가 프레임 해제
+         *  경로에 휩쓸리지 않도록 매핑만 먼저 걷어낸다. */
+        if (timer_vdso_page() != NULL)
+            pml4_clear_page(pml4, (void *)VDSO_TIME_VADDR);
+
         /* Correct ordering here is crucial.  We must set
          * cur->pagedir to NULL before switching page directories,
          * so that a timer interrupt can't switch back to the
@@ -345,6 +997,10 @@ static void process_cleanup(void) {
         pml4_activate(NULL);
         pml4_destroy(pml4);
     }
+
+    /** #Project 3: Process Arena - SPT 정리가 끝났으니 컨테이너가 담긴
+     *  아레나 페이지를 통째로 반납한다. */
+    process_arena_release();
 }
 
 /* Sets up the CPU for running user code in the nest thread.
@@ -414,6 +1070,89 @@ static bool setup_stack(struct intr_frame *if_);
 static bool validate_segment(const struct Phdr *, struct file *);
 static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t read_bytes, uint32_t zero_bytes, bool writable);
 
+/** #Project 3: ELF 헤더 캐시 - 같은 실행 파일을 반복 exec할 때 헤더 I/O와
+ *  검증을 건너뛴다. 키는 inode 포인터다. 파일시스템이 섹터당 inode 객체를
+ *  공유하고, 캐시가 reopen 참조를 쥐고 있어 엔트리가 살아 있는 동안
+ *  포인터가 재사용되지 않는다. 조회는 lock 아래에서 사본을 만들어 주므로
+ *  교체와 사용이 경합하지 않는다. */
+#define ELF_CACHE_LEN 8
+
+struct elf_cache_entry {
+    struct inode *inode; /* 키; 캐시 소유의 reopen 참조 */
+    struct ELF ehdr;
+    struct Phdr *phdrs;  /* 검증까지 끝난 program header 배열 */
+    int phnum;
+};
+
+static struct elf_cache_entry elf_cache[ELF_CACHE_LEN];
+static int elf_cache_next;  // round-robin 교체 지점
+static struct lock elf_cache_lock;
+static bool elf_cache_ready;
+
+static void elf_cache_init(void) {
+    if (!elf_cache_ready) {
+        lock_init(&elf_cache_lock);
+        /** #Project 3: Exec Prefetch - 연쇄 기록 lock도 같은 단일 스레드
+         *  경로에서 초기화한다. */
+        lock_init(&exec_chain_lock);
+        elf_cache_ready = true;
+    }
+}
+
+/** 캐시 적중 시 EHDR/PHDRS/PHNUM을 사본으로 채우고 true를 반환한다.
+ *  PHDRS는 호출자가 free해야 한다. */
+static bool elf_cache_lookup(struct inode *inode, struct ELF *ehdr, struct Phdr **phdrs, int *phnum) {
+    bool hit = false;
+
+    lock_acquire(&elf_cache_lock);
+    for (int i = 0; i < ELF_CACHE_LEN; i++) {
+        struct elf_cache_entry *ce = &elf_cache[i];
+
+        if (ce->inode != inode)
+            continue;
+
+        *phdrs = malloc(ce->phnum * sizeof **phdrs);
+        if (*phdrs != NULL) {
+            memcpy(*phdrs, ce->phdrs, ce->phnum * sizeof **phdrs);
+            *ehdr = ce->ehdr;
+            *phnum = ce->phnum;
+            hit = true;
+        }
+        break;
+    }
+    lock_release(&elf_cache_lock);
+    return hit;
+}
+
+/** 성공적으로 로드된 바이너리의 헤더를 캐시에 넣는다. PHDRS의 소유권을
+ *  가져가며, 저장하지 못하면 그 자리에서 해제한다. */
+static void elf_cache_insert(struct inode *inode, const struct ELF *ehdr, struct Phdr *phdrs, int phnum) {
+    struct elf_cache_entry *ce;
+
+    lock_acquire(&elf_cache_lock);
+    for (int i = 0; i < ELF_CACHE_LEN; i++) {
+        if (elf_cache[i].inode == inode) {  // 경쟁 exec이 먼저 넣음
+            lock_release(&elf_cache_lock);
+            free(phdrs);
+            return;
+        }
+    }
+
+    ce = &elf_cache[elf_cache_next];
+    elf_cache_next = (elf_cache_next + 1) % ELF_CACHE_LEN;
+
+    if (ce->inode != NULL) {
+        inode_close(ce->inode);
+        free(ce->phdrs);
+    }
+
+    ce->inode = inode_reopen(inode);
+    ce->ehdr = *ehdr;
+    ce->phdrs = phdrs;
+    ce->phnum = phnum;
+    lock_release(&elf_cache_lock);
+}
+
 /* Loads an ELF executable from FILE_NAME into the current thread.
  * Stores the executable's entry point into *RIP
  * and its initial stack pointer into *RSP.
@@ -422,6 +1161,9 @@ static bool load(const char *file_name, struct intr_frame *if_) {
     struct thread *t = thread_current();
     struct ELF ehdr;
     struct file *file = NULL;
+    struct Phdr *phdrs = NULL;
+    int phnum = 0;
+    bool validated = false;  // 캐시 적중: 헤더 I/O와 검증 생략
     off_t file_ofs;
     bool success = false;
     int i;
@@ -443,25 +1185,37 @@ static bool load(const char *file_name, struct intr_frame *if_) {
     t->runn_file = file;
     file_deny_write(file); /** #Project 2: Denying Writes to Executables */
 
-    /* Read and verify executable header. */
-    if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E  // amd64
-        || ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024) {
-        printf("load: %s: error loading executable\n", file_name);
-        goto done;
-    }
+    /** #Project 3: ELF 헤더 캐시 - 적중하면 검증까지 끝난 사본을 받는다. */
+    validated = elf_cache_lookup(file_get_inode(file), &ehdr, &phdrs, &phnum);
 
-    /* Read program headers. */
-    file_ofs = ehdr.e_phoff;
-    for (i = 0; i < ehdr.e_phnum; i++) {
-        struct Phdr phdr;
-
-        if (file_ofs < 0 || file_ofs > file_length(file))
+    if (!validated) {
+        /* Read and verify executable header. */
+        if (file_read(file, &ehdr, sizeof ehdr) != sizeof ehdr || memcmp(ehdr.e_ident, "\177ELF\2\1\1", 7) || ehdr.e_type != 2 || ehdr.e_machine != 0x3E  // amd64
+            || ehdr.e_version != 1 || ehdr.e_phentsize != sizeof(struct Phdr) || ehdr.e_phnum > 1024) {
+            printf("load: %s: error loading executable\n", file_name);
             goto done;
-        file_seek(file, file_ofs);
+        }
 
-        if (file_read(file, &phdr, sizeof phdr) != sizeof phdr)
+        /* Read program headers. */
+        phnum = ehdr.e_phnum;
+        phdrs = malloc(phnum * sizeof *phdrs);
+        if (phdrs == NULL)
             goto done;
-        file_ofs += sizeof phdr;
+
+        file_ofs = ehdr.e_phoff;
+        for (i = 0; i < phnum; i++) {
+            if (file_ofs < 0 || file_ofs > file_length(file))
+                goto done;
+
+            if (file_read_at(file, &phdrs[i], sizeof *phdrs, file_ofs) != sizeof *phdrs)
+                goto done;
+            file_ofs += sizeof *phdrs;
+        }
+    }
+
+    for (i = 0; i < phnum; i++) {
+        struct Phdr phdr = phdrs[i];
+
         switch (phdr.p_type) {
             case PT_NULL:
             case PT_NOTE:
@@ -475,7 +1229,7 @@ static bool load(const char *file_name, struct intr_frame *if_) {
             case PT_SHLIB:
                 goto done;
             case PT_LOAD:
-                if (validate_segment(&phdr, file)) {
+                if (validated || validate_segment(&phdr, file)) {
                     bool writable = (phdr.p_flags & PF_W) != 0;
                     uint64_t file_page = phdr.p_offset & ~PGMASK;
                     uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
@@ -494,6 +1248,13 @@ static bool load(const char *file_name, struct intr_frame *if_) {
                     }
                     if (!load_segment(file, file_page, (void *)mem_page, read_bytes, zero_bytes, writable))
                         goto done;
+
+#ifdef VM
+                    /** #Project 3: sbrk - 힙은 가장 높은 세그먼트 바로 뒤에서 시작한다. */
+                    uint64_t seg_end = mem_page + ROUND_UP(page_offset + phdr.p_memsz, PGSIZE);
+                    if ((void *)seg_end > t->heap_start)
+                        t->heap_start = t->heap_break = (void *)seg_end;
+#endif
                 } else
                     goto done;
                 break;
@@ -504,14 +1265,28 @@ static bool load(const char *file_name, struct intr_frame *if_) {
     if (!setup_stack(if_))
         goto done;
 
+    /** #Project 3: vDSO 시간 페이지 - 커널 시간 페이지를 읽기 전용으로
+     *  매핑한다. gettime()은 syscall 없이 이 페이지만 읽는다. */
+    void *vdso = timer_vdso_page();
+    if (vdso != NULL && !pml4_set_page(t->pml4, (void *)VDSO_TIME_VADDR, vdso, false))
+        goto done;
+
     /* Start address. */
     if_->rip = ehdr.e_entry;
 
     success = true;
 
+    /** #Project 3: ELF 헤더 캐시 - 끝까지 검증된 바이너리만 캐시한다.
+     *  insert가 phdrs 소유권을 가져간다. */
+    if (!validated) {
+        elf_cache_insert(file_get_inode(file), &ehdr, phdrs, phnum);
+        phdrs = NULL;
+    }
+
 done:
     /* We arrive here whether the load is successful or not. */
     // file_close(file);
+    free(phdrs);
 
     return success;
 }
@@ -669,17 +1444,27 @@ bool lazy_load_segment(struct page *page, void *aux)
 
 	struct container *lazy_load_arg = (struct container *)aux;
 
-	// 1) 파일의 position을 ofs으로 지정한다.
-	file_seek(lazy_load_arg->file, lazy_load_arg->ofs);
-	// 2) 파일을 read_bytes만큼 물리 프레임에 읽어 들인다.
-	if (file_read(lazy_load_arg->file, page->frame->kva, lazy_load_arg->page_read_bytes) != (int)(lazy_load_arg->page_read_bytes))
-	{
-		palloc_free_page(page->frame->kva);
+	/* file_read_at leaves the handle's position alone: writable
+	 * segments share the executable's struct file, and concurrent
+	 * faults seeking the same handle would corrupt each other. */
+	if (file_read_at(lazy_load_arg->file, page->frame->kva,
+			lazy_load_arg->page_read_bytes, lazy_load_arg->ofs)
+			!= (int)(lazy_load_arg->page_read_bytes))
 		return false;
-	}
-	// 3) 다 읽은 지점부터 zero_bytes만큼 0으로 채운다.make
+	/* The partial last page is zero-filled here, on first fault. */
 	memset(page->frame->kva + lazy_load_arg->page_read_bytes, 0, lazy_load_arg->page_zero_bytes);
 
+	/* Read-only segments are installed as VM_FILE pages so the share
+	 * cache can hand the frame to other instances of this binary;
+	 * hand the metadata over before retiring the container. */
+	if (page_get_type(page) == VM_FILE) {
+		page->file.file = lazy_load_arg->file;
+		page->file.ofs = lazy_load_arg->ofs;
+		page->file.read_bytes = lazy_load_arg->page_read_bytes;
+		page->file.map_start = lazy_load_arg->map_start;
+	}
+	process_arena_free(lazy_load_arg, sizeof *lazy_load_arg);
+
 	return true;
 }
 
@@ -702,6 +1487,12 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
     ASSERT(pg_ofs(upage) == 0);
     ASSERT(ofs % PGSIZE == 0);
 
+    /** #Project 3: VMA - 세그먼트 범위를 영역 목록에 선언해 두면 mmap의
+     *  주소 선택과 스택 성장 판정이 페이지 단위 탐색 없이 끝난다. */
+    if (vm_area_register(&thread_current()->spt, upage, read_bytes + zero_bytes,
+                         writable ? VM_ANON : VM_FILE, file, ofs, false) == NULL)
+        return false;
+
     while (read_bytes > 0 || zero_bytes > 0) {
         /* Do calculate how to fill this page.
          * We will read PAGE_READ_BYTES bytes from FILE
@@ -709,17 +1500,50 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
         size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
         size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
+        /* Pages with nothing to read (BSS) need no loader at all:
+         * registering them as pure anonymous pages lets the zero-frame
+         * and batched-claim paths in vm.c handle them. */
+        if (page_read_bytes == 0) {
+            if (!vm_alloc_page(VM_ANON, upage, writable))
+                return false;
+            zero_bytes -= page_zero_bytes;
+            upage += PGSIZE;
+            continue;
+        }
+
         /* TODO: Set up aux to pass information to the lazy_load_segment. */
-        struct container *aux = (struct container *)malloc(sizeof(struct container));
-        aux ->file = file;
+        struct container *aux = process_arena_alloc(sizeof(struct container));
+        if (aux == NULL)
+            return false;
+        /* Read-only segments get their own file handle and VM_FILE
+         * type so identical text pages are shared across processes
+         * running the same binary. */
+        aux ->file = writable ? file : file_reopen(file);
+        if (aux->file == NULL) {
+            process_arena_free(aux, sizeof *aux);
+            return false;
+        }
         aux ->ofs = ofs;
         aux ->page_read_bytes = page_read_bytes;
         aux ->page_zero_bytes = page_zero_bytes;
         aux ->writable = writable;
-        
+        aux ->map_start = NULL;
 
-        if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable, lazy_load_segment, aux))
+        if (!vm_alloc_page_with_initializer(writable ? VM_ANON : VM_FILE, upage, writable, lazy_load_segment, aux)) {
+            if (!writable)
+                file_close(aux->file);
+            process_arena_free(aux, sizeof *aux);
             return false;
+        }
+
+        /** #Project 3: Shared Text - 읽기 전용 세그먼트는 CoW의 일시적
+         *  읽기 전용과 달리 영원히 바뀌지 않는다. 페이지에 그 의미를
+         *  기록해 두면 공유 캐시가 참조 카운트 없이 프레임을 나눠 줄 수
+         *  있다. vm.c의 text 프레임 처리 참고. */
+        if (!writable) {
+            struct page *page = spt_find_page(&thread_current()->spt, upage);
+            page->perm_ro = true;
+        }
 
         /* Advance. */
         read_bytes -= page_read_bytes;
@@ -755,64 +1579,84 @@ static bool setup_stack(struct intr_frame *if_) {
 }
 #endif /* VM */
 
-/** #Project 2: Command Line Parsing - 유저 스택에 파싱된 토큰을 저장하는 함수 */
-void argument_stack(char **argv, int argc, struct intr_frame *if_) {
-    char *arg_addr[100];
-    int argv_len;
+/** #Project 3: Zero-copy Exec - 최종 스택 이미지를 스택 프레임의 kva에
+ *  한 번의 패스로 직접 조립한다. 명령행 원본 CMD_LEN바이트를 스택 꼭대기
+ *  최종 위치에 통째로 한 번 복사하고, 그 사본 위에서 공백을 NUL로 바꾸며
+ *  토큰화해 argv를 채운다. 예전에는 cmd 페이지에서 strtok_r로 파싱한 뒤
+ *  토큰마다 유저 스택으로 또 복사했으므로 문자열마다 두 번 복사였다.
+ *
+ *  kva 직접 조립은 클레임해 둔 스택 한 페이지 안에서만 유효하므로,
+ *  최악 이미지 크기(명령행 + 정렬 + argv 테이블 + 센티널 + 가짜 복귀
+ *  주소)가 한 페이지를 넘으면 쓰기 전에 실패를 돌려준다. 예전 유저
+ *  주소 경유 코드는 폴트로 끝났지만 kva 산술은 커널 풀을 덮어쓴다. */
+bool argument_stack(char *cmd, size_t cmd_len, struct intr_frame *if_) {
+    uint8_t *base = pml4_get_page(thread_current()->pml4, (void *)(USER_STACK - PGSIZE));
+    uint64_t sp = USER_STACK;
+    char *uargv[64];
+    int argc = 0;
+
+    if (cmd_len + 7 + (64 + 1) * sizeof(char *) + 8 > PGSIZE)
+        return false;
 
-    for (int i = argc - 1; i >= 0; i--) {
-        argv_len = strlen(argv[i]) + 1;
-        if_->rsp -= argv_len;
-        memcpy(if_->rsp, argv[i], argv_len);
-        arg_addr[i] = if_->rsp;
+    /* 유저 주소 UVA에 대응하는 스택 페이지 안 kva */
+#define STACK_KVA(uva) ((void *)(base + ((uint64_t)(uva) - (USER_STACK - PGSIZE))))
+
+    /* 명령행 원본을 통째로 최종 위치에 */
+    sp -= cmd_len;
+    char *img = STACK_KVA(sp);
+    memcpy(img, cmd, cmd_len);
+
+    /* 사본 위에서 토큰화: 구분 공백을 NUL로 바꾸고 토큰 시작의 유저
+       주소를 argv에 기록한다 */
+    char *p = img;
+    char *end = img + cmd_len;
+    while (p < end && argc < 64) {
+        while (p < end && *p == ' ')
+            *p++ = '\0';
+        if (p >= end || *p == '\0')
+            break;
+        uargv[argc++] = (char *)(sp + (uint64_t)(p - img));
+        while (p < end && *p != ' ' && *p != '\0')
+            p++;
     }
 
-    while (if_->rsp % 8)
-        *(uint8_t *)(--if_->rsp) = 0;
+    while (sp % 8)
+        *(uint8_t *)STACK_KVA(--sp) = 0;
 
-    if_->rsp -= 8;
-    memset(if_->rsp, 0, sizeof(char *));
+    sp -= 8;
+    memset(STACK_KVA(sp), 0, sizeof(char *));
 
     for (int i = argc - 1; i >= 0; i--) {
-        if_->rsp -= 8;
-        memcpy(if_->rsp, &arg_addr[i], sizeof(char *));
+        sp -= 8;
+        memcpy(STACK_KVA(sp), &uargv[i], sizeof(char *));
     }
 
-    if_->rsp = if_->rsp - 8;
-    memset(if_->rsp, 0, sizeof(void *));
+    sp -= 8;
+    memset(STACK_KVA(sp), 0, sizeof(void *));
 
+#undef STACK_KVA
+
+    if_->rsp = sp;
     if_->R.rdi = argc;
-    if_->R.rsi = if_->rsp + 8;
+    if_->R.rsi = sp + 8;
+    return true;
 }
 
-thread_t *get_child_process(int pid) {
-    thread_t *curr = thread_current();
-    thread_t *t;
-
-    for (struct list_elem *e = list_begin(&curr->child_list); e != list_end(&curr->child_list); e = list_next(e)) {
-        t = list_entry(e, thread_t, child_elem);
 
-        if (pid == t->tid)
-            return t;
-    }
-
-    return NULL;
-}
-
-/** #Project 2: System Call - 현재 스레드 fdt에 파일 추가 */
+/** #Project 2: System Call - 현재 스레드 fdt에 파일 추가
+ * 빈 슬롯은 fd_map의 first-clear-bit 스캔으로 O(1)에 찾는다. */
 int process_add_file(struct file *f) {
     thread_t *curr = thread_current();
-    struct file **fdt = curr->fdt;
+    size_t fd = bitmap_scan_and_flip(curr->fd_map, 0, 1, false);
 
-    if (curr->fd_idx >= FDCOUNT_LIMIT)
+    if (fd == BITMAP_ERROR)
         return -1;
 
-    while (fdt[curr->fd_idx] != NULL)
-        curr->fd_idx++;
+    curr->fdt[fd] = f;
+    if ((int)fd >= curr->fd_idx)
+        curr->fd_idx = fd + 1;
 
-    fdt[curr->fd_idx++] = f;
-
-    return curr->fd_idx - 1;
+    return fd;
 }
 
 /** #Project 2: System Call - 현재 스레드의 fd번째 파일 정보 얻기 */
@@ -833,6 +1677,7 @@ int process_close_file(int fd) {
         return -1;
 
     curr->fdt[fd] = NULL;
+    bitmap_set(curr->fd_map, fd, false);
     return 0;
 }
 
@@ -844,9 +1689,12 @@ process_insert_file(int fd, struct file *f) {
         return -1;
 
     if (f > STDERR)
-        f->dup_count++;
+        file_dup_ref(f);
 
     fdt[fd] = f;
+    bitmap_set(curr->fd_map, fd, true);
+    if (fd >= curr->fd_idx)
+        curr->fd_idx = fd + 1;
 
     return fd;
 }
\ No newline at end of file
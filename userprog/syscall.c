@@ -13,18 +13,53 @@
 /** #Project 2: System Call */
 #include <string.h>
 
+#include "devices/disk.h"
+#include "devices/timer.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
+#include "threads/trace.h"
+#include "userprog/pipe.h"
 #include "userprog/process.h"
+#ifdef VM
+#include "vm/stat.h"
+#endif
 /** -----------------------  */
 
 void syscall_entry(void);
 void syscall_handler(struct intr_frame *);
 
 /** #Project 2: System Call */
-struct lock filesys_lock;  // 파일 읽기/쓰기 용 lock
+struct lock filesys_lock;  // 네임스페이스(create/remove/open) 보호용 lock; 파일 I/O는 inode별 rwlock 사용
+
+/** #Project 3: Syscall Profile - '-syscall-prof' 커널 옵션으로 활성화 */
+bool syscall_prof_active;
+
+/** #Project 3: Futex - (pml4, 주소)로 해시한 대기열 버킷. 유저 동기화
+ *  객체가 주소 단위로 잠들고 깨어나게 해, 경합 때마다 틱 잠(최소 10ms)을
+ *  자던 유저 스레드 풀이 정확히 깨워질 때까지만 블록하게 한다. */
+#define FUTEX_BUCKET_CNT 64
+
+struct futex_bucket {
+    struct lock lock;
+    struct list waiters;
+};
+
+struct futex_waiter {
+    uint64_t *pml4;         // 대기 주소가 속한 주소 공간
+    void *uaddr;            // 대기 중인 사용자 주소
+    struct semaphore sema;  // 깨울 때 up; 스택에 살고 깨어나면 소멸
+    struct list_elem elem;
+};
+
+static struct futex_bucket futex_table[FUTEX_BUCKET_CNT];
+
+static struct futex_bucket *futex_bucket_of(uint64_t *pml4, void *uaddr) {
+    uintptr_t h = ((uintptr_t)uaddr >> 2) ^ ((uintptr_t)pml4 >> 12);
+    return &futex_table[h % FUTEX_BUCKET_CNT];
+}
 
 /* System call.
  *
@@ -50,65 +85,138 @@ void syscall_init(void) {
 
     /** #Project 2: System Call - read & write 용 lock 초기화 */
     lock_init(&filesys_lock);
+
+    /** #Project 3: Lock 통계 - 네임스페이스 lock 경합 집계 */
+    static struct lock_stat filesys_lock_stat;
+    lock_register_stat(&filesys_lock, &filesys_lock_stat, "filesys");
+
+    /** #Project 3: Futex - 대기열 버킷 초기화 */
+    for (int i = 0; i < FUTEX_BUCKET_CNT; i++) {
+        lock_init(&futex_table[i].lock);
+        list_init(&futex_table[i].waiters);
+    }
 }
 
 /* The main system call interface */
+/** #Project 3: Dispatch Table - switch 문 대신 시스템 콜 번호로 인덱싱하는
+ *  상수 테이블. 핸들러 포인터에 인자 명세(개수, 어떤 인자가 사용자
+ *  포인터인지, 버퍼-길이 짝)를 함께 실어 검증 fast-fail을 공통 경로
+ *  한 곳에서 수행하고, submit() 배치 링도 같은 테이블로 디스패치해
+ *  switch를 중복하지 않는다. 깊은 검증(페이지 존재, 쓰기 권한)은
+ *  여전히 각 핸들러의 check_address/check_buffer 몫이다. */
+typedef uint64_t syscall_fn(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+struct syscall_spec {
+    syscall_fn *fn;     /* 핸들러. NULL이면 미구현 번호 */
+    uint8_t argc;       /* 레지스터 인자 수 */
+    uint8_t uptr_mask;  /* i번 비트: args[i]는 사용자 포인터 */
+    int8_t buf_arg;     /* 버퍼 인자 인덱스 (-1: 없음) */
+    int8_t len_arg;     /* buf_arg와 짝인 바이트 길이 인자 인덱스 */
+    bool has_ret;       /* 반환값을 rax에 쓴다 */
+    bool batch_ok;      /* submit() 배치에서 실행 가능 (fd 기반 I/O만) */
+};
+
+/* 핸들러 서명은 제각각이므로 void(*)(void)를 거쳐 공통 서명으로 캐스팅한다
+ * (x86-64 SysV ABI에서 남는 인자 레지스터는 무시되므로 안전). */
+#define SPEC(fn_, argc_, uptr_, buf_, len_, ret_, batch_) \
+    {(syscall_fn *)(void (*)(void))(fn_), (argc_), (uptr_), (buf_), (len_), (ret_), (batch_)}
+
+static const struct syscall_spec syscall_specs[SYS_CNT] = {
+    [SYS_HALT] = SPEC(halt, 0, 0x0, -1, -1, false, false),
+    [SYS_EXIT] = SPEC(exit, 1, 0x0, -1, -1, false, false),
+    [SYS_FORK] = SPEC(fork, 1, 0x1, -1, -1, true, false),
+    [SYS_EXEC] = SPEC(exec, 1, 0x1, -1, -1, true, false),
+    [SYS_WAIT] = SPEC(process_wait, 1, 0x0, -1, -1, true, false),
+    [SYS_CREATE] = SPEC(create, 2, 0x1, -1, -1, true, false),
+    [SYS_REMOVE] = SPEC(remove, 1, 0x1, -1, -1, true, false),
+    [SYS_OPEN] = SPEC(open, 1, 0x1, -1, -1, true, false),
+    [SYS_FILESIZE] = SPEC(filesize, 1, 0x0, -1, -1, true, true),
+    [SYS_READ] = SPEC(read, 3, 0x2, 1, 2, true, true),
+    [SYS_WRITE] = SPEC(write, 3, 0x2, 1, 2, true, true),
+    [SYS_SEEK] = SPEC(seek, 2, 0x0, -1, -1, false, true),
+    [SYS_TELL] = SPEC(tell, 1, 0x0, -1, -1, true, true),
+    [SYS_CLOSE] = SPEC(close, 1, 0x0, -1, -1, false, true),
+    [SYS_DUP2] = SPEC(dup2, 2, 0x0, -1, -1, true, false),
+    [SYS_PIPE] = SPEC(pipe, 1, 0x1, -1, -1, true, false),
+    [SYS_SPAWN] = SPEC(spawn, 1, 0x1, -1, -1, true, false),
+    [SYS_READV] = SPEC(readv, 3, 0x2, -1, -1, true, true),
+    [SYS_WRITEV] = SPEC(writev, 3, 0x2, -1, -1, true, true),
+    [SYS_SENDFILE] = SPEC(sendfile, 3, 0x0, -1, -1, true, false),
+    [SYS_PREAD] = SPEC(pread, 4, 0x2, 1, 2, true, false),
+    [SYS_PWRITE] = SPEC(pwrite, 4, 0x2, 1, 2, true, false),
+    [SYS_CREATE_MANY] = SPEC(create_many, 3, 0x3, -1, -1, true, false),
+    [SYS_REMOVE_MANY] = SPEC(remove_many, 2, 0x1, -1, -1, true, false),
+    [SYS_FADVISE] = SPEC(fadvise, 2, 0x0, -1, -1, true, false),
+    [SYS_STAT] = SPEC(stat, 1, 0x1, -1, -1, true, false),
+    [SYS_KSTATS] = SPEC(kstats, 1, 0x1, -1, -1, true, false),
+    [SYS_FUTEX] = SPEC(futex, 3, 0x1, -1, -1, true, false),
+    [SYS_GETRUSAGE] = SPEC(getrusage, 1, 0x1, -1, -1, true, false),
+    [SYS_MEMLIMIT] = SPEC(memlimit, 1, 0x0, -1, -1, true, false),
+#ifdef VM
+    [SYS_MMAP] = SPEC(mmap, 5, 0x1, -1, -1, true, false),
+    [SYS_MUNMAP] = SPEC(munmap, 1, 0x1, -1, -1, false, false),
+    [SYS_MADVISE] = SPEC(madvise, 3, 0x1, -1, -1, true, false),
+    [SYS_VMINSPECT] = SPEC(vminspect, 2, 0x1, -1, -1, true, false),
+    [SYS_SBRK] = SPEC(sbrk, 1, 0x0, -1, -1, true, false),
+    [SYS_SHM_OPEN] = SPEC(shm_open, 2, 0x1, -1, -1, true, false),
+    [SYS_SHM_MAP] = SPEC(shm_map, 2, 0x2, -1, -1, true, false),
+    [SYS_SUBMIT] = SPEC(submit, 2, 0x1, -1, -1, true, false),
+    [SYS_CHECKPOINT] = SPEC(checkpoint, 0, 0x0, -1, -1, true, false),
+#endif
+};
+
+/** #Project 3: Dispatch Table - 명세 기반 공통 fast-fail. 사용자 포인터로
+ *  표시된 인자가 커널 범위를 가리키거나, 버퍼-길이 짝의 끝이 커널 공간을
+ *  침범하면(오버플로 포함) 핸들러에 들어가기 전에 종료한다. */
+static void syscall_validate(const struct syscall_spec *sp, const uint64_t *args) {
+    for (int i = 0; i < sp->argc; i++)
+        if ((sp->uptr_mask >> i) & 1 && is_kernel_vaddr((void *)args[i]))
+            exit(-1);
+
+    if (sp->buf_arg >= 0) {
+        uint64_t base = args[sp->buf_arg];
+        uint64_t len = args[sp->len_arg];
+        if (len != 0 && (base + len < base || is_kernel_vaddr((void *)(base + len - 1))))
+            exit(-1);
+    }
+}
+
 /** #Project 2: System Call - 시스템 콜 핸들러 */
 void syscall_handler(struct intr_frame *f UNUSED) {
     // TODO: Your implementation goes here.
     int sys_number = f->R.rax;
 
+#ifdef VM
+    /** #Project 3: Stack Growth - 커널에서 페이지 폴트가 나면 여기서 저장한 rsp를 사용 */
+    thread_current()->user_rsp = (void *)f->rsp;
+#endif
+
+    /** #Project 3: Syscall Profile - 반환하지 않는 호출(exit, 성공한 exec)은
+     *  집계에서 빠진다. */
+    struct syscall_prof *prof = thread_current()->syscall_prof;
+    uint64_t tsc_start = prof != NULL ? rdtsc() : 0;
+
     // Argument 순서
     // %rdi %rsi %rdx %r10 %r8 %r9
 
-    switch (sys_number) {
-        case SYS_HALT:
-            halt();
-            break;
-        case SYS_EXIT:
-            exit(f->R.rdi);
-            break;
-        case SYS_FORK:
-            f->R.rax = fork(f->R.rdi);
-            break;
-        case SYS_EXEC:
-            f->R.rax = exec(f->R.rdi);
-            break;
-        case SYS_WAIT:
-            f->R.rax = process_wait(f->R.rdi);
-            break;
-        case SYS_CREATE:
-            f->R.rax = create(f->R.rdi, f->R.rsi);
-            break;
-        case SYS_REMOVE:
-            f->R.rax = remove(f->R.rdi);
-            break;
-        case SYS_OPEN:
-            f->R.rax = open(f->R.rdi);
-            break;
-        case SYS_FILESIZE:
-            f->R.rax = filesize(f->R.rdi);
-            break;
-        case SYS_READ:
-            f->R.rax = read(f->R.rdi, f->R.rsi, f->R.rdx);
-            break;
-        case SYS_WRITE:
-            f->R.rax = write(f->R.rdi, f->R.rsi, f->R.rdx);
-            break;
-        case SYS_SEEK:
-            seek(f->R.rdi, f->R.rsi);
-            break;
-        case SYS_TELL:
-            f->R.rax = tell(f->R.rdi);
-            break;
-        case SYS_CLOSE:
-            close(f->R.rdi);
-            break;
-        case SYS_DUP2:
-            f->R.rax = dup2(f->R.rdi, f->R.rsi);
-            break;
-        default:
-            exit(-1);
+    /** #Project 3: Event Trace - 시스템 콜 진입 기록 */
+    TRACE(TRACE_SYSCALL, sys_number, f->R.rdi);
+
+    if (sys_number < 0 || sys_number >= SYS_CNT || syscall_specs[sys_number].fn == NULL)
+        exit(-1);
+
+    const struct syscall_spec *sp = &syscall_specs[sys_number];
+    uint64_t args[5] = {f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10, f->R.r8};
+
+    syscall_validate(sp, args);
+
+    uint64_t ret = sp->fn(args[0], args[1], args[2], args[3], args[4]);
+    if (sp->has_ret)
+        f->R.rax = ret;
+
+    if (prof != NULL && sys_number >= 0 && sys_number < SYS_CNT) {
+        prof->cnt[sys_number]++;
+        prof->cycles[sys_number] += rdtsc() - tsc_start;
     }
 }
 
@@ -125,8 +233,89 @@ void check_address(void *addr) {
         exit(-1);
     spt_find_page(&thread_current()->spt,addr);
 }
+
+/* Validates a LEN-byte user buffer in one pass: the range must lie in
+ * user space and every covered page must either be registered in the
+ * SPT (writable if WRITABLE is set) or fall in the growable stack
+ * region.  One SPT walk per page of the range up front replaces
+ * per-argument pointer checks and surprise faults mid-syscall; the
+ * lookups allocate nothing.  Kills the process on a bad buffer. */
+void check_buffer(void *addr, size_t len, bool writable) {
+    struct supplemental_page_table *spt = &thread_current()->spt;
+    uint8_t *end = (uint8_t *)addr + len;
+    uint8_t *va;
+
+    if (len == 0)
+        return;
+    if (addr == NULL || is_kernel_vaddr(addr) || is_kernel_vaddr(end - 1))
+        exit(-1);
+
+    for (va = pg_round_down(addr); va < end; va += PGSIZE) {
+        struct page *page = spt_find_page(spt, va);
+
+        if (page == NULL) {
+            /* Unregistered pages are acceptable only where the stack
+             * is allowed to grow; the fault handler (or the pinning
+             * path) will install them. */
+            void *rsp = thread_current()->user_rsp;
+            if ((uint8_t *)va >= (uint8_t *)USER_STACK - (1 << 20) && (uint8_t *)va < (uint8_t *)USER_STACK && (uint8_t *)va >= (uint8_t *)rsp - 8)
+                continue;
+            exit(-1);
+        }
+        if (writable && !page->writable)
+            exit(-1);
+    }
+}
 #endif
 
+/** #Project 3: User Copy - SIZE바이트를 rep movsb 한 번으로 복사한다.
+ *  사전 검증 없이 폴트 핸들러에 유효성 판단을 맡긴다: 복사 전에 현재
+ *  스레드에 픽스업 주소(복사 루프 바로 뒤)를 걸어 두면, 해소되지 않는
+ *  폴트가 나도 핸들러가 그 주소로 rip을 돌려 복귀한다(exception.c).
+ *  lazy 페이지·CoW·스택 성장은 평소처럼 폴트 핸들러가 채워 넣고 복사가
+ *  이어진다. 복사하지 못한 바이트 수를 반환한다(0이면 성공). */
+static size_t usercopy(void *dst, const void *src, size_t size) {
+    thread_t *curr = thread_current();
+    size_t left = size;
+
+    __asm __volatile(
+        "leaq 1f(%%rip), %%rax\n\t"
+        "movq %%rax, %0\n\t"
+        "rep movsb\n"
+        "1:\n\t"
+        : "+m"(curr->usercopy_fixup), "+D"(dst), "+S"(src), "+c"(left)
+        :
+        : "rax", "memory");
+
+    curr->usercopy_fixup = NULL;
+    return left;
+}
+
+/** #Project 3: User Copy - 사용자 버퍼 USRC에서 커널 DST로 SIZE바이트를
+ *  가져온다. 주소 범위가 사용자 공간인지만 확인하고(SPT는 걷지 않는다)
+ *  페이지 유효성은 폴트 핸들러에 맡긴다. 검증-후-복사의 SPT 이중 순회를
+ *  없애 작은 복사의 시스템 콜 비용을 줄인다. 성공 시 true. */
+bool copy_from_user(void *dst, const void *usrc, size_t size) {
+    if (size == 0)
+        return true;
+    if (usrc == NULL || is_kernel_vaddr((void *)usrc) || is_kernel_vaddr((uint8_t *)usrc + size - 1))
+        return false;
+
+    return usercopy(dst, (void *)usrc, size) == 0;
+}
+
+/** #Project 3: User Copy - 커널 SRC에서 사용자 버퍼 UDST로 SIZE바이트를
+ *  내보낸다. 읽기 전용 페이지 쓰기는 권한 폴트로 떨어지고, CoW면 폴트
+ *  핸들러가 풀어 주며 아니면 픽스업으로 실패 복귀한다. 성공 시 true. */
+bool copy_to_user(void *udst, const void *src, size_t size) {
+    if (size == 0)
+        return true;
+    if (udst == NULL || is_kernel_vaddr(udst) || is_kernel_vaddr((uint8_t *)udst + size - 1))
+        return false;
+
+    return usercopy(udst, (void *)src, size) == 0;
+}
+
 void halt(void) {
     power_off();
 }
@@ -168,6 +357,13 @@ int wait(pid_t tid) {
     return process_wait(tid);
 }
 
+/** #Project 3: Spawn - fork + exec 결합. 부모 주소 공간을 복제하지 않는다. */
+pid_t spawn(const char *cmd_line) {
+    check_address(cmd_line);
+
+    return process_spawn(cmd_line);
+}
+
 bool create(const char *file, unsigned initial_size) {
     check_address(file);
 
@@ -180,6 +376,78 @@ bool remove(const char *file) {
     return filesys_remove(file);
 }
 
+/** #Project 3: Batch Metadata Ops - 이름 포인터 배열을 한 번 검증해 커널
+ *  사본으로 가져온 뒤 각 포인터를 검증한다. 사본으로 동작해야 검증과 사용
+ *  사이의 TOCTOU가 없다. */
+static const char **copy_in_names(const char *const *names, int cnt) {
+    const char **knames;
+
+    knames = malloc(cnt * sizeof *knames);
+    if (knames == NULL)
+        return NULL;
+
+    if (!copy_from_user(knames, names, cnt * sizeof *knames)) {
+        free(knames);
+        exit(-1);
+    }
+
+    for (int i = 0; i < cnt; i++)
+        check_address((void *)knames[i]);
+
+    return knames;
+}
+
+/** #Project 3: Batch Metadata Ops - 파일 CNT개를 시스템 콜 한 번으로
+ *  생성한다. 디렉터리 해석과 락은 배치당 한 번이고, 디렉터리/프리맵 수정은
+ *  버퍼 캐시 안에서 모아져 한꺼번에 플러시된다. 생성한 개수를 반환한다. */
+int create_many(const char *const *names, const unsigned *sizes, int cnt) {
+    if (cnt < 0 || cnt > FS_BATCH_MAX)
+        return -1;
+    if (cnt == 0)
+        return 0;
+
+    unsigned ksizes_u[FS_BATCH_MAX];
+    if (!copy_from_user(ksizes_u, sizes, cnt * sizeof *ksizes_u))
+        exit(-1);
+
+    const char **knames = copy_in_names(names, cnt);
+    if (knames == NULL)
+        return -1;
+
+    off_t *ksizes = malloc(cnt * sizeof *ksizes);
+    if (ksizes == NULL) {
+        free(knames);
+        return -1;
+    }
+
+    for (int i = 0; i < cnt; i++)
+        ksizes[i] = ksizes_u[i];
+
+    int done = filesys_create_many(knames, ksizes, cnt);
+
+    free(ksizes);
+    free(knames);
+    return done;
+}
+
+/** #Project 3: Batch Metadata Ops - 파일 CNT개를 시스템 콜 한 번으로
+ *  삭제한다. 삭제한 개수를 반환한다. */
+int remove_many(const char *const *names, int cnt) {
+    if (cnt < 0 || cnt > FS_BATCH_MAX)
+        return -1;
+    if (cnt == 0)
+        return 0;
+
+    const char **knames = copy_in_names(names, cnt);
+    if (knames == NULL)
+        return -1;
+
+    int done = filesys_remove_many(knames, cnt);
+
+    free(knames);
+    return done;
+}
+
 int open(const char *file) {
     check_address(file);
     struct file *newfile = filesys_open(file);
@@ -206,7 +474,11 @@ int filesize(int fd) {
 
 int read(int fd, void *buffer, unsigned length) {
     thread_t *curr = thread_current();
+#ifdef VM
+    check_buffer(buffer, length, true);
+#else
     check_address(buffer);
+#endif
 
     struct file *file = process_get_file(fd);
 
@@ -228,18 +500,38 @@ int read(int fd, void *buffer, unsigned length) {
     if (file == NULL || file == STDOUT || file == STDERR)  // 빈 파일, stdout, stderr를 읽으려고 할 경우
         return -1;
 
+    /** #Project 3: Pipe - 링 버퍼에서 직접 복사; inode 경로를 타지 않는다. */
+    if (file->pipe != NULL) {
+        if (file->pipe_writer)  // 쓰기 끝단은 읽을 수 없다.
+            return -1;
+        return pipe_read(file->pipe, buffer, length);
+    }
+
     // 그 외의 경우
     off_t bytes = -1;
 
-    lock_acquire(&filesys_lock);
+#ifdef VM
+    /* Pin the buffer first: a page fault (or worse, a swap-in) while
+     * holding the inode lock would stall other users of this file. */
+    if (!vm_pin_buffer(buffer, length, true))
+        exit(-1);
+#endif
+    /* Per-inode reader-writer locking in inode_read_at synchronizes
+     * the I/O; unrelated files no longer serialize on a global lock. */
     bytes = file_read(file, buffer, length);
-    lock_release(&filesys_lock);
+#ifdef VM
+    vm_unpin_buffer(buffer, length);
+#endif
 
     return bytes;
 }
 
 int write(int fd, const void *buffer, unsigned length) {
+#ifdef VM
+    check_buffer((void *)buffer, length, false);
+#else
     check_address(buffer);
+#endif
 
     thread_t *curr = thread_current();
     off_t bytes = -1;
@@ -261,13 +553,405 @@ int write(int fd, const void *buffer, unsigned length) {
         return length;
     }
 
-    lock_acquire(&filesys_lock);
+    /** #Project 3: Pipe - 링 버퍼로 직접 복사; inode 경로를 타지 않는다. */
+    if (file->pipe != NULL) {
+        if (!file->pipe_writer)  // 읽기 끝단에는 쓸 수 없다.
+            return -1;
+        return pipe_write(file->pipe, buffer, length);
+    }
+
+#ifdef VM
+    if (!vm_pin_buffer(buffer, length, false))
+        exit(-1);
+#endif
     bytes = file_write(file, buffer, length);
-    lock_release(&filesys_lock);
+#ifdef VM
+    vm_unpin_buffer(buffer, length);
+#endif
+
+    return bytes;
+}
+
+/** #Project 3: Scatter-Gather I/O - iovec 배열을 한 번 검증해 커널 사본으로
+ *  가져온다. 사본으로 동작해야 검증과 사용 사이의 TOCTOU가 없다. */
+static struct iovec *copy_in_iov(const struct iovec *iov, int iovcnt) {
+    struct iovec *kiov;
+
+    kiov = malloc(iovcnt * sizeof *kiov);
+    if (kiov == NULL)
+        return NULL;
+
+    if (!copy_from_user(kiov, iov, iovcnt * sizeof *kiov)) {
+        free(kiov);
+        exit(-1);
+    }
+    return kiov;
+}
+
+/** #Project 3: Scatter-Gather I/O - 여러 버퍼를 한 번의 시스템 콜로 읽는다.
+ *  세그먼트별로 기존 read() 경로를 재사용하므로 콘솔/파이프/파일 라우팅이
+ *  그대로 적용된다. */
+int readv(int fd, const struct iovec *iov, int iovcnt) {
+    if (iovcnt < 0 || iovcnt > UIO_MAXIOV)
+        return -1;
+    if (iovcnt == 0)
+        return 0;
+
+    struct iovec *kiov = copy_in_iov(iov, iovcnt);
+    if (kiov == NULL)
+        return -1;
+
+    off_t total = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        if (kiov[i].iov_len == 0)
+            continue;
+
+        int bytes = read(fd, kiov[i].iov_base, kiov[i].iov_len);
+        if (bytes < 0) {
+            if (total == 0)
+                total = -1;
+            break;
+        }
+
+        total += bytes;
+        if ((unsigned long)bytes < kiov[i].iov_len)  // short read: 뒤 세그먼트는 채울 수 없다
+            break;
+    }
+
+    free(kiov);
+    return total;
+}
+
+/** #Project 3: Batched Submission - 파일 I/O 시스템 콜 여러 개를 커널 진입
+ *  한 번으로 처리한다. 디스크립터 배열을 커널 사본으로 가져와 순서대로
+ *  수행하고 각 result 필드에 반환값을 써서 돌려준다. 특권 전환 비용이
+ *  배치 전체에 분산된다. */
+int submit(struct syscall_desc *descs, int cnt) {
+    if (cnt < 0 || cnt > SUBMIT_MAX)
+        return -1;
+    if (cnt == 0)
+        return 0;
+
+    struct syscall_desc *kdescs = malloc(cnt * sizeof *kdescs);
+    if (kdescs == NULL)
+        return -1;
+
+    if (!copy_from_user(kdescs, descs, cnt * sizeof *kdescs)) {
+        free(kdescs);
+        exit(-1);
+    }
+
+    for (int i = 0; i < cnt; i++) {
+        struct syscall_desc *d = &kdescs[i];
+
+        /** #Project 3: Dispatch Table - 배치 가능 표시가 있는 항목만 같은
+         *  명세 테이블로 검증·디스패치한다. */
+        const struct syscall_spec *sp = d->nr < SYS_CNT ? &syscall_specs[d->nr] : NULL;
+        if (sp == NULL || sp->fn == NULL || !sp->batch_ok) {
+            d->result = -1;  // 배치로 안전하게 돌릴 수 없는 시스템 콜
+            continue;
+        }
+
+        uint64_t args[5] = {d->args[0], d->args[1], d->args[2], 0, 0};
+        syscall_validate(sp, args);
+
+        uint64_t r = sp->fn(args[0], args[1], args[2], 0, 0);
+        d->result = sp->has_ret ? (long)r : 0;
+    }
+
+    if (!copy_to_user(descs, kdescs, cnt * sizeof *kdescs)) {
+        free(kdescs);
+        exit(-1);
+    }
+    free(kdescs);
+    return cnt;
+}
+
+/** #Project 3: Scatter-Gather I/O - 여러 버퍼를 한 번의 시스템 콜로 쓴다. */
+int writev(int fd, const struct iovec *iov, int iovcnt) {
+    if (iovcnt < 0 || iovcnt > UIO_MAXIOV)
+        return -1;
+    if (iovcnt == 0)
+        return 0;
+
+    struct iovec *kiov = copy_in_iov(iov, iovcnt);
+    if (kiov == NULL)
+        return -1;
+
+    off_t total = 0;
+
+    for (int i = 0; i < iovcnt; i++) {
+        if (kiov[i].iov_len == 0)
+            continue;
+
+        int bytes = write(fd, kiov[i].iov_base, kiov[i].iov_len);
+        if (bytes < 0) {
+            if (total == 0)
+                total = -1;
+            break;
+        }
+
+        total += bytes;
+        if ((unsigned long)bytes < kiov[i].iov_len)  // short write: 여기서 멈춘다
+            break;
+    }
+
+    free(kiov);
+    return total;
+}
+
+/** #Project 3: Stat - 파일을 열지 않고 길이를 조회한다. 항목마다
+ *  open+filesize+close 세 번 부르던 것이 한 번으로 줄고, readdir 프리페치
+ *  덕분에 inode 섹터는 대개 이미 캐시에 올라와 있다. */
+int stat(const char *file) {
+    check_address(file);
+
+    return filesys_stat(file);
+}
+
+/** #Project 3: Kernel Stats - 항상 켜져 있는 커널 카운터들을 한 번의 호출로
+ *  사용자 버퍼에 채운다. 스케줄러 틱, 풀별 여유 페이지, 디스크 전송량, VM
+ *  카운터를 모두 모으며, 버전 필드로 구조체 확장에 대비한다. 주기적으로
+ *  폴링해 델타를 보는 용도라 카운터는 모두 부팅 이후 단조 증가 값이다. */
+int kstats(struct kstats *buf) {
+    struct kstats k;
+
+    memset(&k, 0, sizeof k);
+    k.version = KSTATS_VERSION;
+
+    thread_get_ticks(&k.idle_ticks, &k.kernel_ticks, &k.user_ticks);
+
+    k.user_free_pages = palloc_user_pool_free_cnt();
+    k.kernel_free_pages = palloc_kernel_pool_free_cnt();
+
+    disk_get_totals(&k.disk_read_sectors, &k.disk_write_sectors, &k.disk_merges);
+
+#ifdef VM
+    k.vm_stat_cnt = VM_STAT_CNT;
+    for (int i = 0; i < VM_STAT_CNT; i++)
+        k.vm_stat[i] = vm_stat_read(i);
+#endif
+
+    if (!copy_to_user(buf, &k, sizeof k))
+        exit(-1);
+    return 0;
+}
+
+
+/** #Project 3: CPU 사용량 - 호출 스레드의 누적 CPU 소비를 채운다. 잡
+ *  스케줄러가 자식별 과금에 쓰는 값이라, 블록된 시간은 어디에도 잡히지
+ *  않고 실제 on-CPU 사이클만 적산된다. 사이클은 문맥 전환 경계의 TSC
+ *  표본이고, 틱 카운터가 유저/커널 비율을 준다. */
+int getrusage(struct thread_usage *buf) {
+    struct thread_usage u;
+    long long cycles;
+
+    thread_get_usage(&cycles, &u.user_ticks, &u.kernel_ticks);
+    u.cpu_cycles = cycles;
+    u.cpu_us = timer_cycles_to_us(cycles);
+
+    if (!copy_to_user(buf, &u, sizeof u))
+        exit(-1);
+    return 0;
+}
+
+/** #Project 3: RSS Limit - 호출 프로세스의 소프트 상주 페이지 한도를
+ *  PAGES로 바꾸고 이전 한도를 반환한다. 0은 무제한, 음수는 조회만 한다.
+ *  소프트 한도라 할당 자체는 막지 않는다. 한도를 넘은 프로세스는 축출
+ *  희생자를 전역 클럭보다 자기 프레임에서 먼저 고르므로, 폴트 폭주가
+ *  동거 프로세스의 워킹셋 대신 자기 것을 밀어낸다. vm/vm.c 참고. */
+int memlimit(int pages) {
+    thread_t *curr = thread_current();
+    int old = curr->rss_limit;
+
+    if (pages >= 0)
+        curr->rss_limit = pages;
+    return old;
+}
+
+#ifdef VM
+/** #Project 3: Checkpoint/Restore - 호출 프로세스의 이미지를 스왑 디스크에
+ *  직렬화한다. fork의 0/1 관례를 따른다: 체크포인트를 찍은 쪽은 0을,
+ *  부팅 시 `restore` 액션으로 되살아난 쪽은 1을 반환값으로 본다.
+ *  실패(스왑 없음, 파이프 fd, 슬롯 부족)는 -1. userprog/process.c 참고. */
+int checkpoint(void) {
+    return process_checkpoint();
+}
+#endif
+
+/** #Project 3: Futex - 주소 단위 대기/깨우기. FUTEX_WAIT은 *UADDR이 아직
+ *  VAL일 때만 잠든다. 값 재확인이 버킷 락 안에서 이뤄지므로 확인과 블록
+ *  사이에 끼어든 깨우기를 놓치지 않는다. FUTEX_WAKE는 같은 주소 공간의
+ *  같은 주소에서 자는 스레드를 VAL개까지 깨워 깨운 수를 반환한다. 블록은
+ *  대기자별 세마포어라 스케줄러의 block/unblock 경로를 그대로 탄다.
+ *  비경합 유저 뮤텍스는 시스템 콜 없이 동작하고 경합 시에만 들어온다. */
+int futex(int *uaddr, int op, int val) {
+    thread_t *curr = thread_current();
+    struct futex_bucket *bucket;
+
+    if ((uintptr_t)uaddr % sizeof(int) != 0)
+        return -1;
+    bucket = futex_bucket_of(curr->pml4, uaddr);
+
+    switch (op) {
+        case FUTEX_WAIT: {
+            struct futex_waiter w;
+            int cur;
+
+            lock_acquire(&bucket->lock);
+            if (!copy_from_user(&cur, uaddr, sizeof cur)) {
+                lock_release(&bucket->lock);
+                exit(-1);
+            }
+            if (cur != val) {  // 이미 바뀌었다: 잘 이유가 없다
+                lock_release(&bucket->lock);
+                return -1;
+            }
+            w.pml4 = curr->pml4;
+            w.uaddr = uaddr;
+            sema_init(&w.sema, 0);
+            list_push_back(&bucket->waiters, &w.elem);
+            lock_release(&bucket->lock);
+
+            sema_down(&w.sema);
+            return 0;
+        }
+        case FUTEX_WAKE: {
+            struct list_elem *e = NULL;
+            int woken = 0;
+
+            lock_acquire(&bucket->lock);
+            e = list_begin(&bucket->waiters);
+            while (e != list_end(&bucket->waiters) && woken < val) {
+                struct futex_waiter *w = list_entry(e, struct futex_waiter, elem);
+
+                e = list_next(e);
+                if (w->pml4 == curr->pml4 && w->uaddr == uaddr) {
+                    list_remove(&w->elem);
+                    sema_up(&w->sema);
+                    woken++;
+                }
+            }
+            lock_release(&bucket->lock);
+            return woken;
+        }
+        default:
+            return -1;
+    }
+}
+
+/** #Project 3: Direct I/O - fd의 접근 패턴을 커널에 알린다. FADV_DIRECT는
+ *  한 번 훑고 마는 대용량 순차 작업용으로, 이후 이 fd의 정렬된 전송은 버퍼
+ *  캐시를 우회해 디스크와 직접 주고받으므로 스캔이 캐시를 통째로 비우지
+ *  않는다. FADV_NORMAL은 기본 캐시 경로로 되돌린다. */
+int fadvise(int fd, int advice) {
+    struct file *file = process_get_file(fd);
+
+    if (file == NULL || (file >= STDIN && file <= STDERR) || file->pipe != NULL)
+        return -1;
+
+    switch (advice) {
+        case FADV_NORMAL:
+            file->direct = false;
+            return 0;
+        case FADV_DIRECT:
+            file->direct = true;
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+/** #Project 3: Positionless I/O - 파일의 OFFSET 위치에서 직접 읽는다.
+ *  공유 pos를 읽지도 바꾸지도 않으므로 dup2로 파일을 공유하는 스레드들이
+ *  위치 조율 없이 동시에 임의 접근할 수 있고, seek+read 두 번이 한 번의
+ *  시스템 콜로 줄어든다. 위치 개념이 없는 콘솔/파이프에는 정의되지 않는다. */
+int pread(int fd, void *buffer, unsigned length, off_t offset) {
+#ifdef VM
+    check_buffer(buffer, length, true);
+#else
+    check_address(buffer);
+#endif
+
+    struct file *file = process_get_file(fd);
+
+    if (file == NULL || (file >= STDIN && file <= STDERR) || file->pipe != NULL)
+        return -1;
+
+    if (offset < 0)
+        return -1;
+
+    off_t bytes = -1;
+
+#ifdef VM
+    if (!vm_pin_buffer(buffer, length, true))
+        exit(-1);
+#endif
+    bytes = file_read_at(file, buffer, length, offset);
+#ifdef VM
+    vm_unpin_buffer(buffer, length);
+#endif
 
     return bytes;
 }
 
+/** #Project 3: Positionless I/O - 파일의 OFFSET 위치에 직접 쓴다. pread와
+ *  같은 이유로 공유 pos를 건드리지 않는다. */
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset) {
+#ifdef VM
+    check_buffer((void *)buffer, length, false);
+#else
+    check_address(buffer);
+#endif
+
+    struct file *file = process_get_file(fd);
+
+    if (file == NULL || (file >= STDIN && file <= STDERR) || file->pipe != NULL)
+        return -1;
+
+    if (offset < 0)
+        return -1;
+
+    off_t bytes = -1;
+
+#ifdef VM
+    if (!vm_pin_buffer(buffer, length, false))
+        exit(-1);
+#endif
+    bytes = file_write_at(file, buffer, length, offset);
+#ifdef VM
+    vm_unpin_buffer(buffer, length);
+#endif
+
+    return bytes;
+}
+
+/** #Project 3: Sendfile - src_fd에서 dst_fd로 LENGTH 바이트를 전송한다.
+ *  데이터는 버퍼 캐시 섹터 사이(콘솔이면 캐시에서 putbuf로)에서 직접
+ *  이동하며 유저 메모리에 올라오지 않으므로, read+write 조합이 치르는
+ *  커널->유저, 유저->커널 복사 두 번이 전부 사라진다. 검증하거나 고정할
+ *  유저 버퍼 자체가 없다. */
+int sendfile(int dst_fd, int src_fd, unsigned length) {
+    struct file *src = process_get_file(src_fd);
+    struct file *dst = process_get_file(dst_fd);
+
+    /* 소스는 일반 파일이어야 한다: 콘솔/파이프에는 캐시 섹터가 없다. */
+    if (src == NULL || (src >= STDIN && src <= STDERR) || src->pipe != NULL)
+        return -1;
+
+    if (dst == NULL || dst == STDIN)
+        return -1;
+
+    if (dst == STDOUT || dst == STDERR)
+        return file_send_console(src, length);
+
+    if (dst->pipe != NULL)
+        return -1;
+
+    return file_sendfile(dst, src, length);
+}
+
 void seek(int fd, unsigned position) {
     if (fd < 0)
         return;
@@ -313,12 +997,117 @@ void close(int fd) {
         return;
     }
 
-    if (file->dup_count == 0)
-        file_close(file);
-    else
-        file->dup_count--;
+    file_close(file);  // 마지막 참조일 때만 실제로 닫힌다
 }
 
+#ifdef VM
+/** #Project 3: Memory Mapped Files */
+void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
+    struct file *file = process_get_file(fd);
+
+    if (file == NULL || file <= (struct file *)STDERR)  // 콘솔 fd는 매핑 불가
+        return NULL;
+
+    if (file->pipe != NULL)  // 파이프 끝단은 매핑 불가
+        return NULL;
+
+    if (addr == NULL || is_kernel_vaddr(addr) || pg_ofs(addr) != 0)
+        return NULL;
+
+    if ((long)length <= 0 || is_kernel_vaddr((uint8_t *)addr + length))
+        return NULL;
+
+    if (offset % PGSIZE != 0)
+        return NULL;
+
+    return do_mmap(addr, length, writable, file, offset);
+}
+
+void munmap(void *addr) {
+    do_munmap(addr);
+}
+
+/** #Project 3: Shared Memory - 이름 있는 세그먼트를 열거나 만든다. */
+int shm_open(const char *name, size_t size) {
+    check_address((void *)name);
+
+    return vm_shm_open(name, size);
+}
+
+/** #Project 3: Shared Memory - 세그먼트를 ADDR에 매핑한다. 모든 공유자가
+ *  같은 프레임을 쓰므로 복사 없이 데이터가 오간다. */
+void *shm_map(int id, void *addr) {
+    if (addr == NULL || is_kernel_vaddr(addr))
+        return NULL;
+
+    return vm_shm_map(id, addr);
+}
+
+/** #Project 3: sbrk - program break를 INCREMENT만큼 옮긴다. 확장은 lazy
+ *  VM_ANON 페이지 등록만 하므로 프레임 할당도 zeroing도 첫 접근 때까지
+ *  일어나지 않는다. 성공 시 이전 break, 실패 시 (void *)-1을 반환한다. */
+void *sbrk(intptr_t increment) {
+    thread_t *curr = thread_current();
+    uint8_t *old_brk = curr->heap_break;
+    uint8_t *new_brk = old_brk + increment;
+
+    if (curr->heap_start == NULL)  // 실행 파일이 로드되지 않음
+        return (void *)-1;
+
+    if (increment == 0)
+        return old_brk;
+
+    if (new_brk < (uint8_t *)curr->heap_start || is_kernel_vaddr(new_brk))
+        return (void *)-1;
+
+    if (increment > 0) {
+        /* 새로 걸치는 페이지만 등록한다. 도중 실패하면 이번에 등록한
+         * 페이지를 되돌리고 break는 그대로 둔다. */
+        for (uint8_t *va = pg_round_up(old_brk); va < new_brk; va += PGSIZE) {
+            if (spt_find_page(&curr->spt, va) != NULL)
+                continue;
+
+            if (!vm_alloc_page(VM_ANON, va, true)) {
+                for (uint8_t *undo = pg_round_up(old_brk); undo < va; undo += PGSIZE) {
+                    struct page *page = spt_find_page(&curr->spt, undo);
+                    if (page != NULL)
+                        spt_remove_page(&curr->spt, page);
+                }
+                return (void *)-1;
+            }
+        }
+    } else {
+        /* 줄어든 구간에서 완전히 벗어난 페이지는 프레임/스왑째로 반납한다. */
+        for (uint8_t *va = pg_round_up(new_brk); va < (uint8_t *)pg_round_up(old_brk); va += PGSIZE) {
+            struct page *page = spt_find_page(&curr->spt, va);
+            if (page != NULL)
+                spt_remove_page(&curr->spt, page);
+        }
+    }
+
+    curr->heap_break = new_brk;
+    return old_brk;
+}
+
+int madvise(void *addr, size_t length, int advice) {
+    if (addr == NULL || is_kernel_vaddr(addr) || is_kernel_vaddr((char *)addr + length))
+        return -1;
+
+    return vm_madvise(addr, length, advice);
+}
+
+/** #Project 3: VM Inspect - 호출한 프로세스의 SPT 스냅샷을 사용자 버퍼에
+ *  한 번에 복사한다. 페이지마다 int 0x42로 한 번씩 트랩하던 기존 검사와
+ *  달리 주소 공간 전체가 syscall 한 번이다. 디버깅 도구용. */
+int vminspect(struct vm_page_info *buf, int cnt) {
+    if (cnt <= 0)
+        return -1;
+    check_buffer(buf, sizeof *buf * (size_t)cnt, true);
+
+    return vm_inspect_spt(buf, cnt);
+}
+#endif
+
 /** #Project 2: Extend File Descriptor (Extra) */
 int dup2(int oldfd, int newfd) {
     struct file *oldfile = process_get_file(oldfd);
@@ -338,4 +1127,34 @@ int dup2(int oldfd, int newfd) {
     newfd = process_insert_file(newfd, oldfile);
 
     return newfd;
+}
+
+/** #Project 3: Pipe - 읽기/쓰기 끝단을 만들어 FDS[0], FDS[1]에 담는다. */
+int pipe(int *fds) {
+    struct file *reader;
+    struct file *writer;
+    int read_fd, write_fd;
+
+#ifdef VM
+    check_buffer(fds, 2 * sizeof(int), true);
+#else
+    check_address(fds);
+#endif
+
+    if (!pipe_open(&reader, &writer))
+        return -1;
+
+    read_fd = process_add_file(reader);
+    write_fd = process_add_file(writer);
+    if (read_fd < 0 || write_fd < 0) {
+        if (read_fd >= 0)
+            process_close_file(read_fd);
+        file_close(reader);
+        file_close(writer);
+        return -1;
+    }
+
+    fds[0] = read_fd;
+    fds[1] = write_fd;
+    return 0;
 }
\ No newline at end of file
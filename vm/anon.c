@@ -1,7 +1,16 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
+#include <string.h>
 #include "devices/disk.h"
+#include "lib/kernel/bitmap.h"
+#include "lib/kernel/lz.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/stat.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -9,6 +18,63 @@ static bool anon_swap_in (struct page *page, void *kva);
 static bool anon_swap_out (struct page *page);
 static void anon_destroy (struct page *page);
 
+/* A page occupies this many consecutive sectors in a swap slot. */
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Swap slot allocator: bit N set means slot N (a SECTORS_PER_PAGE
+ * run of sectors on the swap disk) is in use. */
+static struct bitmap *swap_table;
+static struct lock swap_lock;
+
+/* Swap accounting.  Each slot is charged to the process owning the
+ * page, and once total occupancy crosses swap_limit_pct percent the
+ * worst offender is refused further anonymous memory: a machine deep
+ * in swap thrash does no useful work for anyone, so the runaway
+ * process fails fast instead of dragging everything down.  All fields
+ * are protected by swap_lock. */
+static size_t swap_used_slots;
+static int swap_limit_pct = 90;
+static size_t swap_top_cnt;     /* Largest per-process slot count seen. */
+
+static void swap_read_page (size_t slot, void *kva);
+static void swap_write_page (size_t slot, const void *kva);
+
+/* Asynchronous swap write-out.  An evicted page is copied into a
+ * transit buffer and queued on the swap channel, so the evicting
+ * thread can go on to read the replacement page from the filesystem
+ * disk (the other ATA channel) while the write is still in flight.
+ * All fields are protected by swap_lock; writeback_cv is broadcast
+ * whenever a write completes. */
+#define SWAP_WRITEBACK_CNT 4
+struct swap_writeback {
+	size_t slot;		/* Slot being written, ANON_NO_SLOT if idle. */
+	void *buf;			/* Transit copy of the page. */
+};
+static struct swap_writeback writebacks[SWAP_WRITEBACK_CNT];
+static struct condition writeback_cv;
+
+static struct swap_writeback *writeback_find (size_t slot);
+static void swap_write_done (void *wb_);
+
+/* Compressed staging tier (zswap).  Swap I/O on the PIO ATA disk is
+ * extremely expensive per byte, while the overcommitted workloads
+ * that swap the hardest carry highly compressible heaps.  Evicted
+ * pages are therefore first compressed into a kernel-pool arena; a
+ * page that compresses to ZSWAP_MAX_COMPRESSED or less swaps back in
+ * at memory speed instead of paying 8 sector reads.  Blobs spill to
+ * ordinary disk slots, oldest first, only once the arena byte budget
+ * is exhausted.  All tier state is protected by swap_lock. */
+#define ZSWAP_MAX_COMPRESSED (PGSIZE / 2)
+#define ZSWAP_ARENA_MAX (4 * 1024 * 1024)
+
+static struct list zswap_lru;   /* Pages holding blobs, oldest first. */
+static size_t zswap_bytes;      /* Total blob bytes in the arena. */
+
+static bool zswap_store (struct page *page);
+static void zswap_drop (struct anon_page *anon_page);
+static void zswap_drop_locked (struct anon_page *anon_page);
+static void zswap_spill_oldest (void);
+
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
 	.swap_in = anon_swap_in,
@@ -20,8 +86,28 @@ static const struct page_operations anon_ops = {
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
-	/* TODO: Set up the swap_disk. */
-	swap_disk = NULL;
+	/* 1:1 is the swap disk by convention; see disk_get. */
+	swap_disk = disk_get (1, 1);
+	if (swap_disk == NULL)
+		return;
+	swap_table = bitmap_create (disk_size (swap_disk) / SECTORS_PER_PAGE);
+	ASSERT (swap_table != NULL);
+
+	/* Reserve the checkpoint metadata region at the top of the
+	 * disk; see process_checkpoint() in userprog/process.c. */
+	if (bitmap_size (swap_table) > CKPT_META_SLOTS)
+		bitmap_set_multiple (swap_table,
+				bitmap_size (swap_table) - CKPT_META_SLOTS,
+				CKPT_META_SLOTS, true);
+
+	lock_init (&swap_lock);
+	list_init (&zswap_lru);
+
+	cond_init (&writeback_cv);
+	for (int i = 0; i < SWAP_WRITEBACK_CNT; i++) {
+		writebacks[i].slot = ANON_NO_SLOT;
+		writebacks[i].buf = palloc_get_page (PAL_ASSERT);
+	}
 }
 
 /* Initialize the file mapping */
@@ -31,22 +117,439 @@ anon_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &anon_ops;
 
 	struct anon_page *anon_page = &page->anon;
+	anon_page->swap_slot = ANON_NO_SLOT;
+	anon_page->zdata = NULL;
+	anon_page->zsize = 0;
+	return true;
+}
+
+/* Returns the in-flight writeback for SLOT, or a null pointer.
+ * Caller must hold swap_lock. */
+static struct swap_writeback *
+writeback_find (size_t slot) {
+	for (int i = 0; i < SWAP_WRITEBACK_CNT; i++)
+		if (writebacks[i].slot == slot)
+			return &writebacks[i];
+	return NULL;
+}
+
+/* Completion callback, called from the swap channel's dispatcher
+ * thread once the queued write has hit the disk.  Retires the
+ * transit buffer and wakes anyone waiting on the slot. */
+static void
+swap_write_done (void *wb_) {
+	struct swap_writeback *wb = wb_;
+
+	lock_acquire (&swap_lock);
+	wb->slot = ANON_NO_SLOT;
+	cond_broadcast (&writeback_cv, &swap_lock);
+	lock_release (&swap_lock);
+}
+
+/* Transfers the whole page at KVA from swap slot SLOT.  If the
+ * slot's write-out is still in flight the transit buffer holds the
+ * current contents, so the page is copied back from memory without
+ * touching the disk at all. */
+static void
+swap_read_page (size_t slot, void *kva) {
+	struct swap_writeback *wb;
+
+	lock_acquire (&swap_lock);
+	wb = writeback_find (slot);
+	if (wb != NULL) {
+		/* Holding swap_lock keeps the completion callback from
+		 * recycling the buffer under us. */
+		memcpy (kva, wb->buf, PGSIZE);
+		lock_release (&swap_lock);
+		return;
+	}
+	lock_release (&swap_lock);
+
+	disk_read_multi (swap_disk, slot * SECTORS_PER_PAGE,
+			SECTORS_PER_PAGE, kva);
+}
+
+/* Transfers the whole page at KVA to swap slot SLOT.  When a
+ * transit buffer is free the write is queued asynchronously and
+ * this returns after a memcpy; the evicting thread's next disk
+ * access (typically a read on the filesystem channel) then overlaps
+ * with the swap write.  With all buffers busy it falls back to the
+ * old synchronous write. */
+static void
+swap_write_page (size_t slot, const void *kva) {
+	struct swap_writeback *wb;
+
+	lock_acquire (&swap_lock);
+	/* An older write to the same slot must retire first; the
+	 * elevator may otherwise reorder the two. */
+	while (writeback_find (slot) != NULL)
+		cond_wait (&writeback_cv, &swap_lock);
+	wb = writeback_find (ANON_NO_SLOT);
+	if (wb != NULL) {
+		wb->slot = slot;
+		memcpy (wb->buf, kva, PGSIZE);
+		lock_release (&swap_lock);
+		disk_submit_write (swap_disk, slot * SECTORS_PER_PAGE,
+				SECTORS_PER_PAGE, wb->buf, swap_write_done, wb);
+		return;
+	}
+	lock_release (&swap_lock);
+
+	disk_write_multi (swap_disk, slot * SECTORS_PER_PAGE,
+			SECTORS_PER_PAGE, kva);
+}
+
+/* Spills the oldest blob in the arena to a disk slot, making room
+ * for a new one.  Caller holds swap_lock; the waits below drop it,
+ * so the victim is re-fetched from scratch after every wait.  The
+ * transit buffer is claimed and the slot published before the lock
+ * is released, so a concurrent swap-in of the victim finds the
+ * current contents through the writeback machinery rather than
+ * reading a slot the write has not reached yet. */
+static void
+zswap_spill_oldest (void) {
+	struct anon_page *victim;
+	struct swap_writeback *wb;
+	size_t slot;
+
+retry:
+	if (list_empty (&zswap_lru))
+		return;
+	victim = list_entry (list_front (&zswap_lru), struct anon_page, zelem);
+
+	wb = writeback_find (ANON_NO_SLOT);
+	if (wb == NULL) {
+		cond_wait (&writeback_cv, &swap_lock);
+		goto retry;
+	}
+
+	/* A stale slot from before the compression round may still have
+	 * a write in flight; the elevator could reorder ours ahead of
+	 * it otherwise. */
+	slot = victim->swap_slot;
+	if (slot != ANON_NO_SLOT && writeback_find (slot) != NULL) {
+		cond_wait (&writeback_cv, &swap_lock);
+		goto retry;
+	}
+	if (slot == ANON_NO_SLOT) {
+		slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
+		if (slot == BITMAP_ERROR)
+			PANIC ("zswap_spill: out of swap slots");
+		/* The owning process is not known here, so the slot is
+		 * counted globally but charged to nobody; the admission
+		 * heuristic tolerates the slack. */
+		swap_used_slots++;
+		victim->swap_slot = slot;
+	}
+
+	wb->slot = slot;
+	if (!lz_decompress (victim->zdata, victim->zsize, wb->buf, PGSIZE))
+		PANIC ("zswap_spill: corrupt compressed page");
+	zswap_drop_locked (victim);
+
+	lock_release (&swap_lock);
+	disk_submit_write (swap_disk, slot * SECTORS_PER_PAGE,
+			SECTORS_PER_PAGE, wb->buf, swap_write_done, wb);
+	lock_acquire (&swap_lock);
+}
+
+/* Frees ANON_PAGE's blob, if any.  Caller holds swap_lock. */
+static void
+zswap_drop_locked (struct anon_page *anon_page) {
+	if (anon_page->zdata == NULL)
+		return;
+	list_remove (&anon_page->zelem);
+	zswap_bytes -= anon_page->zsize;
+	free (anon_page->zdata);
+	anon_page->zdata = NULL;
+	anon_page->zsize = 0;
+}
+
+/* Frees ANON_PAGE's blob, if any. */
+static void
+zswap_drop (struct anon_page *anon_page) {
+	if (anon_page->zdata == NULL)
+		return;
+	lock_acquire (&swap_lock);
+	zswap_drop_locked (anon_page);
+	lock_release (&swap_lock);
+}
+
+/* Tries to stage PAGE's contents as a compressed blob in the
+ * arena.  False if the page does not compress to the size cap, an
+ * allocation fails, or the arena cannot make room, in which case
+ * the caller falls back to a plain disk slot. */
+static bool
+zswap_store (struct page *page) {
+	struct anon_page *anon_page = &page->anon;
+	uint8_t *scratch;
+	void *blob;
+	size_t zsize;
+
+	/* One allocation covers the compressor's output bound and its
+	 * match-table workspace; the blob is then trimmed into an
+	 * allocation of its exact size. */
+	scratch = malloc (ZSWAP_MAX_COMPRESSED + LZ_WORKSPACE_SIZE);
+	if (scratch == NULL)
+		return false;
+	zsize = lz_compress (page->frame->kva, PGSIZE, scratch,
+			ZSWAP_MAX_COMPRESSED, scratch + ZSWAP_MAX_COMPRESSED);
+	if (zsize == 0) {
+		free (scratch);
+		return false;
+	}
+	blob = malloc (zsize);
+	if (blob == NULL) {
+		free (scratch);
+		return false;
+	}
+	memcpy (blob, scratch, zsize);
+	free (scratch);
+
+	lock_acquire (&swap_lock);
+	while (zswap_bytes + zsize > ZSWAP_ARENA_MAX
+			&& !list_empty (&zswap_lru))
+		zswap_spill_oldest ();
+	if (zswap_bytes + zsize > ZSWAP_ARENA_MAX) {
+		lock_release (&swap_lock);
+		free (blob);
+		return false;
+	}
+	anon_page->zdata = blob;
+	anon_page->zsize = zsize;
+	zswap_bytes += zsize;
+	list_push_back (&zswap_lru, &anon_page->zelem);
+	lock_release (&swap_lock);
+	return true;
 }
 
 /* Swap in the page by read contents from the swap disk. */
 static bool
 anon_swap_in (struct page *page, void *kva) {
 	struct anon_page *anon_page = &page->anon;
+	size_t slot;
+
+	/* Compressed copies come back at memory speed; the blob stays
+	 * in the arena as a clean copy, like a kept disk slot, so an
+	 * undirtied re-eviction costs nothing. */
+	lock_acquire (&swap_lock);
+	if (anon_page->zdata != NULL) {
+		if (!lz_decompress (anon_page->zdata, anon_page->zsize,
+					kva, PGSIZE))
+			PANIC ("anon_swap_in: corrupt compressed page");
+		lock_release (&swap_lock);
+		vm_stat_inc (VM_STAT_SWAP_IN);
+		vm_stat_inc (VM_STAT_MAJOR_FAULT);
+		return true;
+	}
+	lock_release (&swap_lock);
+
+	slot = anon_page->swap_slot;
+
+	/* No slot means no saved contents: the page is zero-fill on
+	 * demand (fresh frames arrive zeroed), as after madvise
+	 * MADV_DONTNEED dropped it. */
+	if (slot == ANON_NO_SLOT)
+		return true;
+
+	swap_read_page (slot, kva);
+
+	/* Keep the slot: until the page is dirtied again it is a clean
+	 * on-disk copy, and the next eviction can skip the write.  The
+	 * slot goes back to the allocator when the page is destroyed. */
+	vm_stat_inc (VM_STAT_SWAP_IN);
+	vm_stat_inc (VM_STAT_MAJOR_FAULT);
+	return true;
 }
 
-/* Swap out the page by writing contents to the swap disk. */
+/* Swap out the page by writing contents to the swap disk.
+ * A page that still owns a slot from its last round trip and has not
+ * been dirtied since is dropped without touching the disk: the slot
+ * already holds an identical copy. */
 static bool
 anon_swap_out (struct page *page) {
 	struct anon_page *anon_page = &page->anon;
+
+	if (swap_table == NULL)
+		return false;
+
+	if ((anon_page->swap_slot != ANON_NO_SLOT || anon_page->zdata != NULL)
+			&& !pml4_is_dirty (page->frame->owner->pml4, page->va))
+		return true;
+
+	/* Dirty contents invalidate any old compressed copy; try to
+	 * stage the new contents in the arena before touching the
+	 * disk at all. */
+	zswap_drop (anon_page);
+	if (zswap_store (page)) {
+		vm_stat_inc (VM_STAT_SWAP_OUT);
+		return true;
+	}
+
+	if (anon_page->swap_slot == ANON_NO_SLOT) {
+		struct thread *owner = page->frame->owner;
+		size_t slot;
+
+		lock_acquire (&swap_lock);
+		slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
+		if (slot != BITMAP_ERROR) {
+			swap_used_slots++;
+			owner->swap_slots++;
+			if (owner->swap_slots > swap_top_cnt)
+				swap_top_cnt = owner->swap_slots;
+		}
+		lock_release (&swap_lock);
+		if (slot == BITMAP_ERROR)
+			PANIC ("anon_swap_out: out of swap slots");
+		anon_page->swap_slot = slot;
+	}
+
+	swap_write_page (anon_page->swap_slot, page->frame->kva);
+	vm_stat_inc (VM_STAT_SWAP_OUT);
+	return true;
+}
+
+/* Sets the admission threshold to PCT percent of swap occupancy;
+ * false if PCT is out of range.  Called from option parsing. */
+bool
+swap_set_limit (int pct) {
+	if (pct < 1 || pct > 100)
+		return false;
+	swap_limit_pct = pct;
+	return true;
+}
+
+/* Admission control for new anonymous memory.  Below the occupancy
+ * threshold everyone is admitted; above it, the process holding the
+ * most swap slots is refused so it fails fast instead of pushing the
+ * whole machine into thrash. */
+bool
+swap_admission_ok (void) {
+	bool ok = true;
+
+	if (swap_table == NULL)
+		return true;
+
+	lock_acquire (&swap_lock);
+	if (swap_used_slots * 100 >= bitmap_size (swap_table) * swap_limit_pct
+			&& thread_current ()->swap_slots >= swap_top_cnt)
+		ok = false;
+	lock_release (&swap_lock);
+	return ok;
+}
+
+/* Gives up PAGE's swap slot, if it holds one.  A page that dies (or
+ * is resident) while a slot is allocated must return it or the slot
+ * leaks until reboot. */
+void
+anon_release_swap (struct page *page) {
+	struct anon_page *anon_page = &page->anon;
+
+	zswap_drop (anon_page);
+	if (anon_page->swap_slot != ANON_NO_SLOT) {
+		struct thread *curr = thread_current ();
+
+		lock_acquire (&swap_lock);
+		bitmap_reset (swap_table, anon_page->swap_slot);
+		swap_used_slots--;
+		/* Slots are only released by their owning process, so the
+		 * charge comes off the current thread.  The worst-offender
+		 * mark follows it down when the top holder releases; it is a
+		 * heuristic, not an exact maximum. */
+		if (curr->swap_slots > 0) {
+			if (curr->swap_slots == swap_top_cnt)
+				swap_top_cnt--;
+			curr->swap_slots--;
+		}
+		lock_release (&swap_lock);
+		anon_page->swap_slot = ANON_NO_SLOT;
+	}
 }
 
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void
 anon_destroy (struct page *page) {
-	struct anon_page *anon_page = &page->anon;
+	anon_release_swap (page);
+	vm_release_frame (page);
+}
+
+/* Swap-slot and metadata-region access for the checkpoint code in
+ * userprog/process.c.  Slots allocated through here are counted
+ * globally but charged to no process, like zswap spill slots: a
+ * checkpointing process is about to go down with the machine, and a
+ * restoring one frees the slots as soon as they are read. */
+size_t
+swap_slot_alloc (void) {
+	size_t slot;
+
+	if (swap_table == NULL)
+		return ANON_NO_SLOT;
+
+	lock_acquire (&swap_lock);
+	slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
+	if (slot != BITMAP_ERROR)
+		swap_used_slots++;
+	lock_release (&swap_lock);
+
+	return slot == BITMAP_ERROR ? ANON_NO_SLOT : slot;
+}
+
+/* Claims the specific slot SLOT, for re-occupying a checkpoint
+ * image's slots at boot before anything can swap over them.
+ * Returns false if the slot is already taken. */
+bool
+swap_slot_mark (size_t slot) {
+	bool ok;
+
+	if (swap_table == NULL || slot >= bitmap_size (swap_table))
+		return false;
+
+	lock_acquire (&swap_lock);
+	ok = !bitmap_test (swap_table, slot);
+	if (ok) {
+		bitmap_mark (swap_table, slot);
+		swap_used_slots++;
+	}
+	lock_release (&swap_lock);
+
+	return ok;
+}
+
+void
+swap_slot_free (size_t slot) {
+	lock_acquire (&swap_lock);
+	ASSERT (bitmap_test (swap_table, slot));
+	bitmap_reset (swap_table, slot);
+	swap_used_slots--;
+	lock_release (&swap_lock);
+}
+
+void
+swap_slot_read (size_t slot, void *kva) {
+	swap_read_page (slot, kva);
+}
+
+void
+swap_slot_write (size_t slot, const void *kva) {
+	swap_write_page (slot, kva);
+}
+
+/* First sector of the reserved metadata region, or 0 when there is
+ * no swap disk (or it is too small to hold the region). */
+disk_sector_t
+swap_ckpt_meta_start (void) {
+	if (swap_table == NULL || bitmap_size (swap_table) <= CKPT_META_SLOTS)
+		return 0;
+	return (disk_sector_t) (bitmap_size (swap_table) - CKPT_META_SLOTS)
+		* SECTORS_PER_PAGE;
+}
+
+void
+swap_meta_read (size_t sec_ofs, size_t cnt, void *buf) {
+	disk_read_multi (swap_disk, swap_ckpt_meta_start () + sec_ofs, cnt, buf);
+}
+
+void
+swap_meta_write (size_t sec_ofs, size_t cnt, const void *buf) {
+	disk_write_multi (swap_disk, swap_ckpt_meta_start () + sec_ofs, cnt, buf);
 }
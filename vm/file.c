@@ -1,10 +1,34 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "vm/stat.h"
+#include <round.h>
+#include <string.h>
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
 static void file_backed_destroy (struct page *page);
+static bool lazy_load_file (struct page *page, void *aux);
+
+/* System-wide cache of resident read-only file pages, keyed by
+ * (inode, page-aligned offset).  N processes mapping the same
+ * executable or file share one physical copy of each clean text
+ * page instead of each reading its own. */
+struct share_entry {
+	struct inode *inode;    /* Identity of the backing file. */
+	off_t ofs;              /* Page-aligned offset within it. */
+	struct frame *frame;    /* Resident copy of the contents. */
+	struct list_elem elem;
+};
+static struct list share_list;
+static struct lock share_lock;
+
+static bool file_page_identity (struct page *page, struct inode **inode,
+		off_t *ofs);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
@@ -17,6 +41,131 @@ static const struct page_operations file_ops = {
 /* The initializer of file vm */
 void
 vm_file_init (void) {
+	list_init (&share_list);
+	lock_init (&share_lock);
+}
+
+/* Extracts the backing-file identity of PAGE: the inode and the
+ * page-aligned offset its contents come from.  Works both before the
+ * first touch (the lazy container still holds the metadata) and
+ * after (file_page does).  Returns false if there is no identity. */
+static bool
+file_page_identity (struct page *page, struct inode **inode, off_t *ofs) {
+	if (page->operations->type == VM_UNINIT) {
+		struct container *c = page->uninit.aux;
+		if (c == NULL || c->file == NULL)
+			return false;
+		*inode = file_get_inode (c->file);
+		*ofs = c->ofs;
+	} else {
+		if (page->file.file == NULL)
+			return false;
+		*inode = file_get_inode (page->file.file);
+		*ofs = page->file.ofs;
+	}
+	return *inode != NULL;
+}
+
+/* Maps PAGE onto an already-resident shared copy of its contents, if
+ * the cache has one.  The page gets a read-only mapping and a new
+ * reference on the frame; an uninit page is transmuted here since
+ * its loader will never run.  Returns true on a cache hit. */
+bool
+file_try_share_page (struct page *page) {
+	struct inode *inode;
+	off_t ofs;
+	struct frame *frame = NULL;
+	struct list_elem *e;
+
+	if (!file_page_identity (page, &inode, &ofs))
+		return false;
+
+	lock_acquire (&share_lock);
+	for (e = list_begin (&share_list); e != list_end (&share_list);
+			e = list_next (e)) {
+		struct share_entry *entry = list_entry (e, struct share_entry, elem);
+		if (entry->inode == inode && entry->ofs == ofs) {
+			frame = entry->frame;
+			break;
+		}
+	}
+	lock_release (&share_lock);
+	if (frame == NULL)
+		return false;
+
+	if (page->operations->type == VM_UNINIT) {
+		struct container *c = page->uninit.aux;
+		file_backed_initializer (page, VM_FILE, NULL);
+		page->file.file = c->file;
+		page->file.ofs = c->ofs;
+		page->file.read_bytes = c->page_read_bytes;
+		page->file.map_start = c->map_start;
+		process_arena_free (c, sizeof *c);
+	}
+
+	if (!pml4_set_page (thread_current ()->pml4, page->va, frame->kva, false))
+		return false;
+	/* A text frame is owned by the cache itself and never freed while
+	 * its entry lives, so sharers skip the reference count entirely --
+	 * a fault on shared text touches no shared cache line at all. */
+	if (!frame->text)
+		vm_frame_ref (frame);
+	vm_map_add (frame, page);
+	page->frame = frame;
+	return true;
+}
+
+/* Publishes PAGE's freshly loaded frame in the share cache.  Only
+ * read-only file pages are eligible; duplicates (two processes
+ * racing the same load) keep the first entry. */
+void
+file_share_insert (struct page *page) {
+	struct share_entry *entry;
+	struct list_elem *e;
+	struct inode *inode;
+	off_t ofs;
+
+	if (page->writable || page->frame == NULL
+			|| !file_page_identity (page, &inode, &ofs))
+		return;
+
+	lock_acquire (&share_lock);
+	for (e = list_begin (&share_list); e != list_end (&share_list);
+			e = list_next (e)) {
+		struct share_entry *dup = list_entry (e, struct share_entry, elem);
+		if (dup->inode == inode && dup->ofs == ofs) {
+			lock_release (&share_lock);
+			return;
+		}
+	}
+	entry = malloc (sizeof *entry);
+	if (entry != NULL) {
+		entry->inode = inode;
+		entry->ofs = ofs;
+		entry->frame = page->frame;
+		list_push_front (&share_list, &entry->elem);
+	}
+	lock_release (&share_lock);
+}
+
+/* Drops FRAME's cache entry, if any.  Called when the frame is
+ * evicted or returned to the pool, so the cache never points at a
+ * frame whose contents are gone. */
+void
+file_share_remove (struct frame *frame) {
+	struct list_elem *e;
+
+	lock_acquire (&share_lock);
+	for (e = list_begin (&share_list); e != list_end (&share_list);
+			e = list_next (e)) {
+		struct share_entry *entry = list_entry (e, struct share_entry, elem);
+		if (entry->frame == frame) {
+			list_remove (&entry->elem);
+			free (entry);
+			break;
+		}
+	}
+	lock_release (&share_lock);
 }
 
 /* Initialize the file backed page */
@@ -26,33 +175,186 @@ file_backed_initializer (struct page *page, enum vm_type type, void *kva) {
 	page->operations = &file_ops;
 
 	struct file_page *file_page = &page->file;
+	/* The real fields arrive in lazy_load_file once the first fault
+	 * pulls the contents in; until then keep them inert. */
+	file_page->file = NULL;
+	file_page->ofs = 0;
+	file_page->read_bytes = 0;
+	file_page->map_start = NULL;
+	return true;
+}
+
+/* First-fault loader for a mmap'd page.  Moves the mapping metadata
+ * from the container into the file_page and reads the backing bytes. */
+static bool
+lazy_load_file (struct page *page, void *aux) {
+	struct container *c = aux;
+	struct file_page *file_page = &page->file;
+
+	file_page->file = c->file;
+	file_page->ofs = c->ofs;
+	file_page->read_bytes = c->page_read_bytes;
+	file_page->map_start = c->map_start;
+	process_arena_free (c, sizeof *c);
+
+	if (file_read_at (file_page->file, page->frame->kva,
+				file_page->read_bytes, file_page->ofs)
+			!= (off_t) file_page->read_bytes)
+		return false;
+	memset ((uint8_t *) page->frame->kva + file_page->read_bytes, 0,
+			PGSIZE - file_page->read_bytes);
+	vm_stat_inc (VM_STAT_MAJOR_FAULT);
+	return true;
 }
 
 /* Swap in the page by read contents from the file. */
 static bool
 file_backed_swap_in (struct page *page, void *kva) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+
+	if (file_read_at (file_page->file, kva, file_page->read_bytes,
+				file_page->ofs) != (off_t) file_page->read_bytes)
+		return false;
+	memset ((uint8_t *) kva + file_page->read_bytes, 0,
+			PGSIZE - file_page->read_bytes);
+	vm_stat_inc (VM_STAT_MAJOR_FAULT);
+	return true;
 }
 
-/* Swap out the page by writeback contents to the file. */
+/* Swap out the page by writeback contents to the file.
+ * Clean pages are simply dropped; the file already holds them. */
 static bool
 file_backed_swap_out (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	struct file_page *file_page = &page->file;
+	struct thread *owner = page->frame->owner;
+
+	if (pml4_is_dirty (owner->pml4, page->va)) {
+		file_write_at (file_page->file, page->frame->kva,
+				file_page->read_bytes, file_page->ofs);
+		pml4_set_dirty (owner->pml4, page->va, false);
+	}
+	return true;
+}
+
+/* Writes PAGE back to its file if it is resident and dirty, then
+ * closes the page's private file handle.  Shared by the normal
+ * destroy op and the bulk teardown path in vm.c. */
+void
+file_teardown_page (struct page *page) {
+	struct file_page *file_page = &page->file;
+
+	if (page->frame != NULL
+			&& pml4_is_dirty (thread_current ()->pml4, page->va))
+		file_write_at (file_page->file, page->frame->kva,
+				file_page->read_bytes, file_page->ofs);
+	file_close (file_page->file);
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void
 file_backed_destroy (struct page *page) {
-	struct file_page *file_page UNUSED = &page->file;
+	file_teardown_page (page);
+	vm_release_frame (page);
 }
 
 /* Do the mmap */
 void *
 do_mmap (void *addr, size_t length, int writable,
 		struct file *file, off_t offset) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	off_t file_len = file_length (file);
+	size_t read_bytes, page_cnt, i;
+	void *upage;
+
+	if (addr == NULL || pg_ofs (addr) != 0 || length == 0)
+		return NULL;
+	if (offset % PGSIZE != 0 || offset >= file_len)
+		return NULL;
+
+	/* Nothing may already live in the target range.  One walk of the
+	 * area list answers this, however large the mapping. */
+	page_cnt = DIV_ROUND_UP (length, PGSIZE);
+	if (!vm_area_range_free (spt, addr, page_cnt * PGSIZE))
+		return NULL;
+	if (vm_area_register (spt, addr, page_cnt * PGSIZE, VM_FILE, file,
+				offset, false) == NULL)
+		return NULL;
+
+	read_bytes = (size_t) (file_len - offset) < length
+		? (size_t) (file_len - offset) : length;
+	upage = addr;
+
+	/* Install one uninit VM_FILE page per covered page; no disk I/O
+	 * happens until a page is actually touched. */
+	for (i = 0; i < page_cnt; i++) {
+		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+		struct container *aux = process_arena_alloc (sizeof *aux);
+
+		if (aux == NULL)
+			goto fail;
+		aux->file = file_reopen (file);
+		if (aux->file == NULL) {
+			process_arena_free (aux, sizeof *aux);
+			goto fail;
+		}
+		aux->ofs = offset + i * PGSIZE;
+		aux->page_read_bytes = page_read_bytes;
+		aux->page_zero_bytes = PGSIZE - page_read_bytes;
+		aux->writable = writable;
+		aux->map_start = addr;
+
+		if (!vm_alloc_page_with_initializer (VM_FILE, upage, writable,
+					lazy_load_file, aux)) {
+			file_close (aux->file);
+			process_arena_free (aux, sizeof *aux);
+			goto fail;
+		}
+
+		read_bytes -= page_read_bytes;
+		upage = (uint8_t *) upage + PGSIZE;
+	}
+	return addr;
+
+fail:
+	do_munmap (addr);
+	return NULL;
 }
 
 /* Do the munmap */
 void
 do_munmap (void *addr) {
+	struct thread *curr = thread_current ();
+	struct supplemental_page_table *spt = &curr->spt;
+	struct page *page;
+	void *map_start = addr;
+
+	/* The destroy ops clear one PTE per resident page; batch the
+	 * invalidations so a large region costs one TLB flush instead of
+	 * one invlpg per page. */
+	pml4_flush_begin ();
+	while ((page = spt_find_page (spt, addr)) != NULL) {
+		enum vm_type type = page->operations->type;
+
+		if (type == VM_UNINIT && VM_TYPE (page->uninit.type) == VM_FILE) {
+			/* Never touched: nothing to write back, but the
+			 * deferred loading state is ours to reclaim. */
+			struct container *c = page->uninit.aux;
+			if (c->map_start != map_start)
+				break;
+			file_close (c->file);
+			process_arena_free (c, sizeof *c);
+			page->uninit.aux = NULL;
+		} else if (type == VM_FILE) {
+			/* Dirty-page-only writeback happens in
+			 * file_backed_destroy. */
+			if (page->file.map_start != map_start)
+				break;
+		} else
+			break;
+
+		spt_remove_page (spt, page);
+		addr = (uint8_t *) addr + PGSIZE;
+	}
+	pml4_flush_end (curr->pml4);
+	vm_area_unregister (spt, map_start);
 }
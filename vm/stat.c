@@ -0,0 +1,57 @@
+/* stat.c: Virtual memory statistics.
+ *
+ * Cheap always-on counters for the fault, eviction, and swap hot
+ * paths.  Each increment lands in the current thread's counters and
+ * in the global set, so both per-process behavior and system-wide
+ * pressure are visible.  The "vmstat" kernel command line action
+ * dumps the global set. */
+
+#include "vm/stat.h"
+
+#include <percpu.h>
+#include <stdio.h>
+
+#include "threads/thread.h"
+
+/* System-wide totals: per-CPU padded slots so the always-on
+ * increments never share a cache line with fault-path data. */
+static struct pcpu_counter global_stat[VM_STAT_CNT];
+
+/* Printable names, indexed by enum vm_stat_kind. */
+static const char *stat_names[VM_STAT_CNT] = {
+	"faults",
+	"major faults",
+	"evictions",
+	"swap-ins",
+	"swap-outs",
+	"cow breaks",
+	"ksm merges",
+};
+
+/* Bumps counter KIND for the current thread and globally.  Plain
+ * increments: faults never run in interrupt context and a lost tick
+ * of a diagnostic counter is not worth an atomic on the fault path. */
+void
+vm_stat_inc (enum vm_stat_kind kind) {
+	ASSERT (kind < VM_STAT_CNT);
+	pcpu_inc (&global_stat[kind]);
+	thread_current ()->vm_stat.cnt[kind]++;
+}
+
+/* Returns the system-wide total for counter KIND. */
+long long
+vm_stat_read (enum vm_stat_kind kind) {
+	ASSERT (kind < VM_STAT_CNT);
+	return pcpu_sum (&global_stat[kind]);
+}
+
+/* Dumps the global counters to the console. */
+void
+vm_stat_dump (void) {
+	int i;
+
+	printf ("VM statistics:\n");
+	for (i = 0; i < VM_STAT_CNT; i++)
+		printf ("  %-12s: %'lld\n", stat_names[i],
+				(long long) pcpu_sum (&global_stat[i]));
+}
@@ -3,3 +3,5 @@ vm_SRC += vm/uninit.c     # Uninitialized page
 vm_SRC += vm/anon.c       # Anonymous page
 vm_SRC += vm/file.c       # File mapped page
 vm_SRC += vm/inspect.c    # Testing utility
+vm_SRC += vm/stat.c       # VM statistics counters
+vm_SRC += vm/thrash.c     # Adaptive load shedding
@@ -0,0 +1,164 @@
+/* thrash.c: Adaptive load shedding under memory thrash.
+ *
+ * When the combined working set exceeds the user pool, every process
+ * faults on pages the others just evicted and aggregate progress
+ * approaches zero.  The controller here watches the global major-fault
+ * rate; when it crosses a threshold, the lowest-priority process that
+ * is actually faulting is told to park: at its next user-mode fault it
+ * releases its frames and blocks, shrinking the working set by a whole
+ * process instead of letting eviction shave a page off everyone.
+ * Parked processes are resumed serially, oldest first, once the rate
+ * has stayed calm for a few intervals -- running K of N processes at
+ * speed beats running N at a crawl. */
+
+#include "vm/thrash.h"
+
+#include <list.h>
+#include <stdio.h>
+
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "vm/stat.h"
+#include "vm/vm.h"
+
+/* Sampling interval of the controller daemon. */
+#define THRASH_INTERVAL_MS 100
+
+/* Major faults per interval that count as thrashing.  Each major
+ * fault is a disk read, so this is roughly the point where the fault
+ * streams saturate the swap disk instead of the CPU. */
+#define THRASH_PARK_RATE 64
+
+/* Major faults per interval considered calm. */
+#define THRASH_RESUME_RATE 8
+
+/* Calm intervals required before one parked process is resumed.
+ * Resuming refills a working set and spikes the rate briefly, so a
+ * single quiet sample is not enough evidence. */
+#define THRASH_CALM_INTERVALS 3
+
+/* Processes currently parked, in parking order.  Threads push
+ * themselves in vm_thrash_checkpoint; only the daemon pops. */
+static struct list parked_list;
+static struct lock thrash_lock;
+
+static void thrash_daemon (void *started_);
+
+/* Spawns the controller daemon.  Called once from vm_init. */
+void
+vm_thrash_init (void) {
+	struct semaphore daemon_started;
+
+	list_init (&parked_list);
+	lock_init (&thrash_lock);
+
+	sema_init (&daemon_started, 0);
+	thread_create ("thrash-daemon", PRI_DEFAULT, thrash_daemon,
+			&daemon_started);
+	sema_down (&daemon_started);
+}
+
+/* Parks the current thread if the controller has marked it.  Called
+ * from the fault path on user-mode faults, where no kernel locks are
+ * held: the thread hands back its frames, then blocks until the
+ * daemon resumes it.  The released frames go straight to the pool, so
+ * the survivors' next faults find free frames instead of evicting. */
+void
+vm_thrash_checkpoint (void) {
+	struct thread *curr = thread_current ();
+
+	if (!curr->thrash_park)
+		return;
+
+	sema_init (&curr->thrash_sema, 0);
+	lock_acquire (&thrash_lock);
+	list_push_back (&parked_list, &curr->thrash_elem);
+	lock_release (&thrash_lock);
+
+	vm_reclaim_thread_frames ();
+	sema_down (&curr->thrash_sema);
+}
+
+/* Per-thread victim scan, run under thread_foreach with interrupts
+ * off.  A candidate is a user process that took major faults since
+ * the last sample and is not already parked or marked; among those
+ * the lowest priority wins, ties broken toward the heavier faulter
+ * since parking it frees more disk bandwidth. */
+struct victim_scan {
+	struct thread *victim;
+	long long victim_delta;
+};
+
+static void
+scan_thread (struct thread *t, void *aux_) {
+	struct victim_scan *scan = aux_;
+	long long major = t->vm_stat.cnt[VM_STAT_MAJOR_FAULT];
+	long long delta = major - t->thrash_last_major;
+
+	t->thrash_last_major = major;
+
+	if (t->pml4 == NULL || t->thrash_park || delta <= 0)
+		return;
+	if (scan->victim == NULL
+			|| t->priority < scan->victim->priority
+			|| (t->priority == scan->victim->priority
+				&& delta > scan->victim_delta)) {
+		scan->victim = t;
+		scan->victim_delta = delta;
+	}
+}
+
+/* Resumes the longest-parked process, if any. */
+static void
+thrash_resume_one (void) {
+	struct thread *t = NULL;
+
+	lock_acquire (&thrash_lock);
+	if (!list_empty (&parked_list))
+		t = list_entry (list_pop_front (&parked_list),
+				struct thread, thrash_elem);
+	lock_release (&thrash_lock);
+
+	if (t != NULL) {
+		t->thrash_park = false;
+		sema_up (&t->thrash_sema);
+	}
+}
+
+/* Main loop of the controller.  Samples the global major-fault rate
+ * each interval; over the park threshold it marks one victim per
+ * interval, and after enough calm intervals it resumes one parked
+ * process, so shedding and recovery both ramp gradually. */
+static void
+thrash_daemon (void *started_) {
+	struct semaphore *started = started_;
+	long long last_major = 0;
+	int calm_intervals = 0;
+
+	sema_up (started);
+	for (;;) {
+		long long major, delta;
+
+		timer_msleep (THRASH_INTERVAL_MS);
+
+		major = vm_stat_read (VM_STAT_MAJOR_FAULT);
+		delta = major - last_major;
+		last_major = major;
+
+		if (delta >= THRASH_PARK_RATE) {
+			struct victim_scan scan = { NULL, 0 };
+
+			calm_intervals = 0;
+			thread_foreach (scan_thread, &scan);
+			if (scan.victim != NULL)
+				scan.victim->thrash_park = true;
+		} else if (delta <= THRASH_RESUME_RATE) {
+			if (++calm_intervals >= THRASH_CALM_INTERVALS) {
+				calm_intervals = 0;
+				thrash_resume_one ();
+			}
+		} else
+			calm_intervals = 0;
+	}
+}
@@ -1,14 +1,77 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
+#include "devices/timer.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/trace.h"
+#include "threads/workqueue.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
-#include "threads/vaddr.h"'
+#include "threads/vaddr.h"
 #include "vm/uninit.h"
 #include "threads/mmu.h"
 #include "lib/kernel/hash.h"
+#include "userprog/process.h"
+#include "vm/stat.h"
+#include "vm/thrash.h"
+#include <round.h>
 #include <string.h>
-
+#include <syscall-nr.h>
+
+/* Frame table.  One entry per physical frame of the user pool, indexed
+ * by physical frame number, so that eviction can scan every candidate
+ * frame sequentially and translating a user-pool kva to its frame is a
+ * single subtract-and-shift.  Sized once at boot from the user pool
+ * bounds; see frame_table_init. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static uint8_t *frame_base;
+
+/* Protects the frame table and the clock hand in vm_get_victim. */
+static struct lock frame_lock;
+
+/* The eviction scan set: every frame that holds a page and is not
+ * pinned, on an intrusive list.  Pin/unpin and page attach/detach swap
+ * frames in and out, so under heavy I/O -- when much of memory is
+ * transiently pinned -- the clock hand never wastes a step visiting a
+ * frame it cannot take.  Protected by frame_lock, like the table. */
+static struct list scan_list;
+static struct list_elem *scan_hand;
+static size_t scan_cnt;
+
+static void frame_table_init (void);
+static struct frame *frame_from_kva (void *kva);
+static void vm_free_frame (struct frame *frame);
+static void frame_scan_update (struct frame *frame);
+static bool vm_share_page (struct supplemental_page_table *dst,
+		struct page *src_page);
+
+/* Writeback daemon.  Eviction writes dirty pages to disk; done inline
+ * in vm_get_frame it adds the full PIO latency to the fault that was
+ * unlucky enough to empty the pool.  The daemon instead evicts
+ * proactively whenever free user-pool pages dip below a low watermark,
+ * keeping a pool of pre-cleaned frames so faults almost always get a
+ * frame straight from palloc. */
+static struct semaphore frame_daemon_sema;
+static void frame_daemon (void *started_);
+static size_t frame_low_water (void);
+static size_t frame_high_water (void);
+
+/* The system-wide zero frame.  First-touch reads of pure anonymous
+ * pages map it read-only instead of spending a frame and a 4KB clear
+ * on contents that are all zero anyway; the first write breaks the
+ * sharing through vm_handle_wp.  Its permanent reference keeps it from
+ * ever being freed or evicted. */
+static struct frame *zero_frame;
+static struct frame *vm_get_frame (void);
+static bool vm_map_zero_page (struct page *page);
+static void shm_init (void);
+static void ksm_init (void);
+
+/* Slab cache for struct page: one is allocated on every mapping and
+ * freed on every unmapping, making it the hottest fixed-size object
+ * in the fault path.  See threads/slab.c. */
+static struct slab_cache page_cache;
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -21,7 +84,23 @@ vm_init (void) {
 #endif
 	register_inspect_intr ();
 	/* DO NOT MODIFY UPPER LINES. */
-	/* TODO: Your code goes here. */
+	frame_table_init ();
+	slab_cache_init (&page_cache, "page", sizeof (struct page));
+
+	/* Spawn the writeback daemon, the same way thread_start spawns
+	 * idle: pass it a semaphore to signal once it is running. */
+	struct semaphore daemon_started;
+	sema_init (&daemon_started, 0);
+	sema_init (&frame_daemon_sema, 0);
+	thread_create ("frame-daemon", PRI_MIN, frame_daemon, &daemon_started);
+	sema_down (&daemon_started);
+
+	zero_frame = vm_get_frame ();
+	ASSERT (zero_frame != NULL);
+
+	shm_init ();
+	vm_thrash_init ();
+	ksm_init ();
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -43,6 +122,163 @@ static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
 static struct frame *vm_evict_frame (void);
 
+/* Allocates the frame table, one entry for every page in the user
+ * pool.  Every frame starts out unowned. */
+static void
+frame_table_init (void) {
+	void *base;
+	size_t i;
+
+	palloc_user_pool_bounds (&base, &frame_cnt);
+	frame_base = base;
+	frame_table = malloc (frame_cnt * sizeof *frame_table);
+	ASSERT (frame_table != NULL);
+	lock_init (&frame_lock);
+
+	/* Contention stats for the frame-table lock; see lock_print_stats(). */
+	static struct lock_stat frame_lock_stat;
+	lock_register_stat (&frame_lock, &frame_lock_stat, "frame-table");
+
+	for (i = 0; i < frame_cnt; i++) {
+		frame_table[i].kva = frame_base + i * PGSIZE;
+		frame_table[i].page = NULL;
+		frame_table[i].owner = NULL;
+		frame_table[i].ref_cnt = 0;
+		frame_table[i].pin_cnt = 0;
+		frame_table[i].hot = false;
+		frame_table[i].shm = false;
+		frame_table[i].ksm_hash = 0;
+		frame_table[i].text = false;
+		frame_table[i].in_scan = false;
+		list_init (&frame_table[i].mappers);
+	}
+	list_init (&scan_list);
+}
+
+/* Reconciles FRAME's membership in the eviction scan set with its
+ * current state: on the list iff it holds a page and is unpinned.
+ * Must be called with frame_lock held after any change to page or
+ * pin_cnt.  Removing the frame the hand rests on advances the hand
+ * first, so the sweep position survives the removal. */
+static void
+frame_scan_update (struct frame *frame) {
+	bool want = frame->page != NULL && frame->pin_cnt == 0
+		&& !frame->text;
+
+	if (want == frame->in_scan)
+		return;
+	if (want) {
+		list_push_back (&scan_list, &frame->scan_elem);
+		scan_cnt++;
+	} else {
+		if (scan_hand == &frame->scan_elem)
+			scan_hand = list_next (scan_hand);
+		list_remove (&frame->scan_elem);
+		scan_cnt--;
+	}
+	frame->in_scan = want;
+}
+
+/* Returns the frame table entry for KVA, which must be a page
+ * allocated from the user pool. */
+static struct frame *
+frame_from_kva (void *kva) {
+	size_t idx = ((uint8_t *) kva - frame_base) >> PGBITS;
+
+	ASSERT (idx < frame_cnt);
+	return &frame_table[idx];
+}
+
+/* Records OWNER as FRAME's owning process, moving the resident-set
+ * charge from the old owner to the new one.  Every owner transition
+ * goes through here, so a thread's rss_cnt is exactly the number of
+ * frames recording it as owner.  frame_lock held. */
+static void
+rss_owner_set (struct frame *frame, struct thread *owner) {
+	if (frame->owner == owner)
+		return;
+	if (frame->owner != NULL) {
+		ASSERT (frame->owner->rss_cnt > 0);
+		frame->owner->rss_cnt--;
+	}
+	if (owner != NULL)
+		owner->rss_cnt++;
+	frame->owner = owner;
+}
+
+/* Drops one reference to FRAME.  When the last sharer is gone the
+ * physical page goes back to the user pool and the frame is marked
+ * unowned. */
+static void
+vm_free_frame (struct frame *frame) {
+	lock_acquire (&frame_lock);
+	ASSERT (frame->ref_cnt > 0);
+	if (--frame->ref_cnt > 0) {
+		lock_release (&frame_lock);
+		return;
+	}
+	frame->page = NULL;
+	rss_owner_set (frame, NULL);
+	frame_scan_update (frame);
+	lock_release (&frame_lock);
+	file_share_remove (frame);
+	palloc_free_page (frame->kva);
+}
+
+/* Adds a reference to FRAME on behalf of a new sharer. */
+void
+vm_frame_ref (struct frame *frame) {
+	lock_acquire (&frame_lock);
+	frame->ref_cnt++;
+	lock_release (&frame_lock);
+}
+
+/* Records PAGE as a mapper of FRAME in the reverse map.  Every path
+ * that installs a PTE pointing at a frame registers the mapping here
+ * (or inline where frame_lock is already held), so eviction can find
+ * and clear all of a shared frame's PTEs in O(mappers) instead of
+ * scanning every pml4 in the system. */
+void
+vm_map_add (struct frame *frame, struct page *page) {
+	page->map_pml4 = thread_current ()->pml4;
+	lock_acquire (&frame_lock);
+	list_push_back (&frame->mappers, &page->map_elem);
+	lock_release (&frame_lock);
+}
+
+/* Detaches PAGE from its frame: unmaps it from the current process
+ * and drops the frame reference.  Called from the page destroy ops,
+ * before pml4_destroy gets a chance to free a frame that a CoW
+ * sharer still maps. */
+void
+vm_release_frame (struct page *page) {
+	struct frame *frame = page->frame;
+
+	if (frame == NULL)
+		return;
+	pml4_clear_page (thread_current ()->pml4, page->va);
+	lock_acquire (&frame_lock);
+	list_remove (&page->map_elem);
+	/* The departing mapper may be the recorded owner of a frame that
+	 * other sharers keep alive; drop the charge now so no frame ever
+	 * bills a dead process. */
+	if (frame->owner == thread_current ())
+		rss_owner_set (frame, NULL);
+	/* Text frames are owned by the file share cache and their mappers
+	 * hold no reference; just unhook the recorded owner so the frame
+	 * never points at a dead page. */
+	if (frame->text) {
+		if (frame->page == page)
+			frame->page = NULL;
+		lock_release (&frame_lock);
+		page->frame = NULL;
+		return;
+	}
+	lock_release (&frame_lock);
+	vm_free_frame (frame);
+	page->frame = NULL;
+}
+
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
  * `vm_alloc_page`.
@@ -58,6 +294,12 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 	struct supplemental_page_table *spt = &thread_current ()->spt;
 
+	/* Overcommit admission control: anonymous pages are backed by
+	 * swap, and once occupancy crosses the configured threshold the
+	 * worst offender is refused more of it.  See vm/anon.c. */
+	if (VM_TYPE (type) == VM_ANON && !swap_admission_ok ())
+		return false;
+
 	/* Check wheter the upage is already occupied or not. */
 	//  1은 anonymous, 2는 filebacked
 	
@@ -69,8 +311,8 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		/* uninit_new에 맞는 함수 매개 변수 선언해야 함 
 			여기에서 원하는 것은 uninit page 생성 후 spt에 삽입*/
 
-		// 1. 페이지 할당 
-		struct page * page = (struct page*)malloc(sizeof(struct page));
+		// 1. 페이지 할당
+		struct page * page = slab_alloc (&page_cache);
 
 		// 2. 함수 포인터  
 		bool (*initializer)(struct page *, enum vm_type, void *);
@@ -94,49 +336,278 @@ err:
 	return false;
 }
 
-/* Find VA from spt and return page. On error, return NULL. */
+/* Find VA from spt and return page. On error, return NULL.
+ * Lock-free: the lookup samples the generation count, walks the
+ * tree, and accepts the result only if no mutation ran in between.
+ * On a torn read it yields (the writer may be the one we preempted)
+ * and retries; mutations are rare, so retries are too. */
 struct page *
 spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
-	struct hash *h = &spt->spt_hash;
-
-	// 페이지 할당  - page va 대입 - hash find 함수 - return hash_elem
-	struct page *p = (struct page *)malloc(sizeof(struct page));
+	for (;;) {
+		unsigned gen = spt->gen;
+		barrier ();
+		if (!(gen & 1)) {
+			/* Three indexed loads keyed by page number: no hash
+			 * function, no comparator callback on the fault path. */
+			struct page *page = vm_radix_find (&spt->spt_map,
+					(uint64_t) pg_no (va));
+			barrier ();
+			if (gen == spt->gen)
+				return page;
+		}
+		thread_yield ();
+	}
+}
 
-	p->va = pg_round_down(va);
-	struct hash_elem *e = hash_find (h, &p->hash_elem);
-	free(p);
+/* Marks the start of an SPT mutation: takes the writer lock and
+ * flips the generation odd so concurrent lookups back off. */
+static void
+spt_write_begin (struct supplemental_page_table *spt) {
+	lock_acquire (&spt->mut_lock);
+	spt->gen++;
+	barrier ();
+}
 
-	if(e != NULL){
-		return hash_entry(e, struct page, hash_elem);
-	}
-	return NULL; 
+/* Marks the end of an SPT mutation: flips the generation back to
+ * even, publishing the new tree to lock-free readers. */
+static void
+spt_write_end (struct supplemental_page_table *spt) {
+	barrier ();
+	spt->gen++;
+	lock_release (&spt->mut_lock);
 }
 
 /* Insert PAGE into spt with validation. */
 bool
 spt_insert_page (struct supplemental_page_table *spt UNUSED, struct page *page UNUSED) {
-	int succ = false;
-	/* TODO: Fill this function. */
-	// page->hash_elem을 spt->hash에 삽입
-	if (!hash_insert(&spt->spt_hash,&page->hash_elem)){
-		succ = true;
-		return succ;
-	}
-	return succ;
+	bool ok;
+
+	spt_write_begin (spt);
+	ok = vm_radix_insert (&spt->spt_map, (uint64_t) pg_no (page->va), page);
+	spt_write_end (spt);
+	return ok;
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	spt_write_begin (spt);
+	vm_radix_delete (&spt->spt_map, (uint64_t) pg_no (page->va));
+	spt_write_end (spt);
 	vm_dealloc_page (page);
-	return true;
+}
+
+/* Eviction policy framework.  Victim selection hides behind an ops
+ * table -- the page_operations pattern -- so policies can be compared
+ * on the same image with -evict=NAME on the kernel command line.  All
+ * policies share the sweep hand and run with frame_lock held. */
+struct evict_policy {
+	const char *name;
+	struct frame *(*pick_victim) (void);
+};
+
+static struct frame *evict_clock (void);
+static struct frame *evict_wsclock (void);
+static struct frame *evict_2q (void);
+
+static const struct evict_policy evict_policies[] = {
+	{"clock", evict_clock},
+	{"wsclock", evict_wsclock},
+	{"2q", evict_2q},
+};
+static const struct evict_policy *evict_policy = &evict_policies[0];
+
+/* Advances the hand one step around the scan set and returns the
+ * frame it lands on, wrapping at either end.  NULL when the set is
+ * empty.  frame_lock held. */
+static struct frame *
+scan_advance (void) {
+	struct frame *frame;
+
+	if (scan_cnt == 0)
+		return NULL;
+	if (scan_hand == NULL || scan_hand == list_end (&scan_list))
+		scan_hand = list_begin (&scan_list);
+	frame = list_entry (scan_hand, struct frame, scan_elem);
+	scan_hand = list_next (scan_hand);
+	return frame;
+}
+
+/* Selects the eviction policy by NAME; false if no such policy.
+ * Called from option parsing, before the VM subsystem is up. */
+bool
+vm_set_evict_policy (const char *name) {
+	size_t i;
+
+	for (i = 0; i < sizeof evict_policies / sizeof *evict_policies; i++)
+		if (!strcmp (evict_policies[i].name, name)) {
+			evict_policy = &evict_policies[i];
+			return true;
+		}
+	return false;
+}
+
+/* True if FRAME may be evicted at all.  Frames shared copy-on-write
+ * stay resident until the sharing is broken (evicting them would need
+ * an rmap we don't keep), and pinned frames are off limits while a
+ * syscall works on their contents. */
+static bool
+evict_candidate (struct frame *frame) {
+	return frame->page != NULL && frame->owner != NULL
+		&& frame->ref_cnt <= 1 && frame->pin_cnt == 0 && !frame->text;
+}
+
+/* True if FRAME holds a page hinted MADV_SEQUENTIAL.  A streaming
+ * region is touched once and never again, so every policy takes such
+ * frames on sight -- evicting ahead, behind the scan cursor -- with
+ * no second chance and no hot promotion.  Without the hint a one-pass
+ * scan ages through the clock at the same rate as everyone else and
+ * pushes the other processes' working sets out first. */
+static bool
+evict_ahead (struct frame *frame) {
+	return frame->page->sequential;
+}
+
+/* Clock (second chance): sweep from where the hand last stopped.  A
+ * frame whose hardware accessed bit is set gets the bit cleared and
+ * survives this pass; the first frame found with the bit clear is the
+ * victim.  Two full sweeps suffice, since the first sweep clears
+ * every accessed bit. */
+static struct frame *
+evict_clock (void) {
+	size_t scanned, limit = scan_cnt * 2;
+
+	for (scanned = 0; scanned < limit; scanned++) {
+		struct frame *frame = scan_advance ();
+
+		if (frame == NULL)
+			break;
+		if (!evict_candidate (frame))
+			continue;
+		if (evict_ahead (frame))
+			return frame;
+		if (pml4_is_accessed (frame->owner->pml4, frame->page->va)) {
+			pml4_set_accessed (frame->owner->pml4, frame->page->va, false);
+			continue;
+		}
+		return frame;
+	}
+	return NULL;
+}
+
+/* WSClock: clock, but clean frames are preferred over dirty ones,
+ * since a dirty victim costs a writeback on the eviction path.  The
+ * first non-accessed dirty frame is remembered as a fallback in case
+ * the sweep finds nothing clean. */
+static struct frame *
+evict_wsclock (void) {
+	struct frame *dirty_fallback = NULL;
+	size_t scanned, limit = scan_cnt * 2;
+
+	for (scanned = 0; scanned < limit; scanned++) {
+		struct frame *frame = scan_advance ();
+
+		if (frame == NULL)
+			break;
+		if (!evict_candidate (frame))
+			continue;
+		if (evict_ahead (frame))
+			return frame;
+		if (pml4_is_accessed (frame->owner->pml4, frame->page->va)) {
+			pml4_set_accessed (frame->owner->pml4, frame->page->va, false);
+			continue;
+		}
+		if (pml4_is_dirty (frame->owner->pml4, frame->page->va)) {
+			if (dirty_fallback == NULL)
+				dirty_fallback = frame;
+			continue;
+		}
+		return frame;
+	}
+	return dirty_fallback;
+}
+
+/* 2Q, approximated with the hardware accessed bit: frames start cold
+ * and are promoted to the hot set the first time a sweep catches
+ * their accessed bit, so a one-shot sequential scan cannot flush the
+ * frames a loop keeps re-touching.  Victims come from the cold queue;
+ * a hot frame is only taken (and demoted) when no cold frame exists. */
+static struct frame *
+evict_2q (void) {
+	struct frame *hot_fallback = NULL;
+	size_t scanned, limit = scan_cnt * 2;
+
+	for (scanned = 0; scanned < limit; scanned++) {
+		struct frame *frame = scan_advance ();
+
+		if (frame == NULL)
+			break;
+		if (!evict_candidate (frame))
+			continue;
+		if (evict_ahead (frame))
+			return frame;
+		if (pml4_is_accessed (frame->owner->pml4, frame->page->va)) {
+			pml4_set_accessed (frame->owner->pml4, frame->page->va, false);
+			frame->hot = true;
+			continue;
+		}
+		if (frame->hot) {
+			if (hot_fallback == NULL)
+				hot_fallback = frame;
+			continue;
+		}
+		return frame;
+	}
+	if (hot_fallback != NULL)
+		hot_fallback->hot = false;
+	return hot_fallback;
+}
+
+/* Sweeps the scan set once for a frame owned by OWNER, preferring
+ * one whose accessed bit is clear; an accessed own frame is aged and
+ * remembered as a fallback.  NULL when OWNER has no evictable frame
+ * at all.  frame_lock held. */
+static struct frame *
+evict_local (struct thread *owner) {
+	struct frame *fallback = NULL;
+	size_t scanned;
+
+	for (scanned = 0; scanned < scan_cnt; scanned++) {
+		struct frame *frame = scan_advance ();
+
+		if (frame == NULL)
+			break;
+		if (!evict_candidate (frame) || frame->owner != owner)
+			continue;
+		if (evict_ahead (frame))
+			return frame;
+		if (pml4_is_accessed (owner->pml4, frame->page->va)) {
+			pml4_set_accessed (owner->pml4, frame->page->va, false);
+			if (fallback == NULL)
+				fallback = frame;
+			continue;
+		}
+		return frame;
+	}
+	return fallback;
 }
 
 /* Get the struct frame, that will be evicted. */
 static struct frame *
 vm_get_victim (void) {
+	struct thread *curr = thread_current ();
 	struct frame *victim = NULL;
-	 /* TODO: The policy for eviction is up to you. */
 
+	lock_acquire (&frame_lock);
+	/* A process over its soft resident-set limit pays for its own
+	 * fault first: the victim comes from its own frames while it has
+	 * an evictable one, so one process's fault storm stops emptying
+	 * everyone else's working set.  Only when nothing of its own can
+	 * go does it fall back to the global policy. */
+	if (curr->rss_limit > 0 && curr->rss_cnt > curr->rss_limit)
+		victim = evict_local (curr);
+	if (victim == NULL)
+		victim = evict_policy->pick_victim ();
+	lock_release (&frame_lock);
 	return victim;
 }
 
@@ -144,10 +615,92 @@ vm_get_victim (void) {
  * Return NULL on error.*/
 static struct frame *
 vm_evict_frame (void) {
-	struct frame *victim UNUSED = vm_get_victim ();
-	/* TODO: swap out the victim and return the evicted frame. */
+	struct frame *victim = vm_get_victim ();
+	struct page *page;
+
+	if (victim == NULL)
+		return NULL;
+	page = victim->page;
+
+	/* Unmap every mapper through the reverse map -- O(mappers), with
+	 * no pml4 scanning -- before writing back, so no owner can dirty
+	 * the page under the writeback.  The candidate filter admits at
+	 * most one referenced mapper, but the walk also catches a stale
+	 * recorded owner left behind by a CoW detach. */
+	lock_acquire (&frame_lock);
+	for (struct list_elem *e = list_begin (&victim->mappers);
+			e != list_end (&victim->mappers); e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, map_elem);
+		pml4_clear_page (p->map_pml4, p->va);
+	}
+	lock_release (&frame_lock);
+	if (!swap_out (page))
+		return NULL;
+
+	lock_acquire (&frame_lock);
+	while (!list_empty (&victim->mappers)) {
+		struct page *p = list_entry (list_pop_front (&victim->mappers),
+				struct page, map_elem);
+		p->frame = NULL;
+	}
+	victim->page = NULL;
+	rss_owner_set (victim, NULL);
+	victim->hot = false;
+	frame_scan_update (victim);
+	lock_release (&frame_lock);
+	file_share_remove (victim);
+	memset (victim->kva, 0, PGSIZE);
+	vm_stat_inc (VM_STAT_EVICTION);
+	return victim;
+}
 
-	return NULL;
+/* Evicts every unpinned, unshared frame owned by the current thread
+ * and returns it to the user pool.  Called by a thread parking itself
+ * at the thrash checkpoint, so the owner cannot fault the pages back
+ * in concurrently; detaching the page under the frame lock keeps the
+ * eviction policies from picking the same frame. */
+void
+vm_reclaim_thread_frames (void) {
+	struct thread *curr = thread_current ();
+	size_t i;
+
+	for (i = 0; i < frame_cnt; i++) {
+		struct frame *frame = &frame_table[i];
+		struct page *page;
+
+		lock_acquire (&frame_lock);
+		if (frame->owner != curr || frame->shm
+				|| !evict_candidate (frame)) {
+			lock_release (&frame_lock);
+			continue;
+		}
+		page = frame->page;
+		frame->page = NULL;
+		frame_scan_update (frame);
+		lock_release (&frame_lock);
+
+		pml4_clear_page (curr->pml4, page->va);
+		if (!swap_out (page)) {
+			lock_acquire (&frame_lock);
+			frame->page = page;
+			frame_scan_update (frame);
+			lock_release (&frame_lock);
+			continue;
+		}
+
+		lock_acquire (&frame_lock);
+		list_remove (&page->map_elem);
+		rss_owner_set (frame, NULL);
+		lock_release (&frame_lock);
+		page->frame = NULL;
+		frame->hot = false;
+		file_share_remove (frame);
+		lock_acquire (&frame_lock);
+		frame->ref_cnt = 0;
+		lock_release (&frame_lock);
+		vm_stat_inc (VM_STAT_EVICTION);
+		palloc_free_page (frame->kva);
+	}
 }
 
 /* palloc() and get frame. If there is no available page, evict the page
@@ -160,33 +713,763 @@ vm_evict_frame (void) {
  * You don't need to handle swap out for now in case of page allocation failure. Just mark those case with PANIC ("todo") for now.
 */
 static struct frame *
-vm_get_frame(void)
-{
-    // 프레임 구조체 할당
-    struct frame *frame = malloc(sizeof(struct frame));
-    ASSERT(frame != NULL);
+vm_get_frame (void) {
+	void *kva = palloc_get_page (PAL_USER | PAL_ZERO);
+	struct frame *frame;
+
+	if (kva == NULL) {
+		/* The pool ran dry before the daemon could refill it; evict
+		 * inline and kick it so the next fault doesn't have to. */
+		sema_up (&frame_daemon_sema);
+		return vm_evict_frame ();
+	}
 
-    frame->kva = palloc_get_page(PAL_USER | PAL_ZERO);
+	if (palloc_user_pool_free_cnt () < frame_low_water ())
+		sema_up (&frame_daemon_sema);
+
+	/* The frame's metadata lives in the boot-time table; no
+	 * allocation happens on this path. */
+	frame = frame_from_kva (kva);
+	frame->page = NULL;
+	frame->ref_cnt = 1;
+	frame->pin_cnt = 0;
+	frame->hot = false;
+	frame->shm = false;
+	frame->ksm_hash = 0;
+	frame->text = false;
+
+	return frame;
+}
 
-    if (frame->kva == NULL)
-        frame = vm_evict_frame();
+/* Watermarks on free user-pool pages.  Dropping below the low mark
+ * wakes the daemon, which evicts until the high mark is reached, so a
+ * burst of faults finds pre-cleaned frames waiting. */
+static size_t
+frame_low_water (void) {
+	size_t mark = frame_cnt / 16;
+	return mark < 4 ? 4 : mark;
+}
 
+static size_t
+frame_high_water (void) {
+	size_t mark = frame_cnt / 8;
+	return mark < 8 ? 8 : mark;
+}
 
-    frame->page = NULL; // 초기에는 연결된 페이지가 없음
+/* Main loop of the writeback daemon.  Runs at minimum priority:
+ * whenever vm_get_frame kicks it, it evicts pages -- taking the
+ * swap-disk writes in this thread rather than a faulting one -- and
+ * returns the cleaned frames to the pool until the high watermark is
+ * restored. */
+static void
+frame_daemon (void *started_) {
+	struct semaphore *started = started_;
+
+	sema_up (started);
+	for (;;) {
+		sema_down (&frame_daemon_sema);
+		while (palloc_user_pool_free_cnt () < frame_high_water ()) {
+			struct frame *frame = vm_evict_frame ();
+			if (frame == NULL)
+				break;
+			lock_acquire (&frame_lock);
+			frame->ref_cnt = 0;
+			lock_release (&frame_lock);
+			palloc_free_page (frame->kva);
+		}
+		/* Collapse kicks that piled up while we were working. */
+		while (sema_try_down (&frame_daemon_sema))
+			continue;
+	}
+}
 
-    ASSERT(frame->page == NULL);
+/* KSM-style same-content page merging.  N identical worker processes
+ * end up with substantially identical anonymous heaps; a background
+ * scanner hashes stable anonymous frames and merges byte-identical
+ * pairs into one read-only frame with the usual CoW semantics, so the
+ * duplicates go back to the pool instead of inflating the working
+ * set.  The scan runs as a self-rearming work item on its own
+ * workqueue and is opt-in via the -ksm kernel option: hashing every
+ * frame is pure overhead for workloads without duplication. */
+bool vm_ksm_requested;
+
+/* Stable table: one slot per hash bucket, holding the frame whose
+ * contents future duplicates are merged into.  Entries are validated
+ * on lookup (a frame may have been freed or rewritten since it was
+ * inserted), so a stale slot costs a miss, never a bad merge. */
+#define KSM_TABLE_SIZE 512
+#define KSM_SCAN_BATCH 64         /* Frames examined per work item. */
+#define KSM_SCAN_INTERVAL_MS 50   /* Pause between batches. */
+
+static struct workqueue ksm_wq;
+static struct work ksm_work;
+static struct frame *ksm_stable[KSM_TABLE_SIZE];
+static size_t ksm_hand;           /* Next frame index to examine. */
+
+/* Only a sole-owned, unpinned, resident anonymous frame may be
+ * merged away.  Shared frames are already deduplicated, and file
+ * pages share through the page cache instead. */
+static bool
+ksm_candidate (struct frame *frame) {
+	return frame->page != NULL && frame->ref_cnt == 1
+		&& frame->pin_cnt == 0 && !frame->shm && frame != zero_frame
+		&& page_get_type (frame->page) == VM_ANON;
+}
 
-    return frame; // 초기화된 프레임 반환
+/* Examines one frame: hashes it, and if the hash matches a stable
+ * entry that memcmp confirms, repoints the frame's page at the kept
+ * frame and frees this one.  A frame whose hash changed since the
+ * last pass is volatile and only has its hash refreshed; merging is
+ * reserved for contents that held still for a full scan cycle.
+ *
+ * The scanner holds its own reference on both frames for the
+ * duration, so a concurrent write from either owner lands in
+ * vm_handle_wp's copy path (ref_cnt > 1) rather than re-enabling
+ * write access in place under the comparison; the final revalidation
+ * under the frame lock catches exactly that divergence. */
+static void
+ksm_try_merge (struct frame *frame) {
+	struct frame *kept;
+	struct thread *owner;
+	struct page *page;
+	uint64_t h;
+
+	lock_acquire (&frame_lock);
+	if (!ksm_candidate (frame)) {
+		lock_release (&frame_lock);
+		return;
+	}
+	page = frame->page;
+	owner = frame->owner;
+	frame->ref_cnt++;
+	lock_release (&frame_lock);
+
+	h = hash_bytes (frame->kva, PGSIZE);
+	if (h != frame->ksm_hash) {
+		/* Volatile: remember the new hash and revisit next pass. */
+		frame->ksm_hash = h;
+		vm_free_frame (frame);
+		return;
+	}
+
+	lock_acquire (&frame_lock);
+	kept = ksm_stable[h % KSM_TABLE_SIZE];
+	if (kept == NULL || kept == frame || kept->ref_cnt == 0
+			|| kept->shm || kept->ksm_hash != h) {
+		/* No valid partner yet: this frame becomes the entry. */
+		ksm_stable[h % KSM_TABLE_SIZE] = frame;
+		lock_release (&frame_lock);
+		vm_free_frame (frame);
+		return;
+	}
+	kept->ref_cnt++;
+	lock_release (&frame_lock);
+
+	/* Write-protect the owner's mapping before comparing, so a late
+	 * store faults into the CoW path instead of racing the memcmp.
+	 * The kept frame's sharers are read-only already or diverge the
+	 * same way. */
+	pml4_clear_page (owner->pml4, page->va);
+	pml4_set_page (owner->pml4, page->va, frame->kva, false);
+
+	if (memcmp (frame->kva, kept->kva, PGSIZE) != 0) {
+		/* Bucket collision or late write: keep both frames. */
+		lock_acquire (&frame_lock);
+		if (frame->page == page && frame->ref_cnt == 2) {
+			pml4_clear_page (owner->pml4, page->va);
+			pml4_set_page (owner->pml4, page->va, frame->kva,
+					page->writable);
+		}
+		lock_release (&frame_lock);
+		frame->ksm_hash = hash_bytes (frame->kva, PGSIZE);
+		vm_free_frame (frame);
+		vm_free_frame (kept);
+		return;
+	}
+
+	lock_acquire (&frame_lock);
+	if (frame->page != page || frame->ref_cnt != 2) {
+		/* The owner wrote or went away under the comparison. */
+		lock_release (&frame_lock);
+		vm_free_frame (frame);
+		vm_free_frame (kept);
+		return;
+	}
+
+	/* Identical: the reference taken on KEPT above transfers to the
+	 * page, and both references on FRAME are dropped, freeing it. */
+	page->frame = kept;
+	list_remove (&page->map_elem);
+	list_push_back (&kept->mappers, &page->map_elem);
+	frame->ref_cnt--;
+	frame->page = NULL;
+	rss_owner_set (frame, NULL);
+	frame->hot = false;
+	frame->ksm_hash = 0;
+	frame_scan_update (frame);
+	if (ksm_stable[h % KSM_TABLE_SIZE] == frame)
+		ksm_stable[h % KSM_TABLE_SIZE] = kept;
+	lock_release (&frame_lock);
+
+	pml4_clear_page (owner->pml4, page->va);
+	pml4_set_page (owner->pml4, page->va, kept->kva, false);
+
+	vm_free_frame (frame);
+	vm_stat_inc (VM_STAT_KSM_MERGE);
 }
 
-/* Growing the stack. */
+/* One scan batch; rearms itself so the sweep runs forever without
+ * tying a dedicated thread up. */
 static void
-vm_stack_growth (void *addr UNUSED) {
+ksm_scan (void *aux UNUSED) {
+	size_t scanned;
+
+	timer_msleep (KSM_SCAN_INTERVAL_MS);
+	for (scanned = 0; scanned < KSM_SCAN_BATCH; scanned++) {
+		ksm_try_merge (&frame_table[ksm_hand]);
+		ksm_hand = (ksm_hand + 1) % frame_cnt;
+	}
+	workqueue_enqueue (&ksm_wq, &ksm_work, ksm_scan, NULL);
+}
+
+/* Starts the scanner if -ksm was given.  Called once from vm_init,
+ * after the workqueue subsystem is up. */
+static void
+ksm_init (void) {
+	if (!vm_ksm_requested)
+		return;
+	workqueue_create (&ksm_wq, "ksm", 1);
+	workqueue_enqueue (&ksm_wq, &ksm_work, ksm_scan, NULL);
+}
+
+/* Lowest address the stack may grow down to (1 MB of stack). */
+#define STACK_LIMIT ((uint8_t *) USER_STACK - (1 << 20))
+
+/* Growing the stack.
+ * Installs every missing page between the fault address and the
+ * current stack bottom as lazy anonymous pages in one batch, so a
+ * fault landing far below the stack costs a single trip here rather
+ * than one fault per 4KB. */
+static void
+vm_stack_growth (void *addr) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	uint8_t *upage = pg_round_down (addr);
+
+	while (upage < (uint8_t *) USER_STACK
+			&& spt_find_page (spt, upage) == NULL) {
+		if (!vm_alloc_page (VM_ANON | VM_MARKER_0, upage, true))
+			return;
+		upage += PGSIZE;
+	}
+}
+
+/* Maps PAGE read-only onto the shared zero frame.  Only a pure
+ * anonymous page -- one with no deferred initializer, so its first
+ * contents are all zero by definition -- may take this path.  The page
+ * is transmuted the same way uninit_initialize would, minus the frame
+ * and the clear. */
+static bool
+vm_map_zero_page (struct page *page) {
+	struct uninit_page *uninit = &page->uninit;
+
+	if (!uninit->page_initializer (page, uninit->type, zero_frame->kva))
+		return false;
+	if (!pml4_set_page (thread_current ()->pml4, page->va,
+				zero_frame->kva, false))
+		return false;
+	vm_frame_ref (zero_frame);
+	vm_map_add (zero_frame, page);
+	page->frame = zero_frame;
+	return true;
 }
 
-/* Handle the fault on write_protected page */
+/* Handle the fault on write_protected page.
+ * The page is mapped read-only because its frame is shared
+ * copy-on-write.  The last sharer just gets write access restored in
+ * place; everyone else copies the contents into a private frame. */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
+vm_handle_wp (struct page *page) {
+	struct thread *curr = thread_current ();
+	struct frame *frame = page->frame;
+	struct frame *copy;
+
+	if (frame == NULL || !page->writable)
+		return false;
+
+	lock_acquire (&frame_lock);
+	if (frame->ref_cnt == 1) {
+		/* Sole remaining sharer: re-enable write access in place. */
+		frame->page = page;
+		rss_owner_set (frame, curr);
+		frame_scan_update (frame);
+		lock_release (&frame_lock);
+		pml4_clear_page (curr->pml4, page->va);
+		return pml4_set_page (curr->pml4, page->va, frame->kva, true);
+	}
+	lock_release (&frame_lock);
+
+	copy = vm_get_frame ();
+	if (copy == NULL)
+		return false;
+	/* A fresh frame is already zeroed, so breaking off the shared
+	 * zero frame needs no copy at all. */
+	if (frame != zero_frame)
+		memcpy (copy->kva, frame->kva, PGSIZE);
+
+	lock_acquire (&frame_lock);
+	frame->ref_cnt--;
+	if (frame->page == page) {
+		/* The recorded owner is leaving.  A remaining sharer fixes
+		 * these up when it takes its own write fault. */
+		frame->page = NULL;
+		rss_owner_set (frame, NULL);
+		frame_scan_update (frame);
+	}
+	/* The mapping moves from the shared frame to the private copy. */
+	list_remove (&page->map_elem);
+	list_push_back (&copy->mappers, &page->map_elem);
+	page->map_pml4 = curr->pml4;
+	copy->page = page;
+	rss_owner_set (copy, curr);
+	frame_scan_update (copy);
+	lock_release (&frame_lock);
+
+	page->frame = copy;
+	pml4_clear_page (curr->pml4, page->va);
+	if (!pml4_set_page (curr->pml4, page->va, copy->kva, true))
+		return false;
+	vm_stat_inc (VM_STAT_COW_BREAK);
+	return true;
+}
+
+/* Pins the pages covering BUFFER through BUFFER + SIZE: faults each
+ * one in up front and bumps its frame's pin count so eviction leaves
+ * it alone.  Syscalls call this before taking filesys_lock, so a user
+ * buffer never faults -- let alone swaps in -- under the global lock.
+ * WRITABLE buffers additionally get any copy-on-write or zero-frame
+ * sharing broken now, since those mappings are read-only in hardware
+ * and would fault on the first store.  On failure every page pinned so
+ * far is unpinned again and false is returned. */
+bool
+vm_pin_buffer (const void *buffer, size_t size, bool writable) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	uint8_t *start = pg_round_down (buffer);
+	uint8_t *end = (uint8_t *) buffer + size;
+	uint8_t *va;
+
+	if (size == 0)
+		return true;
+
+	for (va = start; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+
+		if (page == NULL) {
+			/* The buffer may sit in not-yet-grown stack; apply the
+			 * same heuristic the fault handler would. */
+			void *rsp = thread_current ()->user_rsp;
+			struct vm_area *area = vm_area_find (spt, va);
+			if (area != NULL && area->grows_down
+					&& va >= (uint8_t *) rsp - 8) {
+				vm_stack_growth (va);
+				page = spt_find_page (spt, va);
+			}
+			if (page == NULL)
+				goto fail;
+		}
+		if (writable && !page->writable)
+			goto fail;
+		if (page->frame == NULL && !vm_do_claim_page (page))
+			goto fail;
+		if (writable && !vm_handle_wp (page))
+			goto fail;
+
+		lock_acquire (&frame_lock);
+		page->frame->pin_cnt++;
+		frame_scan_update (page->frame);
+		lock_release (&frame_lock);
+	}
+	return true;
+
+fail:
+	vm_unpin_buffer (start, va - start);
+	return false;
+}
+
+/* Undoes vm_pin_buffer for the same range. */
+void
+vm_unpin_buffer (const void *buffer, size_t size) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	uint8_t *end = (uint8_t *) buffer + size;
+	uint8_t *va;
+
+	if (size == 0)
+		return;
+
+	for (va = pg_round_down (buffer); va < end; va += PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+
+		if (page == NULL || page->frame == NULL)
+			continue;
+		lock_acquire (&frame_lock);
+		ASSERT (page->frame->pin_cnt > 0);
+		page->frame->pin_cnt--;
+		frame_scan_update (page->frame);
+		lock_release (&frame_lock);
+	}
+}
+
+/* madvise backend.  WILLNEED faults the range in now, so the process
+ * pays the disk latency up front instead of page by page; DONTNEED
+ * drops frames and swap slots immediately, without waiting for the
+ * eviction clock to rediscover memory the process knows it is done
+ * with.  A dropped anonymous page refaults as zero fill; a dropped
+ * file page rereads the file, after any dirty contents are written
+ * back.  SEQUENTIAL and RANDOM record an access-pattern hint on every
+ * page of the range, consulted by the eviction policies (see
+ * evict_ahead); RANDOM is the default and simply clears the hint.
+ * Unknown pages in the range are skipped, pinned ones left alone.
+ * Returns 0, or -1 on a malformed request. */
+int
+vm_madvise (void *addr, size_t length, int advice) {
+	struct supplemental_page_table *spt = &thread_current ()->spt;
+	uint8_t *end = (uint8_t *) addr + length;
+	uint8_t *va;
+
+	if (pg_ofs (addr) != 0 || length == 0)
+		return -1;
+	if (advice != MADV_WILLNEED && advice != MADV_DONTNEED
+			&& advice != MADV_SEQUENTIAL && advice != MADV_RANDOM)
+		return -1;
+
+	for (va = addr; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page (spt, va);
+
+		if (page == NULL)
+			continue;
+
+		if (advice == MADV_SEQUENTIAL || advice == MADV_RANDOM) {
+			page->sequential = advice == MADV_SEQUENTIAL;
+			/* A page already promoted by 2Q is demoted along with
+			 * the hint: "scanned once" and "hot" are contradictory. */
+			if (page->sequential && page->frame != NULL)
+				page->frame->hot = false;
+			continue;
+		}
+
+		if (advice == MADV_WILLNEED) {
+			if (page->frame == NULL)
+				vm_do_claim_page (page);
+			continue;
+		}
+
+		if (page->frame != NULL) {
+			bool pinned;
+
+			lock_acquire (&frame_lock);
+			pinned = page->frame->pin_cnt > 0;
+			lock_release (&frame_lock);
+			if (pinned)
+				continue;
+			if (VM_TYPE (page->operations->type) == VM_FILE)
+				swap_out (page);
+			vm_release_frame (page);
+		}
+		if (VM_TYPE (page->operations->type) == VM_ANON)
+			anon_release_swap (page);
+	}
+	return 0;
+}
+
+/* vminspect backend.  Copies a snapshot of the calling process's SPT
+ * -- one struct vm_page_info per mapped page, in ascending address
+ * order straight off the radix walk -- into BUF, stopping after MAX
+ * entries.  Returns the number written, or -1 on a malformed request.
+ * One syscall thus inspects an entire address space, where the
+ * int 0x42 probe (vm/inspect.c, part of the grading interface) costs
+ * a trap per page.  The snapshot is advisory: pages can fault in or
+ * be evicted while the caller looks at it. */
+int
+vm_inspect_spt (struct vm_page_info *buf, int max) {
+	struct thread *curr = thread_current ();
+	struct page *page;
+	uint64_t key = 0;
+	int cnt = 0;
+
+	if (max <= 0)
+		return -1;
+
+	while (cnt < max
+			&& (page = vm_radix_next (&curr->spt.spt_map, key, &key)) != NULL) {
+		struct vm_page_info *info = &buf[cnt++];
+
+		key++;
+		info->va = page->va;
+		info->type = VM_TYPE (page->operations->type);
+		info->resident = page->frame != NULL;
+		info->dirty = info->resident
+			&& pml4_is_dirty (curr->pml4, page->va);
+		info->swap_slot = -1;
+		if (info->type == VM_ANON && page->anon.swap_slot != ANON_NO_SLOT)
+			info->swap_slot = page->anon.swap_slot;
+	}
+	return cnt;
+}
+
+/* Shared memory segments: a named registry of frame lists that any
+ * process can map, for zero-copy IPC.  The registry holds one
+ * permanent reference on every segment frame, so the frames are never
+ * eviction candidates and outlive their mappers; each mapper adds its
+ * own reference and maps the frame writable directly -- there is no
+ * CoW, a store by one process is immediately visible to the others.
+ * Segments persist until reboot. */
+struct shm_segment {
+	char name[16];          /* Registry key. */
+	int id;                 /* Handle returned by vm_shm_open. */
+	size_t page_cnt;        /* Segment length in pages. */
+	struct frame **frames;  /* One permanently referenced frame per page. */
+	struct list_elem elem;  /* Element of shm_list. */
+};
+
+static struct list shm_list;
+static struct lock shm_lock;
+static int shm_next_id;
+
+static void
+shm_init (void) {
+	list_init (&shm_list);
+	lock_init (&shm_lock);
+}
+
+/* Registry lookups; both expect shm_lock held. */
+static struct shm_segment *
+shm_find_name (const char *name) {
+	struct list_elem *e;
+
+	for (e = list_begin (&shm_list); e != list_end (&shm_list);
+			e = list_next (e)) {
+		struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+		if (!strcmp (seg->name, name))
+			return seg;
+	}
+	return NULL;
+}
+
+static struct shm_segment *
+shm_find_id (int id) {
+	struct list_elem *e;
+
+	for (e = list_begin (&shm_list); e != list_end (&shm_list);
+			e = list_next (e)) {
+		struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+		if (seg->id == id)
+			return seg;
+	}
+	return NULL;
+}
+
+/* Opens the segment named NAME, creating it with SIZE bytes worth of
+ * frames if it does not exist yet.  Returns the segment handle, or -1
+ * on failure.  An existing segment is returned as-is regardless of
+ * SIZE, so the second opener can pass 0. */
+int
+vm_shm_open (const char *name, size_t size) {
+	char key[16];
+	struct shm_segment *seg;
+	size_t page_cnt = DIV_ROUND_UP (size, PGSIZE);
+	size_t i;
+	int id = -1;
+
+	/* Copy the name out before taking the lock: NAME is user memory
+	 * and may fault. */
+	strlcpy (key, name, sizeof key);
+	if (key[0] == '\0')
+		return -1;
+
+	lock_acquire (&shm_lock);
+	seg = shm_find_name (key);
+	if (seg != NULL) {
+		lock_release (&shm_lock);
+		return seg->id;
+	}
+	if (page_cnt == 0)
+		goto done;
+
+	seg = malloc (sizeof *seg);
+	if (seg == NULL)
+		goto done;
+	seg->frames = calloc (page_cnt, sizeof *seg->frames);
+	if (seg->frames == NULL) {
+		free (seg);
+		goto done;
+	}
+
+	for (i = 0; i < page_cnt; i++) {
+		seg->frames[i] = vm_get_frame ();
+		if (seg->frames[i] == NULL) {
+			while (i-- > 0)
+				vm_free_frame (seg->frames[i]);
+			free (seg->frames);
+			free (seg);
+			goto done;
+		}
+		/* An evicted frame comes back with stale contents. */
+		memset (seg->frames[i]->kva, 0, PGSIZE);
+		seg->frames[i]->shm = true;
+	}
+
+	strlcpy (seg->name, key, sizeof seg->name);
+	seg->page_cnt = page_cnt;
+	seg->id = ++shm_next_id;
+	list_push_back (&shm_list, &seg->elem);
+	id = seg->id;
+
+done:
+	lock_release (&shm_lock);
+	return id;
+}
+
+/* Maps segment ID at page-aligned ADDR in the current process.  Every
+ * page becomes a writable anonymous mapping of the shared frame, so
+ * the data moves between sharers without a single copy.  Returns ADDR
+ * on success, NULL on failure. */
+void *
+vm_shm_map (int id, void *addr) {
+	struct thread *curr = thread_current ();
+	struct shm_segment *seg;
+	size_t i;
+
+	if (addr == NULL || pg_ofs (addr) != 0)
+		return NULL;
+
+	lock_acquire (&shm_lock);
+	seg = shm_find_id (id);
+	lock_release (&shm_lock);
+	if (seg == NULL)
+		return NULL;
+
+	if (is_kernel_vaddr ((uint8_t *) addr + seg->page_cnt * PGSIZE))
+		return NULL;
+
+	/* The whole range must be free. */
+	for (i = 0; i < seg->page_cnt; i++)
+		if (spt_find_page (&curr->spt, (uint8_t *) addr + i * PGSIZE) != NULL)
+			return NULL;
+
+	for (i = 0; i < seg->page_cnt; i++) {
+		void *va = (uint8_t *) addr + i * PGSIZE;
+		struct frame *frame = seg->frames[i];
+		struct page *page;
+
+		if (!vm_alloc_page (VM_ANON, va, true))
+			goto fail;
+		/* Transmute the fresh uninit entry in place and attach the
+		 * shared frame, the same way the zero frame is mapped. */
+		page = spt_find_page (&curr->spt, va);
+		if (!page->uninit.page_initializer (page, VM_ANON, frame->kva)
+				|| !pml4_set_page (curr->pml4, va, frame->kva, true))
+			goto fail;
+		vm_frame_ref (frame);
+		vm_map_add (frame, page);
+		page->frame = frame;
+	}
+	return addr;
+
+fail:
+	for (size_t j = 0; j <= i; j++) {
+		struct page *page =
+			spt_find_page (&curr->spt, (uint8_t *) addr + j * PGSIZE);
+		if (page != NULL)
+			spt_remove_page (&curr->spt, page);
+	}
+	return NULL;
+}
+
+/* Pages mapped ahead of the faulting one on each fault; the batch
+ * amortizes the trap and lookup cost for sequential scans. */
+#define FAULT_AROUND_PAGES 4
+
+/* Fault-around: after ADDR's page has been claimed, also claim up to
+ * FAULT_AROUND_PAGES - 1 of the pages right after it that are still
+ * waiting in the SPT as uninit entries.  A sequential reader then
+ * traps once per batch instead of once per page.  Stops at the first
+ * hole or already-resident page; failures here are not the faulting
+ * thread's problem, the page will just fault on its own later. */
+static void
+vm_fault_around (struct supplemental_page_table *spt, void *addr) {
+	uint8_t *va = (uint8_t *) pg_round_down (addr);
+	size_t i;
+
+	for (i = 1; i < FAULT_AROUND_PAGES; i++) {
+		struct page *page = spt_find_page (spt, va + i * PGSIZE);
+
+		if (page == NULL)
+			break;
+		if (page->operations->type != VM_UNINIT || page->frame != NULL)
+			continue;
+		if (!vm_do_claim_page (page))
+			break;
+	}
+}
+
+/* Pages in a 2MB run, the granularity large anonymous regions are
+ * claimed at. */
+#define ANON_RUN_PAGES ((1 << 21) / PGSIZE)
+
+/* Large-region claim batching.  A real 2MB mapping would be a single
+ * PDE-level leaf, but that needs 512 physically contiguous, 2MB-aligned
+ * frames, which palloc cannot hand out, and every mmu.c helper assumes
+ * 4KB leaves.  What the big-anon workloads actually pay for, though,
+ * is one trap per page: so when a write fault lands in a run of pure
+ * anonymous uninit pages, claim the whole surrounding 2MB-aligned run
+ * at once, leaving enough free frames that the claim itself does not
+ * force evictions. */
+static void
+vm_claim_anon_run (struct supplemental_page_table *spt, void *addr) {
+	uintptr_t run_size = (uintptr_t) ANON_RUN_PAGES * PGSIZE;
+	uint8_t *base = (uint8_t *) ((uintptr_t) addr & ~(run_size - 1));
+	size_t i;
+
+	for (i = 0; i < ANON_RUN_PAGES; i++) {
+		struct page *page = spt_find_page (spt, base + i * PGSIZE);
+
+		if (page == NULL || page->operations->type != VM_UNINIT
+				|| VM_TYPE (page->uninit.type) != VM_ANON
+				|| page->uninit.init != NULL || page->frame != NULL)
+			continue;
+		if (palloc_user_pool_free_cnt () <= frame_high_water ())
+			break;
+		if (!vm_do_claim_page (page))
+			break;
+	}
+}
+
+/* Swap slots read ahead once a sequential major-fault run is seen. */
+#define SWAP_READAHEAD_PAGES 4
+
+/* Swap readahead.  When a process faults on the page right after the
+ * one it faulted on last time, it is streaming, and each swapped-out
+ * anon page it is about to reach costs a synchronous 8-sector read.
+ * Pull the next few swapped-out pages in now, while the disk is warm,
+ * so the upcoming faults become plain SPT hits.  The disk interface is
+ * synchronous PIO, so the readahead rides this fault rather than a
+ * separate I/O context; the trap-per-page cost still disappears. */
+static void
+vm_swap_readahead (struct supplemental_page_table *spt, void *addr) {
+	uint8_t *va = (uint8_t *) pg_round_down (addr);
+	size_t i;
+
+	for (i = 1; i <= SWAP_READAHEAD_PAGES; i++) {
+		struct page *page = spt_find_page (spt, va + i * PGSIZE);
+
+		if (page == NULL)
+			break;
+		if (VM_TYPE (page->operations->type) != VM_ANON
+				|| page->frame != NULL
+				|| page->anon.swap_slot == ANON_NO_SLOT)
+			continue;
+		if (!vm_do_claim_page (page))
+			break;
+	}
 }
 
 /* Return true on success */
@@ -197,20 +1480,82 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED, bool user U
 	/* TODO: Validate the fault */
 	/* TODO: Your code goes here */
 
+	TRACE (TRACE_FAULT, addr, write);
+
 	// printf("🚨 Address: %p\n", addr);
 
+	/* Thrash checkpoint: a fault taken in user mode is a safe place
+	 * to park, since no kernel locks are held here. */
+	if (user)
+		vm_thrash_checkpoint ();
+
 	if(not_present){
 		//  사실상 이 부분이 핵심 (페이지를 구해야 하기 떄문에)
 		page = spt_find_page(spt,addr);
 		if(page == NULL){
-			return false;
+			/* No mapping: maybe the stack wants to grow.  The rsp
+			 * comes from the faulting frame for user faults, or from
+			 * the value stashed at syscall entry when the kernel
+			 * touches a user buffer.  Allow the usual 8-byte slack
+			 * below rsp for PUSH. */
+			void *rsp = user ? (void *) f->rsp
+				: thread_current ()->user_rsp;
+			struct vm_area *area = vm_area_find (spt, addr);
+			if (area != NULL && area->grows_down
+					&& (uint8_t *) addr >= (uint8_t *) rsp - 8) {
+				vm_stack_growth (addr);
+				page = spt_find_page (spt, addr);
+			}
+			if (page == NULL)
+				return false;
 		}
 		// if(write==1 && page->writable == 0){
 		// 	return false ;
 		// }
-		return vm_do_claim_page (page);
+		/* First-touch read of a pure anonymous page: serve it from
+		 * the shared zero frame instead of claiming one. */
+		if (page->operations->type == VM_UNINIT
+				&& VM_TYPE (page->uninit.type) == VM_ANON
+				&& page->uninit.init == NULL) {
+			if (!write) {
+				if (!vm_map_zero_page (page))
+					return false;
+				vm_stat_inc (VM_STAT_FAULT);
+				return true;
+			}
+			/* First write into a big anonymous region: claim the
+			 * whole 2MB-aligned run in this one trap. */
+			if (!vm_do_claim_page (page))
+				return false;
+			vm_claim_anon_run (spt, addr);
+			vm_stat_inc (VM_STAT_FAULT);
+			return true;
+		}
+		if (!vm_do_claim_page (page))
+			return false;
+		vm_fault_around (spt, addr);
+		/* Second fault in a row on consecutive pages: the process is
+		 * streaming, so read the swap slots ahead of it now. */
+		if (pg_round_down (addr)
+				== (uint8_t *) thread_current ()->last_fault_va + PGSIZE)
+			vm_swap_readahead (spt, addr);
+		thread_current ()->last_fault_va = pg_round_down (addr);
+		vm_stat_inc (VM_STAT_FAULT);
+		return true;
 	}
-	
+
+	/* Present but write-protected: a copy-on-write fault if the page
+	 * is logically writable. */
+	if (write) {
+		page = spt_find_page (spt, addr);
+		if (page == NULL)
+			return false;
+		if (!vm_handle_wp (page))
+			return false;
+		vm_stat_inc (VM_STAT_FAULT);
+		return true;
+	}
+
 	return false ;
 }
 
@@ -219,7 +1564,7 @@ vm_try_handle_fault (struct intr_frame *f UNUSED, void *addr UNUSED, bool user U
 void
 vm_dealloc_page (struct page *page) {
 	destroy (page);
-	free (page);
+	slab_free (&page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -253,7 +1598,15 @@ vm_claim_page (void *va UNUSED) {
  */
 static bool
 vm_do_claim_page (struct page *page) {
-	struct frame *frame = vm_get_frame ();
+	struct frame *frame;
+
+	/* A read-only file page may already be resident on behalf of
+	 * another process; share that copy instead of reading again. */
+	if (!page->writable && page_get_type (page) == VM_FILE
+			&& file_try_share_page (page))
+		return true;
+
+	frame = vm_get_frame ();
 
 
 	// if (!frame || !frame->kva) {
@@ -272,7 +1625,13 @@ vm_do_claim_page (struct page *page) {
 	}
 
 	/* Set links */
+	page->map_pml4 = thread_current ()->pml4;
+	lock_acquire (&frame_lock);
 	frame->page = page;
+	rss_owner_set (frame, thread_current ());
+	list_push_back (&frame->mappers, &page->map_elem);
+	frame_scan_update (frame);
+	lock_release (&frame_lock);
 	page->frame = frame;
 
 	/* TODO: Insert page table entry to map page's VA to frame's PA. */
@@ -282,34 +1641,235 @@ vm_do_claim_page (struct page *page) {
 	bool success = pml4_set_page(t->pml4,page->va,frame->kva, page->writable);
 	
 	if (success){
-		return swap_in (page, frame->kva);
+		if (!swap_in (page, frame->kva))
+			return false;
+		/* Freshly loaded read-only file pages become shareable.  A
+		 * permanently read-only segment page (text/rodata) goes
+		 * further: its frame is marked text before it is published,
+		 * transferring the load reference to the share cache, so
+		 * every later sharer maps it with zero refcount updates and
+		 * it stays resident as long as the cache entry lives. */
+		if (!page->writable && page_get_type (page) == VM_FILE) {
+			if (page->perm_ro) {
+				lock_acquire (&frame_lock);
+				frame->text = true;
+				frame_scan_update (frame);
+				lock_release (&frame_lock);
+			}
+			file_share_insert (page);
+		}
+		return true;
 	}else{
-		palloc_free_page(frame->kva);
-		free(frame);
+		page->frame = NULL;
+		vm_free_frame (frame);
 		return false;
-	}	
+	}
 	return false;
-	
+
+}
+
+/* Orders areas by start address for list_insert_ordered. */
+static bool
+vm_area_before (const struct list_elem *a, const struct list_elem *b,
+		void *aux UNUSED) {
+	return list_entry (a, struct vm_area, elem)->start
+		< list_entry (b, struct vm_area, elem)->start;
+}
+
+/* Returns the area containing ADDR, or null.  The list is sorted by
+ * start, so the walk stops at the first area past ADDR. */
+struct vm_area *
+vm_area_find (struct supplemental_page_table *spt, const void *addr) {
+	struct list_elem *e;
+
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+
+		if (addr < area->start)
+			break;
+		if (addr < area->end)
+			return area;
+	}
+	return NULL;
+}
+
+/* Returns true if [START, START + LENGTH) overlaps no registered
+ * area.  One ordered walk, however many pages the range covers. */
+bool
+vm_area_range_free (struct supplemental_page_table *spt, void *start,
+		size_t length) {
+	uint8_t *end = (uint8_t *) start + length;
+	struct list_elem *e;
+
+	for (e = list_begin (&spt->areas); e != list_end (&spt->areas);
+			e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+
+		if ((uint8_t *) area->start >= end)
+			break;
+		if ((uint8_t *) area->end > (uint8_t *) start)
+			return false;
+	}
+	return true;
+}
+
+/* Records [START, START + LENGTH) as an area of the address space.
+ * The record lives in the process arena, so exit reclaims it
+ * wholesale.  Returns null on allocation failure. */
+struct vm_area *
+vm_area_register (struct supplemental_page_table *spt, void *start,
+		size_t length, enum vm_type type, struct file *file, off_t offset,
+		bool grows_down) {
+	struct vm_area *area = process_arena_alloc (sizeof *area);
+
+	if (area == NULL)
+		return NULL;
+	area->start = start;
+	area->end = (uint8_t *) start + length;
+	area->type = type;
+	area->file = file;
+	area->offset = offset;
+	area->grows_down = grows_down;
+	list_insert_ordered (&spt->areas, &area->elem, vm_area_before, NULL);
+	return area;
+}
+
+/* Drops the area starting exactly at START, if any. */
+void
+vm_area_unregister (struct supplemental_page_table *spt, void *start) {
+	struct vm_area *area = vm_area_find (spt, start);
+
+	if (area != NULL && area->start == start) {
+		list_remove (&area->elem);
+		process_arena_free (area, sizeof *area);
+	}
 }
 
 /* Initialize new supplemental page table */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt UNUSED) {
-	hash_init(&spt->spt_hash,hash_func,less_func,NULL);
+	vm_radix_init (&spt->spt_map);
+	lock_init (&spt->mut_lock);
+	spt->gen = 0;
+	list_init (&spt->areas);
+
+	/* The stack region is declared up front; the pages inside it
+	 * appear on demand in vm_stack_growth. */
+	vm_area_register (spt, STACK_LIMIT, 1 << 20, VM_ANON, NULL, 0, true);
+}
+
+/* Gives the current (child) process a copy-on-write reference to
+ * SRC_PAGE's frame.  The child gets its own struct page backed by the
+ * same frame, and both mappings are downgraded to read-only so the
+ * first write from either side lands in vm_handle_wp. */
+static bool
+vm_share_page (struct supplemental_page_table *dst, struct page *src_page) {
+	struct thread *curr = thread_current ();
+	struct frame *frame = src_page->frame;
+	struct page *new_page = slab_alloc (&page_cache);
+
+	if (new_page == NULL)
+		return false;
+
+	*new_page = *src_page;
+	/* Swap-backed state is per-copy: the parent keeps its slot and
+	 * any compressed blob, the child starts with neither, or both
+	 * sides would release the same storage. */
+	if (page_get_type (new_page) == VM_ANON) {
+		new_page->anon.swap_slot = ANON_NO_SLOT;
+		new_page->anon.zdata = NULL;
+		new_page->anon.zsize = 0;
+	}
+	/* A file-backed page owns its struct file handle; the child
+	 * needs its own so both sides can close independently. */
+	if (page_get_type (new_page) == VM_FILE && new_page->file.file != NULL) {
+		new_page->file.file = file_reopen (new_page->file.file);
+		if (new_page->file.file == NULL) {
+			slab_free (&page_cache, new_page);
+			return false;
+		}
+	}
+	if (!spt_insert_page (dst, new_page)) {
+		if (page_get_type (new_page) == VM_FILE && new_page->file.file != NULL)
+			file_close (new_page->file.file);
+		slab_free (&page_cache, new_page);
+		return false;
+	}
+
+	/* Text frames are mapped refcount-free; see vm_release_frame. */
+	new_page->map_pml4 = curr->pml4;
+	lock_acquire (&frame_lock);
+	if (!frame->text)
+		frame->ref_cnt++;
+	list_push_back (&frame->mappers, &new_page->map_elem);
+	lock_release (&frame_lock);
+
+	/* Shared-memory frames are shared writable by design: the child
+	 * maps them directly and nobody gets downgraded. */
+	if (!pml4_set_page (curr->pml4, new_page->va, frame->kva,
+				frame->shm && new_page->writable))
+		return false;
+	/* The zero frame has no single owner and is read-only already;
+	 * text is read-only for good -- neither side needs a downgrade.
+	 * Everything else gets the parent's mapping downgraded too. */
+	if (frame != zero_frame && !frame->shm && !frame->text) {
+		pml4_clear_page (frame->owner->pml4, src_page->va);
+		pml4_set_page (frame->owner->pml4, src_page->va, frame->kva, false);
+	}
+	return true;
 }
 
+/* Entries copied per chunk before the fork walk yields the CPU. */
+#define SPT_COPY_CHUNK 64
+
 /* Copy supplemental page table from src to dst */
 // 이 함수 같은 경우 자식 프로세스가 실행 중이라는 전재
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		struct supplemental_page_table *src UNUSED) {
 
-	// 스택에 객체 생성 
-	struct hash_iterator i; 
-	hash_first(&i,&src->spt_hash);
-  
-	while(hash_next(&i)){
-		struct page *src_page = hash_entry(hash_cur(&i), struct page, hash_elem);
+	// 주소 오름차순으로 순회
+	struct page *src_page;
+	uint64_t key = 0;
+	unsigned gen;
+	int chunk = 0;
+
+	/* The walk is chunked so a large parent SPT does not pin the CPU
+	 * for the whole copy: every SPT_COPY_CHUNK entries it yields and
+	 * resumes from the radix cursor.  Across the gap the source
+	 * generation must hold still -- the entries already copied cannot
+	 * be revalidated cheaply -- so if a mutation slips in while we are
+	 * off-CPU the snapshot is broken and the copy reports failure
+	 * rather than handing the child a torn address space. */
+	do {
+		gen = src->gen;
+		barrier ();
+	} while ((gen & 1) && (thread_yield (), true));
+
+	/* Regions first.  The child's stack area was already registered
+	 * by supplemental_page_table_init, so only the rest is copied. */
+	for (struct list_elem *e = list_begin (&src->areas);
+			e != list_end (&src->areas); e = list_next (e)) {
+		struct vm_area *area = list_entry (e, struct vm_area, elem);
+
+		if (vm_area_find (dst, area->start) == NULL
+				&& vm_area_register (dst, area->start,
+					(uint8_t *) area->end - (uint8_t *) area->start,
+					area->type, area->file, area->offset,
+					area->grows_down) == NULL)
+			return false;
+	}
+
+	while ((src_page = vm_radix_next (&src->spt_map, key, &key)) != NULL) {
+		key++;
+		if (++chunk == SPT_COPY_CHUNK) {
+			chunk = 0;
+			thread_cond_resched ();
+			barrier ();
+			if (gen != src->gen)
+				return false;
+		}
 		void * upage = src_page->va;
 		bool writable = src_page->writable;
 
@@ -318,36 +1878,123 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		enum vm_type type = src_page->operations->type;
 		if(type == VM_UNINIT){
 			vm_initializer *init = (&src_page->uninit)->init;
+			enum vm_type real_type = (&src_page->uninit)->type;
 			void *aux = (&src_page->uninit)->aux;
-			vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_0, upage, writable, init, aux);
+
+			/* The lazy-load container must be duplicated: parent and
+			 * child each consume (and free) their own on first touch.
+			 * File-backed containers own their file handle, so the
+			 * child gets a reopened one. */
+			if (aux != NULL) {
+				/* Runs in the child during __do_fork, so the copy
+				 * lands in the child's own arena. */
+				struct container *c = process_arena_alloc (sizeof *c);
+				if (c == NULL)
+					return false;
+				*c = *(struct container *) aux;
+				if (VM_TYPE (real_type) == VM_FILE) {
+					c->file = file_reopen (c->file);
+					if (c->file == NULL) {
+						process_arena_free (c, sizeof *c);
+						return false;
+					}
+				}
+				aux = c;
+			}
+			vm_alloc_page_with_initializer(real_type, upage, writable, init, aux);
 			continue;
 		}
 
 		// vm_type이 UNINT 이외의 경우
+		/* Resident page: share the parent's frame copy-on-write
+		 * instead of claiming a frame and copying PGSIZE bytes. */
+		if (src_page->frame != NULL) {
+			if (!vm_share_page (dst, src_page))
+				return false;
+			continue;
+		}
+
+		/* Not resident: claim a fresh frame for the child. */
 		if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, NULL)){
-			return false ; 	
+			return false ;
 		}
 
 		// VA를 PA와 매핑
 		if(!vm_claim_page(upage)){
 			return false ;
 		}
-
-		struct page *dst_page = spt_find_page(dst,upage);
-		memcpy(dst_page->frame->kva,src_page->frame->kva,PGSIZE);
 	}
 
 	return true;
 }
 
+/* Bulk page destructor for supplemental_page_table_kill.  The whole
+ * address space is going away, so unlike the per-page destroy ops we
+ * never pml4_clear_page (and thus never invlpg) individual mappings:
+ * backing-store state is released, the frame reference is dropped, and
+ * the struct page is freed, all in the one hash sweep.  pt_destroy
+ * knows not to free data frames behind our back (see mmu.c). */
+static void
+spt_kill_page (uint64_t key UNUSED, void *val) {
+	struct page *page = val;
+	static unsigned kill_cnt;
+
+	/* A big exit sweeps thousands of pages; give a woken
+	 * higher-priority thread a chance every so often. */
+	if ((++kill_cnt & 63) == 0)
+		thread_cond_resched ();
+
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT: {
+			/* Never faulted in: only the deferred loading state exists.
+			 * A file-type uninit page owns its reopened handle; an anon
+			 * segment's container borrows the executable's file. */
+			struct container *c = page->uninit.aux;
+			if (c != NULL) {
+				if (VM_TYPE (page->uninit.type) == VM_FILE)
+					file_close (c->file);
+				/* Arena-allocated: the pages go back wholesale in
+				 * process_cleanup, right after this sweep. */
+			}
+			break;
+		}
+		case VM_ANON:
+			anon_release_swap (page);
+			break;
+		case VM_FILE:
+			file_teardown_page (page);
+			break;
+		default:
+			break;
+	}
+
+	if (page->frame != NULL) {
+		lock_acquire (&frame_lock);
+		list_remove (&page->map_elem);
+		if (page->frame->owner == thread_current ())
+			rss_owner_set (page->frame, NULL);
+		/* Text frames belong to the share cache; see vm_release_frame. */
+		if (page->frame->text) {
+			if (page->frame->page == page)
+				page->frame->page = NULL;
+			lock_release (&frame_lock);
+		} else {
+			lock_release (&frame_lock);
+			vm_free_frame (page->frame);
+		}
+		page->frame = NULL;
+	}
+	slab_free (&page_cache, page);
+}
+
 /* Free the resource hold by the supplemental page table */
 void
 supplemental_page_table_kill (struct supplemental_page_table *spt UNUSED) {
-	/* TODO: Destroy all the supplemental_page_table hold by thread and
-	 * TODO: writeback all the modified contents to the storage. */
-
-	hash_clear (&spt->spt_hash, hash_page_destory);
-
+	/* Exit-time teardown takes the batched path: one walk over the
+	 * hash writes back dirty file pages, returns frames to the pool
+	 * and frees the page objects, without unmapping pages one at a
+	 * time from a pml4 that is destroyed right afterwards. */
+	vm_radix_destroy (&spt->spt_map, spt_kill_page);
 }
 
 